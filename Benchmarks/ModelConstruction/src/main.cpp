@@ -0,0 +1,123 @@
+/* Copyright 2018 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKBenchmark
+ *  @file main.cpp
+ *  @brief Benchmark of Model construction.
+ *
+ *  Measures the throughput of model << HoppingAmplitude, as well as the time
+ *  required by Model::construct(), for a 3D lattice with two orbitals and
+ *  spin. The lattice size can be passed as the first argument (default 40).
+ *
+ *  @author Kristofer Björnson
+ */
+
+#include "TBTK/Model.h"
+#include "TBTK/Streams.h"
+
+#include <chrono>
+#include <complex>
+#include <cstdlib>
+
+using namespace std;
+using namespace TBTK;
+
+int main(int argc, char **argv){
+	//Lattice size
+	const int SIZE = (argc > 1) ? atoi(argv[1]) : 40;
+	const int NUM_ORBITALS = 2;
+	const int NUM_REPETITIONS = 3;
+
+	//Parameters
+	complex<double> mu = -1.0;
+	complex<double> t = 1.0;
+
+	double bestAddTime = -1;
+	double bestConstructTime = -1;
+	unsigned int numHoppingAmplitudes = 0;
+	for(int r = 0; r < NUM_REPETITIONS; r++){
+		Model model;
+		numHoppingAmplitudes = 0;
+
+		//Time model << HoppingAmplitude.
+		chrono::time_point<chrono::high_resolution_clock> start
+			= chrono::high_resolution_clock::now();
+		for(int x = 0; x < SIZE; x++){
+			for(int y = 0; y < SIZE; y++){
+				for(int z = 0; z < SIZE; z++){
+					for(int o = 0; o < NUM_ORBITALS; o++){
+						for(int s = 0; s < 2; s++){
+							model << HoppingAmplitude(
+								-mu,
+								{x, y, z, o, s},
+								{x, y, z, o, s}
+							);
+							numHoppingAmplitudes++;
+
+							if(x+1 < SIZE){
+								model << HoppingAmplitude(
+									-t,
+									{x+1, y, z, o, s},
+									{x, y, z, o, s}
+								) + HC;
+								numHoppingAmplitudes += 2;
+							}
+							if(y+1 < SIZE){
+								model << HoppingAmplitude(
+									-t,
+									{x, y+1, z, o, s},
+									{x, y, z, o, s}
+								) + HC;
+								numHoppingAmplitudes += 2;
+							}
+							if(z+1 < SIZE){
+								model << HoppingAmplitude(
+									-t,
+									{x, y, z+1, o, s},
+									{x, y, z, o, s}
+								) + HC;
+								numHoppingAmplitudes += 2;
+							}
+						}
+					}
+				}
+			}
+		}
+		chrono::time_point<chrono::high_resolution_clock> stop
+			= chrono::high_resolution_clock::now();
+		double addTime = chrono::duration<double>(stop - start).count();
+
+		//Time Model::construct().
+		start = chrono::high_resolution_clock::now();
+		model.construct();
+		stop = chrono::high_resolution_clock::now();
+		double constructTime
+			= chrono::duration<double>(stop - start).count();
+
+		if(bestAddTime < 0 || addTime < bestAddTime)
+			bestAddTime = addTime;
+		if(bestConstructTime < 0 || constructTime < bestConstructTime)
+			bestConstructTime = constructTime;
+	}
+
+	Streams::out << "Lattice size:\t\t" << SIZE << "x" << SIZE << "x" << SIZE
+		<< " (" << NUM_ORBITALS << " orbitals, 2 spins)\n";
+	Streams::out << "HoppingAmplitudes:\t" << numHoppingAmplitudes << "\n";
+	Streams::out << "model << ha:\t\t" << bestAddTime << " s ("
+		<< numHoppingAmplitudes/bestAddTime << " HoppingAmplitudes/s)\n";
+	Streams::out << "model.construct():\t" << bestConstructTime << " s\n";
+
+	return 0;
+}
@@ -28,6 +28,7 @@
 #include "TBTK/StateTreeNode.h"
 #include "TBTK/UnitCell.h"
 
+#include <complex>
 #include <initializer_list>
 #include <vector>
 
@@ -63,6 +64,8 @@ namespace TBTK{
  *  space environment around a reference UnitCell, large enough to ensure that
  *  the sum can run over all relevant \f[\bar{R}\f], and then using this to
  *  calcualte the coefficeints when Models with given k and k' is demanded.
+ *  The matrix elements \f[a_{\bar{R}i0i'}\f] are extracted from the real
+ *  space environment once, when the ReciprocalLattice is constructed.
  **/
 class ReciprocalLattice{
 public:
@@ -78,7 +81,9 @@ public:
 	/** Genearates a Model for give momentum. */
 	Model* generateModel(std::vector<double> momentum) const;
 
-	/** Genearates a Model for give momentum. */
+	/** Genearates a Model for give momentum. The momentum space
+	 *  amplitudes for the different momentums are calculated in
+	 *  parallel. */
 	Model* generateModel(
 		const std::vector<std::vector<double>> &momentums,
 		const std::vector<Index> &blockIndices
@@ -111,6 +116,27 @@ private:
 	/** Reciprocal lattice vectors. */
 	std::vector<std::vector<double>> reciprocalLatticeVectors;
 
+	/** Distinct UnitCell displacements \f[\bar{R}\f] for which there
+	 *  are nonzero matrix elements, in units of the lattice vectors. The
+	 *  displacements are stored with one integer per lattice vector. */
+	std::vector<int> cellDisplacements;
+
+	/** Largest absolute value of the displacements along each lattice
+	 *  vector. */
+	std::vector<int> maxCellDisplacements;
+
+	/** Nonzero real space matrix elements \f[a_{\bar{R}i0i'}\f]. */
+	std::vector<std::complex<double>> hoppingMatrixElements;
+
+	/** State pair numBands*from + to for each matrix element, where from
+	 *  and to are the positions of the ket and bra in the reference
+	 *  cell. */
+	std::vector<unsigned int> hoppingStatePairs;
+
+	/** Position in cellDisplacements of the displacement for each matrix
+	 *  element. */
+	std::vector<unsigned int> hoppingCellDisplacements;
+
 	/** Constant used to provide a margin that protects from roundoff
 	 *  errors. */
 	static constexpr double ROUNDOFF_MARGIN_MULTIPLIER = 1.01;
@@ -120,6 +146,18 @@ private:
 
 	/** Setup real space environment. */
 	void setupRealSpaceEnvironment(const UnitCell *unitCell);
+
+	/** Extract the matrix elements between the states in the reference
+	 *  cell and the real space environment. */
+	void setupHoppingTable();
+
+	/** Calculate the momentum space amplitudes for all state pairs. The
+	 *  amplitude for momentum m and state pair p is stored in
+	 *  amplitudes[numBands*numBands*m + p]. */
+	void calculateAmplitudes(
+		const std::vector<std::vector<double>> &momentums,
+		std::vector<std::complex<double>> &amplitudes
+	) const;
 };
 
 inline const std::vector<std::vector<double>>& ReciprocalLattice::getReciprocalLatticeVectors() const{
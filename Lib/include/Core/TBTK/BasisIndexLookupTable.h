@@ -0,0 +1,171 @@
+/* Copyright 2018 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file BasisIndexLookupTable.h
+ *  @brief Flat lookup table between physical indices and basis indices.
+ *
+ *  @author Kristofer Björnson
+ */
+
+#ifndef COM_DAFER45_TBTK_BASIS_INDEX_LOOKUP_TABLE
+#define COM_DAFER45_TBTK_BASIS_INDEX_LOOKUP_TABLE
+
+#include "TBTK/HoppingAmplitudeTree.h"
+#include "TBTK/Index.h"
+
+#include <vector>
+
+namespace TBTK{
+
+/** @brief Flat lookup table between physical indices and basis indices.
+ *
+ *  The BasisIndexLookupTable is generated from a constructed
+ *  HoppingAmplitudeTree and provides constant time lookup of basis indices
+ *  for physical @link Index Indices@endlink, as well as of physical @link
+ *  Index Indices@endlink for basis indices. The physical indices are stored
+ *  packed in a single array ordered by basis index, and the lookup from
+ *  physical Index to basis index is performed through an open addressing
+ *  hash table that stores basis indices into the packed array. */
+class BasisIndexLookupTable{
+public:
+	/** Constructs an empty BasisIndexLookupTable. */
+	BasisIndexLookupTable();
+
+	/** Generate the lookup table from a HoppingAmplitudeTree for which
+	 *  HoppingAmplitudeTree::generateBasisIndices() has been called.
+	 *
+	 *  @param hoppingAmplitudeTree The HoppingAmplitudeTree to generate
+	 *  the table from.
+	 *  @param basisPermutation Optional permutation that maps the basis
+	 *  indices of the HoppingAmplitudeTree to the basis indices stored in
+	 *  the table. Leave empty to use the basis indices of the
+	 *  HoppingAmplitudeTree directly. */
+	void generate(
+		const HoppingAmplitudeTree &hoppingAmplitudeTree,
+		const std::vector<int> &basisPermutation = {}
+	);
+
+	/** Clear the lookup table. */
+	void clear();
+
+	/** Returns true if the lookup table has been generated.
+	 *
+	 *  @return True if the lookup table has been generated, otherwise
+	 *  false. */
+	bool getIsGenerated() const;
+
+	/** Get basis index for given physical Index.
+	 *
+	 *  @param index Physical Index to get the basis index for.
+	 *
+	 *  @return The basis index corresponding to the physical Index, or -1
+	 *  if the Index is not contained in the table. */
+	int getBasisIndex(const Index &index) const;
+
+	/** Get physical Index for given basis index.
+	 *
+	 *  @param basisIndex Basis index to get the physical Index for. Must
+	 *  be in the range [0, basisSize).
+	 *
+	 *  @return The physical Index corresponding to the basis index. */
+	Index getPhysicalIndex(int basisIndex) const;
+
+	/** Get size in bytes.
+	 *
+	 *  @return Memory size required to store the BasisIndexLookupTable. */
+	unsigned int getSizeInBytes() const;
+private:
+	/** Subindices of all physical indices, packed in basis index order. */
+	std::vector<int> subindices;
+
+	/** Offsets into subindices. The subindices of the physical Index
+	 *  with basis index n are stored in the range
+	 *  [offsets[n], offsets[n+1]). */
+	std::vector<unsigned int> offsets;
+
+	/** Open addressing hash table containing basis indices. Empty slots
+	 *  are marked by -1. The size is always a power of two. */
+	std::vector<int> hashTable;
+
+	/** Calculate hash for the given subindices. */
+	static unsigned int hash(const int *subindices, unsigned int size);
+
+	/** Returns true if the physical Index with the given basis index is
+	 *  equal to the given Index. */
+	bool equals(int basisIndex, const Index &index) const;
+};
+
+inline bool BasisIndexLookupTable::getIsGenerated() const{
+	return offsets.size() != 0;
+}
+
+inline int BasisIndexLookupTable::getBasisIndex(const Index &index) const{
+	if(hashTable.size() == 0)
+		return -1;
+
+	const unsigned int MASK = hashTable.size() - 1;
+	unsigned int slot = hash(&index[0], index.getSize())&MASK;
+	while(hashTable[slot] != -1){
+		if(equals(hashTable[slot], index))
+			return hashTable[slot];
+
+		slot = (slot + 1)&MASK;
+	}
+
+	return -1;
+}
+
+inline unsigned int BasisIndexLookupTable::hash(
+	const int *subindices,
+	unsigned int size
+){
+	//FNV-1a hash followed by a final avalanche step.
+	unsigned long long h = 14695981039346656037ull;
+	for(unsigned int n = 0; n < size; n++){
+		h ^= (unsigned int)subindices[n];
+		h *= 1099511628211ull;
+	}
+	h ^= h >> 32;
+
+	return (unsigned int)h;
+}
+
+inline bool BasisIndexLookupTable::equals(
+	int basisIndex,
+	const Index &index
+) const{
+	unsigned int begin = offsets[basisIndex];
+	unsigned int end = offsets[basisIndex+1];
+	if(end - begin != index.getSize())
+		return false;
+
+	for(unsigned int n = begin; n < end; n++)
+		if(subindices[n] != index[n - begin])
+			return false;
+
+	return true;
+}
+
+inline unsigned int BasisIndexLookupTable::getSizeInBytes() const{
+	return sizeof(*this)
+		+ sizeof(int)*subindices.capacity()
+		+ sizeof(unsigned int)*offsets.capacity()
+		+ sizeof(int)*hashTable.capacity();
+}
+
+};	//End of namespace TBTK
+
+#endif
@@ -89,6 +89,11 @@ public:
 	 *  @param ha HoppingAmplitude to copy. */
 	HoppingAmplitude(const HoppingAmplitude &ha);
 
+	/** Move constructor.
+	 *
+	 *  @param ha HoppingAmplitude to move. */
+	HoppingAmplitude(HoppingAmplitude &&ha) noexcept;
+
 	/** Constructor. Constructs the HoppingAmplitude from a serialization
 	 *  string.
 	 *
@@ -101,6 +106,20 @@ public:
 		Serializable::Mode mode
 	);
 
+	/** Assignment operator.
+	 *
+	 *  @param rhs HoppingAmplitude to assign to the left hand side.
+	 *
+	 *  @return Reference to the assigned HoppingAmplitude. */
+	HoppingAmplitude& operator=(const HoppingAmplitude &rhs);
+
+	/** Move assignment operator.
+	 *
+	 *  @param rhs HoppingAmplitude to assign to the left hand side.
+	 *
+	 *  @return Reference to the assigned HoppingAmplitude. */
+	HoppingAmplitude& operator=(HoppingAmplitude &&rhs) noexcept;
+
 	/** Get the Hermitian cojugate of the HoppingAmplitude.
 	 *
 	 *  @return The Hermitian conjugate of the HoppingAmplitude. */
@@ -114,6 +133,12 @@ public:
 	 *  @return The value of the amplitude. */
 	std::complex<double> getAmplitude() const;
 
+	/** Get whether the amplitude is evaluated through a callback.
+	 *
+	 *  @return True if the amplitude is given by a callback function,
+	 *  otherwise false. */
+	bool getIsCallbackDependent() const;
+
 	/** Addition operator. Creates a tuple containing the HoppingAmplitude
 	 *  and its Hermitian conjugate. Used to allow the syntax<br>
 	 *  model << hoppingAmplitude + HC.
@@ -182,6 +207,10 @@ inline std::complex<double> HoppingAmplitude::getAmplitude() const{
 		return amplitude;
 }
 
+inline bool HoppingAmplitude::getIsCallbackDependent() const{
+	return amplitudeCallback != nullptr;
+}
+
 inline std::tuple<HoppingAmplitude, HoppingAmplitude> HoppingAmplitude::operator+(
 	HermitianConjugate hc
 ){
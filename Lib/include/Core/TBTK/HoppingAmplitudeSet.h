@@ -23,14 +23,18 @@
 #ifndef COM_DAFER45_TBTK_HOPPING_AMPLITUDE_SET
 #define COM_DAFER45_TBTK_HOPPING_AMPLITUDE_SET
 
+#include "TBTK/BasisIndexLookupTable.h"
 #include "TBTK/HoppingAmplitude.h"
 #include "TBTK/HoppingAmplitudeTree.h"
 #include "TBTK/IndexTree.h"
 #include "TBTK/Serializable.h"
+#include "TBTK/SparseMatrix.h"
 #include "TBTK/Streams.h"
 #include "TBTK/TBTKMacros.h"
 
 #include <complex>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace TBTK{
@@ -48,6 +52,24 @@ namespace TBTK{
  *  Hamiltonian. */
 class HoppingAmplitudeSet : public Serializable{
 public:
+	/** Enum class for specifying the order in which construct()
+	 *  enumerates the basis states. */
+	enum class BasisOrdering{
+		/** The basis indices follow the lexicographic order of the
+		 *  physical indices. */
+		Lexicographic,
+		/** The basis indices are ordered using the reverse
+		 *  Cuthill-McKee algorithm, which reduces the bandwidth of
+		 *  the Hamiltonian by placing states that are connected by
+		 *  HoppingAmplitudes close to each other. */
+		ReverseCuthillMcKee,
+		/** The basis indices follow the Morton (Z-order) curve
+		 *  through the subindices of the physical indices. For
+		 *  indices such as {x, y, orbital}, states on nearby lattice
+		 *  sites are placed close to each other. */
+		Morton
+	};
+
 	/** Constructor. */
 	HoppingAmplitudeSet();
 
@@ -113,6 +135,33 @@ public:
 	 *  HoppingAmplitudes @endlink should be added after this call. */
 	void construct();
 
+	/** Set whether a flat BasisIndexLookupTable should be used to speed
+	 *  up getBasisIndex() and getPhysicalIndex(). The table is generated
+	 *  by construct(), or immediately if the HoppingAmplitudeSet already
+	 *  is constructed. Enabled by default.
+	 *
+	 *  @param useBasisIndexLookupTable True to use the lookup table. */
+	void setUseBasisIndexLookupTable(bool useBasisIndexLookupTable);
+
+	/** Set the order in which construct() enumerates the basis states.
+	 *  The basis states are only reordered within each block, which
+	 *  therefore remain contiguous ranges of basis indices.
+	 *  getBasisIndex() and getPhysicalIndex() always refer to the
+	 *  reordered basis, and quantities that are indexed by physical
+	 *  indices are therefore unaffected by the ordering. Has to be set
+	 *  before construct() is called. Solvers that assume that the basis
+	 *  indices within a block follow the lexicographic order of the
+	 *  physical indices, such as the RPA calculators, require
+	 *  BasisOrdering::Lexicographic, which is the default.
+	 *
+	 *  @param basisOrdering The BasisOrdering to use. */
+	void setBasisOrdering(BasisOrdering basisOrdering);
+
+	/** Get the order in which construct() enumerates the basis states.
+	 *
+	 *  @return The BasisOrdering. */
+	BasisOrdering getBasisOrdering() const;
+
 	/** Returns true if the Hilbert space basis has been constructed. */
 	bool getIsConstructed() const;
 
@@ -156,6 +205,36 @@ public:
 	/** Get row indices on COO format. */
 	const std::complex<double>* getCOOValues() const;
 
+	/** Get the Hamiltonian as a SparseMatrix on CSR format. The row and
+	 *  column indices are the basis indices of the 'to'- and
+	 *  'from'-indices, respectively. The matrix is constructed the first
+	 *  time it is requested and is then cached and shared by all callers
+	 *  until the HoppingAmplitudeSet is modified or
+	 *  invalidateSparseMatrix() is called. If any HoppingAmplitude is
+	 *  given through a callback, the matrix is instead reconstructed on
+	 *  every call, such that the callbacks are always reevaluated. The
+	 *  function is thread safe.
+	 *
+	 *  @return The Hamiltonian on CSR format. */
+	std::shared_ptr<const SparseMatrix<std::complex<double>>>
+	getSparseMatrix() const;
+
+	/** Invalidate the cached SparseMatrix, forcing the matrix to be
+	 *  reconstructed the next time it is requested. Matrices that have
+	 *  already been returned by getSparseMatrix() remain valid. */
+	void invalidateSparseMatrix();
+
+	/** Get a 64-bit hash of the content of the HoppingAmplitudeSet. The
+	 *  hash covers the basis size, the physical Index of each basis
+	 *  index, and the Hamiltonian on CSR format. Amplitudes given
+	 *  through callbacks are evaluated anew every time the hash is
+	 *  calculated. Two HoppingAmplitudeSets with the
+	 *  same hash therefore, with overwhelming probability, describe the
+	 *  same Hamiltonian in the same basis.
+	 *
+	 *  @return The hash. */
+	unsigned long long getHash() const;
+
 	/** Iterator for iterating through @link HoppingAmplitude
 	 *  HoppingAmplitudes @endlink. */
 	class Iterator{
@@ -268,6 +347,25 @@ private:
 	 */
 	bool isSorted;
 
+	/** Flag indicating whether the basisIndexLookupTable should be used.
+	 */
+	bool useBasisIndexLookupTable;
+
+	/** Lookup table for constant time conversion between physical indices
+	 *  and basis indices. */
+	BasisIndexLookupTable basisIndexLookupTable;
+
+	/** The order in which the basis states are enumerated. */
+	BasisOrdering basisOrdering;
+
+	/** Permutation from the basis indices of the HoppingAmplitudeTree,
+	 *  which follow the lexicographic order, to the basis indices. Is
+	 *  empty for BasisOrdering::Lexicographic. */
+	std::vector<int> basisPermutation;
+
+	/** Inverse of basisPermutation. */
+	std::vector<int> inverseBasisPermutation;
+
 	/** Number of matrix elements in HoppingAmplitudeSet. Is only used and
 	 *  if COO format has been constructed and is otherwise -1. */
 	int numMatrixElements;
@@ -280,17 +378,53 @@ private:
 
 	/** COO format values. */
 	std::complex<double> *cooValues;
+
+	/** Cached Hamiltonian on CSR format. Is nullptr when not
+	 *  constructed or when the amplitudes depend on callbacks. */
+	mutable std::shared_ptr<const SparseMatrix<std::complex<double>>>
+		sparseMatrix;
+
+	/** Mutex protecting sparseMatrix. */
+	mutable std::mutex sparseMatrixMutex;
+
+	/** Construct the Hamiltonian on CSR format.
+	 *
+	 *  @param isCallbackDependent Set to true if any of the amplitudes
+	 *  are given by callbacks, otherwise false.
+	 *
+	 *  @return The Hamiltonian on CSR format. */
+	SparseMatrix<std::complex<double>>* constructSparseMatrix(
+		bool &isCallbackDependent
+	) const;
+
+	/** Generate basisPermutation and inverseBasisPermutation according
+	 *  to the basisOrdering. */
+	void generateBasisPermutation();
+
+	/** Get the ranges [first, last] of tree basis indices that make up
+	 *  the blocks. */
+	std::vector<std::pair<int, int>> getBlockRanges() const;
+
+	/** Get the tree basis indices ordered using the reverse
+	 *  Cuthill-McKee algorithm. */
+	std::vector<int> getReverseCuthillMcKeeOrder() const;
+
+	/** Get the tree basis indices ordered along the Morton curve. */
+	std::vector<int> getMortonOrder() const;
 };
 
 inline void HoppingAmplitudeSet::addHoppingAmplitude(HoppingAmplitude ha){
-	hoppingAmplitudeTree.add(ha);
+	invalidateSparseMatrix();
+	hoppingAmplitudeTree.add(std::move(ha));
 }
 
 inline void HoppingAmplitudeSet::addHoppingAmplitudeAndHermitianConjugate(
 	HoppingAmplitude ha
 ){
-	hoppingAmplitudeTree.add(ha);
-	hoppingAmplitudeTree.add(ha.getHermitianConjugate());
+	invalidateSparseMatrix();
+	HoppingAmplitude hc = ha.getHermitianConjugate();
+	hoppingAmplitudeTree.add(std::move(ha));
+	hoppingAmplitudeTree.add(std::move(hc));
 }
 
 inline const std::vector<HoppingAmplitude>* HoppingAmplitudeSet::getHAs(
@@ -300,10 +434,34 @@ inline const std::vector<HoppingAmplitude>* HoppingAmplitudeSet::getHAs(
 }
 
 inline int HoppingAmplitudeSet::getBasisIndex(const Index &index) const{
-	return hoppingAmplitudeTree.getBasisIndex(index);
+	if(basisIndexLookupTable.getIsGenerated()){
+		int basisIndex = basisIndexLookupTable.getBasisIndex(index);
+		if(basisIndex != -1)
+			return basisIndex;
+	}
+
+	//Indices that are not in the lookup table are passed on to the tree to
+	//get the appropriate return value or error message.
+	int basisIndex = hoppingAmplitudeTree.getBasisIndex(index);
+	if(basisPermutation.size() == 0 || basisIndex < 0)
+		return basisIndex;
+	else
+		return basisPermutation[basisIndex];
 }
 
 inline Index HoppingAmplitudeSet::getPhysicalIndex(int basisIndex) const{
+	if(basisIndexLookupTable.getIsGenerated())
+		return basisIndexLookupTable.getPhysicalIndex(basisIndex);
+
+	//Out of bound basis indices are passed on to the tree unchanged to
+	//get the appropriate error message.
+	if(
+		basisIndex >= 0
+		&& basisIndex < (int)inverseBasisPermutation.size()
+	){
+		basisIndex = inverseBasisPermutation[basisIndex];
+	}
+
 	return hoppingAmplitudeTree.getPhysicalIndex(basisIndex);
 }
 
@@ -327,10 +485,56 @@ inline void HoppingAmplitudeSet::construct(){
 		""
 	);
 
+	invalidateSparseMatrix();
 	hoppingAmplitudeTree.generateBasisIndices();
+	generateBasisPermutation();
+	if(useBasisIndexLookupTable){
+		basisIndexLookupTable.generate(
+			hoppingAmplitudeTree,
+			basisPermutation
+		);
+	}
 	isConstructed = true;
 }
 
+inline void HoppingAmplitudeSet::setUseBasisIndexLookupTable(
+	bool useBasisIndexLookupTable
+){
+	this->useBasisIndexLookupTable = useBasisIndexLookupTable;
+	if(isConstructed){
+		if(useBasisIndexLookupTable){
+			if(!basisIndexLookupTable.getIsGenerated()){
+				basisIndexLookupTable.generate(
+					hoppingAmplitudeTree,
+					basisPermutation
+				);
+			}
+		}
+		else{
+			basisIndexLookupTable.clear();
+		}
+	}
+}
+
+inline void HoppingAmplitudeSet::setBasisOrdering(
+	BasisOrdering basisOrdering
+){
+	TBTKAssert(
+		!isConstructed,
+		"HoppingAmplitudeSet::setBasisOrdering()",
+		"Unable to set the basis ordering since the"
+		<< " HoppingAmplitudeSet already is constructed.",
+		"Set the basis ordering before calling construct()."
+	);
+
+	this->basisOrdering = basisOrdering;
+}
+
+inline HoppingAmplitudeSet::BasisOrdering
+HoppingAmplitudeSet::getBasisOrdering() const{
+	return basisOrdering;
+}
+
 inline bool HoppingAmplitudeSet::getIsConstructed() const{
 	return isConstructed;
 }
@@ -379,9 +583,37 @@ inline const std::complex<double>* HoppingAmplitudeSet::getCOOValues() const{
 	return cooValues;
 }
 
+inline std::shared_ptr<const SparseMatrix<std::complex<double>>>
+HoppingAmplitudeSet::getSparseMatrix() const{
+	std::lock_guard<std::mutex> lock(sparseMatrixMutex);
+	if(sparseMatrix != nullptr)
+		return sparseMatrix;
+
+	bool isCallbackDependent;
+	std::shared_ptr<const SparseMatrix<std::complex<double>>> matrix(
+		constructSparseMatrix(isCallbackDependent)
+	);
+	if(!isCallbackDependent)
+		sparseMatrix = matrix;
+
+	return matrix;
+}
+
+inline void HoppingAmplitudeSet::invalidateSparseMatrix(){
+	std::lock_guard<std::mutex> lock(sparseMatrixMutex);
+	sparseMatrix.reset();
+}
+
 inline unsigned int HoppingAmplitudeSet::getSizeInBytes() const{
-	unsigned int size = sizeof(*this) - sizeof(hoppingAmplitudeTree);
+	unsigned int size = sizeof(*this)
+		- sizeof(hoppingAmplitudeTree)
+		- sizeof(basisIndexLookupTable);
 	size += hoppingAmplitudeTree.getSizeInBytes();
+	size += basisIndexLookupTable.getSizeInBytes();
+	size += sizeof(int)*(
+		basisPermutation.capacity()
+		+ inverseBasisPermutation.capacity()
+	);
 	if(numMatrixElements > 0){
 		size += numMatrixElements*(
 			sizeof(*cooRowIndices)
@@ -389,6 +621,14 @@ inline unsigned int HoppingAmplitudeSet::getSizeInBytes() const{
 			+ sizeof(*cooValues)
 		);
 	}
+	std::lock_guard<std::mutex> lock(sparseMatrixMutex);
+	if(sparseMatrix != nullptr){
+		size += sizeof(*sparseMatrix);
+		size += (sparseMatrix->getNumRows() + 1)*sizeof(unsigned int);
+		size += sparseMatrix->getCSRNumMatrixElements()*(
+			sizeof(unsigned int) + sizeof(std::complex<double>)
+		);
+	}
 
 	return size;
 }
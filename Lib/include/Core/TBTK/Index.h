@@ -26,6 +26,7 @@
 #include "TBTK/Serializable.h"
 #include "TBTK/Streams.h"
 
+#include <stdexcept>
 #include <vector>
 
 namespace TBTK{
@@ -66,26 +67,36 @@ enum {
  *  Flexible physical index for indexing arbitrary models. Each index can
  *  contain an arbitrary number of subindices. For example {x, y, spin},
  *  {x, y, z, orbital, spin}, and {subsystem, x, y, z, orbital, spin}.
+ *
+ *  Indices with at most Index::INLINE_CAPACITY subindices are stored inline
+ *  in the Index itself, while longer indices (typically compound indices)
+ *  spill over to heap allocated memory. Constructing, copying, and moving
+ *  the common short Index therefore does not require any heap allocation.
  */
 class Index{
 public:
 	/** Constructs an empty Index. */
-	Index(){};
+	Index();
 
 	/** Constructs an Index from an initializer list.
 	 *
 	 * @param i Initializer list from which the Index is constructed. */
-	Index(std::initializer_list<int> i) : indices(i){};
+	Index(std::initializer_list<int> i);
 
 	/** Constructs an Index from an std::vector<int>.
 	 *
 	 *  @param i Vector from which the Index is constructed. */
-	Index(std::vector<int> i) : indices(i){};
+	Index(const std::vector<int> &i);
 
 	/** Copy constructor.
 	 *
 	 *  @param index Index to copy. */
-	Index(const Index &index) : indices(index.indices){};
+	Index(const Index &index);
+
+	/** Move constructor.
+	 *
+	 *  @param index Index to move. */
+	Index(Index &&index) noexcept;
 
 	/** Constructs a new Index by concatenating two indices into one total
 	 *  index of the form {head, tail}.
@@ -126,6 +137,23 @@ public:
 	 *  @param mode Mode with which the string has been serialized. */
 	Index(const std::string &serialization, Serializable::Mode mode);
 
+	/** Destructor. */
+	~Index();
+
+	/** Assignment operator.
+	 *
+	 *  @param rhs Index to assign to the left hand side.
+	 *
+	 *  @return Reference to the assigned Index. */
+	Index& operator=(const Index &rhs);
+
+	/** Move assignment operator.
+	 *
+	 *  @param rhs Index to assign to the left hand side.
+	 *
+	 *  @return Reference to the assigned Index. */
+	Index& operator=(Index &&rhs) noexcept;
+
 	/** Compare this index with another index. Returns true if the indices
 	 *  have the same number of subindices and all subindices are equal.
 	 *
@@ -247,17 +275,119 @@ public:
 	 *
 	 *  @return Memory size required to store the Index. */
 	unsigned int getSizeInBytes() const;
+
+	/** Maximum number of subindices that can be stored without heap
+	 *  allocation. */
+	static constexpr unsigned int INLINE_CAPACITY = 8;
 private:
-	/** Subindex container. */
-	std::vector<int> indices;
+	/** Number of subindices. */
+	unsigned int size;
+
+	/** Number of subindices that fit into the currently used storage. */
+	unsigned int capacity;
+
+	/** Subindex container. Points to inlineIndices as long as capacity is
+	 *  INLINE_CAPACITY, and to heap allocated memory otherwise. */
+	int *indices;
+
+	/** Inline storage for short indices. */
+	int inlineIndices[INLINE_CAPACITY];
+
+	/** Returns true if the subindices are stored in heap allocated
+	 *  memory. */
+	bool isOnHeap() const;
+
+	/** Replace the content of the Index by the given subindices.
+	 *
+	 *  @param subindices Pointer to the subindices.
+	 *  @param numSubindices Number of subindices. */
+	void assign(const int *subindices, unsigned int numSubindices);
 };
 
+inline Index::Index() :
+	size(0),
+	capacity(INLINE_CAPACITY),
+	indices(inlineIndices),
+	inlineIndices()
+{
+}
+
+inline Index::Index(std::initializer_list<int> i) : Index(){
+	assign(i.begin(), i.size());
+}
+
+inline Index::Index(const std::vector<int> &i) : Index(){
+	assign(i.data(), i.size());
+}
+
+inline Index::Index(const Index &index) : Index(){
+	assign(index.indices, index.size);
+}
+
+inline Index::Index(Index &&index) noexcept : Index(){
+	if(index.isOnHeap()){
+		indices = index.indices;
+		capacity = index.capacity;
+		index.indices = index.inlineIndices;
+		index.capacity = INLINE_CAPACITY;
+	}
+	else{
+		//The subindices are stored inline. Copying the full inline
+		//buffer avoids a data dependent copy length.
+		for(unsigned int n = 0; n < INLINE_CAPACITY; n++)
+			inlineIndices[n] = index.inlineIndices[n];
+	}
+	size = index.size;
+	index.size = 0;
+}
+
+inline Index::~Index(){
+	if(isOnHeap())
+		delete [] indices;
+}
+
+inline Index& Index::operator=(const Index &rhs){
+	if(this != &rhs)
+		assign(rhs.indices, rhs.size);
+
+	return *this;
+}
+
+inline Index& Index::operator=(Index &&rhs) noexcept{
+	if(this != &rhs){
+		if(rhs.isOnHeap()){
+			if(isOnHeap())
+				delete [] indices;
+			indices = rhs.indices;
+			capacity = rhs.capacity;
+			rhs.indices = rhs.inlineIndices;
+			rhs.capacity = INLINE_CAPACITY;
+			size = rhs.size;
+		}
+		else{
+			//rhs.size <= INLINE_CAPACITY <= capacity, so no
+			//allocation takes place.
+			for(
+				unsigned int n = 0;
+				n < rhs.size && n < INLINE_CAPACITY;
+				n++
+			){
+				indices[n] = rhs.inlineIndices[n];
+			}
+			size = rhs.size;
+		}
+		rhs.size = 0;
+	}
+
+	return *this;
+}
+
 inline void Index::print() const{
 	Streams::out << "{";
-	for(unsigned int n = 0; n < indices.size(); n++){
+	for(unsigned int n = 0; n < size; n++){
 		if(n != 0)
 			Streams::out << ", ";
-		Streams::out << indices.at(n);
+		Streams::out << indices[n];
 	}
 	Streams::out << "}\n";
 }
@@ -265,10 +395,10 @@ inline void Index::print() const{
 inline std::string Index::toString() const{
 	std::string str = "{";
 	bool isFirstIndex = true;
-	for(unsigned int n = 0; n < indices.size(); n++){
+	for(unsigned int n = 0; n < size; n++){
 /*		if(n != 0)
 			str += ", ";*/
-		int subindex = indices.at(n);
+		int subindex = indices[n];
 		if(!isFirstIndex && subindex != IDX_SEPARATOR)
 			str += ", ";
 		else
@@ -307,15 +437,15 @@ inline std::string Index::toString() const{
 }
 
 inline bool Index::equals(const Index &index, bool allowWildcard) const{
-	if(indices.size() == index.indices.size()){
-		for(unsigned int n = 0; n < indices.size(); n++){
-			if(indices.at(n) != index.indices.at(n)){
+	if(size == index.size){
+		for(unsigned int n = 0; n < size; n++){
+			if(indices[n] != index.indices[n]){
 				if(!allowWildcard)
 					return false;
 				else{
 					if(
-						indices.at(n) == IDX_ALL ||
-						index.indices.at(n) == IDX_ALL
+						indices[n] == IDX_ALL ||
+						index.indices[n] == IDX_ALL
 					)
 						continue;
 					else
@@ -332,42 +462,49 @@ inline bool Index::equals(const Index &index, bool allowWildcard) const{
 }
 
 inline int& Index::at(unsigned int n){
-	return indices.at(n);
+	if(n >= size)
+		throw std::out_of_range("Index::at()");
+
+	return indices[n];
 }
 
 inline const int& Index::at(unsigned int n) const{
-	return indices.at(n);
-}
+	if(n >= size)
+		throw std::out_of_range("Index::at()");
 
-inline unsigned int Index::getSize() const{
-	return indices.size();
+	return indices[n];
 }
 
-inline void Index::reserve(unsigned int size){
-	indices.reserve(size);
+inline unsigned int Index::getSize() const{
+	return size;
 }
 
 inline void Index::push_back(int subindex){
-	indices.push_back(subindex);
+	if(size == capacity)
+		reserve(2*capacity);
+
+	indices[size++] = subindex;
 }
 
 inline int Index::popFront(){
-	int first = indices.at(0);
-	indices.erase(indices.begin());
+	int first = at(0);
+	for(unsigned int n = 1; n < size; n++)
+		indices[n-1] = indices[n];
+	size--;
 
 	return first;
 }
 
 inline int Index::popBack(){
-	int last = indices.back();
-	indices.pop_back();
+	int last = indices[size-1];
+	size--;
 
 	return last;
 }
 
 inline bool Index::isPatternIndex() const{
-	for(unsigned int n = 0; n < indices.size(); n++)
-		if(indices.at(n) < 0)
+	for(unsigned int n = 0; n < size; n++)
+		if(indices[n] < 0)
 			return true;
 
 	return false;
@@ -382,7 +519,22 @@ inline const int& Index::operator[](unsigned int subindex) const{
 }
 
 inline unsigned int Index::getSizeInBytes() const{
-	return sizeof(*this) + sizeof(int)*indices.capacity();
+	if(isOnHeap())
+		return sizeof(*this) + sizeof(int)*capacity;
+	else
+		return sizeof(*this);
+}
+
+inline bool Index::isOnHeap() const{
+	return indices != inlineIndices;
+}
+
+inline void Index::assign(const int *subindices, unsigned int numSubindices){
+	if(numSubindices > capacity)
+		reserve(numSubindices);
+	for(unsigned int n = 0; n < numSubindices; n++)
+		indices[n] = subindices[n];
+	size = numSubindices;
 }
 
 };	//End of namespace TBTK
@@ -98,6 +98,18 @@ public:
 	/** Returns true if the Hilbert space basis has been constructed. */
 	bool getIsConstructed();
 
+	/** Set whether a flat lookup table should be used for conversion
+	 *  between physical indices and basis indices. Enabled by default.
+	 *  See HoppingAmplitudeSet::setUseBasisIndexLookupTable(). */
+	void setUseBasisIndexLookupTable(bool useBasisIndexLookupTable);
+
+	/** Set the order in which construct() enumerates the basis states,
+	 *  for example to reduce the bandwidth of the Hamiltonian. See
+	 *  HoppingAmplitudeSet::setBasisOrdering(). */
+	void setBasisOrdering(
+		HoppingAmplitudeSet::BasisOrdering basisOrdering
+	);
+
 	/** Sort HoppingAmplitudes. */
 	void sortHoppingAmplitudes();
 
@@ -114,6 +126,14 @@ public:
 	 *  callbacks. */
 	void reconstructCOO();
 
+	/** Invalidate the cached Hamiltonian on CSR format. See
+	 *  HoppingAmplitudeSet::invalidateSparseMatrix(). */
+	void invalidateSparseMatrix();
+
+	/** Get a hash of the Hamiltonian and basis. See
+	 *  HoppingAmplitudeSet::getHash(). */
+	unsigned long long getHash() const;
+
 	/** Set temperature. */
 	void setTemperature(double temperature);
 
@@ -194,13 +214,15 @@ private:
 };
 
 inline void Model::addHoppingAmplitude(HoppingAmplitude ha){
-	singleParticleContext->addHoppingAmplitude(ha);
+	singleParticleContext->addHoppingAmplitude(std::move(ha));
 }
 
 inline void Model::addHoppingAmplitudeAndHermitianConjugate(
 	HoppingAmplitude ha
 ){
-	singleParticleContext->addHoppingAmplitudeAndHermitianConjugate(ha);
+	singleParticleContext->addHoppingAmplitudeAndHermitianConjugate(
+		std::move(ha)
+	);
 }
 
 inline int Model::getBasisSize() const{
@@ -219,6 +241,20 @@ inline void Model::sortHoppingAmplitudes(){
 	singleParticleContext->sortHoppingAmplitudes();
 }
 
+inline void Model::setUseBasisIndexLookupTable(
+	bool useBasisIndexLookupTable
+){
+	singleParticleContext->setUseBasisIndexLookupTable(
+		useBasisIndexLookupTable
+	);
+}
+
+inline void Model::setBasisOrdering(
+	HoppingAmplitudeSet::BasisOrdering basisOrdering
+){
+	singleParticleContext->setBasisOrdering(basisOrdering);
+}
+
 inline void Model::constructCOO(){
 	singleParticleContext->constructCOO();
 }
@@ -231,6 +267,14 @@ inline void Model::reconstructCOO(){
 	singleParticleContext->reconstructCOO();
 }
 
+inline void Model::invalidateSparseMatrix(){
+	singleParticleContext->invalidateSparseMatrix();
+}
+
+inline unsigned long long Model::getHash() const{
+	return singleParticleContext->getHash();
+}
+
 inline void Model::setTemperature(double temperature){
 	this->temperature = temperature;
 }
@@ -87,6 +87,17 @@ public:
 	 *  HoppingAmplitudes @endlink should be added after this call. */
 	void construct();
 
+	/** Set whether a flat lookup table should be used for conversion
+	 *  between physical indices and basis indices. See
+	 *  HoppingAmplitudeSet::setUseBasisIndexLookupTable(). */
+	void setUseBasisIndexLookupTable(bool useBasisIndexLookupTable);
+
+	/** Set the order in which construct() enumerates the basis states.
+	 *  See HoppingAmplitudeSet::setBasisOrdering(). */
+	void setBasisOrdering(
+		HoppingAmplitudeSet::BasisOrdering basisOrdering
+	);
+
 	/*** Sort HoppingAmplitudes. */
 	void sortHoppingAmplitudes();
 
@@ -106,6 +117,14 @@ public:
 	 *  callbacks. */
 	void reconstructCOO();
 
+	/** Invalidate the cached Hamiltonian on CSR format. See
+	 *  HoppingAmplitudeSet::invalidateSparseMatrix(). */
+	void invalidateSparseMatrix();
+
+	/** Get a hash of the Hamiltonian and basis. See
+	 *  HoppingAmplitudeSet::getHash(). */
+	unsigned long long getHash() const;
+
 	/** Get HoppingAMplitudeSet. */
 	const HoppingAmplitudeSet* getHoppingAmplitudeSet() const;
 
@@ -141,13 +160,15 @@ inline Statistics SingleParticleContext::getStatistics() const{
 }
 
 inline void SingleParticleContext::addHoppingAmplitude(HoppingAmplitude ha){
-	hoppingAmplitudeSet->addHoppingAmplitude(ha);
+	hoppingAmplitudeSet->addHoppingAmplitude(std::move(ha));
 }
 
 inline void SingleParticleContext::addHoppingAmplitudeAndHermitianConjugate(
 	HoppingAmplitude ha
 ){
-	hoppingAmplitudeSet->addHoppingAmplitudeAndHermitianConjugate(ha);
+	hoppingAmplitudeSet->addHoppingAmplitudeAndHermitianConjugate(
+		std::move(ha)
+	);
 }
 
 inline int SingleParticleContext::getBasisIndex(const Index &index) const{
@@ -166,6 +187,20 @@ inline void SingleParticleContext::sortHoppingAmplitudes(){
 	hoppingAmplitudeSet->sort();
 }
 
+inline void SingleParticleContext::setUseBasisIndexLookupTable(
+	bool useBasisIndexLookupTable
+){
+	hoppingAmplitudeSet->setUseBasisIndexLookupTable(
+		useBasisIndexLookupTable
+	);
+}
+
+inline void SingleParticleContext::setBasisOrdering(
+	HoppingAmplitudeSet::BasisOrdering basisOrdering
+){
+	hoppingAmplitudeSet->setBasisOrdering(basisOrdering);
+}
+
 inline void SingleParticleContext::constructCOO(){
 	hoppingAmplitudeSet->sort();
 	hoppingAmplitudeSet->constructCOO();
@@ -179,6 +214,14 @@ inline void SingleParticleContext::reconstructCOO(){
 	hoppingAmplitudeSet->reconstructCOO();
 }
 
+inline void SingleParticleContext::invalidateSparseMatrix(){
+	hoppingAmplitudeSet->invalidateSparseMatrix();
+}
+
+inline unsigned long long SingleParticleContext::getHash() const{
+	return hoppingAmplitudeSet->getHash();
+}
+
 inline const HoppingAmplitudeSet* SingleParticleContext::getHoppingAmplitudeSet() const{
 	return hoppingAmplitudeSet;
 }
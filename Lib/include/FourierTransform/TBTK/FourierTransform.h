@@ -390,14 +390,15 @@ inline FourierTransform::Plan<DataType>& FourierTransform::Plan<
 			fftw_destroy_plan(*this->plan);
 
 			delete this->plan;
+		}
 
-			this->plan = rhs.plan;
+		this->plan = rhs.plan;
+		rhs.plan = nullptr;
 
-			normalizationFactor = rhs.normalizationFactor;
-			size = rhs.size;
-			input = rhs.input;
-			output = rhs.output;
-		}
+		normalizationFactor = rhs.normalizationFactor;
+		size = rhs.size;
+		input = rhs.input;
+		output = rhs.output;
 	}
 
 	return *this;
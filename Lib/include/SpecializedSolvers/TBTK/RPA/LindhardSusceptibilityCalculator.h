@@ -62,8 +62,19 @@ public:
 
 	/** Precompute susceptibilities. Will calculate the susceptibility for
 	 *  all values using a parallel algorithm. Can speed up calculations if
-	 *  most of the susceptibilities are needed. */
-	void precompute(unsigned int numWorkers = 129);
+	 *  most of the susceptibilities are needed. The k-points are handed
+	 *  out to the threads one at a time, and each result is written
+	 *  directly into a preallocated contiguous store that is used for
+	 *  subsequent lookups. Progress and the time spent in each phase is
+	 *  printed if the calculator is verbose. */
+	void precompute();
+
+	/** Save susceptibilities, including the precomputed ones. */
+	virtual void saveSusceptibilities(const std::string &filename) const;
+
+	/** Load susceptibilities. Discards the precomputed susceptibilities.
+	 */
+	virtual void loadSusceptibilities(const std::string &filename);
 
 	/** Set to true if the susceptibility is known to only be
 	 *  evaluated at points away from poles. */
@@ -82,6 +93,31 @@ private:
 	/** Fermi-Dirac distribution lookup table. */
 	double *fermiDiracLookupTable;
 
+	/** Real part of the susceptibilities calculated by precompute(). One
+	 *  block per mesh point, each on the format returned by
+	 *  calculateSusceptibilities(). */
+	std::vector<double> precomputedRealSusceptibilities;
+
+	/** Imaginary part of the susceptibilities calculated by
+	 *  precompute(). */
+	std::vector<double> precomputedImaginarySusceptibilities;
+
+	/** Energies for which the precomputed susceptibilities are valid. */
+	std::vector<std::complex<double>> precomputedEnergies;
+
+	/** Get a susceptibility from the store of precomputed
+	 *  susceptibilities. Returns false if it is not available. */
+	bool getPrecomputedSusceptibility(
+		const DualIndex &kDual,
+		const std::vector<int> &orbitalIndices,
+		std::vector<std::complex<double>> &result
+	) const;
+
+	/** Add the precomputed susceptibilities to an IndexedDataTree. */
+	void addPrecomputedSusceptibilities(
+		IndexedDataTree<SerializableVector<std::complex<double>>> &tree
+	) const;
+
 	/** Slave constructor. */
 	LindhardSusceptibilityCalculator(
 		const MomentumSpaceContext &momentumSpaceContext,
@@ -96,11 +132,36 @@ private:
 		std::complex<double> energy
 	);
 
-	/** Calculate the susceptibility using the Lindhard function. */
+	/** Calculate the susceptibility using the Lindhard function for all
+	 *  combinations of orbital indices at once. The pole and Fermi
+	 *  factors are evaluated once per mesh point and pair of states and
+	 *  are then contracted with the products of amplitudes. The result is
+	 *  stored with real and imaginary parts in separate arrays, with the
+	 *  energy index running fastest and preceded by the orbital indices
+	 *  in the order (orbital3, orbital0, orbital1, orbital2). The result
+	 *  arrays must have room for numOrbitals^4*numEnergies elements. */
 	template<bool useKPlusQLookupTable, bool isSafeFromPoles>
-	std::vector<std::complex<double>> calculateSusceptibilityLindhard(
+	void calculateSusceptibilityLindhard(
 		const DualIndex &kDual,
-		const std::vector<int> &orbitalIndices
+		double *realResult,
+		double *imaginaryResult
+	) const;
+
+	/** Calculate the susceptibility for all combinations of orbital
+	 *  indices using the version of calculateSusceptibilityLindhard()
+	 *  that matches the current settings. */
+	void calculateSusceptibilities(
+		const DualIndex &kDual,
+		double *realResult,
+		double *imaginaryResult
+	) const;
+
+	/** Cache the susceptibilities calculated by
+	 *  calculateSusceptibilities(). */
+	void cacheSusceptibilities(
+		const DualIndex &kDual,
+		const std::vector<double> &realResult,
+		const std::vector<double> &imaginaryResult
 	);
 
 	/** Get polt times two Fermi functions for use in the Linhard
@@ -33,9 +33,17 @@ namespace TBTK{
 
 class MatsubaraSusceptibilityCalculator : public SusceptibilityCalculator{
 public:
-	/** Constructor. */
+	/** Constructor.
+	 *
+	 *  @param momentumSpaceContext The MomentumSpaceContext.
+	 *  @param algorithm Algorithm::Matsubara evaluates the Matsubara sum
+	 *  directly for each requested k. Algorithm::MatsubaraFFT evaluates
+	 *  the sum as a correlation in k and the summation energy using
+	 *  Fourier transforms, which calculates the susceptibility for every
+	 *  k on the mesh at once and requires a nodal mesh and FFTW3. */
 	MatsubaraSusceptibilityCalculator(
-		const MomentumSpaceContext &momentumSpaceContext
+		const MomentumSpaceContext &momentumSpaceContext,
+		Algorithm algorithm = Algorithm::Matsubara
 	);
 
 	/** Destructor. */
@@ -61,16 +69,42 @@ public:
 
 	/** Set the number of summation energies. */
 	void setNumSummationEnergies(unsigned int numSummationEnergies);
+
+	/** Set whether the part of the Matsubara sum that lies outside of the
+	 *  summation energies should be added using the asymptotic form 1/E
+	 *  of the Green's function. Reduces the truncation error of the sum
+	 *  for the orbital combinations that are diagonal in the asymptotic
+	 *  form. Off by default.
+	 *
+	 *  @param useTailCorrection Set to true to add the tail correction. */
+	void setUseTailCorrection(bool useTailCorrection);
+
+	/** Get whether the tail correction is used.
+	 *
+	 *  @return True if the tail correction is used. */
+	bool getUseTailCorrection() const;
 private:
 	/** Green's function for use in Mode::Matsubara. */
 	std::complex<double> *greensFunction;
 
+	/** Fourier transform of the Green's function with respect to k and
+	 *  the summation energy index. Used in Algorithm::MatsubaraFFT. */
+	std::complex<double> *greensFunctionTransform;
+
+	/** Number of summation energies after zero padding in
+	 *  greensFunctionTransform. */
+	unsigned int numPaddedEnergies;
+
 	/** Summation energies. Used in Mode::Matsubara. */
 	std::vector<std::complex<double>> summationEnergies;
 
+	/** Flag indicating whether the tail correction is used. */
+	bool useTailCorrection;
+
 	/** Slave constructor. */
 	MatsubaraSusceptibilityCalculator(
 		const MomentumSpaceContext &momentumSpaceContext,
+		Algorithm algorithm,
 		int *kPlusQLookupTable
 	);
 
@@ -88,9 +122,30 @@ private:
 		const std::vector<int> &orbitalIndices
 	);
 
+	/** Calculate the susceptibility for every k on the mesh using the
+	 *  Fourier transform of the Green's function, and cache the result.
+	 */
+	void calculateSusceptibilityMatsubaraFFT(
+		const std::vector<int> &orbitalIndices
+	);
+
+	/** Calculate the part of the Matsubara sum that lies outside of the
+	 *  summation energies, using the asymptotic form 1/E of the Green's
+	 *  function. Only nonzero if the tail correction is used,
+	 *  orbitalIndices[3] == orbitalIndices[0], and orbitalIndices[1] ==
+	 *  orbitalIndices[2], since the asymptotic form is diagonal in the
+	 *  orbitals. The result is to be added to the
+	 *  sum for each mesh point. */
+	std::vector<std::complex<double>> calculateTailCorrections(
+		const std::vector<int> &orbitalIndices
+	) const;
+
 	/** Calculate Green's function. */
 	void calculateGreensFunction();
 
+	/** Calculate greensFunctionTransform. */
+	void calculateGreensFunctionTransform();
+
 	/** Get greensFunctionValue. */
 	std::complex<double>& getGreensFunctionValue(
 		unsigned int meshPoint,
@@ -116,12 +171,14 @@ inline void MatsubaraSusceptibilityCalculator::setNumSummationEnergies(
 		getMomentumSpaceContext().getModel().getTemperature()
 	);
 	double kT = UnitHandler::getK_BB()*temperature;
-	double hbar = UnitHandler::getHbarB();
 
+	//Fermionic Matsubara energies.
 	summationEnergies.clear();
 	for(unsigned int n = 0; n < numSummationEnergies; n++){
 		summationEnergies.push_back(
-			M_PI*(2*(n - numSummationEnergies/2))*kT/hbar
+			std::complex<double>(0, 1)*M_PI*(
+				2.*((int)n - (int)numSummationEnergies/2) + 1.
+			)*kT
 		);
 	}
 
@@ -130,6 +187,23 @@ inline void MatsubaraSusceptibilityCalculator::setNumSummationEnergies(
 		delete [] greensFunction;
 		greensFunction = nullptr;
 	}
+	if(greensFunctionTransform != nullptr){
+		delete [] greensFunctionTransform;
+		greensFunctionTransform = nullptr;
+	}
+}
+
+inline void MatsubaraSusceptibilityCalculator::setUseTailCorrection(
+	bool useTailCorrection
+){
+	if(this->useTailCorrection != useTailCorrection){
+		this->useTailCorrection = useTailCorrection;
+		clearCache();
+	}
+}
+
+inline bool MatsubaraSusceptibilityCalculator::getUseTailCorrection() const{
+	return useTailCorrection;
 }
 
 /*inline std::vector<std::complex<double>> SusceptibilityCalculator::calculateSusceptibility(
@@ -0,0 +1,141 @@
+/* Copyright 2018 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file MomentumSpaceFourierTransform.h
+ *  @brief Fourier transform of functions defined on the mesh of a
+ *  MomentumSpaceContext.
+ *
+ *  @author Kristofer Björnson
+ */
+
+#ifndef COM_DAFER45_TBTK_MOMENTUM_SPACE_FOURIER_TRANSFORM
+#define COM_DAFER45_TBTK_MOMENTUM_SPACE_FOURIER_TRANSFORM
+
+#include "TBTK/FourierTransform.h"
+#include "TBTK/RPA/MomentumSpaceContext.h"
+
+#include <complex>
+#include <vector>
+
+namespace TBTK{
+
+/** @brief Fourier transform of functions defined on the mesh of a
+ *  MomentumSpaceContext.
+ *
+ *  The mesh has to be a nodal mesh, in which case the mesh points form a
+ *  periodic grid on which k+q is a mesh point whenever k and q are. Sums on
+ *  the form \f$\sum_{q}A(q)B(k \pm q)\f$ can therefore be calculated as
+ *  products of the Fourier transforms of A and B. Functions in momentum
+ *  space are indexed by the mesh point, while their transforms are indexed
+ *  by the linear index of the reciprocal grid point. The transforms are not
+ *  normalized, which means that a forward transform followed by an inverse
+ *  transform multiplies the function by getSize(). */
+class MomentumSpaceFourierTransform{
+public:
+	/** Constructor.
+	 *
+	 *  @param momentumSpaceContext The MomentumSpaceContext that defines
+	 *  the mesh. */
+	MomentumSpaceFourierTransform(
+		const MomentumSpaceContext &momentumSpaceContext
+	);
+
+	/** Copy constructor. */
+	MomentumSpaceFourierTransform(
+		const MomentumSpaceFourierTransform &momentumSpaceFourierTransform
+	) = delete;
+
+	/** Destructor. */
+	~MomentumSpaceFourierTransform();
+
+	/** Assignment operator. */
+	MomentumSpaceFourierTransform& operator=(
+		const MomentumSpaceFourierTransform &rhs
+	) = delete;
+
+	/** Get the number of mesh points.
+	 *
+	 *  @return The number of mesh points. */
+	unsigned int getSize() const;
+
+	/** Get the grid point that corresponds to a given mesh point. The
+	 *  grid point is also the index of the corresponding reciprocal grid
+	 *  point in a transform.
+	 *
+	 *  @param meshPoint The mesh point.
+	 *
+	 *  @return The linear index of the grid point. */
+	unsigned int getGridPoint(unsigned int meshPoint) const;
+
+	/** Get the reciprocal grid point -f.
+	 *
+	 *  @param gridPoint The linear index of the reciprocal grid point f.
+	 *
+	 *  @return The linear index of the reciprocal grid point -f. */
+	unsigned int getInvertedGridPoint(unsigned int gridPoint) const;
+
+	/** Forward transform.
+	 *
+	 *  @param in Function indexed by mesh point.
+	 *  @param out Array that on return contains the transform indexed by
+	 *  reciprocal grid point. Can be the same as in. */
+	void forward(const std::complex<double> *in, std::complex<double> *out);
+
+	/** Inverse transform.
+	 *
+	 *  @param in Transform indexed by reciprocal grid point.
+	 *  @param out Array that on return contains the function indexed by
+	 *  mesh point. Can be the same as in. */
+	void inverse(const std::complex<double> *in, std::complex<double> *out);
+private:
+	/** Grid point for each mesh point. */
+	std::vector<unsigned int> gridPoints;
+
+	/** Inverted grid point for each grid point. */
+	std::vector<unsigned int> invertedGridPoints;
+
+	/** Input buffer for the plans. */
+	std::vector<std::complex<double>> input;
+
+	/** Output buffer for the plans. */
+	std::vector<std::complex<double>> output;
+
+	/** Plan for the forward transform. */
+	FourierTransform::ForwardPlan<std::complex<double>> *forwardPlan;
+
+	/** Plan for the inverse transform. */
+	FourierTransform::InversePlan<std::complex<double>> *inversePlan;
+};
+
+inline unsigned int MomentumSpaceFourierTransform::getSize() const{
+	return gridPoints.size();
+}
+
+inline unsigned int MomentumSpaceFourierTransform::getGridPoint(
+	unsigned int meshPoint
+) const{
+	return gridPoints[meshPoint];
+}
+
+inline unsigned int MomentumSpaceFourierTransform::getInvertedGridPoint(
+	unsigned int gridPoint
+) const{
+	return invertedGridPoints[gridPoint];
+}
+
+};	//End of namespace TBTK
+
+#endif
@@ -30,6 +30,7 @@
 #include "TBTK/RPA/LindhardSusceptibilityCalculator.h"
 
 #include <complex>
+#include <vector>
 
 //#include <omp.h>
 
@@ -52,10 +53,14 @@ public:
 	 *  used after the generating master have been destructed. */
 	RPASusceptibilityCalculator* createSlave();
 
-	/** Precompute susceptibilities. Will calculate the susceptibility for
-	 *  all values using a parallel algorithm. Can speed up calculations if
-	 *  most of the susceptibilities are needed. */
-	void precompute(unsigned int numWorkers = 129);
+	/** Precompute the charge and spin RPA susceptibilities, and the RPA
+	 *  susceptibility if interaction amplitudes have been set using
+	 *  setInteractionAmplitudes(), for every point in the mesh. The bare
+	 *  susceptibilities are calculated first, after which the RPA
+	 *  equations for all k-points and energies are solved in parallel.
+	 *  Can speed up calculations if most of the susceptibilities are
+	 *  needed. */
+	void precompute();
 
 	const MomentumSpaceContext& getMomentumSpaceContext() const;
 
@@ -212,24 +217,87 @@ private:
 		const std::vector<int> &orbitalIndices
 	) const;
 
-	/** Invert matix. */
-	void invertMatrix(std::complex<double> *matrix, unsigned int dimensions);
+	/** Workspace used to solve the RPA equation for a single energy. */
+	class Workspace{
+	public:
+		/** Denominator matrix. Overwritten by its LU factorization. */
+		std::vector<std::complex<double>> denominator;
 
-	/** Multiply matrices. */
-	void multiplyMatrices(
-		std::complex<double> *matrix1,
-		std::complex<double> *matrix2,
-		std::complex<double> *result,
-		unsigned int dimensions
+		/** Pivot indices for the LU factorization. */
+		std::vector<int> pivots;
+	};
+
+	/** Workspaces, one per thread. Allocated on first use and reused
+	 *  for every energy and k-point. */
+	std::vector<Workspace> workspaces;
+
+	/** Allocate one workspace per thread, if not already done. */
+	void initWorkspaces();
+
+	/** Get the bare susceptibility for all combinations of orbital
+	 *  indices. The result is stored as one column-major matrix per
+	 *  energy, with the element chi_0[a, b, d, c] on row
+	 *  numOrbitals*a + b and column numOrbitals*c + d. */
+	void getBareSusceptibilityMatrices(
+		const DualIndex &kDual,
+		std::vector<std::complex<double>> &bareSusceptibilities
+	);
+
+	/** Generate the matrix U such that the denominator in the RPA
+	 *  equation is 1 + U\chi_0, with \chi_0 on the format returned by
+	 *  getBareSusceptibilityMatrices(). */
+	void generateInteractionMatrix(
+		const std::vector<InteractionAmplitude> &interactionAmplitudes,
+		std::vector<std::complex<double>> &interactionMatrix
+	) const;
+
+	/** Solve the RPA equation \chi_RPA = \chi_0(1 + U\chi_0)^{-1} for a
+	 *  single energy. The denominator is LU factorized and the transpose
+	 *  of the equation is solved for all orbital indices at once, which
+	 *  avoids the explicit inversion. The result is stored in
+	 *  rpaSusceptibility with the element \chi_RPA[a, b, c, d] at
+	 *  position numOrbitals^2*(numOrbitals*a + b) + numOrbitals*c + d. */
+	void solveRPAEquation(
+		const std::complex<double> *interactionMatrix,
+		const std::complex<double> *bareSusceptibility,
+		std::complex<double> *rpaSusceptibility,
+		Workspace &workspace
+	) const;
+
+	/** RPA-susceptibility main algorithm. Solves the RPA equation for
+	 *  all energies in parallel. */
+	void rpaSusceptibilityMainAlgorithm(
+		const std::vector<std::complex<double>> &bareSusceptibilities,
+		const std::vector<InteractionAmplitude> &interactionAmpltiudes,
+		std::vector<std::complex<double>> &rpaSusceptibilities
 	);
 
-	/** RPA-susceptibility main algorithm. */
-	std::vector<std::vector<std::vector<std::complex<double>>>> rpaSusceptibilityMainAlgorithm(
+	/** Calculate the RPA susceptibility for all combinations of orbital
+	 *  indices at the given k-point, cache the result, and return the
+	 *  result for the requested orbital indices. */
+	std::vector<std::complex<double>> calculateRPASusceptibility(
 		const DualIndex &kDual,
 		const std::vector<int> &orbitalIndices,
-		const std::vector<InteractionAmplitude> &interactionAmpltiudes
+		const std::vector<InteractionAmplitude> &interactionAmplitudes,
+		IndexedDataTree<SerializableVector<std::complex<double>>> &tree,
+		bool useInversionSymmetry
+	);
+
+	/** Cache RPA susceptibilities on the format returned by
+	 *  rpaSusceptibilityMainAlgorithm(). If useInversionSymmetry is true,
+	 *  the results are also extended to -k using the symmetries of
+	 *  inversion symmetric imaginary energies. */
+	void cacheRPASusceptibilities(
+		const DualIndex &kDual,
+		const std::vector<std::complex<double>> &rpaSusceptibilities,
+		IndexedDataTree<SerializableVector<std::complex<double>>> &tree,
+		bool useInversionSymmetry
 	);
 
+	/** Returns true if the results can be extended to -k using the
+	 *  symmetries of inversion symmetric imaginary energies. */
+	bool getUseInversionSymmetry() const;
+
 	/** Interaction parameters. */
 	std::complex<double> U, Up, J, Jp;
 
@@ -250,6 +318,13 @@ inline void RPASusceptibilityCalculator::setInteractionAmplitudes(
 	this->interactionAmplitudes = interactionAmplitudes;
 }
 
+inline bool RPASusceptibilityCalculator::getUseInversionSymmetry() const{
+	return (
+		getEnergyType() == EnergyType::Imaginary
+		&& getEnergiesAreInversionSymmetric()
+	);
+}
+
 inline Index RPASusceptibilityCalculator::getSusceptibilityResultIndex(
 	const Index &kIndex,
 	const std::vector<int> &orbitalIndices
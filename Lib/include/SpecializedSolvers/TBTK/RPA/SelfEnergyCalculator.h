@@ -26,15 +26,28 @@
 #include "TBTK/BrillouinZone.h"
 #include "TBTK/IndexedDataTree.h"
 #include "TBTK/RPA/ElectronFluctuationVertexCalculator.h"
+#include "TBTK/RPA/SusceptibilityCalculator.h"
 
 namespace TBTK{
 
+class MomentumSpaceFourierTransform;
+
 class SelfEnergyCalculator{
 public:
-	/** Constructor. */
+	/** Constructor.
+	 *
+	 *  @param momentumSpaceContext The MomentumSpaceContext.
+	 *  @param numWorkers Number of workers.
+	 *  @param algorithm Algorithm::MatsubaraFFT evaluates the sum over q
+	 *  as a convolution using Fourier transforms, which calculates the
+	 *  self-energy for every k on the mesh at once and requires a nodal
+	 *  mesh and FFTW3. For any other algorithm, the sum over q is
+	 *  performed directly for each requested k. */
 	SelfEnergyCalculator(
 		const MomentumSpaceContext &momentumSpaceContext,
-		unsigned int numWorkers
+		unsigned int numWorkers,
+		SusceptibilityCalculator::Algorithm algorithm
+			= SusceptibilityCalculator::Algorithm::Lindhard
 	);
 
 	/** Destructor. */
@@ -46,6 +59,9 @@ public:
 	/** Initialize the SelfEnergyCalculator. */
 	void init();
 
+	/** Get the algorithm used to calculate the self-energy. */
+	SusceptibilityCalculator::Algorithm getAlgorithm() const;
+
 	/** Enum class for indicating whether the energy is an arbitrary comlex
 	 *  number, or if it is restricted to the real or imaginary axis. */
 //	enum class EnergyType {Real, Imaginary, Complex};
@@ -130,6 +146,9 @@ private:
 	/** Flag indicating whether the SelfEnergyCalculator is initialized. */
 	bool isInitialized;
 
+	/** Algorithm. */
+	SusceptibilityCalculator::Algorithm algorithm;
+
 	/** IndexedDataTree storing the self-energy. */
 	IndexedDataTree<SerializableVector<std::complex<double>>> selfEnergyTree;
 
@@ -141,6 +160,41 @@ private:
 		std::vector<std::complex<double>> &result
 	);
 
+	/** Self-energy main loop for Algorithm::MatsubaraFFT. Calculates and
+	 *  caches the self-energy for every k on the mesh. */
+	void selfEnergyMainLoopFFT(const std::vector<int> &orbitalIndices);
+
+	/** Fourier transformed Green's functions used by
+	 *  Algorithm::MatsubaraFFT. The transforms do not depend on the
+	 *  orbital indices of the self-energy and are therefore shared
+	 *  between calls. Contains one entry per pair of propagator orbitals,
+	 *  each storing the transforms for every energy in
+	 *  greensFunctionEnergies. Empty entries are not yet calculated. */
+	std::vector<std::vector<std::complex<double>>> greensFunctionTransforms;
+
+	/** Distinct energies for which the Green's functions are
+	 *  transformed. */
+	std::vector<std::complex<double>> greensFunctionEnergies;
+
+	/** Index into greensFunctionEnergies for every pair of summation
+	 *  energy and self-energy energy. */
+	std::vector<unsigned int> greensFunctionEnergyIndices;
+
+	/** Generate greensFunctionEnergies and greensFunctionEnergyIndices,
+	 *  and prepare greensFunctionTransforms for lazy evaluation. */
+	void initGreensFunctionTransforms();
+
+	/** Calculate the Fourier transformed Green's functions for the given
+	 *  pair of propagator orbitals. */
+	void calculateGreensFunctionTransforms(
+		unsigned int propagatorStart,
+		unsigned int propagatorEnd,
+		MomentumSpaceFourierTransform &momentumSpaceFourierTransform
+	);
+
+	/** Clear the Fourier transformed Green's functions. */
+	void clearGreensFunctionTransforms();
+
 	/** Interaction parameters. */
 	std::complex<double> U, Up, J, Jp;
 };
@@ -150,6 +204,11 @@ inline const MomentumSpaceContext& SelfEnergyCalculator::getMomentumSpaceContext
 	return electronFluctuationVertexCalculators[0]->getMomentumSpaceContext();
 }
 
+inline SusceptibilityCalculator::Algorithm SelfEnergyCalculator::getAlgorithm(
+) const{
+	return algorithm;
+}
+
 inline void SelfEnergyCalculator::setNumSummationEnergies(
 	unsigned int numSummationEnergies
 ){
@@ -172,6 +231,7 @@ inline void SelfEnergyCalculator::setSelfEnergyEnergies(
 ){
 	this->selfEnergyEnergies = selfEnergyEnergies;
 	selfEnergyTree.clear();
+	clearGreensFunctionTransforms();
 }
 
 inline void SelfEnergyCalculator::setU(std::complex<double> U){
@@ -236,6 +296,12 @@ inline void SelfEnergyCalculator::setJp(std::complex<double> Jp){
 	susceptibilityCalculator.precompute(numWorkers);
 }*/
 
+inline void SelfEnergyCalculator::clearGreensFunctionTransforms(){
+	greensFunctionTransforms.clear();
+	greensFunctionEnergies.clear();
+	greensFunctionEnergyIndices.clear();
+}
+
 inline void SelfEnergyCalculator::saveSusceptibilities(
 	const std::string &filename
 ) const{
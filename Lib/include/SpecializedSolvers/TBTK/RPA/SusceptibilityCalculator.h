@@ -23,6 +23,7 @@
 #ifndef COM_DAFER45_TBTK_SUSCEPTIBILITY_CALCULATOR
 #define COM_DAFER45_TBTK_SUSCEPTIBILITY_CALCULATOR
 
+#include "TBTK/Communicator.h"
 #include "TBTK/RPA/DualIndex.h"
 #include "TBTK/IndexedDataTree.h"
 #include "TBTK/InteractionAmplitude.h"
@@ -38,7 +39,7 @@
 
 namespace TBTK{
 
-class SusceptibilityCalculator{
+class SusceptibilityCalculator : public Communicator{
 public:
 	/** List of algorithm identifiers. Officilly supported algorithms are
 	 *  given unique identifiers. Algorithms not (yet) supported should
@@ -48,7 +49,8 @@ public:
 	 *  algorithms that are not (yet) supported. */
 	enum Algorithm {
 		Lindhard = 0,
-		Matsubara = 1
+		Matsubara = 1,
+		MatsubaraFFT = 2
 	};
 
 	/** Constructor. */
@@ -137,10 +139,10 @@ public:
 	bool getEnergiesAreInversionSymmetric() const;
 
 	/** Save susceptibilities. */
-	void saveSusceptibilities(const std::string &filename) const;
+	virtual void saveSusceptibilities(const std::string &filename) const;
 
 	/** Load susceptibilities. */
-	void loadSusceptibilities(const std::string &filename);
+	virtual void loadSusceptibilities(const std::string &filename);
 protected:
 	/** Slave constructor. */
 	SusceptibilityCalculator(
@@ -28,6 +28,7 @@
 #include "TBTK/Index.h"
 #include "TBTK/IndexTree.h"
 
+#include <atomic>
 #include <complex>
 #include <tuple>
 
@@ -79,8 +80,10 @@ private:
 		 *  cell index, while the second index is the unit cell index */
 		std::vector<std::tuple<std::complex<double>, Index, Index>> overlaps;
 
-		/** Flag indicating whether overlaps is sorted. */
-		bool overlapsIsSorted;
+		/** Flag indicating whether overlaps is sorted. Atomic since
+		 *  cloned states share Storage, which therefore can be sorted
+		 *  lazily from several threads. */
+		std::atomic<bool> overlapsIsSorted;
 
 		/** IndexTree used to speed up lookup in overlaps. */
 //		IndexTree *overlapsIndexTree;
@@ -93,8 +96,9 @@ private:
 		 *  intra cell index, while the second index is the unit cell index */
 		std::vector<std::tuple<std::complex<double>, Index, Index>> matrixElements;
 
-		/** Flag indicating whether matrixElements is sorted. */
-		bool matrixElementsIsSorted;
+		/** Flag indicating whether matrixElements is sorted. Atomic
+		 *  for the same reason as overlapsIsSorted. */
+		std::atomic<bool> matrixElementsIsSorted;
 
 		/** IndexTree used to speed up lookup in matrixElements. */
 //		IndexTree *matrixElementsIndexTree;
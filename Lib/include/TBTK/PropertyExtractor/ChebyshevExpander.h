@@ -25,6 +25,7 @@
 
 #include "TBTK/Solver/ChebyshevExpander.h"
 #include "TBTK/Property/Density.h"
+#include "TBTK/Property/DOS.h"
 #include "TBTK/Property/GreensFunction.h"
 #include "TBTK/Property/LDOS.h"
 #include "TBTK/Property/Magnetization.h"
@@ -33,6 +34,8 @@
 
 #include <initializer_list>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 namespace TBTK{
 namespace PropertyExtractor{
@@ -40,6 +43,11 @@ namespace PropertyExtractor{
 /** Experimental class for extracting properties from a ChebyshevExpander. */
 class ChebyshevExpander : public PropertyExtractor{
 public:
+	/** Enum class for specifying the kernel used to damp the Chebyshev
+	 *  moments in the stochastic (kernel polynomial method) calculation
+	 *  of the DOS and LDOS. */
+	enum class Kernel {Jackson, Lorentz};
+
 	/** Constructor. */
 	ChebyshevExpander(
 		Solver::ChebyshevExpander &cSolver,
@@ -59,6 +67,75 @@ public:
 		int energyResolution
 	);
 
+	/** Set the number of random vectors used to stochastically evaluate
+	 *  the trace in calculateDOS() and, if enabled, the LDOS.
+	 *
+	 *  @param numRandomVectors The number of random vectors. */
+	void setNumRandomVectors(unsigned int numRandomVectors);
+
+	/** Get the number of random vectors used for stochastic evaluation.
+	 *
+	 *  @return The number of random vectors. */
+	unsigned int getNumRandomVectors() const;
+
+	/** Set the kernel used to damp the Chebyshev moments in the
+	 *  stochastic calculations.
+	 *
+	 *  @param kernel The kernel to use. */
+	void setKernel(Kernel kernel);
+
+	/** Get the kernel used in the stochastic calculations.
+	 *
+	 *  @return The kernel. */
+	Kernel getKernel() const;
+
+	/** Set whether the LDOS should be calculated stochastically. If
+	 *  enabled, the LDOS for all requested Indices is calculated from a
+	 *  single set of random vectors, which is much cheaper than
+	 *  calculating the diagonal Green's function for each Index when
+	 *  the number of Indices is large. The result is an estimate with a
+	 *  statistical error that decreases as
+	 *  \f$1/\sqrt{\textrm{numRandomVectors}}\f$.
+	 *
+	 *  @param useStochasticLDOS True to use stochastic evaluation. */
+	void setUseStochasticLDOS(bool useStochasticLDOS);
+
+	/** Get whether the LDOS is calculated stochastically.
+	 *
+	 *  @return True if the LDOS is calculated stochastically. */
+	bool getUseStochasticLDOS() const;
+
+	/** Set whether the trace in calculateDOS() should be evaluated
+	 *  stochastically. If disabled (default), the DOS is the exact trace
+	 *  of the LDOS, which requires one expansion per basis state. If
+	 *  enabled, the trace is estimated using the kernel polynomial
+	 *  method with getNumRandomVectors() random phase vectors, which is
+	 *  much cheaper for large models.
+	 *
+	 *  @param useStochasticDOS True to use stochastic evaluation. */
+	void setUseStochasticDOS(bool useStochasticDOS);
+
+	/** Get whether the trace in calculateDOS() is evaluated
+	 *  stochastically.
+	 *
+	 *  @return True if the trace is evaluated stochastically. */
+	bool getUseStochasticDOS() const;
+
+	/** Overrides PropertyExtractor::calculateDOS(). The DOS is the trace
+	 *  of the LDOS, evaluated exactly or stochastically depending on
+	 *  setUseStochasticDOS(). */
+	virtual Property::DOS calculateDOS();
+
+	/** Calculate the DOS and estimate the statistical error from the
+	 *  spread between the random vectors.
+	 *
+	 *  @param standardError DOS that on return contains the estimated
+	 *  standard error of the returned DOS. The standard error is zero if
+	 *  the trace is evaluated exactly or only one random vector is used.
+	 *
+	 *  @return The DOS. */
+	Property::DOS calculateDOS(Property::DOS &standardError);
+
 	/** Calculate Green's function. */
 //	Property::GreensFunction* calculateGreensFunction(
 	Property::GreensFunction calculateGreensFunction(
@@ -109,10 +186,14 @@ public:
 		std::initializer_list<Index> patterns
 	);
 
-	/** Overrides PropertyExtractor::calculateLDOS(). */
+	/** Overrides PropertyExtractor::calculateLDOS(). The Indices are
+	 *  collected into blocks that are expanded together, which requires
+	 *  the callbacks to be executed serially. Parallel execution is
+	 *  therefore ignored by this function. */
 	virtual Property::LDOS calculateLDOS(Index pattern, Index ranges);
 
-	/** Overrides PropertyExtractor::calculateLDOS(). */
+	/** Overrides PropertyExtractor::calculateLDOS(). Parallel execution
+	 *  is ignored, see calculateLDOS(Index pattern, Index ranges). */
 	virtual Property::LDOS calculateLDOS(
 		std::initializer_list<Index> pattern
 	);
@@ -145,6 +226,21 @@ private:
 	 *  functions. */
 	bool useGPUToGenerateGreensFunctions;
 
+	/** Default number of random vectors. */
+	static constexpr unsigned int DEFAULT_NUM_RANDOM_VECTORS = 10;
+
+	/** Number of random vectors used in stochastic calculations. */
+	unsigned int numRandomVectors;
+
+	/** Kernel used in stochastic calculations. */
+	Kernel kernel;
+
+	/** Flag indicating whether the LDOS is calculated stochastically. */
+	bool useStochasticLDOS;
+
+	/** Flag indicating whether the DOS is calculated stochastically. */
+	bool useStochasticDOS;
+
 	/** !!!Not tested!!! Callback for calculating density.
 	 *  Used by calculateDensity. */
 	static void calculateDensityCallback(
@@ -181,10 +277,84 @@ private:
 		int offset
 	);
 
+	/** Indices and offsets for which calculateLDOSCallback() has
+	 *  requested the LDOS, but for which it has not yet been calculated.
+	 */
+	std::vector<std::pair<Index, int>> ldosBatch;
+
+	/** Calculate the LDOS for all Indices in ldosBatch, stochastically
+	 *  if useStochasticLDOS is set, and clear the batch.
+	 *
+	 *  @param ldos Pointer to the LDOS data. */
+	void calculateLDOSBatch(double *ldos);
+
+	/** Calculate the LDOS for all Indices in ldosBatch using
+	 *  Solver::ChebyshevExpander::calculateCoefficientsBlock() and clear
+	 *  the batch.
+	 *
+	 *  @param ldos Pointer to the LDOS data. */
+	void calculateExactLDOSBatch(double *ldos);
+
+	/** Calculate the LDOS for all Indices in ldosBatch stochastically
+	 *  using Solver::ChebyshevExpander::calculateStochasticMoments() and
+	 *  clear the batch.
+	 *
+	 *  @param ldos Pointer to the LDOS data. */
+	void calculateStochasticLDOSBatch(double *ldos);
+
+	/** Multiply the moments by the kernel and reconstruct the density
+	 *  \f$\rho(E)\f$ on the energy grid.
+	 *
+	 *  @param moments Pointer to numCoefficients moments.
+	 *  @param density Pointer to energyResolution values that on return
+	 *  contains the density. */
+	void reconstructDensity(const double *moments, double *density) const;
+
 	/** Ensure that the lookup table is in a ready state. */
 	void ensureLookupTableIsReady();
 };
 
+inline void ChebyshevExpander::setNumRandomVectors(
+	unsigned int numRandomVectors
+){
+	TBTKAssert(
+		numRandomVectors > 0,
+		"PropertyExtractor::ChebyshevExpander::setNumRandomVectors()",
+		"Argument numRandomVectors has to be a positive number.",
+		""
+	);
+
+	this->numRandomVectors = numRandomVectors;
+}
+
+inline unsigned int ChebyshevExpander::getNumRandomVectors() const{
+	return numRandomVectors;
+}
+
+inline void ChebyshevExpander::setKernel(Kernel kernel){
+	this->kernel = kernel;
+}
+
+inline ChebyshevExpander::Kernel ChebyshevExpander::getKernel() const{
+	return kernel;
+}
+
+inline void ChebyshevExpander::setUseStochasticLDOS(bool useStochasticLDOS){
+	this->useStochasticLDOS = useStochasticLDOS;
+}
+
+inline bool ChebyshevExpander::getUseStochasticLDOS() const{
+	return useStochasticLDOS;
+}
+
+inline void ChebyshevExpander::setUseStochasticDOS(bool useStochasticDOS){
+	this->useStochasticDOS = useStochasticDOS;
+}
+
+inline bool ChebyshevExpander::getUseStochasticDOS() const{
+	return useStochasticDOS;
+}
+
 };	//End of namespace PropertyExtractor
 };	//End of namespace TBTK
 
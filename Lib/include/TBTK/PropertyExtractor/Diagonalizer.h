@@ -36,6 +36,7 @@
 
 #include <complex>
 #include <initializer_list>
+#include <vector>
 
 namespace TBTK{
 namespace PropertyExtractor{
@@ -190,6 +191,64 @@ private:
 		int offset
 	);
 
+	/** Number of rows of the precomputed tables that are handled
+	 *  together when looping over the eigenstates. */
+	static constexpr unsigned int ROW_BLOCK_SIZE = 1024;
+
+	/** Maps basis indices to rows in the precomputed tables. Basis
+	 *  indices without a row are mapped to -1. */
+	std::vector<int> basisToRow;
+
+	/** Precomputed density (one element per row) or LDOS (one element
+	 *  per energy and row, with the row index running fastest). */
+	std::vector<double> realTable;
+
+	/** Precomputed magnetization (four elements per row). */
+	std::vector<std::complex<double>> complexTable;
+
+	/** Calculate the occupation of each eigenstate, using the
+	 *  statistics, chemical potential, and temperature of the Model. */
+	std::vector<double> calculateOccupations();
+
+	/** Get all Indices stored in an IndexTree. */
+	static std::vector<Index> getIndices(const IndexTree &indexTree);
+
+	/** Assign a row in the precomputed tables to each of the given
+	 *  Indices and set up basisToRow. Indices with the same basis index
+	 *  share a row and Indices that do not correspond to a basis index
+	 *  are ignored.
+	 *
+	 *  @param indices The Indices.
+	 *
+	 *  @return The basis index of each row. */
+	std::vector<int> setupRows(const std::vector<Index> &indices);
+
+	/** Precompute the density for the given Indices. The density is
+	 *  calculated for all Indices at once as weighted norms of the rows
+	 *  of the eigenvector matrix, which results in a single contiguous
+	 *  pass over each eigenvector. Used by calculateDensityCallback. */
+	void tabulateDensity(const std::vector<Index> &indices);
+
+	/** Precompute the magnetization for the given Indices. Used by
+	 *  calculateMAGCallback.
+	 *
+	 *  @param indices The Indices.
+	 *  @param spinSubindices The position of the spin subindex for each
+	 *  Index. */
+	void tabulateMagnetization(
+		const std::vector<Index> &indices,
+		const std::vector<int> &spinSubindices
+	);
+
+	/** Precompute the LDOS for the given Indices. The eigenvalues are
+	 *  binned once, after which the weights of the eigenstates are
+	 *  histogrammed for all Indices at once. Used by
+	 *  calculateLDOSCallback. */
+	void tabulateLDOS(const std::vector<Index> &indices);
+
+	/** Release the precomputed tables. */
+	void clearTables();
+
 	/** Solver::Diagonalizer to work on. */
 	Solver::Diagonalizer *dSolver;
 };
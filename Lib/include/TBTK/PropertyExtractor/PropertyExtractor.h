@@ -34,6 +34,11 @@
 
 #include <complex>
 #include <initializer_list>
+#include <vector>
+
+#ifdef TBTK_USE_OPEN_MP
+#include <omp.h>
+#endif
 
 namespace TBTK{
 namespace PropertyExtractor{
@@ -225,7 +230,27 @@ public:
 
 	/** Calculate entropy. */
 	virtual double calculateEntropy();
+
+	/** Set whether the callbacks used to calculate properties should be
+	 *  executed in parallel. Indices that are written to the same memory
+	 *  location are handled by the same thread, in the same order as for
+	 *  serial execution. If there are fewer such groups than threads,
+	 *  thread-private copies of the property are accumulated instead.
+	 *  Should only be enabled for PropertyExtractors with thread safe
+	 *  callbacks. Enabled by default for the Diagonalizer and
+	 *  BlockDiagonalizer.
+	 *
+	 *  @param parallelExecution True to enable parallel execution. */
+	void setParallelExecution(bool parallelExecution);
+
+	/** Get whether parallel execution is enabled.
+	 *
+	 *  @return True if parallel execution is enabled. */
+	bool getParallelExecution() const;
 protected:
+	/** Flag indicating whether callbacks are executed in parallel. */
+	bool parallelExecution;
+
 	/** Default energy resolution. */
 	static constexpr int ENERGY_RESOLUTION = 1000;
 
@@ -260,6 +285,25 @@ protected:
 		int offsetMultiplier
 	);
 
+	/** Same as calculate() above, but writes to the data of an
+	 *  AbstractProperty. When executed in parallel, indices that share
+	 *  an offset, such as those summed over using IDX_SUM_ALL, are
+	 *  accumulated in thread-private copies of the data. */
+	template<typename DataType>
+	void calculate(
+		void (*callback)(
+			PropertyExtractor *cb_this,
+			void *memory,
+			const Index &index,
+			int offset
+		),
+		Property::AbstractProperty<DataType> &abstractProperty,
+		Index pattern,
+		const Index &ranges,
+		int currentOffset,
+		int offsetMultiplier
+	);
+
 	/** Loops over the indices satisfying the specified patterns and calls
 	 *  the appropriate callback function to calculate the correct
 	 *  quantity. */
@@ -281,6 +325,53 @@ protected:
 	 *  calculate[Property]Callback. */
 	void *hint;
 
+	/** Recursively collects the indices and offsets that are looped over
+	 *  by calculate(). Takes the same arguments as calculate(). */
+	void getIndicesAndOffsets(
+		Index pattern,
+		const Index &ranges,
+		int currentOffset,
+		int offsetMultiplier,
+		std::vector<Index> &indices,
+		std::vector<int> &offsets
+	);
+
+	/** Calls the callback for each index in parallel, letting a single
+	 *  thread handle all indices with the same offset. */
+	void calculateInParallel(
+		void (*callback)(
+			PropertyExtractor *cb_this,
+			void *memory,
+			const Index &index,
+			int offset
+		),
+		void *memory,
+		const std::vector<Index> &indices,
+		const std::vector<int> &offsets
+	);
+
+	/** Same as calculateInParallel() above, but uses thread-private
+	 *  copies of the data to accumulate the result when there are fewer
+	 *  distinct offsets than threads. */
+	template<typename DataType>
+	void calculateInParallel(
+		void (*callback)(
+			PropertyExtractor *cb_this,
+			void *memory,
+			const Index &index,
+			int offset
+		),
+		DataType *data,
+		unsigned int size,
+		const std::vector<Index> &indices,
+		const std::vector<int> &offsets
+	);
+
+	/** Get the number of distinct offsets. */
+	static unsigned int getNumDistinctOffsets(
+		const std::vector<int> &offsets
+	);
+
 	/** Ensure that range indices are on compliant format. (Set range to
 	 *  one for indices with non-negative pattern value.) */
 	void ensureCompliantRanges(const Index &pattern, Index &ranges);
@@ -302,6 +393,52 @@ protected:
 	);
 };
 
+template<typename DataType>
+void PropertyExtractor::calculate(
+	void (*callback)(
+		PropertyExtractor *cb_this,
+		void *memory,
+		const Index &index,
+		int offset
+	),
+	Property::AbstractProperty<DataType> &abstractProperty,
+	Index pattern,
+	const Index &ranges,
+	int currentOffset,
+	int offsetMultiplier
+){
+	std::vector<Index> indices;
+	std::vector<int> offsets;
+	getIndicesAndOffsets(
+		pattern,
+		ranges,
+		currentOffset,
+		offsetMultiplier,
+		indices,
+		offsets
+	);
+
+	if(parallelExecution){
+		calculateInParallel(
+			callback,
+			abstractProperty.getDataRW(),
+			abstractProperty.getSize(),
+			indices,
+			offsets
+		);
+	}
+	else{
+		for(unsigned int n = 0; n < indices.size(); n++){
+			callback(
+				this,
+				abstractProperty.getDataRW(),
+				indices[n],
+				offsets[n]
+			);
+		}
+	}
+}
+
 template<typename DataType>
 void PropertyExtractor::calculate(
 	void (*callback)(
@@ -343,6 +480,10 @@ void PropertyExtractor::calculate(
 
 		it.searchNext();
 	}*/
+	std::vector<Index> indices;
+	std::vector<int> offsets;
+	std::vector<int> spinSubindices;
+	bool hasUniqueSpinSubindex = true;
 	IndexTree::Iterator it = allIndices.begin();
 	while(!it.getHasReachedEnd()){
 		Index index = it.getIndex();
@@ -358,18 +499,104 @@ void PropertyExtractor::calculate(
 				"Zero or several spin indeces found.",
 				"Use IDX_SPIN once and only once per pattern to indicate spin index."
 			);
-			*spinIndexHint = spinIndices.at(0);
+			spinSubindices.push_back(spinIndices.at(0));
+			if(spinSubindices.back() != spinSubindices.front())
+				hasUniqueSpinSubindex = false;
 		}
 
-		callback(
-			this,
+		offsets.push_back(abstractProperty.getOffset(index));
+		indices.push_back(std::move(index));
+
+		it.searchNext();
+	}
+
+	//The spin index is passed to the callbacks through a shared hint,
+	//which requires serial execution unless it is the same for all
+	//indices.
+	if(!parallelExecution || !hasUniqueSpinSubindex){
+		for(unsigned int n = 0; n < indices.size(); n++){
+			if(spinIndexHint != nullptr)
+				*spinIndexHint = spinSubindices[n];
+
+			callback(
+				this,
+				abstractProperty.getDataRW(),
+				indices[n],
+				offsets[n]
+			);
+		}
+	}
+	else{
+		if(spinIndexHint != nullptr && spinSubindices.size() != 0)
+			*spinIndexHint = spinSubindices[0];
+
+		calculateInParallel(
+			callback,
 			abstractProperty.getDataRW(),
-			index,
-			abstractProperty.getOffset(index)
+			abstractProperty.getSize(),
+			indices,
+			offsets
 		);
+	}
+}
 
-		it.searchNext();
+template<typename DataType>
+void PropertyExtractor::calculateInParallel(
+	void (*callback)(
+		PropertyExtractor *cb_this,
+		void *memory,
+		const Index &index,
+		int offset
+	),
+	DataType *data,
+	unsigned int size,
+	const std::vector<Index> &indices,
+	const std::vector<int> &offsets
+){
+	unsigned int numThreads = 1;
+#ifdef TBTK_USE_OPEN_MP
+	numThreads = omp_get_max_threads();
+#endif
+	if(numThreads == 1 || getNumDistinctOffsets(offsets) >= numThreads){
+		calculateInParallel(callback, (void*)data, indices, offsets);
+
+		return;
+	}
+
+	//Few distinct offsets, for example when summing over all indices.
+	//Accumulate into thread-private copies of the data and add them up
+	//afterwards.
+	std::vector<std::vector<DataType>> buffers(numThreads);
+	#pragma omp parallel
+	{
+		unsigned int thread = 0;
+#ifdef TBTK_USE_OPEN_MP
+		thread = omp_get_thread_num();
+#endif
+		buffers[thread].resize(size);
+
+		#pragma omp for schedule(dynamic)
+		for(unsigned int n = 0; n < indices.size(); n++){
+			callback(
+				this,
+				buffers[thread].data(),
+				indices[n],
+				offsets[n]
+			);
+		}
 	}
+
+	for(unsigned int t = 0; t < numThreads; t++)
+		for(unsigned int n = 0; n < buffers[t].size(); n++)
+			data[n] += buffers[t][n];
+}
+
+inline void PropertyExtractor::setParallelExecution(bool parallelExecution){
+	this->parallelExecution = parallelExecution;
+}
+
+inline bool PropertyExtractor::getParallelExecution() const{
+	return parallelExecution;
 }
 
 };	//End of namespace PropertyExtractor
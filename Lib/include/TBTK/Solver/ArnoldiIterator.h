@@ -28,6 +28,8 @@
 #include "TBTK/Solver/Solver.h"
 
 #include <complex>
+#include <memory>
+#include <vector>
 
 namespace TBTK{
 namespace Solver{
@@ -90,6 +92,38 @@ public:
 	/** Run the implicitly restarted Arnoldi algorithm. */
 	void run();
 
+	/** Eigenvalues and eigenvectors calculated around a central value.
+	 */
+	class EigenPairs{
+	public:
+		/** Central value around which the eigenpairs were calculated.
+		 */
+		double centralValue;
+
+		/** Eigenvalues in ascending order. */
+		std::vector<std::complex<double>> eigenValues;
+
+		/** Eigenvectors, stored one after the other in the same order
+		 *  as the eigenvalues. Empty if eigenvectors are not
+		 *  calculated. */
+		std::vector<std::complex<double>> eigenVectors;
+	};
+
+	/** Run the implicitly restarted Arnoldi algorithm in
+	 *  Mode::ShiftAndInvert once for each central value. The matrices
+	 *  (H - centralValue) have the same sparsity pattern, so the symbolic
+	 *  analysis of the LU factorization is only performed for the first
+	 *  central value. After the call, the eigenvalues and eigenvectors
+	 *  accessible through the ArnoldiIterator are those for the last
+	 *  central value.
+	 *
+	 *  @param centralValues The central values to calculate eigenpairs
+	 *  around.
+	 *
+	 *  @return The eigenpairs for each central value, in the same order
+	 *  as centralValues. */
+	std::vector<EigenPairs> run(const std::vector<double> &centralValues);
+
 	/** Get eigenValues. */
 	const std::complex<double>* getEigenValues() const;
 
@@ -140,6 +174,9 @@ private:
 	/** LUSolver. */
 	LUSolver luSolver;
 
+	/** Hamiltonian on CSR format. Used in normal mode. */
+	std::shared_ptr<const SparseMatrix<std::complex<double>>> hamiltonian;
+
 	/** Initialize solver for normal mode. Setting up SuperLU. (SuperLU
 	 *  routine). */
 	void initNormal();
@@ -177,27 +214,6 @@ private:
 	/** Sort eigen values and eigen vectors in accending order according to
 	 *  the real part of the eigen values. */
 	void sort();
-
-	/** Merge sort helper function for ArnoldiIterator::sort(). */
-	void mergeSortSplit(
-		std::complex<double> *dataIn,
-		std::complex<double> *dataOut,
-		int *orderIn,
-		int *orderOut,
-		int first,
-		int end
-	);
-
-	/** Merge sort helper function for ArnoldiIterator::sort(). */
-	void mergeSortMerge(
-		std::complex<double> *dataIn,
-		std::complex<double> *dataOut,
-		int *orderIn,
-		int *orderOut,
-		int first,
-		int middle,
-		int end
-	);
 };
 
 inline void ArnoldiIterator::setMode(Mode mode){
@@ -24,11 +24,13 @@
 #define COM_DAFER45_TBTK_SOLVER_BLOCK_DIAGONALIZER
 
 #include "TBTK/Communicator.h"
+#include "TBTK/EigenSolutionCache.h"
 #include "TBTK/Model.h"
 #include "TBTK/Solver/Solver.h"
 #include "TBTK/Timer.h"
 
 #include <complex>
+#include <vector>
 
 namespace TBTK{
 namespace Solver{
@@ -59,6 +61,16 @@ public:
 	/** Set maximum number of iterations for the self-consistency loop. */
 	void setMaxIterations(int maxIterations);
 
+	/** Set an EigenSolutionCache to load and store solutions from and
+	 *  to. If the hash of the Model (see Model::getHash()) matches a
+	 *  cached solution, the eigenvalues and eigenvectors are loaded from
+	 *  the cache instead of being calculated. Newly calculated solutions
+	 *  are stored in the cache.
+	 *
+	 *  @param eigenSolutionCache The cache to use. Set to NULL to disable
+	 *  caching. */
+	void setEigenSolutionCache(EigenSolutionCache *eigenSolutionCache);
+
 	/** Run calculations. Diagonalizes ones if no self-consistency callback
 	 *  have been set, or otherwise multiple times until slef-consistencey
 	 *  or maximum number of iterations has been reached. */
@@ -98,6 +110,22 @@ public:
 
 	/** Set whether parallel execution is enabled or not. */
 	void setParallelExecution(bool parallelExecution);
+
+	/** Set the number of states above which a block is considered large.
+	 *  Large blocks are diagonalized one at a time using the divide and
+	 *  conquer routine zheevd, leaving the parallelization to a
+	 *  multithreaded BLAS. Smaller blocks are diagonalized using zhpev
+	 *  and, if parallel execution is enabled, distributed over the
+	 *  threads with the most expensive blocks first.
+	 *
+	 *  @param largeBlockThreshold The smallest number of states for
+	 *  which a block is considered large. */
+	void setLargeBlockThreshold(unsigned int largeBlockThreshold);
+
+	/** Get the number of states above which a block is considered large.
+	 *
+	 *  @return The large block threshold. */
+	unsigned int getLargeBlockThreshold() const;
 private:
 	/** pointer to array containing Hamiltonian. */
 	std::complex<double> *hamiltonian;
@@ -132,12 +160,50 @@ private:
 	/** Number of blocks in the Hamiltonian. */
 	int numBlocks;
 
+	/** Cache for eigenvalues and eigenvectors. */
+	EigenSolutionCache *eigenSolutionCache;
+
 	/** Maximum number of iterations in the self-consistency loop. */
 	int maxIterations;
 
 	/** Flag indicating wether to enable parallel execution. */
 	bool parallelExecution;
 
+	/** Default value for largeBlockThreshold. */
+	static constexpr unsigned int DEFAULT_LARGE_BLOCK_THRESHOLD = 256;
+
+	/** Smallest number of states for which a block is diagonalized using
+	 *  zheevd. */
+	unsigned int largeBlockThreshold;
+
+	/** LAPACK workspace. */
+	class Workspace{
+	public:
+		/** Complex workspace. */
+		std::vector<std::complex<double>> work;
+
+		/** Real workspace. */
+		std::vector<double> rwork;
+
+		/** Integer workspace. */
+		std::vector<int> iwork;
+	};
+
+	/** Workspaces used for small blocks, one per thread. Allocated when
+	 *  first needed and reused in every iteration of the
+	 *  self-consistency loop. */
+	std::vector<Workspace> smallBlockWorkspaces;
+
+	/** Workspace used for large blocks. */
+	Workspace largeBlockWorkspace;
+
+	/** Blocks that are diagonalized using zheevd. */
+	std::vector<unsigned int> largeBlocks;
+
+	/** Blocks that are diagonalized using zhpev, sorted by decreasing
+	 *  size. */
+	std::vector<unsigned int> smallBlocks;
+
 	/** Callback function to call each time a diagonalization has been
 	 *  completed. */
 	bool (*selfConsistencyCallback)(BlockDiagonalizer &blockDiagonalizer);
@@ -148,8 +214,27 @@ private:
 	/** Updates Hamiltonian. */
 	void update();
 
+	/** Sorts the blocks into large and small blocks and allocates the
+	 *  workspaces. */
+	void initSchedule();
+
+	/** Ensures that there are at least numWorkspaces small block
+	 *  workspaces.
+	 *
+	 *  @param numWorkspaces The number of workspaces. */
+	void resizeSmallBlockWorkspaces(unsigned int numWorkspaces);
+
 	/** Diagonalizes the Hamiltonian. */
 	void solve();
+
+	/** Diagonalizes a large block using zheevd. */
+	void solveLargeBlock(unsigned int block);
+
+	/** Diagonalizes a small block using zhpev.
+	 *
+	 *  @param block The block to diagonalize.
+	 *  @param workspace Workspace to use. */
+	void solveSmallBlock(unsigned int block, Workspace &workspace);
 };
 
 inline void BlockDiagonalizer::setSelfConsistencyCallback(
@@ -164,6 +249,12 @@ inline void BlockDiagonalizer::setMaxIterations(int maxIterations){
 	this->maxIterations = maxIterations;
 }
 
+inline void BlockDiagonalizer::setEigenSolutionCache(
+	EigenSolutionCache *eigenSolutionCache
+){
+	this->eigenSolutionCache = eigenSolutionCache;
+}
+
 inline const std::complex<double> BlockDiagonalizer::getAmplitude(
 	int state,
 	const Index &index
@@ -247,6 +338,16 @@ inline void BlockDiagonalizer::setParallelExecution(
 	this->parallelExecution = parallelExecution;
 }
 
+inline void BlockDiagonalizer::setLargeBlockThreshold(
+	unsigned int largeBlockThreshold
+){
+	this->largeBlockThreshold = largeBlockThreshold;
+}
+
+inline unsigned int BlockDiagonalizer::getLargeBlockThreshold() const{
+	return largeBlockThreshold;
+}
+
 };	//End of namespace Solver
 };	//End of namespace TBTK
 
@@ -28,8 +28,12 @@
 #include "TBTK/Communicator.h"
 #include "TBTK/Model.h"
 #include "TBTK/Solver/Solver.h"
+#include "TBTK/SparseMatrix.h"
+#include "TBTK/TBTKMacros.h"
 
 #include <complex>
+#include <memory>
+#include <vector>
 #ifndef __APPLE__
 #	include <omp.h>
 #endif
@@ -65,6 +69,18 @@ public:
 	/** Get scale factor. */
 	double getScaleFactor();
 
+	/** Set the number of source vectors that are advanced together by
+	 *  calculateCoefficientsBlock().
+	 *
+	 *  @param blockSize The number of source vectors in each block. */
+	void setBlockSize(unsigned int blockSize);
+
+	/** Get the number of source vectors that are advanced together by
+	 *  calculateCoefficientsBlock().
+	 *
+	 *  @return The number of source vectors in each block. */
+	unsigned int getBlockSize() const;
+
 	/** Calculates the Chebyshev coefficients for \f$ G_{ij}(E)\f$, where
 	 *  \f$i = \textrm{to}\f$ is a set of indices and \f$j =
 	 *  \textrm{from}\f$. Runs on CPU.
@@ -139,6 +155,66 @@ public:
 		double broadening = 0.000001
 	);
 
+	/** Calculates the Chebyshev coefficients for \f$ G_{ij}(E)\f$ for
+	 *  each pair of indices \f$i = \textrm{to[n]}\f$ and \f$j =
+	 *  \textrm{from[n]}\f$. Runs on CPU. Up to getBlockSize() expansions
+	 *  are performed simultaneously using sparse matrix-dense matrix
+	 *  multiplications, which amortizes the cost of reading the
+	 *  Hamiltonian from memory over the whole block. This is more
+	 *  efficient than repeated calls to calculateCoefficients() when many
+	 *  'from'-indices are needed, such as when calculating the LDOS.
+	 *  @param to vector of 'to'-indices, or \f$i\f$'s.
+	 *  @param from vector of 'from'-indices, or \f$j\f$'s. Must have the
+	 *  same size as 'to'.
+	 *  @param coefficients Pointer to array able to hold
+	 *  numCoefficients\f$\times\f$to.size() coefficients. The
+	 *  coefficients for the n:th pair of indices starts at
+	 *  n*numCoefficients.
+	 *  @param numCoefficients Number of coefficients to calculate for each
+	 *  pair of indices.
+	 *  @param broadening Broadening to use in convolusion of coefficients
+	 *  to remedy Gibb's osciallations.
+	 */
+	void calculateCoefficientsBlock(
+		const std::vector<Index> &to,
+		const std::vector<Index> &from,
+		std::complex<double> *coefficients,
+		int numCoefficients,
+		double broadening = 0.000001
+	);
+
+	/** Calculates Chebyshev moments stochastically using random phase
+	 *  vectors \f$|r\rangle\f$, with components \f$e^{i\phi}\f$ where
+	 *  \f$\phi\f$ is uniformly distributed. Runs on CPU. For each random
+	 *  vector, the moments \f$\mu_n = \langle r|T_n(H/s)|r\rangle\f$ are
+	 *  calculated, which are unbiased estimates of
+	 *  \f$\textrm{Tr}[T_n(H/s)]\f$. The random vectors are advanced in
+	 *  blocks of getBlockSize() vectors. The cost is
+	 *  \f$O(RNM)\f$, where \f$R\f$ is the number of random vectors,
+	 *  \f$N\f$ is the size of the basis, and \f$M\f$ is the number of
+	 *  moments.
+	 *  @param numRandomVectors Number of random vectors to use.
+	 *  @param numCoefficients Number of moments to calculate.
+	 *  @param moments Pointer to array able to hold
+	 *  numRandomVectors\f$\times\f$numCoefficients moments. The moments
+	 *  for the r:th random vector start at r*numCoefficients.
+	 *  @param localIndices Indices for which local moments
+	 *  \f$\overline{\langle r|i\rangle\langle i|T_n(H/s)|r\rangle}\f$,
+	 *  averaged over the random vectors, also should be calculated.
+	 *  @param localMoments Pointer to array able to hold
+	 *  localIndices.size()\f$\times\f$numCoefficients moments. Can be
+	 *  NULL if localIndices is empty.
+	 *  @param seed Seed for the random number generator.
+	 */
+	void calculateStochasticMoments(
+		unsigned int numRandomVectors,
+		int numCoefficients,
+		double *moments,
+		const std::vector<Index> &localIndices = {},
+		double *localMoments = NULL,
+		unsigned int seed = 0
+	);
+
 	/** Experimental. */
 	void calculateCoefficientsWithCutoff(
 		Index to,
@@ -149,19 +225,43 @@ public:
 		double broadening = 0.000001
 	);
 
+	/** Enum class for specifying how the lookup table generated by
+	 *  generateLookupTable() stores the generating functions. */
+	enum class LookupTableStorage{
+		/** numCoefficients x energyResolution complex<double>. */
+		Double,
+		/** numCoefficients x energyResolution complex<float>, which
+		 *  halves the memory footprint at single precision accuracy.
+		 */
+		Float,
+		/** Only the energy dependent prefactor and the phase
+		 *  \f$e^{-i\arccos(E)}\f$ are stored, requiring
+		 *  2 x energyResolution complex<double>. The generating
+		 *  functions are generated on the fly by recurrence in the
+		 *  coefficient index, at the cost of one additional complex
+		 *  multiplication per term. */
+		Recurrence
+	};
+
 	/** Generate lokup table for quicker generation of multiple Green's
-	 *  functions. Required if evaluation is to be performed on GPU.
+	 *  functions. Required if evaluation is to be performed on GPU. The
+	 *  lookup table is shared read-only between all ChebyshevExpanders
+	 *  that generate a lookup table with the same parameters and scale
+	 *  factor, and is freed when the last of them releases it.
 	 *  @param numCoefficeints Number of coefficients used in Chebyshev
+	 *  expansion.
+	 *  @param energyResolution Number of energy points.
 	 *  @param lowerBound Lower bound, has to be larger or equal to
 	 *  -scaleFactor set by setScaleFactor (default value 1).
 	 *  @param upperBound Upper bound, has to be smaller or equal to
 	 *  scaleFactor setBy setScaleFactor (default value 1).
-	 *  expansion.*/
+	 *  @param storage The storage format to use for the lookup table. */
 	void generateLookupTable(
 		int numCoefficeints,
 		int energyResolution,
 		double lowerBound = -1.,
-		double upperBound = 1.
+		double upperBound = 1.,
+		LookupTableStorage storage = LookupTableStorage::Double
 	);
 
 	/** Free memory allocated by ChebyshevExpander::generateLookupTable(). */
@@ -212,6 +312,68 @@ public:
 		Type type = Type::Retarded
 	);
 
+	/** Generate Green's function on the Chebyshev nodes
+	 *  \f$E_k = s\cos(\pi(k + 1/2)/K)\f$, \f$k = 0, ..., K-1\f$, where
+	 *  \f$s\f$ is the scale factor and \f$K\f$ is the energy
+	 *  resolution. On these nodes the Chebyshev series is a discrete
+	 *  Fourier transform of the coefficients and is evaluated using a
+	 *  fast Fourier transform in \f$O((M + K)\log(M + K))\f$ time and
+	 *  \f$O(M + K)\f$ memory, where \f$M\f$ is the number of
+	 *  coefficients. Does not use the lookup table. Runs on CPU.
+	 *  Requires FFTW3.
+	 *  @param coefficients Chebyshev coefficients calculated by
+	 *  ChebyshevExpander::calculateCoefficients.
+	 *  @param numCoefficients Number of coefficients in coefficients.
+	 *  @param energyResolution Number of Chebyshev nodes \f$K\f$.
+	 *  @param type The Green's function type.
+	 *
+	 *  @return Array with energyResolution elements, in the order of
+	 *  decreasing energy given by getChebyshevNodes(). */
+	std::complex<double>* generateGreensFunctionOnChebyshevNodes(
+		const std::complex<double> *coefficients,
+		int numCoefficients,
+		int energyResolution,
+		Type type = Type::Retarded
+	);
+
+	/** Get the energies of the Chebyshev nodes used by
+	 *  generateGreensFunctionOnChebyshevNodes().
+	 *  @param energyResolution Number of Chebyshev nodes.
+	 *
+	 *  @return The energies in decreasing order. */
+	std::vector<double> getChebyshevNodes(int energyResolution) const;
+
+	/** Genererate Green's function on the same uniform energy grid as
+	 *  generateGreensFunction() without lookup table, but using a fast
+	 *  Fourier transform. The series is evaluated on a grid of
+	 *  Chebyshev nodes that oversamples the expansion by a factor
+	 *  FFT_OVERSAMPLING and is resampled onto the uniform grid using
+	 *  cubic interpolation in \f$\theta = \arccos(E/s)\f$, in which the
+	 *  series is a smooth trigonometric polynomial. The singular prefactor
+	 *  is evaluated exactly at each energy. Runs in
+	 *  \f$O(M\log(M) + E)\f$ time and \f$O(M + E)\f$ memory, where
+	 *  \f$M\f$ is the number of coefficients and \f$E\f$ the energy
+	 *  resolution. Runs on CPU. Requires FFTW3.
+	 *  @param coefficients Chebyshev coefficients calculated by
+	 *  ChebyshevExpander::calculateCoefficients.
+	 *  @param numCoefficeints Number of coefficients in coefficients.
+	 *  @param energyResolution Number of elements in greensFunction.
+	 *  @param lowerBound Lower bound, has to be larger than -scaleFactor
+	 *  set by setScaleFactor (default value 1).
+	 *  @param upperBound Upper bound, has to be smaller than scaleFactor
+	 *  set by setScaleFactor (default value 1).
+	 *  @param type The Green's function type.
+	 *
+	 *  @return Array with energyResolution elements. */
+	std::complex<double>* generateGreensFunctionFFT(
+		const std::complex<double> *coefficients,
+		int numCoefficients,
+		int energyResolution,
+		double lowerBound = -1.,
+		double upperBound = 1.,
+		Type type = Type::Retarded
+	);
+
 	/** Genererate Green's function. Uses lookup table generated by
 	 *  ChebyshevExpander::generateLookupTable. Runs on CPU.
 	 *  @param greensFunction Pointer to array able to hold Green's
@@ -273,12 +435,112 @@ private:
 	/** Scale factor. */
 	double scaleFactor;
 
+	/** Default number of source vectors in each block used by
+	 *  calculateCoefficientsBlock(). */
+	static constexpr unsigned int DEFAULT_BLOCK_SIZE = 16;
+
+	/** Number of source vectors in each block used by
+	 *  calculateCoefficientsBlock(). */
+	unsigned int blockSize;
+
 	/** Damping mask. */
 	std::complex<double> *damping;
 
-	/** Pointer to lookup table used to speed up evaluation of multiple
-	 *  Green's functions. */
-	std::complex<double> **generatingFunctionLookupTable;
+	/** Lookup table for the generating functions
+	 *  \f$g_n(E) = -2ie^{-in\arccos(E/s)}/(sd_n\sqrt{1 - (E/s)^2})\f$,
+	 *  where \f$d_0 = 2\f$ and \f$d_n = 1\f$ otherwise. The table is
+	 *  independent of the Green's function type and is never modified
+	 *  after construction, which allows it to be shared between
+	 *  ChebyshevExpanders. */
+	class LookupTable{
+	public:
+		/** Constructor. */
+		LookupTable(
+			int numCoefficients,
+			int energyResolution,
+			double lowerBound,
+			double upperBound,
+			double scaleFactor,
+			LookupTableStorage storage
+		);
+
+		/** Get a lookup table with the given parameters. Returns the
+		 *  existing lookup table if one with the same parameters is
+		 *  in use by any ChebyshevExpander, and otherwise generates a
+		 *  new one. */
+		static std::shared_ptr<const LookupTable> get(
+			int numCoefficients,
+			int energyResolution,
+			double lowerBound,
+			double upperBound,
+			double scaleFactor,
+			LookupTableStorage storage
+		);
+
+		/** Add the Green's function of the given type to
+		 *  greensFunction.
+		 *
+		 *  @param coefficients The Chebyshev coefficients.
+		 *  @param greensFunction Array with energyResolution elements
+		 *  to add the result to.
+		 *  @param type The Green's function type. */
+		void generateGreensFunction(
+			const std::complex<double> *coefficients,
+			std::complex<double> *greensFunction,
+			Type type
+		) const;
+
+		/** Write the generating functions to a dense array, with
+		 *  \f$g_n(E_e)\f$ stored at n*energyResolution + e.
+		 *
+		 *  @param table Array able to hold
+		 *  numCoefficients*energyResolution elements. */
+		void getDenseTable(std::complex<double> *table) const;
+	private:
+		/** Number of coefficients. */
+		int numCoefficients;
+
+		/** Energy resolution. */
+		int energyResolution;
+
+		/** Storage format. */
+		LookupTableStorage storage;
+
+		/** Generating functions for LookupTableStorage::Double. */
+		std::vector<std::complex<double>> doubleTable;
+
+		/** Generating functions for LookupTableStorage::Float. */
+		std::vector<std::complex<float>> floatTable;
+
+		/** Prefactors \f$-2i/(s\sqrt{1 - (E/s)^2})\f$ for
+		 *  LookupTableStorage::Recurrence. */
+		std::vector<std::complex<double>> prefactors;
+
+		/** Phases \f$e^{-i\arccos(E/s)}\f$ for
+		 *  LookupTableStorage::Recurrence. */
+		std::vector<std::complex<double>> phases;
+
+		/** Get the generating functions \f$g_n(E_e)\f$ for all
+		 *  energies. For LookupTableStorage::Recurrence, the rows
+		 *  have to be requested in order of increasing n, starting
+		 *  from zero, with powers initialized to the prefactors.
+		 *
+		 *  @param n The coefficient index.
+		 *  @param row Workspace with energyResolution elements.
+		 *  @param powers Running powers used by the recurrence.
+		 *
+		 *  @return Pointer to energyResolution generating functions.
+		 */
+		const std::complex<double>* getRow(
+			int n,
+			std::vector<std::complex<double>> &row,
+			std::vector<std::complex<double>> &powers
+		) const;
+	};
+
+	/** Lookup table used to speed up evaluation of multiple Green's
+	 *  functions. */
+	std::shared_ptr<const LookupTable> lookupTable;
 
 	/** Pointer to lookup table on GPU. */
 	std::complex<double> ***generatingFunctionLookupTable_device;
@@ -296,6 +558,95 @@ private:
 
 	/** Upper bound for energy used for the lookup table. */
 	double lookupTableUpperBound;
+
+	/** Factor by which the grid of Chebyshev nodes used by
+	 *  generateGreensFunctionFFT() oversamples the expansion. */
+	static constexpr unsigned int FFT_OVERSAMPLING = 16;
+
+	/** Evaluates the sums \f$\sum_n c_n e^{\mp in\theta_j}/d_n\f$, where
+	 *  \f$d_0 = 2\f$ and \f$d_n = 1\f$ otherwise, on the angles
+	 *  \f$\theta_j = \pi(j + 1/2)/K\f$, \f$j = 0, ..., 2K-1\f$, using
+	 *  a single fast Fourier transform of size \f$2K\f$. Coefficients
+	 *  with \f$n \geq 2K\f$ are folded back onto the transform without
+	 *  approximation.
+	 *  @param coefficients The Chebyshev coefficients \f$c_n\f$.
+	 *  @param numCoefficients Number of coefficients.
+	 *  @param numNodes The number of nodes \f$K\f$ in \f$[0, \pi]\f$.
+	 *  @param sign -1 for \f$e^{-in\theta}\f$ and 1 for
+	 *  \f$e^{in\theta}\f$.
+	 *  @param sums Vector that will be resized to \f$2K\f$ and filled
+	 *  with the sums. */
+	void calculateChebyshevSumsFFT(
+		const std::complex<double> *coefficients,
+		int numCoefficients,
+		int numNodes,
+		int sign,
+		std::vector<std::complex<double>> &sums
+	) const;
+
+	/** Combines the sums calculated by calculateChebyshevSumsFFT() into
+	 *  a Green's function value of the given type at a scaled energy.
+	 *  @param E The energy divided by the scale factor.
+	 *  @param retardedSum The sum for sign = -1.
+	 *  @param advancedSum The sum for sign = 1.
+	 *  @param type The Green's function type.
+	 *
+	 *  @return The Green's function at the energy. */
+	std::complex<double> combineChebyshevSums(
+		double E,
+		std::complex<double> retardedSum,
+		std::complex<double> advancedSum,
+		Type type
+	) const;
+
+	/** Performs one step of the Chebyshev recursion on CPU by calculating
+	 *  jResult = multiplier*H*jIn1 - jIn2, with the damping applied as in
+	 *  the rest of the recursion. The multiplication gathers over the rows
+	 *  of the Hamiltonian on CSR format and is parallelized over rows.
+	 *
+	 *  @param hamiltonian The Hamiltonian on CSR format.
+	 *  @param jIn1 The vector |j(n-1)>.
+	 *  @param jIn2 The vector |j(n-2)>. Pass NULL for the first step.
+	 *  @param jResult Array to write the result |j(n)> to.
+	 *  @param multiplier Factor to multiply the Hamiltonian by.
+	 *  @param coefficientMap Map from basis indices to the position in
+	 *  'coefficients' in which the corresponding element of |j(n)> is to
+	 *  be stored, or -1. Pass NULL to not extract any coefficients.
+	 *  @param coefficients Coefficients to store the elements of |j(n)>
+	 *  in.
+	 *  @param numCoefficients Number of coefficients per 'to'-index.
+	 *  @param n The order of the current step. */
+	void calculateChebyshevStep(
+		const SparseMatrix<std::complex<double>> &hamiltonian,
+		const std::complex<double> *jIn1,
+		const std::complex<double> *jIn2,
+		std::complex<double> *jResult,
+		double multiplier,
+		const int *coefficientMap,
+		std::complex<double> *coefficients,
+		int numCoefficients,
+		int n
+	) const;
+
+	/** Block version of calculateChebyshevStep(). Calculates jResult =
+	 *  multiplier*H*jIn1 - jIn2 for blockSize vectors simultaneously. The
+	 *  vectors are stored with the block index running fastest, such that
+	 *  element i of vector k is stored at i*blockSize + k.
+	 *
+	 *  @param hamiltonian The Hamiltonian on CSR format.
+	 *  @param jIn1 The vectors |j(n-1)>.
+	 *  @param jIn2 The vectors |j(n-2)>. Pass NULL for the first step.
+	 *  @param jResult Array to write the result |j(n)> to.
+	 *  @param blockSize Number of vectors in the block.
+	 *  @param multiplier Factor to multiply the Hamiltonian by. */
+	void calculateChebyshevBlockStep(
+		const SparseMatrix<std::complex<double>> &hamiltonian,
+		const std::complex<double> *jIn1,
+		const std::complex<double> *jIn2,
+		std::complex<double> *jResult,
+		unsigned int blockSize,
+		double multiplier
+	) const;
 };
 
 inline void ChebyshevExpander::setScaleFactor(double scaleFactor){
@@ -306,8 +657,23 @@ inline double ChebyshevExpander::getScaleFactor(){
 	return scaleFactor;
 }
 
+inline void ChebyshevExpander::setBlockSize(unsigned int blockSize){
+	TBTKAssert(
+		blockSize > 0,
+		"ChebyshevExpander::setBlockSize()",
+		"The block size must be larger than zero.",
+		""
+	);
+
+	this->blockSize = blockSize;
+}
+
+inline unsigned int ChebyshevExpander::getBlockSize() const{
+	return blockSize;
+}
+
 inline bool ChebyshevExpander::getLookupTableIsGenerated(){
-	if(generatingFunctionLookupTable != NULL)
+	if(lookupTable != nullptr)
 		return true;
 	else
 		return false;
@@ -24,10 +24,13 @@
 #define COM_DAFER45_TBTK_SOLVER_DIAGONALIZATION
 
 #include "TBTK/Communicator.h"
+#include "TBTK/EigenSolutionCache.h"
 #include "TBTK/Model.h"
 #include "TBTK/Solver/Solver.h"
+#include "TBTK/TBTKMacros.h"
 
 #include <complex>
+#include <vector>
 
 namespace TBTK{
 namespace Solver{
@@ -41,6 +44,23 @@ namespace Solver{
  *  space. */
 class Diagonalizer : public Solver, public Communicator{
 public:
+	/** Enum class for selecting the LAPACK routine that is used to
+	 *  diagonalize the Hamiltonian. */
+	enum class Algorithm{
+		/** Packed upper triangular storage, diagonalized using
+		 *  zhpev. Requires the least amount of memory. */
+		Packed,
+		/** Full storage, diagonalized using the divide and conquer
+		 *  routine zheevd. Typically much faster than Packed for
+		 *  large matrices, since it can make use of multithreaded
+		 *  BLAS-3 routines. */
+		DivideAndConquer,
+		/** Full storage, diagonalized using the MRRR routine zheevr.
+		 *  Supports calculating only the eigenpairs in an energy
+		 *  window or index range. */
+		MRRR
+	};
+
 	/** Constructor */
 	Diagonalizer();
 
@@ -58,6 +78,119 @@ public:
 	/** Set maximum number of iterations for the self-consistency loop. */
 	void setMaxIterations(int maxIterations);
 
+	/** Set callbacks for a self-consistency loop driven by the
+	 *  Diagonalizer. The order parameter is represented by a vector of
+	 *  complex numbers. After each diagonalization,
+	 *  calculateOrderParameter is called to calculate the order
+	 *  parameter \f$F(x)\f$ from the current solution. The new input
+	 *  \f$x\f$ is then obtained through Anderson (Pulay/DIIS) mixing of
+	 *  the previous inputs and residuals \f$F(x) - x\f$ and passed to
+	 *  setOrderParameter, which is expected to update the order
+	 *  parameter that the HoppingAmplitude callbacks use. The loop stops
+	 *  when the largest relative change
+	 *  \f$|F(x)_n - x_n|/\max(|F(x)_n|, |x_n|)\f$ is smaller than the
+	 *  convergence limit or the maximum number of iterations is reached.
+	 *  The calculated order parameter \f$F(x)\f$ of the last iteration
+	 *  is available through getOrderParameter(). Cannot be
+	 *  combined with setSelfConsistencyCallback().
+	 *
+	 *  @param initialOrderParameter Initial guess for the order
+	 *  parameter.
+	 *  @param calculateOrderParameter Callback that calculates the order
+	 *  parameter from the current solution.
+	 *  @param setOrderParameter Callback that sets the order parameter
+	 *  used in the Hamiltonian. */
+	void setOrderParameterCallbacks(
+		const std::vector<std::complex<double>> &initialOrderParameter,
+		void (*calculateOrderParameter)(
+			Diagonalizer &diagonalizer,
+			std::vector<std::complex<double>> &orderParameter
+		),
+		void (*setOrderParameter)(
+			Diagonalizer &diagonalizer,
+			const std::vector<std::complex<double>> &orderParameter
+		)
+	);
+
+	/** Set the number of previous iterations used in the Anderson
+	 *  mixing. A history size of zero gives linear mixing.
+	 *
+	 *  @param mixingHistorySize The number of previous iterations. */
+	void setMixingHistorySize(unsigned int mixingHistorySize);
+
+	/** Set the mixing parameter \f$\beta\f$. For linear mixing, the new
+	 *  input is \f$x + \beta(F(x) - x)\f$.
+	 *
+	 *  @param mixingParameter The mixing parameter. */
+	void setMixingParameter(double mixingParameter);
+
+	/** Set the convergence limit for the largest relative change
+	 *  \f$|F(x)_n - x_n|/\max(|F(x)_n|, |x_n|)\f$ of the order parameter.
+	 *  Elements for which both \f$F(x)_n\f$ and \f$x_n\f$ are zero are
+	 *  considered converged.
+	 *
+	 *  @param convergenceLimit The convergence limit. */
+	void setConvergenceLimit(double convergenceLimit);
+
+	/** Get the Euclidean norm of the residual for each iteration of the
+	 *  last run of the order parameter driven self-consistency loop.
+	 *
+	 *  @return The residual norms. */
+	const std::vector<double>& getResidualNorms() const;
+
+	/** Get the order parameter calculated in the last iteration of the
+	 *  order parameter driven self-consistency loop.
+	 *
+	 *  @return The order parameter. */
+	const std::vector<std::complex<double>>& getOrderParameter() const;
+
+	/** Set an EigenSolutionCache to load and store solutions from and
+	 *  to. If the hash of the Model (see Model::getHash()) matches a
+	 *  cached solution, the eigenvalues and eigenvectors are loaded from
+	 *  the cache instead of being calculated. Newly calculated solutions
+	 *  are stored in the cache. Only used when all eigenpairs are
+	 *  calculated.
+	 *
+	 *  @param eigenSolutionCache The cache to use. Set to NULL to disable
+	 *  caching. */
+	void setEigenSolutionCache(EigenSolutionCache *eigenSolutionCache);
+
+	/** Set the algorithm used to diagonalize the Hamiltonian.
+	 *
+	 *  @param algorithm The algorithm to use. */
+	void setAlgorithm(Algorithm algorithm);
+
+	/** Get the algorithm used to diagonalize the Hamiltonian.
+	 *
+	 *  @return The algorithm. */
+	Algorithm getAlgorithm() const;
+
+	/** Only calculate eigenpairs with eigenvalues in the half-open
+	 *  interval (lowerBound, upperBound]. Requires Algorithm::MRRR.
+	 *
+	 *  @param lowerBound Lower bound of the energy window.
+	 *  @param upperBound Upper bound of the energy window. */
+	void setEigenValueWindow(double lowerBound, double upperBound);
+
+	/** Only calculate the eigenpairs with index first to last
+	 *  (inclusive), with eigenvalues sorted in ascending order and
+	 *  indices starting at zero. Requires Algorithm::MRRR.
+	 *
+	 *  @param first Index of the first eigenpair to calculate.
+	 *  @param last Index of the last eigenpair to calculate. */
+	void setEigenStateRange(int first, int last);
+
+	/** Calculate all eigenpairs (default). Removes any restriction set
+	 *  through setEigenValueWindow() or setEigenStateRange(). */
+	void setCalculateAllEigenStates();
+
+	/** Get the number of eigenpairs that were calculated in the last
+	 *  diagonalization. Equal to the basis size unless the calculation
+	 *  has been restricted to an energy window or index range.
+	 *
+	 *  @return The number of eigenvalues. */
+	int getNumEigenValues() const;
+
 	/** Run calculations. Diagonalizes ones if no self-consistency callback
 	 *  have been set, or otherwise multiple times until slef-consistencey
 	 *  or maximum number of iterations has been reached. */
@@ -87,7 +220,13 @@ public:
 	 */
 	const std::complex<double> getAmplitude(int state, const Index &index);
 private:
-	/** pointer to array containing Hamiltonian. */
+	/** Enum class for specifying which eigenpairs to calculate. */
+	enum class Range{All, EigenValueWindow, EigenStateRange};
+
+	/** pointer to array containing Hamiltonian. For
+	 *  Algorithm::DivideAndConquer the Hamiltonian is instead stored
+	 *  directly in the eigenvector array, which zheevd overwrites with
+	 *  the eigenvectors, and this pointer is NULL. */
 	std::complex<double> *hamiltonian;
 
 	/** Pointer to array containing eigenvalues.*/
@@ -96,6 +235,46 @@ private:
 	/** Pointer to array containing eigenvectors. */
 	std::complex<double> *eigenVectors;
 
+	/** Number of calculated eigenpairs. */
+	int numEigenValues;
+
+	/** Algorithm used to diagonalize the Hamiltonian. */
+	Algorithm algorithm;
+
+	/** Which eigenpairs to calculate. */
+	Range range;
+
+	/** Energy window used when range is Range::EigenValueWindow. */
+	double eigenValueWindow[2];
+
+	/** Index range used when range is Range::EigenStateRange. */
+	int eigenStateRange[2];
+
+	/** Complex workspace for LAPACK. Allocated once in init() and reused
+	 *  in each iteration of the self-consistency loop. */
+	std::complex<double> *work;
+
+	/** Size of work. */
+	int lwork;
+
+	/** Real workspace for LAPACK. */
+	double *rwork;
+
+	/** Size of rwork. */
+	int lrwork;
+
+	/** Integer workspace for LAPACK. */
+	int *iwork;
+
+	/** Size of iwork. */
+	int liwork;
+
+	/** Support of the eigenvectors, required by zheevr. */
+	int *isuppz;
+
+	/** Cache for eigenvalues and eigenvectors. */
+	EigenSolutionCache *eigenSolutionCache;
+
 	/** Maximum number of iterations in the self-consistency loop. */
 	int maxIterations;
 
@@ -105,9 +284,71 @@ private:
 		Diagonalizer &diagonalizer
 	);
 
+	/** Callback that calculates the order parameter from the current
+	 *  solution. */
+	void (*calculateOrderParameter)(
+		Diagonalizer &diagonalizer,
+		std::vector<std::complex<double>> &orderParameter
+	);
+
+	/** Callback that sets the order parameter used in the Hamiltonian. */
+	void (*setOrderParameter)(
+		Diagonalizer &diagonalizer,
+		const std::vector<std::complex<double>> &orderParameter
+	);
+
+	/** Initial order parameter. */
+	std::vector<std::complex<double>> initialOrderParameter;
+
+	/** Order parameter calculated in the last iteration. */
+	std::vector<std::complex<double>> orderParameter;
+
+	/** Default mixing history size. */
+	static constexpr unsigned int DEFAULT_MIXING_HISTORY_SIZE = 5;
+
+	/** Default mixing parameter. */
+	static constexpr double DEFAULT_MIXING_PARAMETER = 0.5;
+
+	/** Default convergence limit. */
+	static constexpr double DEFAULT_CONVERGENCE_LIMIT = 1e-6;
+
+	/** Number of previous iterations used in the Anderson mixing. */
+	unsigned int mixingHistorySize;
+
+	/** Mixing parameter. */
+	double mixingParameter;
+
+	/** Convergence limit for the norm of the residual. */
+	double convergenceLimit;
+
+	/** Residual norms for each iteration. */
+	std::vector<double> residualNorms;
+
 	/** Allocates space for Hamiltonian etc. */
 	void init();
 
+	/** Runs the self-consistency loop using the order parameter
+	 *  callbacks and Anderson mixing. */
+	void runOrderParameterLoop();
+
+	/** Calculate the next input using Anderson mixing.
+	 *
+	 *  @param inputs Previous inputs, with the most recent last.
+	 *  @param residuals Previous residuals, with the most recent last.
+	 *  @param result Vector that on return contains the next input. */
+	void mix(
+		const std::vector<std::vector<std::complex<double>>> &inputs,
+		const std::vector<std::vector<std::complex<double>>> &residuals,
+		std::vector<std::complex<double>> &result
+	) const;
+
+	/** Query LAPACK for the optimal workspace sizes for the selected
+	 *  algorithm and allocate the workspaces. */
+	void initWorkspaces();
+
+	/** Free the LAPACK workspaces. */
+	void freeWorkspaces();
+
 	/** Updates Hamiltonian. */
 	void update();
 
@@ -127,6 +368,97 @@ inline void Diagonalizer::setMaxIterations(int maxIterations){
 	this->maxIterations = maxIterations;
 }
 
+inline void Diagonalizer::setOrderParameterCallbacks(
+	const std::vector<std::complex<double>> &initialOrderParameter,
+	void (*calculateOrderParameter)(
+		Diagonalizer &diagonalizer,
+		std::vector<std::complex<double>> &orderParameter
+	),
+	void (*setOrderParameter)(
+		Diagonalizer &diagonalizer,
+		const std::vector<std::complex<double>> &orderParameter
+	)
+){
+	this->initialOrderParameter = initialOrderParameter;
+	this->calculateOrderParameter = calculateOrderParameter;
+	this->setOrderParameter = setOrderParameter;
+}
+
+inline void Diagonalizer::setMixingHistorySize(
+	unsigned int mixingHistorySize
+){
+	this->mixingHistorySize = mixingHistorySize;
+}
+
+inline void Diagonalizer::setMixingParameter(double mixingParameter){
+	this->mixingParameter = mixingParameter;
+}
+
+inline void Diagonalizer::setConvergenceLimit(double convergenceLimit){
+	this->convergenceLimit = convergenceLimit;
+}
+
+inline const std::vector<double>& Diagonalizer::getResidualNorms() const{
+	return residualNorms;
+}
+
+inline const std::vector<std::complex<double>>&
+Diagonalizer::getOrderParameter() const{
+	return orderParameter;
+}
+
+inline void Diagonalizer::setEigenSolutionCache(
+	EigenSolutionCache *eigenSolutionCache
+){
+	this->eigenSolutionCache = eigenSolutionCache;
+}
+
+inline void Diagonalizer::setAlgorithm(Algorithm algorithm){
+	this->algorithm = algorithm;
+}
+
+inline Diagonalizer::Algorithm Diagonalizer::getAlgorithm() const{
+	return algorithm;
+}
+
+inline void Diagonalizer::setEigenValueWindow(
+	double lowerBound,
+	double upperBound
+){
+	TBTKAssert(
+		lowerBound < upperBound,
+		"Diagonalizer::setEigenValueWindow()",
+		"Argument lowerBound has to be smaller than argument"
+		<< " upperBound.",
+		""
+	);
+
+	range = Range::EigenValueWindow;
+	eigenValueWindow[0] = lowerBound;
+	eigenValueWindow[1] = upperBound;
+}
+
+inline void Diagonalizer::setEigenStateRange(int first, int last){
+	TBTKAssert(
+		first >= 0 && first <= last,
+		"Diagonalizer::setEigenStateRange()",
+		"Invalid range [" << first << ", " << last << "].",
+		"The arguments must satisfy 0 <= first <= last."
+	);
+
+	range = Range::EigenStateRange;
+	eigenStateRange[0] = first;
+	eigenStateRange[1] = last;
+}
+
+inline void Diagonalizer::setCalculateAllEigenStates(){
+	range = Range::All;
+}
+
+inline int Diagonalizer::getNumEigenValues() const{
+	return numEigenValues;
+}
+
 inline const double* Diagonalizer::getEigenValues(){
 	return eigenValues;
 }
@@ -26,8 +26,10 @@
 #include "TBTK/Communicator.h"
 #include "TBTK/Matrix.h"
 #include "TBTK/SparseMatrix.h"
+#include "TBTK/TBTKMacros.h"
 
 #include <complex>
+#include <vector>
 
 #include "slu_zdefs.h"
 
@@ -47,19 +49,71 @@ public:
 	/** Destructor. */
 	~LUSolver();
 
-	/** Set matrix. */
+	/** Set matrix. If the matrix has the same sparsity pattern as the
+	 *  previously set matrix, the column permutation and the column
+	 *  elimination tree are reused and only the numerical factorization
+	 *  is performed. */
 	void setMatrix(const SparseMatrix<double> &sparseMatrix);
 
-	/** Set matrix. */
+	/** Set matrix. If the matrix has the same sparsity pattern as the
+	 *  previously set matrix, the column permutation and the column
+	 *  elimination tree are reused and only the numerical factorization
+	 *  is performed. */
 	void setMatrix(const SparseMatrix<std::complex<double>> &sparseMatrix);
 
+	/** Get whether the symbolic analysis was reused in the last call to
+	 *  setMatrix(). */
+	bool getSymbolicAnalysisWasReused() const;
+
 	/** Get matrix data type. */
 	DataType getMatrixDataType() const;
 
-	/** Solve. */
+	/** Set whether the factorization should be performed in SuperLU's
+	 *  SymmetricMode. The column permutation is then calculated using
+	 *  minimum degree ordering on the structure of A^T + A
+	 *  (MMD_AT_PLUS_A) and diagonal pivots are preferred (pivot
+	 *  threshold 0.001). This only exploits a symmetric sparsity
+	 *  pattern. The numerical values are not assumed to be symmetric and
+	 *  a full LU factorization is still performed, so no LDL^T type
+	 *  factorization is used for Hermitian or complex symmetric
+	 *  matrices. Can reduce the fill-in for matrices with a symmetric
+	 *  sparsity pattern and a large diagonal, such as (E - H). Takes
+	 *  effect at the next call to setMatrix().
+	 *
+	 *  @param symmetricMode True to enable symmetric mode. */
+	void setSymmetricMode(bool symmetricMode);
+
+	/** Get whether the factorization is performed in symmetric mode.
+	 *
+	 *  @return True if symmetric mode is enabled. */
+	bool getSymmetricMode() const;
+
+	/** Set the maximum number of right hand side columns that are passed
+	 *  to SuperLU in one triangular solve. Each block is solved as a
+	 *  whole, allowing the supernodal solve to use level 3 BLAS, while
+	 *  the block size bounds the size of the temporary workspace.
+	 *
+	 *  @param blockSize The maximum number of columns per block. */
+	void setBlockSize(unsigned int blockSize);
+
+	/** Get the maximum number of right hand side columns that are passed
+	 *  to SuperLU in one triangular solve.
+	 *
+	 *  @return The maximum number of columns per block. */
+	unsigned int getBlockSize() const;
+
+	/** Set whether the blocks of right hand side columns should be solved
+	 *  in parallel.
+	 *
+	 *  @param parallelExecution True to enable parallel execution. */
+	void setParallelExecution(bool parallelExecution);
+
+	/** Solve. The solution is calculated in place, directly on the data
+	 *  of 'b'. */
 	void solve(Matrix<double> &b);
 
-	/** Solve. */
+	/** Solve. The solution is calculated in place, directly on the data
+	 *  of 'b'. */
 	void solve(Matrix<std::complex<double>> &b);
 private:
 	/** Pointer to lower triangular matrix. */
@@ -80,6 +134,46 @@ private:
 	/** Get matrix data type. */
 	DataType matrixDataType;
 
+	/** Column elimination tree. */
+	std::vector<int> eliminationTree;
+
+	/** Column pointers for the sparsity pattern of the last factorized
+	 *  matrix. */
+	std::vector<unsigned int> patternColumnPointers;
+
+	/** Rows for the sparsity pattern of the last factorized matrix. */
+	std::vector<unsigned int> patternRows;
+
+	/** Flag indicating whether the symbolic analysis was reused in the
+	 *  last call to setMatrix(). */
+	bool symbolicAnalysisWasReused;
+
+	/** Flag indicating whether the factorization is performed in
+	 *  symmetric mode. */
+	bool symmetricMode;
+
+	/** Maximum number of right hand side columns per triangular solve. */
+	unsigned int blockSize;
+
+	/** Flag indicating whether the blocks of right hand side columns are
+	 *  solved in parallel. */
+	bool parallelExecution;
+
+	/** Workspaces used to split complex right hand sides into real and
+	 *  imaginary parts when the matrix is real. One per thread. */
+	std::vector<std::vector<double>> realWorkspaces;
+
+	/** Compare the sparsity pattern of a matrix on CSC format with the
+	 *  sparsity pattern of the last factorized matrix and store it as the
+	 *  new pattern. Returns true if the patterns are the same. */
+	bool updateSparsityPattern(
+		unsigned int numRows,
+		unsigned int numColumns,
+		unsigned int numMatrixElements,
+		const unsigned int *cscColumnPointers,
+		const unsigned int *cscRows
+	);
+
 	/** Allocate permutation matrices. */
 	void allocatePermutationMatrices(
 		unsigned int numRows,
@@ -95,11 +189,53 @@ private:
 	/** Initialize SuperLU options and permutation matrices. */
 	void initOptionsAndPermutationMatrices(
 		superlu_options_t &options,
-		SuperMatrix &matrix
+		SuperMatrix &matrix,
+		bool reuseSymbolicAnalysis
 	);
 
-	/** Perform LU factorization. */
-	void performLUFactorization(SuperMatrix &matrix);
+	/** Perform LU factorization. If reuseSymbolicAnalysis is true, the
+	 *  column permutation and column elimination tree from the previous
+	 *  factorization are used. */
+	void performLUFactorization(
+		SuperMatrix &matrix,
+		bool reuseSymbolicAnalysis
+	);
+
+	/** Get the number of blocks that numColumns right hand side columns
+	 *  are split into. */
+	unsigned int getNumBlocks(unsigned int numColumns) const;
+
+	/** Get whether the blocks should be solved in parallel. */
+	bool solveBlocksInParallel(unsigned int numBlocks) const;
+
+	/** Solve for a block of right hand side columns in place, using a
+	 *  real matrix. */
+	void solveBlock(
+		double *b,
+		unsigned int numRows,
+		unsigned int numColumns,
+		SuperLUStat_t &statistics
+	);
+
+	/** Solve for a block of right hand side columns in place, using a
+	 *  complex matrix. */
+	void solveBlock(
+		std::complex<double> *b,
+		unsigned int numRows,
+		unsigned int numColumns,
+		SuperLUStat_t &statistics
+	);
+
+	/** Solve for a block of complex right hand side columns in place,
+	 *  using a real matrix. The real and imaginary parts are packed into
+	 *  the workspace and solved for in a single triangular solve. */
+	void solveBlock(
+		std::complex<double> *b,
+		unsigned int numRows,
+		unsigned int numColumns,
+		std::vector<double> &workspace,
+		SuperLUStat_t &statistics
+	);
 
 	/** Check assertments for solve(). */
 	void checkSolveAssert(unsigned int numRows);
@@ -119,6 +255,41 @@ inline LUSolver::DataType LUSolver::getMatrixDataType() const{
 	return matrixDataType;
 }
 
+inline bool LUSolver::getSymbolicAnalysisWasReused() const{
+	return symbolicAnalysisWasReused;
+}
+
+inline bool LUSolver::getSymmetricMode() const{
+	return symmetricMode;
+}
+
+inline void LUSolver::setBlockSize(unsigned int blockSize){
+	TBTKAssert(
+		blockSize > 0,
+		"LUSolver::setBlockSize()",
+		"Invalid block size '" << blockSize << "'.",
+		"The block size must be larger than zero."
+	);
+
+	this->blockSize = blockSize;
+}
+
+inline unsigned int LUSolver::getBlockSize() const{
+	return blockSize;
+}
+
+inline void LUSolver::setParallelExecution(bool parallelExecution){
+	this->parallelExecution = parallelExecution;
+}
+
+inline unsigned int LUSolver::getNumBlocks(unsigned int numColumns) const{
+	return (numColumns + blockSize - 1)/blockSize;
+}
+
+inline bool LUSolver::solveBlocksInParallel(unsigned int numBlocks) const{
+	return parallelExecution && numBlocks > 1;
+}
+
 };	//End of namespace TBTK
 
 #endif
@@ -25,6 +25,7 @@
 
 #include "TBTK/Solver/Diagonalizer.h"
 #include "TBTK/Model.h"
+#include "TBTK/SparseMatrix.h"
 #include "TBTK/UnitHandler.h"
 
 #include <complex>
@@ -135,6 +136,77 @@ public:
 
 	/** Get orthogonalityError. */
 	double getOrthogonalityError();
+
+	/** Propagators:
+	 *	Euler - First order explicit update followed by normalization.
+	 *		Requires a small time step.
+	 *	CrankNicolson - Second order implicit update
+	 *		(1 + iHdt/2)Psi(t+dt) = (1 - iHdt/2)Psi(t). The linear
+	 *		system is solved iteratively using the sparse
+	 *		Hamiltonian.
+	 *	Chebyshev - Expansion of exp(-iHdt) in Chebyshev polynomials of
+	 *		the rescaled Hamiltonian. The number of terms is chosen
+	 *		to reach the propagation tolerance.
+	 *	Lanczos - Exponentiation of the Hamiltonian projected onto a
+	 *		Krylov subspace constructed for each state. The time
+	 *		step is subdivided if the Krylov subspace is too small to
+	 *		reach the propagation tolerance.
+	 *
+	 *  CrankNicolson, Chebyshev, and Lanczos are norm preserving up to the
+	 *  propagation tolerance and allow for considerably larger time
+	 *  steps than Euler. */
+	enum class Propagator{Euler, CrankNicolson, Chebyshev, Lanczos};
+
+	/** Set the propagator.
+	 *
+	 *  @param propagator The propagator to use. */
+	void setPropagator(Propagator propagator);
+
+	/** Get the propagator.
+	 *
+	 *  @return The propagator. */
+	Propagator getPropagator() const;
+
+	/** Set the tolerance for the CrankNicolson, Chebyshev, and Lanczos
+	 *  propagators.
+	 *
+	 *  @param propagationTolerance The maximal error per state and time
+	 *  step. */
+	void setPropagationTolerance(double propagationTolerance);
+
+	/** Get the propagation tolerance.
+	 *
+	 *  @return The propagation tolerance. */
+	double getPropagationTolerance() const;
+
+	/** Set the maximal dimension of the Krylov subspace used by the
+	 *  Lanczos propagator.
+	 *
+	 *  @param maxKrylovDimension The maximal Krylov dimension. */
+	void setMaxKrylovDimension(unsigned int maxKrylovDimension);
+
+	/** Get the maximal dimension of the Krylov subspace used by the
+	 *  Lanczos propagator.
+	 *
+	 *  @return The maximal Krylov dimension. */
+	unsigned int getMaxKrylovDimension() const;
+
+	/** Set whether only occupied states should be time evolved. If set
+	 *  to true, the states with zero occupancy are left untouched, which
+	 *  reduces the cost of each time step from being proportional to the
+	 *  basis size to being proportional to the number of occupied states.
+	 *  The eigenvalues of the unoccupied states are then not updated and
+	 *  the unoccupied states keep their positions, while the occupied
+	 *  states are sorted among themselves. Requires DecayMode::None.
+	 *
+	 *  @param propagateOccupiedStatesOnly True to only time evolve
+	 *  occupied states. */
+	void setPropagateOccupiedStatesOnly(bool propagateOccupiedStatesOnly);
+
+	/** Get whether only occupied states are time evolved.
+	 *
+	 *  @return True if only occupied states are time evolved. */
+	bool getPropagateOccupiedStatesOnly() const;
 private:
 	/** Diagonalizer which is used to find the ground state, and which also
 	 *  acts as a container for the eigenvectors and energies during the
@@ -226,6 +298,92 @@ private:
 
 	/** Calculate orthogonality error. */
 	void calculateOrthogonalityError();
+
+	/** Default propagation tolerance. */
+	static constexpr double DEFAULT_PROPAGATION_TOLERANCE = 1e-12;
+
+	/** Default maximal Krylov dimension. */
+	static constexpr unsigned int DEFAULT_MAX_KRYLOV_DIMENSION = 30;
+
+	/** Propagator. */
+	Propagator propagator;
+
+	/** Propagation tolerance. */
+	double propagationTolerance;
+
+	/** Maximal Krylov dimension. */
+	unsigned int maxKrylovDimension;
+
+	/** Flag indicating whether only occupied states are time evolved. */
+	bool propagateOccupiedStatesOnly;
+
+	/** Time evolve the states one time step using the CrankNicolson,
+	 *  Chebyshev, or Lanczos propagator, and update the eigenvalues to
+	 *  the energy expectation values of the evolved states.
+	 *
+	 *  @param hamiltonian The Hamiltonian. */
+	void propagate(const SparseMatrix<std::complex<double>> &hamiltonian);
+
+	/** Crank-Nicolson step for a block of states. The implicit equation
+	 *  is solved using the conjugate gradient method on the normal
+	 *  equations, which is guaranteed to converge since
+	 *  (1 + iHt/2)^{\dagger}(1 + iHt/2) = 1 + H^2t^2/4 is positive
+	 *  definite.
+	 *
+	 *  @param hamiltonian The Hamiltonian.
+	 *  @param states Block of states with the state index running
+	 *  fastest. Overwritten by the evolved states.
+	 *  @param numStates The number of states in the block.
+	 *  @param time The time step in natural units (t/hbar). */
+	void propagateCrankNicolson(
+		const SparseMatrix<std::complex<double>> &hamiltonian,
+		std::complex<double> *states,
+		unsigned int numStates,
+		double time
+	) const;
+
+	/** Chebyshev step for a block of states.
+	 *
+	 *  @param hamiltonian The Hamiltonian.
+	 *  @param states Block of states with the state index running
+	 *  fastest. Overwritten by the evolved states.
+	 *  @param numStates The number of states in the block.
+	 *  @param time The time step in natural units (t/hbar). */
+	void propagateChebyshev(
+		const SparseMatrix<std::complex<double>> &hamiltonian,
+		std::complex<double> *states,
+		unsigned int numStates,
+		double time
+	) const;
+
+	/** Lanczos step for a single state.
+	 *
+	 *  @param hamiltonian The Hamiltonian.
+	 *  @param state The state. Overwritten by the evolved state.
+	 *  @param time The time step in natural units (t/hbar). */
+	void propagateLanczos(
+		const SparseMatrix<std::complex<double>> &hamiltonian,
+		std::complex<double> *state,
+		double time
+	) const;
+
+	/** Calculate out = multiplier*(H - shift)*in for a block of states
+	 *  with the state index running fastest.
+	 *
+	 *  @param hamiltonian The Hamiltonian.
+	 *  @param in The input block.
+	 *  @param out The output block.
+	 *  @param numStates The number of states in the block.
+	 *  @param shift Energy shift.
+	 *  @param multiplier Multiplier. */
+	static void multiply(
+		const SparseMatrix<std::complex<double>> &hamiltonian,
+		const std::complex<double> *in,
+		std::complex<double> *out,
+		unsigned int numStates,
+		double shift = 0,
+		double multiplier = 1
+	);
 };
 
 inline void TimeEvolver::setCallback(
@@ -299,6 +457,42 @@ inline double TimeEvolver::getOrthogonalityError(){
 	return orthogonalityError;
 }
 
+inline void TimeEvolver::setPropagator(Propagator propagator){
+	this->propagator = propagator;
+}
+
+inline TimeEvolver::Propagator TimeEvolver::getPropagator() const{
+	return propagator;
+}
+
+inline void TimeEvolver::setPropagationTolerance(double propagationTolerance){
+	this->propagationTolerance = propagationTolerance;
+}
+
+inline double TimeEvolver::getPropagationTolerance() const{
+	return propagationTolerance;
+}
+
+inline void TimeEvolver::setMaxKrylovDimension(
+	unsigned int maxKrylovDimension
+){
+	this->maxKrylovDimension = maxKrylovDimension;
+}
+
+inline unsigned int TimeEvolver::getMaxKrylovDimension() const{
+	return maxKrylovDimension;
+}
+
+inline void TimeEvolver::setPropagateOccupiedStatesOnly(
+	bool propagateOccupiedStatesOnly
+){
+	this->propagateOccupiedStatesOnly = propagateOccupiedStatesOnly;
+}
+
+inline bool TimeEvolver::getPropagateOccupiedStatesOnly() const{
+	return propagateOccupiedStatesOnly;
+}
+
 };	//End of namespace Solver
 };	//End of namespace TBTK
 
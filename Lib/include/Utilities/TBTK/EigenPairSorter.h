@@ -0,0 +1,172 @@
+/* Copyright 2018 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file EigenPairSorter.h
+ *  @brief Sorts eigenpairs through permutations.
+ *
+ *  @author Kristofer Björnson
+ */
+
+#ifndef COM_DAFER45_TBTK_EIGEN_PAIR_SORTER
+#define COM_DAFER45_TBTK_EIGEN_PAIR_SORTER
+
+#include <algorithm>
+#include <complex>
+#include <vector>
+
+namespace TBTK{
+
+/** @brief Sorts eigenpairs through permutations.
+ *
+ *  The sort is performed on an array of indices, after which the resulting
+ *  permutation can be applied to any number of arrays, such as eigenvalues,
+ *  occupations, or arrays of pointers to eigenvectors. Eigenvectors can
+ *  thereby be reordered without moving their data. Complex eigenvalues are
+ *  ordered by their real part and equal values keep their original order.
+ */
+class EigenPairSorter{
+public:
+	/** Get the permutation that sorts the given values in ascending
+	 *  order. Element n of the permutation is the position in the
+	 *  original array of the value that is to be placed at position n.
+	 *
+	 *  @param values The values to sort.
+	 *  @param size The number of values.
+	 *
+	 *  @return The permutation. */
+	template<typename DataType>
+	static std::vector<unsigned int> getPermutation(
+		const DataType *values,
+		unsigned int size
+	);
+
+	/** Apply a permutation to an array, such that element n is replaced
+	 *  by element permutation[n].
+	 *
+	 *  @param data The array to permute.
+	 *  @param permutation The permutation. */
+	template<typename DataType>
+	static void permute(
+		DataType *data,
+		const std::vector<unsigned int> &permutation
+	);
+
+	/** Apply a permutation to an array of blocks of elements, such as an
+	 *  array of eigenvectors stored one after the other. Block n is
+	 *  replaced by block permutation[n].
+	 *
+	 *  @param data The array to permute.
+	 *  @param permutation The permutation.
+	 *  @param blockSize The number of elements in each block. */
+	template<typename DataType>
+	static void permute(
+		DataType *data,
+		const std::vector<unsigned int> &permutation,
+		unsigned int blockSize
+	);
+private:
+	/** Get the value to sort by. */
+	static double getSortKey(double value);
+
+	/** Get the value to sort by. */
+	static double getSortKey(const std::complex<double> &value);
+};
+
+template<typename DataType>
+inline std::vector<unsigned int> EigenPairSorter::getPermutation(
+	const DataType *values,
+	unsigned int size
+){
+	std::vector<unsigned int> permutation(size);
+	for(unsigned int n = 0; n < size; n++)
+		permutation[n] = n;
+
+	//Ties are broken by the original position, which makes the sort
+	//stable.
+	auto compare = [values](unsigned int lhs, unsigned int rhs){
+		double lhsKey = getSortKey(values[lhs]);
+		double rhsKey = getSortKey(values[rhs]);
+		if(lhsKey != rhsKey)
+			return lhsKey < rhsKey;
+		else
+			return lhs < rhs;
+	};
+
+	std::sort(permutation.begin(), permutation.end(), compare);
+
+	return permutation;
+}
+
+template<typename DataType>
+inline void EigenPairSorter::permute(
+	DataType *data,
+	const std::vector<unsigned int> &permutation
+){
+	std::vector<DataType> workspace(data, data + permutation.size());
+	for(unsigned int n = 0; n < permutation.size(); n++)
+		data[n] = workspace[permutation[n]];
+}
+
+template<typename DataType>
+inline void EigenPairSorter::permute(
+	DataType *data,
+	const std::vector<unsigned int> &permutation,
+	unsigned int blockSize
+){
+	//Follow the cycles of the permutation, which requires storage for a
+	//single block only.
+	std::vector<bool> isPlaced(permutation.size(), false);
+	std::vector<DataType> block(blockSize);
+	for(unsigned int start = 0; start < permutation.size(); start++){
+		if(isPlaced[start] || permutation[start] == start)
+			continue;
+
+		std::copy(
+			data + (size_t)start*blockSize,
+			data + (size_t)(start+1)*blockSize,
+			block.begin()
+		);
+		unsigned int current = start;
+		while(permutation[current] != start){
+			unsigned int next = permutation[current];
+			std::copy(
+				data + (size_t)next*blockSize,
+				data + (size_t)(next+1)*blockSize,
+				data + (size_t)current*blockSize
+			);
+			isPlaced[current] = true;
+			current = next;
+		}
+		std::copy(
+			block.begin(),
+			block.end(),
+			data + (size_t)current*blockSize
+		);
+		isPlaced[current] = true;
+	}
+}
+
+inline double EigenPairSorter::getSortKey(double value){
+	return value;
+}
+
+inline double EigenPairSorter::getSortKey(const std::complex<double> &value){
+	return real(value);
+}
+
+};	//End of namespace TBTK
+
+#endif
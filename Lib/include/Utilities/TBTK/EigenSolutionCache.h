@@ -0,0 +1,162 @@
+/* Copyright 2018 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file EigenSolutionCache.h
+ *  @brief On-disk cache for eigenvalues and eigenvectors.
+ *
+ *  @author Kristofer Björnson
+ */
+
+#ifndef COM_DAFER45_TBTK_EIGEN_SOLUTION_CACHE
+#define COM_DAFER45_TBTK_EIGEN_SOLUTION_CACHE
+
+#include <complex>
+#include <string>
+#include <vector>
+
+namespace TBTK{
+
+/** @brief On-disk cache for eigenvalues and eigenvectors.
+ *
+ *  Stores eigenvalues and eigenvectors in binary files in a given directory,
+ *  keyed on a hash of the Model that they were calculated for (see
+ *  Model::getHash()) together with the size of the solution. An index file
+ *  in the directory keeps track of the size of each entry and when it was
+ *  last used. When the total size of the entries exceeds the size budget,
+ *  the least recently used entries are removed.
+ *
+ *  The cache is used by Solver::Diagonalizer and Solver::BlockDiagonalizer
+ *  through their setEigenSolutionCache() functions. The directory has to
+ *  exist. */
+class EigenSolutionCache{
+public:
+	/** Constructor.
+	 *
+	 *  @param path Directory in which the cache is stored.
+	 *  @param maxSize Maximum total size in bytes of the cached
+	 *  solutions. */
+	EigenSolutionCache(const std::string &path, size_t maxSize);
+
+	/** Set the maximum total size in bytes of the cached solutions.
+	 *  Entries are removed immediately if the cache exceeds the new size.
+	 *
+	 *  @param maxSize The maximum size. */
+	void setMaxSize(size_t maxSize);
+
+	/** Get the maximum total size in bytes of the cached solutions.
+	 *
+	 *  @return The maximum size. */
+	size_t getMaxSize() const;
+
+	/** Get the total size in bytes of the cached solutions.
+	 *
+	 *  @return The size. */
+	size_t getSize();
+
+	/** Load a cached solution. The entry is marked as the most recently
+	 *  used entry.
+	 *
+	 *  @param hash The hash of the Model.
+	 *  @param numEigenValues The number of eigenvalues.
+	 *  @param numEigenVectorElements The number of elements in the
+	 *  eigenvector array.
+	 *  @param eigenValues Array that on success contains the eigenvalues.
+	 *  @param eigenVectors Array that on success contains the
+	 *  eigenvectors.
+	 *
+	 *  @return True if a solution with matching hash and sizes was found,
+	 *  otherwise false. */
+	bool load(
+		unsigned long long hash,
+		unsigned int numEigenValues,
+		size_t numEigenVectorElements,
+		double *eigenValues,
+		std::complex<double> *eigenVectors
+	);
+
+	/** Store a solution. Least recently used entries are removed if
+	 *  necessary to fit the solution within the size budget. Solutions
+	 *  that are larger than the budget are not stored.
+	 *
+	 *  @param hash The hash of the Model.
+	 *  @param numEigenValues The number of eigenvalues.
+	 *  @param numEigenVectorElements The number of elements in the
+	 *  eigenvector array.
+	 *  @param eigenValues The eigenvalues.
+	 *  @param eigenVectors The eigenvectors. */
+	void store(
+		unsigned long long hash,
+		unsigned int numEigenValues,
+		size_t numEigenVectorElements,
+		const double *eigenValues,
+		const std::complex<double> *eigenVectors
+	);
+
+	/** Remove all cached solutions. */
+	void clear();
+private:
+	/** Entry in the index. */
+	class Entry{
+	public:
+		/** Key formed from the hash of the Model and the size of the
+		 *  solution. */
+		unsigned long long key;
+
+		/** Size of the file in bytes. */
+		size_t size;
+
+		/** Value of the use counter when the entry was last used. */
+		unsigned long long lastUsed;
+	};
+
+	/** Directory in which the cache is stored. */
+	std::string path;
+
+	/** Maximum total size in bytes. */
+	size_t maxSize;
+
+	/** Get the name of the file that stores the solution for the given
+	 *  key. */
+	std::string getFilename(unsigned long long key) const;
+
+	/** Get the name of the index file. */
+	std::string getIndexFilename() const;
+
+	/** Read the index. A missing index file corresponds to an empty
+	 *  cache. */
+	void readIndex(
+		std::vector<Entry> &entries,
+		unsigned long long &useCounter
+	) const;
+
+	/** Write the index. */
+	void writeIndex(
+		const std::vector<Entry> &entries,
+		unsigned long long useCounter
+	) const;
+
+	/** Remove the least recently used entries until the total size is
+	 *  at most the given size. */
+	void evict(std::vector<Entry> &entries, size_t size);
+};
+
+inline size_t EigenSolutionCache::getMaxSize() const{
+	return maxSize;
+}
+
+};	//End of namespace TBTK
+
+#endif
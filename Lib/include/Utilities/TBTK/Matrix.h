@@ -103,6 +103,20 @@ public:
 	/** Get number of columns. */
 	unsigned int getNumCols() const;
 
+	/** Get a pointer to the data. The data is stored in column major
+	 *  order, such that element (row, col) is located at
+	 *  row + getNumRows()*col.
+	 *
+	 *  @return Pointer to the first element. */
+	const DataType* getData() const;
+
+	/** Get a pointer to the data. The data is stored in column major
+	 *  order, such that element (row, col) is located at
+	 *  row + getNumRows()*col.
+	 *
+	 *  @return Pointer to the first element. */
+	DataType* getData();
+
 	/** Multiplication operator. */
 	const Matrix<DataType, 0, 0> operator*(
 		const Matrix<DataType, 0, 0> &rhs
@@ -158,6 +172,20 @@ public:
 	/** Get number of columns. */
 	unsigned int getNumCols() const;
 
+	/** Get a pointer to the data. The data is stored in column major
+	 *  order, such that element (row, col) is located at
+	 *  row + getNumRows()*col.
+	 *
+	 *  @return Pointer to the first element. */
+	const std::complex<double>* getData() const;
+
+	/** Get a pointer to the data. The data is stored in column major
+	 *  order, such that element (row, col) is located at
+	 *  row + getNumRows()*col.
+	 *
+	 *  @return Pointer to the first element. */
+	std::complex<double>* getData();
+
 	/** Multiplication operator. */
 	const Matrix<std::complex<double>, 0, 0> operator*(
 		const Matrix<std::complex<double>, 0, 0> &rhs
@@ -429,6 +457,25 @@ inline unsigned int Matrix<std::complex<double>, 0, 0>::getNumCols() const{
 	return cols;
 }
 
+template<typename DataType>
+const DataType* Matrix<DataType, 0, 0>::getData() const{
+	return data;
+}
+
+template<typename DataType>
+DataType* Matrix<DataType, 0, 0>::getData(){
+	return data;
+}
+
+inline const std::complex<double>* Matrix<std::complex<double>, 0, 0>::getData(
+) const{
+	return data;
+}
+
+inline std::complex<double>* Matrix<std::complex<double>, 0, 0>::getData(){
+	return data;
+}
+
 template<typename DataType>
 inline const Matrix<DataType, 0, 0> Matrix<DataType, 0, 0>::operator*(
 	const Matrix<DataType, 0, 0> &rhs
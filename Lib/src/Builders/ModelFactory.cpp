@@ -111,72 +111,11 @@ Model* ModelFactory::createModel(
 	const StateSet &stateSet,
 	const AbstractOperator &o
 ){
-	Model *model = new Model();
-
-	const vector<AbstractState*> states = stateSet.getStates();
-	for(unsigned int from = 0; from < states.size(); from++){
-		AbstractState *ket = states.at(from);
-		for(unsigned int to = 0; to < states.size(); to++){
-			AbstractState *bra = states.at(to);
-
-			complex<double> amplitude = ket->getMatrixElement(*bra);
-			if(amplitude != 0.){
-				*model << HoppingAmplitude(
-					amplitude,
-					Index(
-						bra->getContainer(),
-						bra->getIndex()
-					),
-					Index(
-						ket->getContainer(),
-						ket->getIndex()
-					)
-				);
-			}
-		}
-	}
-
-	unsigned int numCoordinates = states.at(0)->getCoordinates().size();
-	for(unsigned int n = 1; n < states.size(); n++){
-		TBTKAssert(
-			states.at(n)->getCoordinates().size() == numCoordinates,
-			"ModelFactory::createModel()",
-			"Incompatible coordinate dimensions. First state has "
-				<< numCoordinates
-				<< " coordinates, while state " << n << " has "
-				<< states.at(n)->getCoordinates().size() << " coordinates.",
-			""
-		);
-	}
-
-	unsigned int numSpecifiers = states.at(0)->getSpecifiers().size();
-	for(unsigned int n = 1; n < states.size(); n++){
-		TBTKAssert(
-			states.at(n)->getSpecifiers().size() == numSpecifiers,
-			"ModelFactory::createModel()",
-			"Incompatible number of specifiers. First state has "
-				<< numSpecifiers
-				<< " specifiers, while state " << n << " has "
-				<< states.at(n)->getSpecifiers().size() << " specifiers.",
-			""
-		);
-	}
+	//Matrix elements can only be nonzero between states with overlapping
+	//extent. Use a StateTreeNode to only evaluate these.
+	StateTreeNode stateTreeNode(stateSet);
 
-	model->construct();
-	model->createGeometry(numCoordinates, numSpecifiers);
-	Geometry *geometry = model->getGeometry();
-	for(unsigned int n = 0; n < states.size(); n++){
-		geometry->setCoordinates(
-			Index(
-				states.at(n)->getContainer(),
-				states.at(n)->getIndex()
-			),
-			states.at(n)->getCoordinates(),
-			states.at(n)->getSpecifiers()
-		);
-	}
-
-	return model;
+	return createModel(stateSet, stateTreeNode, o);
 }
 
 Model* ModelFactory::createModel(
@@ -186,7 +125,14 @@ Model* ModelFactory::createModel(
 ){
 	Model *model = new Model();
 
+	//The matrix elements for different kets are calculated in parallel
+	//and are added to the Model afterwards, in the order of the kets, to
+	//make the result independent of the number of threads.
 	const vector<AbstractState*> states = stateSet.getStates();
+	vector<vector<HoppingAmplitude>> hoppingAmplitudes(states.size());
+#ifdef TBTK_USE_OPEN_MP
+	#pragma omp parallel for schedule(dynamic)
+#endif
 	for(unsigned int from = 0; from < states.size(); from++){
 		AbstractState *ket = states.at(from);
 		const vector<const AbstractState*> *bras = stateTreeNode.getOverlappingStates(ket->getCoordinates(), ket->getExtent());
@@ -194,17 +140,22 @@ Model* ModelFactory::createModel(
 		for(unsigned int to = 0; to < bras->size(); to++){
 			const AbstractState *bra = bras->at(to);
 
-			complex<double> amplitude = ket->getMatrixElement(*bra);
+			complex<double> amplitude = ket->getMatrixElement(
+				*bra,
+				o
+			);
 			if(amplitude != 0.){
-				*model << HoppingAmplitude(
-					amplitude,
-					Index(
-						bra->getContainer(),
-						bra->getIndex()
-					),
-					Index(
-						ket->getContainer(),
-						ket->getIndex()
+				hoppingAmplitudes[from].push_back(
+					HoppingAmplitude(
+						amplitude,
+						Index(
+							bra->getContainer(),
+							bra->getIndex()
+						),
+						Index(
+							ket->getContainer(),
+							ket->getIndex()
+						)
 					)
 				);
 			}
@@ -212,6 +163,12 @@ Model* ModelFactory::createModel(
 
 		delete bras;
 	}
+	for(unsigned int from = 0; from < hoppingAmplitudes.size(); from++){
+		for(unsigned int n = 0; n < hoppingAmplitudes[from].size(); n++)
+			*model << hoppingAmplitudes[from][n];
+		hoppingAmplitudes[from].clear();
+		hoppingAmplitudes[from].shrink_to_fit();
+	}
 
 	unsigned int numCoordinates = states.at(0)->getCoordinates().size();
 	for(unsigned int n = 1; n < states.size(); n++){
@@ -23,7 +23,9 @@
 #include "TBTK/TBTKMacros.h"
 #include "TBTK/Vector3d.h"
 
+#include <algorithm>
 #include <limits>
+#include <tuple>
 #include <typeinfo>
 
 using namespace std;
@@ -40,6 +42,7 @@ ReciprocalLattice::ReciprocalLattice(
 
 	setupReciprocalLatticeVectors(unitCell);
 	setupRealSpaceEnvironment(unitCell);
+	setupHoppingTable();
 }
 
 ReciprocalLattice::~ReciprocalLattice(){
@@ -134,52 +137,19 @@ Model* ReciprocalLattice::generateModel(vector<double> momentum) const{
 		""
 	);
 
-	for(unsigned int from = 0; from < realSpaceReferenceCell->getStates().size(); from++){
-		//Get reference ket.
-		const AbstractState *referenceKet = realSpaceReferenceCell->getStates().at(from);
-
-		for(unsigned int to = 0; to < realSpaceReferenceCell->getStates().size(); to++){
-			//Get reference bra and its Index.
-			const AbstractState *referenceBra = realSpaceReferenceCell->getStates().at(to);
-			Index referenceBraIndex(referenceBra->getIndex());
-
-			//Get all bras that have a possible overlap with the
-			//reference ket.
-/*			const vector<const AbstractState*> *bras = realSpaceEnvironmentStateTree->getOverlappingStates(
-				referenceKet->getCoordinates(),
-				referenceKet->getExtent()
-			);*/
-			vector<const AbstractState*> *bras = realSpaceEnvironmentStateTree->getOverlappingStates(
-				referenceKet->getCoordinates(),
-				referenceKet->getExtent()
+	vector<complex<double>> amplitudes;
+	calculateAmplitudes({momentum}, amplitudes);
+
+	const vector<AbstractState*> &referenceStates
+		= realSpaceReferenceCell->getStates();
+	unsigned int numStates = referenceStates.size();
+	for(unsigned int from = 0; from < numStates; from++){
+		for(unsigned int to = 0; to < numStates; to++){
+			*model << HoppingAmplitude(
+				amplitudes[numStates*from + to],
+				referenceStates[to]->getIndex(),
+				referenceStates[from]->getIndex()
 			);
-
-			//Calculate momentum space amplitude
-			complex<double> amplitude = 0.;
-			for(unsigned int n = 0; n < bras->size(); n++){
-				//Loop over all states that have a possible
-				//finite overlap with the reference ket.
-				const AbstractState *bra = bras->at(n);
-				if(bra->getIndex().equals(referenceBraIndex)){
-					//Only states with the same Index as
-					//the reference ket contributes to the
-					//amplitude.
-
-					static const complex<double> i(0., 1.);
-					complex<double> exponent = 0.;
-					for(unsigned int c = 0; c < momentum.size(); c++)
-						exponent += i*(momentum.at(c))*(bra->getCoordinates().at(c) - referenceBra->getCoordinates().at(c));
-					amplitude += bras->at(n)->getMatrixElement(*referenceKet)*exp(exponent);
-				}
-			}
-
-			delete bras;
-
-			//Add HoppingAmplitude to Hamiltonian, unless the
-			//amplitude is exactly zero.
-//			if(amplitude != 0.)
-//				model->addHA(HoppingAmplitude(amplitude, referenceBraIndex, referenceKet->getIndex()));
-				*model << HoppingAmplitude(amplitude, referenceBraIndex, referenceKet->getIndex());
 		}
 	}
 
@@ -232,114 +202,112 @@ Model* ReciprocalLattice::generateModel(
 
 	Model *model = new Model();
 
-	for(unsigned int from = 0; from < realSpaceReferenceCell->getStates().size(); from++){
-		//Get reference ket.
-		const AbstractState *referenceKet = realSpaceReferenceCell->getStates().at(from);
-
-		for(unsigned int to = 0; to < realSpaceReferenceCell->getStates().size(); to++){
-			//Get reference bra and its Index.
-			const AbstractState *referenceBra = realSpaceReferenceCell->getStates().at(to);
-			Index referenceBraIndex(referenceBra->getIndex());
-
-			//Get all bras that have a possible overlap with the
-			//reference ket.
-/*			const vector<const AbstractState*> *bras = realSpaceEnvironmentStateTree->getOverlappingStates(
-				referenceKet->getCoordinates(),
-				referenceKet->getExtent()
-			);*/
-			vector<const AbstractState*> *bras = realSpaceEnvironmentStateTree->getOverlappingStates(
-				referenceKet->getCoordinates(),
-				referenceKet->getExtent()
-			);
+	vector<complex<double>> amplitudes;
+	calculateAmplitudes(momentums, amplitudes);
 
-			//Calculate momentum space amplitudes
-			vector<complex<double>> amplitudes;
-			for(unsigned int n = 0; n < momentums.size(); n++)
-				amplitudes.push_back(0.);
+	const vector<AbstractState*> &referenceStates
+		= realSpaceReferenceCell->getStates();
+	unsigned int numStates = referenceStates.size();
+	for(unsigned int from = 0; from < numStates; from++){
+		for(unsigned int to = 0; to < numStates; to++){
+			for(unsigned int n = 0; n < momentums.size(); n++){
+				*model << HoppingAmplitude(
+					amplitudes[
+						numStates*(numStates*n + from)
+						+ to
+					],
+					Index(
+						blockIndices[n],
+						referenceStates[to]->getIndex()
+					),
+					Index(
+						blockIndices[n],
+						referenceStates[from]->getIndex()
+					)
+				);
+			}
+		}
+	}
 
-			for(unsigned int n = 0; n < bras->size(); n++){
-				//Loop over all states that have a possible
-				//finite overlap with the reference ket.
-				const AbstractState *bra = bras->at(n);
-				if(bra->getIndex().equals(referenceBraIndex)){
-					//Only states with the same Index as
-					//the reference ket contributes to the
-					//amplitude.
+	return model;
+}
 
-					//Get matrix element.
-					complex<double> matrixElement
-						= bras->at(
-							n
-						)->getMatrixElement(
-							*referenceKet
-						);
-
-					//Get coordinates.
-					const vector<double> &braCoordinates
-						= bra->getCoordinates();
-					const vector<double> &referenceCoordinates
-						= referenceBra->getCoordinates();
-					vector<double> coordinatesDifference;
-					for(
-						unsigned int c = 0;
-						c < braCoordinates.size();
-						c++
-					){
-						coordinatesDifference.push_back(
-							braCoordinates[c]
-							- referenceCoordinates[c]
-						);
-					}
+void ReciprocalLattice::calculateAmplitudes(
+	const vector<vector<double>> &momentums,
+	vector<complex<double>> &amplitudes
+) const{
+	const vector<vector<double>> latticeVectors
+		= unitCell->getLatticeVectors();
+	unsigned int numLatticeVectors = latticeVectors.size();
+	unsigned int numStates = realSpaceReferenceCell->getStates().size();
+	unsigned int numStatePairs = numStates*numStates;
+	unsigned int numCellDisplacements
+		= cellDisplacements.size()/numLatticeVectors;
+
+	//Offsets into the table of powers of exp(ik*v) for the different
+	//lattice vectors v.
+	vector<int> powerOffsets;
+	int numPowers = 0;
+	for(unsigned int v = 0; v < numLatticeVectors; v++){
+		powerOffsets.push_back(numPowers + maxCellDisplacements[v]);
+		numPowers += 2*maxCellDisplacements[v] + 1;
+	}
 
-					static const complex<double> i(0., 1.);
-					for(
-						unsigned int m = 0;
-						m < momentums.size();
-						m++
-					){
-						const vector<double> &momentum
-							= momentums[m];
-
-						double exponent = 0.;
-						for(
-							unsigned int c = 0;
-							c < momentums[m].size();
-							c++
-						){
-							exponent += momentum[c]*coordinatesDifference[c];
-						}
-
-						amplitudes[m]
-							+= matrixElement*exp(
-								i*exponent
-							);
-					}
+	amplitudes.assign(numStatePairs*momentums.size(), 0.);
+
+#ifdef TBTK_USE_OPEN_MP
+	#pragma omp parallel
+#endif
+	{
+		vector<complex<double>> powers(numPowers);
+		vector<complex<double>> phases(numCellDisplacements);
+
+#ifdef TBTK_USE_OPEN_MP
+		#pragma omp for schedule(dynamic)
+#endif
+		for(unsigned int m = 0; m < momentums.size(); m++){
+			const vector<double> &momentum = momentums[m];
+
+			//Since the displacements are integer multiples of the
+			//lattice vectors, exp(ik*R) only requires the powers of
+			//exp(ik*v). These are calculated through the recurrence
+			//z^{n+1} = z^{n}z, using z^{-n} = conj(z^{n}).
+			for(unsigned int v = 0; v < numLatticeVectors; v++){
+				double kDotV = 0.;
+				for(unsigned int c = 0; c < momentum.size(); c++)
+					kDotV += momentum[c]*latticeVectors[v][c];
+				complex<double> z(cos(kDotV), sin(kDotV));
+
+				complex<double> *power = &powers[powerOffsets[v]];
+				power[0] = 1.;
+				for(int n = 1; n <= maxCellDisplacements[v]; n++){
+					power[n] = power[n-1]*z;
+					power[-n] = conj(power[n]);
 				}
 			}
 
-			delete bras;
+			for(unsigned int d = 0; d < numCellDisplacements; d++){
+				complex<double> phase = 1.;
+				for(unsigned int v = 0; v < numLatticeVectors; v++){
+					phase *= powers[
+						powerOffsets[v] + cellDisplacements[
+							numLatticeVectors*d + v
+						]
+					];
+				}
+				phases[d] = phase;
+			}
 
-			//Add HoppingAmplitude to Hamiltonian, unless the
-			//amplitude is exactly zero.
-			for(unsigned int n = 0; n < momentums.size(); n++){
-//				if(amplitude != 0.)
-//					model->addHA(HoppingAmplitude(amplitude, referenceBraIndex, referenceKet->getIndex()));
-					*model << HoppingAmplitude(
-						amplitudes[n],
-						Index(
-							blockIndices[n],
-							referenceBraIndex
-						),
-						Index(
-							blockIndices[n],
-							referenceKet->getIndex()
-						)
-					);
+			complex<double> *amplitude
+				= &amplitudes[numStatePairs*m];
+			for(unsigned int n = 0; n < hoppingMatrixElements.size(); n++){
+				amplitude[hoppingStatePairs[n]]
+					+= hoppingMatrixElements[n]*phases[
+						hoppingCellDisplacements[n]
+					];
 			}
 		}
 	}
-
-	return model;
 }
 
 void ReciprocalLattice::setupReciprocalLatticeVectors(const UnitCell *unitCell){
@@ -607,4 +575,111 @@ void ReciprocalLattice::setupRealSpaceEnvironment(const UnitCell *unitCell){
 	}
 }
 
+void ReciprocalLattice::setupHoppingTable(){
+	const vector<AbstractState*> &referenceStates
+		= realSpaceReferenceCell->getStates();
+	unsigned int numStates = referenceStates.size();
+	unsigned int numLatticeVectors = unitCell->getLatticeVectors().size();
+	const Index &referenceCell = referenceStates.at(0)->getContainer();
+
+	//Collect the nonzero matrix elements between the reference kets and
+	//all bras that have a possible overlap with them. Each bra
+	//contributes to the amplitudes between the reference ket and every
+	//reference bra with the same Index.
+	vector<tuple<vector<int>, unsigned int, complex<double>>> hoppings;
+	for(unsigned int from = 0; from < numStates; from++){
+		const AbstractState *referenceKet = referenceStates[from];
+		vector<const AbstractState*> *bras
+			= realSpaceEnvironmentStateTree->getOverlappingStates(
+				referenceKet->getCoordinates(),
+				referenceKet->getExtent()
+			);
+
+		for(unsigned int n = 0; n < bras->size(); n++){
+			const AbstractState *bra = bras->at(n);
+
+			vector<int> cellDisplacement;
+			for(unsigned int v = 0; v < numLatticeVectors; v++){
+				cellDisplacement.push_back(
+					bra->getContainer().at(v)
+					- referenceCell.at(v)
+				);
+			}
+
+			complex<double> matrixElement;
+			bool matrixElementIsCalculated = false;
+			for(unsigned int to = 0; to < numStates; to++){
+				if(
+					!bra->getIndex().equals(
+						referenceStates[to]->getIndex()
+					)
+				){
+					continue;
+				}
+
+				if(!matrixElementIsCalculated){
+					matrixElement = bra->getMatrixElement(
+						*referenceKet
+					);
+					matrixElementIsCalculated = true;
+				}
+				if(matrixElement != 0.){
+					hoppings.push_back(
+						make_tuple(
+							cellDisplacement,
+							numStates*from + to,
+							matrixElement
+						)
+					);
+				}
+			}
+		}
+
+		delete bras;
+	}
+
+	//Sort the matrix elements by displacement and state pair and store
+	//them in flat arrays.
+	sort(
+		hoppings.begin(),
+		hoppings.end(),
+		[](
+			const tuple<vector<int>, unsigned int, complex<double>> &lhs,
+			const tuple<vector<int>, unsigned int, complex<double>> &rhs
+		){
+			return make_pair(get<0>(lhs), get<1>(lhs))
+				< make_pair(get<0>(rhs), get<1>(rhs));
+		}
+	);
+
+	cellDisplacements.clear();
+	maxCellDisplacements.assign(numLatticeVectors, 0);
+	hoppingMatrixElements.clear();
+	hoppingStatePairs.clear();
+	hoppingCellDisplacements.clear();
+	for(unsigned int n = 0; n < hoppings.size(); n++){
+		const vector<int> &cellDisplacement = get<0>(hoppings[n]);
+		if(n == 0 || cellDisplacement != get<0>(hoppings[n-1])){
+			for(unsigned int v = 0; v < numLatticeVectors; v++){
+				cellDisplacements.push_back(
+					cellDisplacement[v]
+				);
+				if(
+					maxCellDisplacements[v]
+					< abs(cellDisplacement[v])
+				){
+					maxCellDisplacements[v]
+						= abs(cellDisplacement[v]);
+				}
+			}
+		}
+
+		hoppingCellDisplacements.push_back(
+			cellDisplacements.size()/numLatticeVectors - 1
+		);
+		hoppingStatePairs.push_back(get<1>(hoppings[n]));
+		hoppingMatrixElements.push_back(get<2>(hoppings[n]));
+	}
+}
+
 };	//End of namespace TBTK
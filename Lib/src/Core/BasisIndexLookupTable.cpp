@@ -0,0 +1,137 @@
+/* Copyright 2018 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file BasisIndexLookupTable.cpp
+ *
+ *  @author Kristofer Björnson
+ */
+
+#include "TBTK/BasisIndexLookupTable.h"
+#include "TBTK/TBTKMacros.h"
+
+using namespace std;
+
+namespace TBTK{
+
+BasisIndexLookupTable::BasisIndexLookupTable(){
+}
+
+void BasisIndexLookupTable::generate(
+	const HoppingAmplitudeTree &hoppingAmplitudeTree,
+	const vector<int> &basisPermutation
+){
+	clear();
+
+	int basisSize = hoppingAmplitudeTree.getBasisSize();
+	TBTKAssert(
+		basisSize != -1,
+		"BasisIndexLookupTable::generate()",
+		"Basis indices not generated.",
+		"Call HoppingAmplitudeTree::generateBasisIndices() first."
+	);
+	TBTKAssert(
+		basisPermutation.size() == 0
+		|| (int)basisPermutation.size() == basisSize,
+		"BasisIndexLookupTable::generate()",
+		"Incompatible permutation size. The permutation has size "
+		<< basisPermutation.size() << " but the basis size is "
+		<< basisSize << ".",
+		""
+	);
+
+	//Collect the physical indices in basis index order. The
+	//HoppingAmplitudes are stored on the leaf nodes, and all
+	//HoppingAmplitudes with the same from-Index are therefore visited
+	//consecutively by the Iterator.
+	vector<const Index*> physicalIndices(basisSize, nullptr);
+	unsigned int numSubindices = 0;
+	HoppingAmplitudeTree::Iterator it = hoppingAmplitudeTree.begin();
+	const HoppingAmplitude *ha;
+	const Index *previousIndex = nullptr;
+	while((ha = it.getHA())){
+		const Index &fromIndex = ha->getFromIndex();
+		if(previousIndex == nullptr || !previousIndex->equals(fromIndex)){
+			int basisIndex
+				= hoppingAmplitudeTree.getBasisIndex(fromIndex);
+			if(basisPermutation.size() != 0)
+				basisIndex = basisPermutation[basisIndex];
+			physicalIndices[basisIndex] = &fromIndex;
+			numSubindices += fromIndex.getSize();
+			previousIndex = &fromIndex;
+		}
+
+		it.searchNextHA();
+	}
+
+	//Pack the subindices.
+	subindices.reserve(numSubindices);
+	offsets.reserve(basisSize + 1);
+	for(int n = 0; n < basisSize; n++){
+		offsets.push_back(subindices.size());
+		const Index &index = *physicalIndices[n];
+		for(unsigned int c = 0; c < index.getSize(); c++)
+			subindices.push_back(index[c]);
+	}
+	offsets.push_back(subindices.size());
+
+	//Insert the basis indices into a hash table with a load factor of at
+	//most 1/2.
+	unsigned int hashTableSize = 1;
+	while(hashTableSize < 2*(unsigned int)basisSize)
+		hashTableSize *= 2;
+	hashTable.assign(hashTableSize, -1);
+	const unsigned int MASK = hashTableSize - 1;
+	for(int n = 0; n < basisSize; n++){
+		unsigned int slot = hash(
+			&subindices[offsets[n]],
+			offsets[n+1] - offsets[n]
+		)&MASK;
+		while(hashTable[slot] != -1)
+			slot = (slot + 1)&MASK;
+		hashTable[slot] = n;
+	}
+}
+
+void BasisIndexLookupTable::clear(){
+	subindices.clear();
+	subindices.shrink_to_fit();
+	offsets.clear();
+	offsets.shrink_to_fit();
+	hashTable.clear();
+	hashTable.shrink_to_fit();
+}
+
+Index BasisIndexLookupTable::getPhysicalIndex(int basisIndex) const{
+	TBTKAssert(
+		basisIndex >= 0 && basisIndex + 1 < (int)offsets.size(),
+		"BasisIndexLookupTable::getPhysicalIndex()",
+		"Hilbert space index out of bound.",
+		""
+	);
+
+	Index index;
+	index.reserve(offsets[basisIndex+1] - offsets[basisIndex]);
+	for(
+		unsigned int n = offsets[basisIndex];
+		n < offsets[basisIndex+1];
+		n++
+	){
+		index.push_back(subindices[n]);
+	}
+
+	return index;
+}
+
+};	//End of namespace TBTK
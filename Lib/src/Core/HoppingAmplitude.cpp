@@ -35,8 +35,8 @@ HoppingAmplitude::HoppingAmplitude(
 	Index toIndex,
 	Index fromIndex
 ) :
-	fromIndex(fromIndex),
-	toIndex(toIndex)
+	fromIndex(std::move(fromIndex)),
+	toIndex(std::move(toIndex))
 {
 	this->amplitude = amplitude;
 	this->amplitudeCallback = NULL;
@@ -50,8 +50,8 @@ HoppingAmplitude::HoppingAmplitude(
 	Index toIndex,
 	Index fromIndex
 ) :
-	fromIndex(fromIndex),
-	toIndex(toIndex)
+	fromIndex(std::move(fromIndex)),
+	toIndex(std::move(toIndex))
 {
 	this->amplitudeCallback = amplitudeCallback;
 };
@@ -66,6 +66,16 @@ HoppingAmplitude::HoppingAmplitude(
 	this->amplitudeCallback = ha.amplitudeCallback;
 }
 
+HoppingAmplitude::HoppingAmplitude(
+	HoppingAmplitude &&ha
+) noexcept :
+	fromIndex(std::move(ha.fromIndex)),
+	toIndex(std::move(ha.toIndex))
+{
+	amplitude = ha.amplitude;
+	this->amplitudeCallback = ha.amplitudeCallback;
+}
+
 HoppingAmplitude::HoppingAmplitude(
 	const string &serialization,
 	Serializable::Mode mode
@@ -131,6 +141,30 @@ HoppingAmplitude::HoppingAmplitude(
 	}
 }
 
+HoppingAmplitude& HoppingAmplitude::operator=(const HoppingAmplitude &rhs){
+	if(this != &rhs){
+		amplitude = rhs.amplitude;
+		amplitudeCallback = rhs.amplitudeCallback;
+		fromIndex = rhs.fromIndex;
+		toIndex = rhs.toIndex;
+	}
+
+	return *this;
+}
+
+HoppingAmplitude& HoppingAmplitude::operator=(
+	HoppingAmplitude &&rhs
+) noexcept{
+	if(this != &rhs){
+		amplitude = rhs.amplitude;
+		amplitudeCallback = rhs.amplitudeCallback;
+		fromIndex = std::move(rhs.fromIndex);
+		toIndex = std::move(rhs.toIndex);
+	}
+
+	return *this;
+}
+
 HoppingAmplitude HoppingAmplitude::getHermitianConjugate() const{
 	if(amplitudeCallback)
 		return HoppingAmplitude(amplitudeCallback, fromIndex, toIndex);
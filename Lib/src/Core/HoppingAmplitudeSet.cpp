@@ -24,6 +24,10 @@
 
 #include "TBTK/json.hpp"
 
+#include <algorithm>
+#include <queue>
+#include <tuple>
+
 using namespace std;
 using namespace nlohmann;
 
@@ -32,22 +36,30 @@ namespace TBTK{
 HoppingAmplitudeSet::HoppingAmplitudeSet(){
 	isConstructed = false;
 	isSorted = false;
+	useBasisIndexLookupTable = true;
+	basisOrdering = BasisOrdering::Lexicographic;
 	numMatrixElements = -1;
 
 	cooRowIndices = NULL;
 	cooColIndices = NULL;
 	cooValues = NULL;
+
+	sparseMatrix = nullptr;
 }
 
 HoppingAmplitudeSet::HoppingAmplitudeSet(const vector<unsigned int> &capacity){
 	isConstructed = false;
 	isSorted = false;
+	useBasisIndexLookupTable = true;
+	basisOrdering = BasisOrdering::Lexicographic;
 	numMatrixElements = -1;
 
 	cooRowIndices = NULL;
 	cooColIndices = NULL;
 	cooValues = NULL;
 
+	sparseMatrix = nullptr;
+
 	hoppingAmplitudeTree = HoppingAmplitudeTree(capacity);
 }
 
@@ -57,6 +69,12 @@ HoppingAmplitudeSet::HoppingAmplitudeSet(
 	hoppingAmplitudeTree = hoppingAmplitudeSet.hoppingAmplitudeTree;
 	isConstructed = hoppingAmplitudeSet.isConstructed;
 	isSorted = hoppingAmplitudeSet.isSorted;
+	useBasisIndexLookupTable
+		= hoppingAmplitudeSet.useBasisIndexLookupTable;
+	basisIndexLookupTable = hoppingAmplitudeSet.basisIndexLookupTable;
+	basisOrdering = hoppingAmplitudeSet.basisOrdering;
+	basisPermutation = hoppingAmplitudeSet.basisPermutation;
+	inverseBasisPermutation = hoppingAmplitudeSet.inverseBasisPermutation;
 	numMatrixElements = hoppingAmplitudeSet.numMatrixElements;
 
 	if(numMatrixElements == -1){
@@ -74,6 +92,10 @@ HoppingAmplitudeSet::HoppingAmplitudeSet(
 			cooValues[n] = hoppingAmplitudeSet.cooValues[n];
 		}
 	}
+
+	//The cached matrix is immutable and can therefore be shared.
+	lock_guard<mutex> lock(hoppingAmplitudeSet.sparseMatrixMutex);
+	sparseMatrix = hoppingAmplitudeSet.sparseMatrix;
 }
 
 HoppingAmplitudeSet::HoppingAmplitudeSet(
@@ -82,6 +104,16 @@ HoppingAmplitudeSet::HoppingAmplitudeSet(
 	hoppingAmplitudeTree = hoppingAmplitudeSet.hoppingAmplitudeTree;
 	isConstructed = hoppingAmplitudeSet.isConstructed;
 	isSorted = hoppingAmplitudeSet.isSorted;
+	useBasisIndexLookupTable
+		= hoppingAmplitudeSet.useBasisIndexLookupTable;
+	basisIndexLookupTable = std::move(
+		hoppingAmplitudeSet.basisIndexLookupTable
+	);
+	basisOrdering = hoppingAmplitudeSet.basisOrdering;
+	basisPermutation = std::move(hoppingAmplitudeSet.basisPermutation);
+	inverseBasisPermutation = std::move(
+		hoppingAmplitudeSet.inverseBasisPermutation
+	);
 	numMatrixElements = hoppingAmplitudeSet.numMatrixElements;
 
 	cooRowIndices = hoppingAmplitudeSet.cooRowIndices;
@@ -92,12 +124,18 @@ HoppingAmplitudeSet::HoppingAmplitudeSet(
 
 	cooValues = hoppingAmplitudeSet.cooValues;
 	hoppingAmplitudeSet.cooValues = nullptr;
+
+	sparseMatrix = std::move(hoppingAmplitudeSet.sparseMatrix);
 }
 
 HoppingAmplitudeSet::HoppingAmplitudeSet(
 	const string &serialization,
 	Mode mode
 ){
+	useBasisIndexLookupTable = true;
+	basisOrdering = BasisOrdering::Lexicographic;
+	sparseMatrix = nullptr;
+
 	switch(mode){
 	case Mode::Debug:
 	{
@@ -152,6 +190,19 @@ HoppingAmplitudeSet::HoppingAmplitudeSet(
 			}
 		}
 
+		//The basis ordering is stored last and is absent in
+		//serializations created before it was introduced.
+		if(
+			elements.size()
+			> 4 + 3*(unsigned int)max(numMatrixElements, 0)
+		){
+			int ordering;
+			ss.clear();
+			ss.str(elements.back());
+			ss >> ordering;
+			basisOrdering = static_cast<BasisOrdering>(ordering);
+		}
+
 		break;
 	}
 	case Mode::JSON:
@@ -165,6 +216,11 @@ HoppingAmplitudeSet::HoppingAmplitudeSet(
 			isConstructed = j.at("isConstructed").get<bool>();
 			isSorted = j.at("isSorted").get<bool>();
 			numMatrixElements = j.at("numMatrixElements").get<int>();
+			if(j.find("basisOrdering") != j.end()){
+				basisOrdering = static_cast<BasisOrdering>(
+					j.at("basisOrdering").get<int>()
+				);
+			}
 			if(numMatrixElements == -1){
 				cooRowIndices = nullptr;
 				cooColIndices = nullptr;
@@ -256,6 +312,16 @@ HoppingAmplitudeSet::HoppingAmplitudeSet(
 			""
 		);
 	}
+
+	if(isConstructed){
+		generateBasisPermutation();
+		if(useBasisIndexLookupTable){
+			basisIndexLookupTable.generate(
+				hoppingAmplitudeTree,
+				basisPermutation
+			);
+		}
+	}
 }
 
 HoppingAmplitudeSet::~HoppingAmplitudeSet(){
@@ -274,6 +340,11 @@ HoppingAmplitudeSet& HoppingAmplitudeSet::operator=(
 		hoppingAmplitudeTree = rhs.hoppingAmplitudeTree;
 		isConstructed = rhs.isConstructed;
 		isSorted = rhs.isSorted;
+		useBasisIndexLookupTable = rhs.useBasisIndexLookupTable;
+		basisIndexLookupTable = rhs.basisIndexLookupTable;
+		basisOrdering = rhs.basisOrdering;
+		basisPermutation = rhs.basisPermutation;
+		inverseBasisPermutation = rhs.inverseBasisPermutation;
 		numMatrixElements = rhs.numMatrixElements;
 
 		if(numMatrixElements == -1){
@@ -291,6 +362,13 @@ HoppingAmplitudeSet& HoppingAmplitudeSet::operator=(
 				cooValues[n] = rhs.cooValues[n];
 			}
 		}
+
+		//The cached matrix is immutable and can therefore be
+		//shared.
+		std::lock(sparseMatrixMutex, rhs.sparseMatrixMutex);
+		lock_guard<mutex> lhsLock(sparseMatrixMutex, adopt_lock);
+		lock_guard<mutex> rhsLock(rhs.sparseMatrixMutex, adopt_lock);
+		sparseMatrix = rhs.sparseMatrix;
 	}
 
 	return *this;
@@ -301,6 +379,13 @@ HoppingAmplitudeSet& HoppingAmplitudeSet::operator=(HoppingAmplitudeSet &&rhs){
 		hoppingAmplitudeTree = rhs.hoppingAmplitudeTree;
 		isConstructed = rhs.isConstructed;
 		isSorted = rhs.isSorted;
+		useBasisIndexLookupTable = rhs.useBasisIndexLookupTable;
+		basisIndexLookupTable = std::move(rhs.basisIndexLookupTable);
+		basisOrdering = rhs.basisOrdering;
+		basisPermutation = std::move(rhs.basisPermutation);
+		inverseBasisPermutation = std::move(
+			rhs.inverseBasisPermutation
+		);
 		numMatrixElements = rhs.numMatrixElements;
 
 		cooRowIndices = rhs.cooRowIndices;
@@ -311,6 +396,8 @@ HoppingAmplitudeSet& HoppingAmplitudeSet::operator=(HoppingAmplitudeSet &&rhs){
 
 		cooValues = rhs.cooValues;
 		rhs.cooValues = nullptr;
+
+		sparseMatrix = std::move(rhs.sparseMatrix);
 	}
 
 	return *this;
@@ -352,11 +439,11 @@ void HoppingAmplitudeSet::constructCOO(){
 		int row = getBasisIndex(ha->toIndex);*/
 		int col = getBasisIndex(ha->getFromIndex());
 		int row = getBasisIndex(ha->getToIndex());
-		if(col > currentCol){
+		if(col != currentCol){
 			currentCol = col;
 			currentRow = -1;
 		}
-		if(row > currentRow){
+		if(row != currentRow){
 			currentRow = row;
 			numMatrixElements++;
 		}
@@ -380,11 +467,11 @@ void HoppingAmplitudeSet::constructCOO(){
 		int row = getBasisIndex(ha->getToIndex());
 		complex<double> amplitude = ha->getAmplitude();
 
-		if(col > currentCol){
+		if(col != currentCol){
 			currentCol = col;
 			currentRow = -1;
 		}
-		if(row > currentRow){
+		if(row != currentRow){
 			currentRow = row;
 			currentMatrixElement++;
 
@@ -403,6 +490,39 @@ void HoppingAmplitudeSet::constructCOO(){
 
 		it.searchNextHA();
 	}
+
+	//The HoppingAmplitudes are iterated over in the lexicographic order,
+	//which only results in sorted matrix elements if the basis follows
+	//the same order.
+	if(basisPermutation.size() != 0){
+		vector<tuple<int, int, complex<double>>> matrixElements;
+		matrixElements.reserve(numMatrixElements);
+		for(int n = 0; n < numMatrixElements; n++){
+			matrixElements.push_back(
+				make_tuple(
+					cooRowIndices[n],
+					cooColIndices[n],
+					cooValues[n]
+				)
+			);
+		}
+		std::sort(
+			matrixElements.begin(),
+			matrixElements.end(),
+			[](
+				const tuple<int, int, complex<double>> &lhs,
+				const tuple<int, int, complex<double>> &rhs
+			){
+				return make_pair(get<0>(lhs), get<1>(lhs))
+					< make_pair(get<0>(rhs), get<1>(rhs));
+			}
+		);
+		for(int n = 0; n < numMatrixElements; n++){
+			cooRowIndices[n] = get<0>(matrixElements[n]);
+			cooColIndices[n] = get<1>(matrixElements[n]);
+			cooValues[n] = get<2>(matrixElements[n]);
+		}
+	}
 }
 
 void HoppingAmplitudeSet::destructCOO(){
@@ -422,12 +542,420 @@ void HoppingAmplitudeSet::destructCOO(){
 }
 
 void HoppingAmplitudeSet::reconstructCOO(){
+	invalidateSparseMatrix();
 	if(numMatrixElements != -1){
 		destructCOO();
 		constructCOO();
 	}
 }
 
+SparseMatrix<complex<double>>* HoppingAmplitudeSet::constructSparseMatrix(
+	bool &isCallbackDependent
+) const{
+	TBTKAssert(
+		isConstructed,
+		"HoppingAmplitudeSet::constructSparseMatrix()",
+		"HoppingAmplitudeSet has to be constructed first.",
+		""
+	);
+
+	int basisSize = getBasisSize();
+	SparseMatrix<complex<double>> *sparseMatrix
+		= new SparseMatrix<complex<double>>(
+			SparseMatrix<complex<double>>::StorageFormat::CSR,
+			basisSize,
+			basisSize
+		);
+
+	//The HoppingAmplitudes are iterated over in order of their
+	//'from'-indices, which therefore only need to be looked up when they
+	//change.
+	Iterator it = getIterator();
+	const HoppingAmplitude *ha;
+	const Index *previousFromIndex = nullptr;
+	int from = -1;
+	isCallbackDependent = false;
+	while((ha = it.getHA())){
+		const Index &fromIndex = ha->getFromIndex();
+		if(
+			previousFromIndex == nullptr
+			|| !fromIndex.equals(*previousFromIndex)
+		){
+			from = getBasisIndex(fromIndex);
+			previousFromIndex = &fromIndex;
+		}
+		int to = getBasisIndex(ha->getToIndex());
+		sparseMatrix->add(to, from, ha->getAmplitude());
+		if(ha->getIsCallbackDependent())
+			isCallbackDependent = true;
+
+		it.searchNextHA();
+	}
+	sparseMatrix->constructCSX();
+
+	return sparseMatrix;
+}
+
+void HoppingAmplitudeSet::generateBasisPermutation(){
+	basisPermutation.clear();
+	inverseBasisPermutation.clear();
+
+	switch(basisOrdering){
+	case BasisOrdering::Lexicographic:
+		return;
+	case BasisOrdering::ReverseCuthillMcKee:
+		inverseBasisPermutation = getReverseCuthillMcKeeOrder();
+		break;
+	case BasisOrdering::Morton:
+		inverseBasisPermutation = getMortonOrder();
+		break;
+	default:
+		TBTKExit(
+			"HoppingAmplitudeSet::generateBasisPermutation()",
+			"Unknown BasisOrdering.",
+			"This should never happen, contact the developer."
+		);
+	}
+
+	basisPermutation.resize(inverseBasisPermutation.size());
+	for(unsigned int n = 0; n < inverseBasisPermutation.size(); n++)
+		basisPermutation[inverseBasisPermutation[n]] = n;
+}
+
+vector<pair<int, int>> HoppingAmplitudeSet::getBlockRanges() const{
+	vector<pair<int, int>> blockRanges;
+
+	IndexTree blockIndices = hoppingAmplitudeTree.getSubspaceIndices();
+	IndexTree::Iterator blockIterator = blockIndices.begin();
+	while(!blockIterator.getHasReachedEnd()){
+		Index blockIndex = blockIterator.getIndex();
+		blockRanges.push_back(
+			make_pair(
+				hoppingAmplitudeTree.getFirstIndexInSubspace(
+					blockIndex
+				),
+				hoppingAmplitudeTree.getLastIndexInSubspace(
+					blockIndex
+				)
+			)
+		);
+
+		blockIterator.searchNext();
+	}
+
+	//The whole Hilbert space forms a single block if the
+	//HoppingAmplitudeTree has no block structure.
+	if(blockRanges.size() == 0 && getBasisSize() > 0)
+		blockRanges.push_back(make_pair(0, getBasisSize() - 1));
+
+	return blockRanges;
+}
+
+vector<int> HoppingAmplitudeSet::getReverseCuthillMcKeeOrder() const{
+	int basisSize = getBasisSize();
+
+	//Setup the symmetrized adjacency structure of the Hamiltonian in
+	//terms of the tree basis indices. The HoppingAmplitudes are iterated
+	//over in order of their 'from'-indices, which therefore only need to
+	//be looked up when they change.
+	vector<pair<int, int>> edges;
+	HoppingAmplitudeTree::Iterator it = hoppingAmplitudeTree.begin();
+	const HoppingAmplitude *ha;
+	const Index *previousFromIndex = nullptr;
+	int from = -1;
+	while((ha = it.getHA())){
+		const Index &fromIndex = ha->getFromIndex();
+		if(
+			previousFromIndex == nullptr
+			|| !fromIndex.equals(*previousFromIndex)
+		){
+			from = hoppingAmplitudeTree.getBasisIndex(fromIndex);
+			previousFromIndex = &fromIndex;
+		}
+		int to = hoppingAmplitudeTree.getBasisIndex(ha->getToIndex());
+		if(from != to){
+			edges.push_back(make_pair(from, to));
+			edges.push_back(make_pair(to, from));
+		}
+
+		it.searchNextHA();
+	}
+	std::sort(edges.begin(), edges.end());
+	edges.erase(unique(edges.begin(), edges.end()), edges.end());
+
+	vector<unsigned int> neighborOffsets(basisSize + 1, 0);
+	vector<int> neighbors;
+	neighbors.reserve(edges.size());
+	for(unsigned int n = 0; n < edges.size(); n++){
+		neighborOffsets[edges[n].first + 1]++;
+		neighbors.push_back(edges[n].second);
+	}
+	edges.clear();
+	edges.shrink_to_fit();
+	for(int n = 0; n < basisSize; n++)
+		neighborOffsets[n + 1] += neighborOffsets[n];
+
+	auto getDegree = [&neighborOffsets](int state){
+		return neighborOffsets[state + 1] - neighborOffsets[state];
+	};
+
+	//Breadth first search through the unvisited states connected to
+	//'root'. The visited states are appended to 'levelStates' and the
+	//index in 'levelStates' at which the last level starts is returned.
+	//If 'sortByDegree' is true, the neighbors of each state are visited
+	//in order of increasing degree.
+	vector<int> levels(basisSize, -1);
+	vector<bool> isOrdered(basisSize, false);
+	auto breadthFirstSearch = [&](
+		int root,
+		vector<int> &levelStates,
+		bool sortByDegree
+	){
+		unsigned int begin = levelStates.size();
+		levelStates.push_back(root);
+		levels[root] = 0;
+		unsigned int lastLevelBegin = begin;
+		for(
+			unsigned int n = begin;
+			n < levelStates.size();
+			n++
+		){
+			int state = levelStates[n];
+			if(levels[state] != levels[levelStates[lastLevelBegin]])
+				lastLevelBegin = n;
+
+			unsigned int firstNeighbor = levelStates.size();
+			for(
+				unsigned int c = neighborOffsets[state];
+				c < neighborOffsets[state + 1];
+				c++
+			){
+				int neighbor = neighbors[c];
+				if(levels[neighbor] == -1 && !isOrdered[neighbor]){
+					levels[neighbor] = levels[state] + 1;
+					levelStates.push_back(neighbor);
+				}
+			}
+			if(sortByDegree){
+				std::sort(
+					levelStates.begin() + firstNeighbor,
+					levelStates.end(),
+					[&getDegree](int lhs, int rhs){
+						return getDegree(lhs)
+							< getDegree(rhs);
+					}
+				);
+			}
+		}
+
+		return lastLevelBegin;
+	};
+	auto resetLevels = [&levels](
+		const vector<int> &levelStates,
+		unsigned int begin
+	){
+		for(unsigned int n = begin; n < levelStates.size(); n++)
+			levels[levelStates[n]] = -1;
+	};
+
+	//Order each block separately to keep the blocks contiguous. Each
+	//connected component is started from a pseudo-peripheral state found
+	//using the algorithm by George and Liu.
+	vector<int> order;
+	order.reserve(basisSize);
+	vector<pair<int, int>> blockRanges = getBlockRanges();
+	for(unsigned int b = 0; b < blockRanges.size(); b++){
+		vector<int> candidates;
+		for(int n = blockRanges[b].first; n <= blockRanges[b].second; n++)
+			candidates.push_back(n);
+		stable_sort(
+			candidates.begin(),
+			candidates.end(),
+			[&getDegree](int lhs, int rhs){
+				return getDegree(lhs) < getDegree(rhs);
+			}
+		);
+
+		unsigned int blockBegin = order.size();
+		for(unsigned int c = 0; c < candidates.size(); c++){
+			if(isOrdered[candidates[c]])
+				continue;
+
+			int root = candidates[c];
+			vector<int> levelStates;
+			unsigned int lastLevelBegin
+				= breadthFirstSearch(root, levelStates, false);
+			int eccentricity = levels[levelStates.back()];
+			while(true){
+				int candidate = levelStates[lastLevelBegin];
+				for(
+					unsigned int n = lastLevelBegin + 1;
+					n < levelStates.size();
+					n++
+				){
+					if(
+						getDegree(levelStates[n])
+						< getDegree(candidate)
+					){
+						candidate = levelStates[n];
+					}
+				}
+				resetLevels(levelStates, 0);
+				levelStates.clear();
+
+				lastLevelBegin = breadthFirstSearch(
+					candidate,
+					levelStates,
+					false
+				);
+				int candidateEccentricity
+					= levels[levelStates.back()];
+				if(candidateEccentricity <= eccentricity)
+					break;
+
+				root = candidate;
+				eccentricity = candidateEccentricity;
+			}
+			resetLevels(levelStates, 0);
+
+			unsigned int componentBegin = order.size();
+			breadthFirstSearch(root, order, true);
+			for(unsigned int n = componentBegin; n < order.size(); n++)
+				isOrdered[order[n]] = true;
+			resetLevels(order, componentBegin);
+		}
+		reverse(order.begin() + blockBegin, order.end());
+	}
+
+	return order;
+}
+
+vector<int> HoppingAmplitudeSet::getMortonOrder() const{
+	int basisSize = getBasisSize();
+
+	//Collect the physical indices in tree basis index order.
+	vector<Index> physicalIndices(basisSize);
+	unsigned int maxIndexSize = 0;
+	HoppingAmplitudeTree::Iterator it = hoppingAmplitudeTree.begin();
+	const HoppingAmplitude *ha;
+	const Index *previousFromIndex = nullptr;
+	while((ha = it.getHA())){
+		const Index &fromIndex = ha->getFromIndex();
+		if(
+			previousFromIndex == nullptr
+			|| !fromIndex.equals(*previousFromIndex)
+		){
+			physicalIndices[
+				hoppingAmplitudeTree.getBasisIndex(fromIndex)
+			] = fromIndex;
+			if(fromIndex.getSize() > maxIndexSize)
+				maxIndexSize = fromIndex.getSize();
+			previousFromIndex = &fromIndex;
+		}
+
+		it.searchNextHA();
+	}
+
+	//Compares the position along the Morton curve by finding the
+	//subindex with the most significant differing bit. Missing subindices
+	//are treated as zero. If the most significant differing bit is at the
+	//same position for several subindices, the first of them determines
+	//the order, which places the last subindices, such as orbital and
+	//spin subindices, innermost.
+	auto getSubindex = [](const Index &index, unsigned int n){
+		return n < index.getSize() ? (unsigned int)index[n] : 0u;
+	};
+	auto mortonLess = [&](int lhs, int rhs){
+		const Index &lhsIndex = physicalIndices[lhs];
+		const Index &rhsIndex = physicalIndices[rhs];
+		unsigned int significantSubindex = 0;
+		unsigned int maxDifference = 0;
+		for(unsigned int n = 0; n < maxIndexSize; n++){
+			unsigned int difference = getSubindex(lhsIndex, n)
+				^ getSubindex(rhsIndex, n);
+			if(
+				maxDifference < difference
+				&& maxDifference < (maxDifference ^ difference)
+			){
+				significantSubindex = n;
+				maxDifference = difference;
+			}
+		}
+
+		return getSubindex(lhsIndex, significantSubindex)
+			< getSubindex(rhsIndex, significantSubindex);
+	};
+
+	//Order each block separately to keep the blocks contiguous.
+	vector<int> order(basisSize);
+	for(int n = 0; n < basisSize; n++)
+		order[n] = n;
+	vector<pair<int, int>> blockRanges = getBlockRanges();
+	for(unsigned int b = 0; b < blockRanges.size(); b++){
+		std::sort(
+			order.begin() + blockRanges[b].first,
+			order.begin() + blockRanges[b].second + 1,
+			mortonLess
+		);
+	}
+
+	return order;
+}
+
+//FNV-1a hash of a sequence of bytes.
+static void hashBytes(
+	unsigned long long &hash,
+	const void *data,
+	size_t numBytes
+){
+	const unsigned char *bytes = (const unsigned char*)data;
+	for(size_t n = 0; n < numBytes; n++){
+		hash ^= bytes[n];
+		hash *= 1099511628211ull;
+	}
+}
+
+unsigned long long HoppingAmplitudeSet::getHash() const{
+	unsigned long long hash = 14695981039346656037ull;
+
+	//Basis ordering.
+	int basisSize = getBasisSize();
+	hashBytes(hash, &basisSize, sizeof(basisSize));
+	for(int n = 0; n < basisSize; n++){
+		Index index = getPhysicalIndex(n);
+		unsigned int size = index.getSize();
+		hashBytes(hash, &size, sizeof(size));
+		for(unsigned int c = 0; c < size; c++){
+			int subindex = index[c];
+			hashBytes(hash, &subindex, sizeof(subindex));
+		}
+	}
+
+	//Hamiltonian.
+	shared_ptr<const SparseMatrix<complex<double>>> sparseMatrix
+		= getSparseMatrix();
+	const SparseMatrix<complex<double>> &matrix = *sparseMatrix;
+	unsigned int numMatrixElements = matrix.getCSRNumMatrixElements();
+	hashBytes(hash, &numMatrixElements, sizeof(numMatrixElements));
+	hashBytes(
+		hash,
+		matrix.getCSRRowPointers(),
+		(basisSize + 1)*sizeof(unsigned int)
+	);
+	hashBytes(
+		hash,
+		matrix.getCSRColumns(),
+		numMatrixElements*sizeof(unsigned int)
+	);
+	hashBytes(
+		hash,
+		matrix.getCSRValues(),
+		numMatrixElements*sizeof(complex<double>)
+	);
+
+	return hash;
+}
+
 void HoppingAmplitudeSet::print(){
 	hoppingAmplitudeTree.print();
 }
@@ -472,6 +1000,10 @@ string HoppingAmplitudeSet::serialize(Mode mode) const{
 				);
 			}
 		}
+		ss << "," << Serializable::serialize(
+			static_cast<int>(basisOrdering),
+			mode
+		);
 		ss << ")";
 
 		return ss.str();
@@ -486,6 +1018,7 @@ string HoppingAmplitudeSet::serialize(Mode mode) const{
 		j["isConstructed"] = isConstructed;
 		j["isSorted"] = isSorted;
 		j["numMatrixElements"] = numMatrixElements;
+		j["basisOrdering"] = static_cast<int>(basisOrdering);
 		if(numMatrixElements != -1){
 			for(int n = 0; n < numMatrixElements; n++){
 				j["cooRowIndices"].push_back(cooRowIndices[n]);
@@ -311,8 +311,9 @@ void HoppingAmplitudeTree::add(HoppingAmplitude &ha, unsigned int subindex){
 			getFirstHA().print();
 			exit(1);
 		}*/
-		//Add HoppingAmplitude to node.
-		hoppingAmplitudes.push_back(ha);
+		//Add HoppingAmplitude to node. The HoppingAmplitude is owned
+		//by add(HoppingAmplitude ha) and can therefore be moved.
+		hoppingAmplitudes.push_back(std::move(ha));
 	}
 }
 
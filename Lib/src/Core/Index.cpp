@@ -31,53 +31,54 @@ using namespace nlohmann;
 
 namespace TBTK{
 
-Index::Index(const Index &head, const Index &tail){
-	indices.reserve(head.getSize() + tail.getSize());
-	indices.insert(
-		indices.end(),
-		head.indices.begin(),
-		head.indices.end()
-	);
-	indices.insert(
-		indices.end(),
-		tail.indices.begin(),
-		tail.indices.end()
-	);
+constexpr unsigned int Index::INLINE_CAPACITY;
+
+Index::Index(const Index &head, const Index &tail) : Index(){
+	reserve(head.size + tail.size);
+	for(unsigned int n = 0; n < head.size; n++)
+		indices[n] = head.indices[n];
+	for(unsigned int n = 0; n < tail.size; n++)
+		indices[head.size + n] = tail.indices[n];
+	size = head.size + tail.size;
 }
 
-Index::Index(initializer_list<initializer_list<int>> indexList){
+Index::Index(
+	initializer_list<initializer_list<int>> indexList
+) :
+	Index()
+{
 	for(unsigned int n = 0; n < indexList.size(); n++){
 		if(n > 0)
-			indices.push_back(IDX_SEPARATOR);
+			push_back(IDX_SEPARATOR);
 		for(unsigned int c = 0; c < (indexList.begin()+n)->size(); c++)
-			indices.push_back(*((indexList.begin() + n)->begin() + c));
+			push_back(*((indexList.begin() + n)->begin() + c));
 	}
 }
 
-Index::Index(const vector<vector<int>> &indexList){
+Index::Index(const vector<vector<int>> &indexList) : Index(){
 	for(unsigned int n = 0; n < indexList.size(); n++){
 		if(n > 0)
-			indices.push_back(IDX_SEPARATOR);
+			push_back(IDX_SEPARATOR);
 		for(unsigned int c = 0; c < indexList.at(n).size(); c++)
-			indices.push_back(indexList.at(n).at(c));
+			push_back(indexList.at(n).at(c));
 	}
 }
 
-Index::Index(initializer_list<Index> indexList){
+Index::Index(initializer_list<Index> indexList) : Index(){
 	for(unsigned int n = 0; n < indexList.size(); n++){
 		if(n > 0)
-			indices.push_back(IDX_SEPARATOR);
+			push_back(IDX_SEPARATOR);
 		for(
 			unsigned int c = 0;
 			c < (indexList.begin() + n)->getSize();
 			c++
 		){
-			indices.push_back((indexList.begin() + n)->at(c));
+			push_back((indexList.begin() + n)->at(c));
 		}
 	}
 }
 
-Index::Index(const string &indexString){
+Index::Index(const string &indexString) : Index(){
 	TBTKExceptionAssert(
 		indexString[0] == '{',
 		IndexException(
@@ -243,11 +244,15 @@ Index::Index(const string &indexString){
 		)
 	);
 
-	for(unsigned int n = 0; n < indexVector.size(); n++)
-		indices.push_back(indexVector.at(n));
+	assign(indexVector.data(), indexVector.size());
 }
 
-Index::Index(const string &serialization, Serializable::Mode mode){
+Index::Index(
+	const string &serialization,
+	Serializable::Mode mode
+) :
+	Index()
+{
 	switch(mode){
 	case Serializable::Mode::Debug:
 	{
@@ -267,7 +272,7 @@ Index::Index(const string &serialization, Serializable::Mode mode){
 		ss.str(content);
 		int subindex;
 		while((ss >> subindex)){
-			indices.push_back(subindex);
+			push_back(subindex);
 			char c;
 			TBTKAssert(
 				!(ss >> c) || c == ',',
@@ -291,7 +296,9 @@ Index::Index(const string &serialization, Serializable::Mode mode){
 
 		try{
 			json j = json::parse(serialization);
-			indices = j.at("indices").get<vector<int>>();
+			vector<int> subindices
+				= j.at("indices").get<vector<int>>();
+			assign(subindices.data(), subindices.size());
 		}
 		catch(json::exception e){
 			TBTKExit(
@@ -377,11 +384,25 @@ Index Index::getUnitRange(){
 }
 
 Index Index::getSubIndex(int first, int last){
-	vector<int> newSubindices;
+	Index newIndex;
+	newIndex.reserve(last - first + 1);
 	for(int n = first; n <= last; n++)
-		newSubindices.push_back(indices.at(n));
+		newIndex.push_back(at(n));
+
+	return newIndex;
+}
 
-	return Index(newSubindices);
+void Index::reserve(unsigned int size){
+	if(size <= capacity)
+		return;
+
+	int *newIndices = new int[size];
+	for(unsigned int n = 0; n < this->size; n++)
+		newIndices[n] = indices[n];
+	if(isOnHeap())
+		delete [] indices;
+	indices = newIndices;
+	capacity = size;
 }
 
 string Index::serialize(Serializable::Mode mode) const{
@@ -390,10 +411,10 @@ string Index::serialize(Serializable::Mode mode) const{
 	{
 		stringstream ss;
 		ss << "Index(";
-		for(unsigned int n = 0; n < indices.size(); n++){
+		for(unsigned int n = 0; n < size; n++){
 			if(n != 0)
 				ss << ",";
-			ss << Serializable::serialize(indices.at(n), mode);
+			ss << Serializable::serialize(indices[n], mode);
 		}
 		ss << ")";
 
@@ -403,7 +424,7 @@ string Index::serialize(Serializable::Mode mode) const{
 	{
 		json j;
 		j["id"] = "Index";
-		j["indices"] = json(indices);
+		j["indices"] = json(vector<int>(indices, indices + size));
 
 		return j.dump();
 	}
@@ -200,7 +200,7 @@ Property::LDOS ArnoldiIterator::calculateLDOS(
 
 	calculate(
 		calculateLDOSCallback,
-		(void*)ldos.getData(),
+		ldos,
 		pattern,
 		ranges,
 		0,
@@ -322,7 +322,7 @@ Property::SpinPolarizedLDOS ArnoldiIterator::calculateSpinPolarizedLDOS(
 
 	calculate(
 		calculateSpinPolarizedLDOSCallback,
-		(void*)spinPolarizedLDOS.getDataRW(),
+		spinPolarizedLDOS,
 		pattern,
 		ranges,
 		0,
@@ -31,6 +31,10 @@ namespace PropertyExtractor{
 
 BlockDiagonalizer::BlockDiagonalizer(Solver::BlockDiagonalizer &bSolver){
 	this->bSolver = &bSolver;
+
+	//The callbacks only read from the solver and can therefore be
+	//executed in parallel.
+	setParallelExecution(true);
 }
 
 BlockDiagonalizer::~BlockDiagonalizer(){
@@ -471,7 +475,7 @@ Property::LDOS BlockDiagonalizer::calculateLDOS(
 
 	calculate(
 		calculateSP_LDOSCallback,
-		(void*)spinPolarizedLDOS.getDataRW(),
+		spinPolarizedLDOS,
 		pattern,
 		ranges,
 		0,
@@ -23,15 +23,21 @@
 #include "TBTK/Streams.h"
 #include "TBTK/TBTKMacros.h"
 
+#include <cmath>
 #include <set>
 
 using namespace std;
 
 static complex<double> i(0, 1);
 
+//Parameter lambda for the Lorentz kernel.
+static const double LORENTZ_KERNEL_LAMBDA = 4.;
+
 namespace TBTK{
 namespace PropertyExtractor{
 
+constexpr unsigned int ChebyshevExpander::DEFAULT_NUM_RANDOM_VECTORS;
+
 ChebyshevExpander::ChebyshevExpander(
 	Solver::ChebyshevExpander &cSolver,
 	int numCoefficients,
@@ -75,6 +81,10 @@ ChebyshevExpander::ChebyshevExpander(
 	this->useGPUToCalculateCoefficients = useGPUToCalculateCoefficients;
 	this->useGPUToGenerateGreensFunctions = useGPUToGenerateGreensFunctions;
 	this->useLookupTable = useLookupTable;
+	numRandomVectors = DEFAULT_NUM_RANDOM_VECTORS;
+	kernel = Kernel::Jackson;
+	useStochasticLDOS = false;
+	useStochasticDOS = false;
 
 	setEnergyWindow(
 		-cSolver.getScaleFactor(),
@@ -106,6 +116,104 @@ void ChebyshevExpander::setEnergyWindow(
 		cSolver->destroyLookupTable();
 }
 
+Property::DOS ChebyshevExpander::calculateDOS(){
+	Property::DOS standardError(lowerBound, upperBound, energyResolution);
+
+	return calculateDOS(standardError);
+}
+
+Property::DOS ChebyshevExpander::calculateDOS(Property::DOS &standardError){
+	if(!useStochasticDOS){
+		standardError = Property::DOS(
+			lowerBound,
+			upperBound,
+			energyResolution
+		);
+
+		//Sum the LDOS over all basis states, one block of Indices at
+		//the time. All Indices share offset zero.
+		ensureLookupTableIsReady();
+		const HoppingAmplitudeSet *hoppingAmplitudeSet
+			= cSolver->getModel().getHoppingAmplitudeSet();
+		int basisSize = hoppingAmplitudeSet->getBasisSize();
+		double *ldos = new double[energyResolution];
+		for(int e = 0; e < energyResolution; e++)
+			ldos[e] = 0.;
+		for(int n = 0; n < basisSize; n++){
+			ldosBatch.push_back(
+				make_pair(
+					hoppingAmplitudeSet->getPhysicalIndex(n),
+					0
+				)
+			);
+			if(ldosBatch.size() >= cSolver->getBlockSize())
+				calculateExactLDOSBatch(ldos);
+		}
+		calculateExactLDOSBatch(ldos);
+
+		Property::DOS dos(lowerBound, upperBound, energyResolution);
+		double *dosData = dos.getDataRW();
+		const double dE = (upperBound - lowerBound)/energyResolution;
+		for(int e = 0; e < energyResolution; e++)
+			dosData[e] = ldos[e]/dE;
+
+		delete [] ldos;
+
+		return dos;
+	}
+
+	double *moments = new double[numRandomVectors*numCoefficients];
+	cSolver->calculateStochasticMoments(
+		numRandomVectors,
+		numCoefficients,
+		moments
+	);
+
+	Property::DOS dos(lowerBound, upperBound, energyResolution);
+	standardError = Property::DOS(
+		lowerBound,
+		upperBound,
+		energyResolution
+	);
+	double *dosData = dos.getDataRW();
+	double *standardErrorData = standardError.getDataRW();
+
+	//Reconstruct the DOS for each random vector separately to be able
+	//to estimate the error from the spread between them.
+	double *densities = new double[numRandomVectors*energyResolution];
+	for(unsigned int r = 0; r < numRandomVectors; r++){
+		reconstructDensity(
+			&moments[r*numCoefficients],
+			&densities[r*energyResolution]
+		);
+	}
+
+	for(int e = 0; e < energyResolution; e++){
+		double mean = 0.;
+		for(unsigned int r = 0; r < numRandomVectors; r++)
+			mean += densities[r*energyResolution + e];
+		mean /= numRandomVectors;
+		dosData[e] = mean;
+
+		if(numRandomVectors > 1){
+			double variance = 0.;
+			for(unsigned int r = 0; r < numRandomVectors; r++){
+				double difference
+					= densities[r*energyResolution + e]
+					- mean;
+				variance += difference*difference;
+			}
+			variance /= numRandomVectors - 1;
+			standardErrorData[e] = sqrt(variance/numRandomVectors);
+		}
+	}
+
+	delete [] densities;
+	delete [] moments;
+
+	return dos;
+}
+
 //Property::GreensFunction* CPropertyExtractor::calculateGreensFunction(
 Property::GreensFunction ChebyshevExpander::calculateGreensFunction(
 	Index to,
@@ -391,7 +499,7 @@ Property::Density ChebyshevExpander::calculateDensity(
 
 	calculate(
 		calculateDensityCallback,
-		(void*)density.getDataRW(),
+		density,
 		pattern,
 		ranges,
 		0,
@@ -462,7 +570,7 @@ Property::Magnetization ChebyshevExpander::calculateMagnetization(
 
 	calculate(
 		calculateMAGCallback,
-		(void*)magnetization.getDataRW(),
+		magnetization,
 		pattern,
 		ranges,
 		0,
@@ -521,14 +629,21 @@ Property::LDOS ChebyshevExpander::calculateLDOS(Index pattern, Index ranges){
 		energyResolution
 	);
 
+	//The LDOS is batched through ldosBatch, which is shared between the
+	//callbacks. Execute them serially and flush the batch into the same
+	//buffer as the callbacks write to.
+	bool parallelExecution = getParallelExecution();
+	setParallelExecution(false);
 	calculate(
 		calculateLDOSCallback,
-		(void*)ldos.getDataRW(),
+		ldos,
 		pattern,
 		ranges,
 		0,
 		/*1*/energyResolution
 	);
+	calculateLDOSBatch(ldos.getDataRW());
+	setParallelExecution(parallelExecution);
 
 	return ldos;
 }
@@ -557,12 +672,17 @@ Property::LDOS ChebyshevExpander::calculateLDOS(
 		energyResolution
 	);
 
+	//See calculateLDOS(Index pattern, Index ranges).
+	bool parallelExecution = getParallelExecution();
+	setParallelExecution(false);
 	calculate(
 		calculateLDOSCallback,
 		allIndices,
 		memoryLayout,
 		ldos
 	);
+	calculateLDOSBatch(ldos.getDataRW());
+	setParallelExecution(parallelExecution);
 
 	return ldos;
 }
@@ -605,7 +725,7 @@ Property::SpinPolarizedLDOS ChebyshevExpander::calculateSpinPolarizedLDOS(
 
 	calculate(
 		calculateSP_LDOSCallback,
-		(void*)spinPolarizedLDOS.getDataRW(),
+		spinPolarizedLDOS,
 		pattern,
 		ranges,
 		0,
@@ -749,6 +869,24 @@ void ChebyshevExpander::calculateLDOSCallback(
 ){
 	ChebyshevExpander *pe = (ChebyshevExpander*)cb_this;
 
+	if(pe->useStochasticLDOS){
+		//Collect all Indices and calculate the LDOS for all of them
+		//using the same random vectors.
+		pe->ldosBatch.push_back(make_pair(index, offset));
+
+		return;
+	}
+
+	if(!pe->useGPUToCalculateCoefficients){
+		//Collect the Indices and calculate the LDOS for a full block
+		//of Indices at once.
+		pe->ldosBatch.push_back(make_pair(index, offset));
+		if(pe->ldosBatch.size() >= pe->cSolver->getBlockSize())
+			pe->calculateLDOSBatch((double*)ldos);
+
+		return;
+	}
+
 	Property::GreensFunction greensFunction = pe->calculateGreensFunction(
 		index,
 		index,
@@ -789,6 +927,165 @@ void ChebyshevExpander::calculateSP_LDOSCallback(
 	}
 }
 
+void ChebyshevExpander::calculateLDOSBatch(double *ldos){
+	if(ldosBatch.size() == 0)
+		return;
+
+	if(useStochasticLDOS){
+		calculateStochasticLDOSBatch(ldos);
+
+		return;
+	}
+
+	ensureLookupTableIsReady();
+	calculateExactLDOSBatch(ldos);
+}
+
+void ChebyshevExpander::calculateExactLDOSBatch(double *ldos){
+	if(ldosBatch.size() == 0)
+		return;
+
+	vector<Index> indices;
+	for(unsigned int n = 0; n < ldosBatch.size(); n++)
+		indices.push_back(ldosBatch[n].first);
+
+	complex<double> *coefficients
+		= new complex<double>[numCoefficients*indices.size()];
+	cSolver->calculateCoefficientsBlock(
+		indices,
+		indices,
+		coefficients,
+		numCoefficients
+	);
+
+	const double dE = (upperBound - lowerBound)/energyResolution;
+	for(unsigned int n = 0; n < ldosBatch.size(); n++){
+		complex<double> *greensFunctionData;
+		if(useGPUToGenerateGreensFunctions){
+			greensFunctionData = cSolver->generateGreensFunctionGPU(
+				&(coefficients[n*numCoefficients]),
+				Solver::ChebyshevExpander::Type::NonPrincipal
+			);
+		}
+		else if(useLookupTable){
+			greensFunctionData = cSolver->generateGreensFunction(
+				&(coefficients[n*numCoefficients]),
+				Solver::ChebyshevExpander::Type::NonPrincipal
+			);
+		}
+		else{
+			greensFunctionData = cSolver->generateGreensFunction(
+				&(coefficients[n*numCoefficients]),
+				numCoefficients,
+				energyResolution,
+				lowerBound,
+				upperBound,
+				Solver::ChebyshevExpander::Type::NonPrincipal
+			);
+		}
+
+		int offset = ldosBatch[n].second;
+		for(int e = 0; e < energyResolution; e++)
+			ldos[offset + e] += imag(greensFunctionData[e])/M_PI*dE;
+
+		delete [] greensFunctionData;
+	}
+
+	delete [] coefficients;
+	ldosBatch.clear();
+}
+
+void ChebyshevExpander::calculateStochasticLDOSBatch(double *ldos){
+	vector<Index> indices;
+	for(unsigned int n = 0; n < ldosBatch.size(); n++)
+		indices.push_back(ldosBatch[n].first);
+
+	double *moments = new double[numRandomVectors*numCoefficients];
+	double *localMoments = new double[indices.size()*numCoefficients];
+	cSolver->calculateStochasticMoments(
+		numRandomVectors,
+		numCoefficients,
+		moments,
+		indices,
+		localMoments
+	);
+
+	const double dE = (upperBound - lowerBound)/energyResolution;
+	double *density = new double[energyResolution];
+	for(unsigned int n = 0; n < ldosBatch.size(); n++){
+		reconstructDensity(&localMoments[n*numCoefficients], density);
+
+		int offset = ldosBatch[n].second;
+		for(int e = 0; e < energyResolution; e++)
+			ldos[offset + e] += density[e]*dE;
+	}
+
+	delete [] density;
+	delete [] localMoments;
+	delete [] moments;
+	ldosBatch.clear();
+}
+
+void ChebyshevExpander::reconstructDensity(
+	const double *moments,
+	double *density
+) const{
+	//Damp the moments using the kernel to suppress Gibbs oscillations.
+	double *dampedMoments = new double[numCoefficients];
+	for(int n = 0; n < numCoefficients; n++){
+		double g;
+		switch(kernel){
+		case Kernel::Jackson:
+		{
+			double q = M_PI/(numCoefficients + 1);
+			g = (
+				(numCoefficients - n + 1)*cos(q*n)
+				+ sin(q*n)/tan(q)
+			)/(numCoefficients + 1);
+			break;
+		}
+		case Kernel::Lorentz:
+			g = sinh(
+				LORENTZ_KERNEL_LAMBDA*(1 - n/(double)numCoefficients)
+			)/sinh(LORENTZ_KERNEL_LAMBDA);
+			break;
+		default:
+			TBTKExit(
+				"PropertyExtractor::ChebyshevExpander::reconstructDensity()",
+				"Unknown kernel.",
+				"This should never happen, contact the developer."
+			);
+		}
+		dampedMoments[n] = g*moments[n];
+	}
+
+	double scaleFactor = cSolver->getScaleFactor();
+	for(int e = 0; e < energyResolution; e++){
+		double E = lowerBound + (e/(double)energyResolution)*(upperBound - lowerBound);
+		double x = E/scaleFactor;
+		if(x <= -1 || x >= 1){
+			density[e] = 0.;
+			continue;
+		}
+
+		//Evaluate the Chebyshev series using the recursion
+		//T_n(x) = 2xT_{n-1}(x) - T_{n-2}(x).
+		double sum = dampedMoments[0];
+		double t0 = 1.;
+		double t1 = x;
+		for(int n = 1; n < numCoefficients; n++){
+			sum += 2*dampedMoments[n]*t1;
+			double t2 = 2*x*t1 - t0;
+			t0 = t1;
+			t1 = t2;
+		}
+
+		density[e] = sum/(M_PI*scaleFactor*sqrt(1 - x*x));
+	}
+
+	delete [] dampedMoments;
+}
+
 void ChebyshevExpander::ensureLookupTableIsReady(){
 	if(useLookupTable){
 		if(!cSolver->getLookupTableIsGenerated())
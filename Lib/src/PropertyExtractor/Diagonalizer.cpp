@@ -22,6 +22,7 @@
 #include "TBTK/Functions.h"
 #include "TBTK/Streams.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace std;
@@ -29,8 +30,14 @@ using namespace std;
 namespace TBTK{
 namespace PropertyExtractor{
 
+constexpr unsigned int Diagonalizer::ROW_BLOCK_SIZE;
+
 Diagonalizer::Diagonalizer(Solver::Diagonalizer &dSolver){
 	this->dSolver = &dSolver;
+
+	//The callbacks only read from the solver and can therefore be
+	//executed in parallel.
+	setParallelExecution(true);
 }
 
 Diagonalizer::~Diagonalizer(){
@@ -44,7 +51,7 @@ void Diagonalizer::saveEigenValues(string path, string filename){
 	ss << filename;
 	ofstream fout;
 	fout.open(ss.str().c_str());
-	for(int n = 0; n < dSolver->getModel().getBasisSize(); n++){
+	for(int n = 0; n < dSolver->getNumEigenValues(); n++){
 		fout << dSolver->getEigenValues()[n] << "\n";
 	}
 	fout.close();
@@ -65,7 +72,7 @@ void Diagonalizer::getTabulatedHoppingAmplitudeSet(
 }
 
 Property::EigenValues Diagonalizer::getEigenValues(){
-	int size = dSolver->getModel().getBasisSize();
+	int size = dSolver->getNumEigenValues();
 	const double *ev = dSolver->getEigenValues();
 
 	Property::EigenValues eigenValues(size);
@@ -97,7 +104,7 @@ Property::WaveFunctions Diagonalizer::calculateWaveFunctions(
 	vector<unsigned int> statesVector;
 	if(states.size() == 1){
 		if(*states.begin() == IDX_ALL){
-			for(int n = 0; n < dSolver->getModel().getBasisSize(); n++)
+			for(int n = 0; n < dSolver->getNumEigenValues(); n++)
 				statesVector.push_back(n);
 		}
 		else{
@@ -144,11 +151,11 @@ Property::WaveFunctions Diagonalizer::calculateWaveFunctions(
 	Index from,
 	Property::GreensFunction::Type type
 ){
-	unsigned int numPoles = dSolver->getModel().getBasisSize();
+	unsigned int numPoles = dSolver->getNumEigenValues();
 
 	complex<double> *positions = new complex<double>[numPoles];
 	complex<double> *amplitudes = new complex<double>[numPoles];
-	for(int n = 0; n < dSolver->getModel().getBasisSize(); n++){
+	for(int n = 0; n < dSolver->getNumEigenValues(); n++){
 		positions[n] = dSolver->getEigenValue(n);
 
 		complex<double> uTo = dSolver->getAmplitude(n, to);
@@ -177,7 +184,7 @@ Property::DOS Diagonalizer::calculateDOS(){
 	Property::DOS dos(lowerBound, upperBound, energyResolution);
 	double *data = dos.getDataRW();
 	double dE = (upperBound - lowerBound)/energyResolution;
-	for(int n = 0; n < dSolver->getModel().getBasisSize(); n++){
+	for(int n = 0; n < dSolver->getNumEigenValues(); n++){
 		int e = (int)(((ev[n] - lowerBound)/(upperBound - lowerBound))*energyResolution);
 		if(e >= 0 && e < energyResolution){
 			data[e] += 1./dE;
@@ -197,7 +204,7 @@ complex<double> Diagonalizer::calculateExpectationValue(
 
 	Statistics statistics = dSolver->getModel().getStatistics();
 
-	for(int n = 0; n < dSolver->getModel().getBasisSize(); n++){
+	for(int n = 0; n < dSolver->getNumEigenValues(); n++){
 		double weight;
 		if(statistics == Statistics::FermiDirac){
 			weight = Functions::fermiDiracDistribution(
@@ -234,8 +241,15 @@ Property::Density Diagonalizer::calculateDensity(
 	getLoopRanges(pattern, ranges, &lDimensions, &lRanges);
 	Property::Density density(lDimensions, lRanges);
 
+	vector<Index> indices;
+	vector<int> offsets;
+	getIndicesAndOffsets(pattern, ranges, 0, 1, indices, offsets);
+	tabulateDensity(indices);
+
 	calculate(calculateDensityCallback, (void*)density.getDataRW(), pattern, ranges, 0, 1);
 
+	clearTables();
+
 	return density;
 }
 
@@ -258,6 +272,8 @@ Property::Density Diagonalizer::calculateDensity(
 
 	Property::Density density(memoryLayout);
 
+	tabulateDensity(getIndices(allIndices));
+
 	calculate(
 		calculateDensityCallback,
 		allIndices,
@@ -265,6 +281,8 @@ Property::Density Diagonalizer::calculateDensity(
 		density
 	);
 
+	clearTables();
+
 	return density;
 }
 
@@ -298,15 +316,24 @@ Property::Magnetization Diagonalizer::calculateMagnetization(
 	getLoopRanges(pattern, ranges, &lDimensions, &lRanges);
 	Property::Magnetization magnetization(lDimensions, lRanges);
 
+	vector<Index> indices;
+	vector<int> offsets;
+	getIndicesAndOffsets(pattern, ranges, 0, 1, indices, offsets);
+	tabulateMagnetization(
+		indices,
+		vector<int>(indices.size(), ((int*)hint)[0])
+	);
+
 	calculate(
 		calculateMAGCallback,
-		(void*)magnetization.getDataRW(),
+		magnetization,
 		pattern,
 		ranges,
 		0,
 		1
 	);
 
+	clearTables();
 	delete [] (int*)hint;
 
 	return magnetization;
@@ -331,6 +358,24 @@ Property::Magnetization Diagonalizer::calculateMagnetization(
 
 	Property::Magnetization magnetization(memoryLayout);
 
+	vector<Index> indices = getIndices(allIndices);
+	vector<int> spinSubindices;
+	for(unsigned int n = 0; n < indices.size(); n++){
+		vector<unsigned int> spinIndices
+			= memoryLayout.getSubindicesMatching(
+				IDX_SPIN,
+				indices[n],
+				IndexTree::SearchMode::MatchWildcards
+			);
+		//Indices without a unique spin subindex are reported by
+		//calculate().
+		if(spinIndices.size() == 1)
+			spinSubindices.push_back(spinIndices[0]);
+		else
+			spinSubindices.push_back(-1);
+	}
+	tabulateMagnetization(indices, spinSubindices);
+
 	hint = new int[1];
 	calculate(
 		calculateMAGCallback,
@@ -340,6 +385,7 @@ Property::Magnetization Diagonalizer::calculateMagnetization(
 		(int*)hint
 	);
 
+	clearTables();
 	delete [] (int*)hint;
 
 	return magnetization;
@@ -349,18 +395,6 @@ Property::LDOS Diagonalizer::calculateLDOS(
 	Index pattern,
 	Index ranges
 ){
-	//hint[0] is an array of doubles, hint[1] is an array of ints
-	//hint[0][0]: upperBound
-	//hint[0][1]: lowerBound
-	//hint[1][0]: resolution
-	//hint[1][1]: spin_index
-	hint = new void*[2];
-	((double**)hint)[0] = new double[2];
-	((int**)hint)[1] = new int[1];
-	((double**)hint)[0][0] = upperBound;
-	((double**)hint)[0][1] = lowerBound;
-	((int**)hint)[1][0] = energyResolution;
-
 	ensureCompliantRanges(pattern, ranges);
 
 	int lDimensions;
@@ -374,26 +408,21 @@ Property::LDOS Diagonalizer::calculateLDOS(
 		energyResolution
 	);
 
+	vector<Index> indices;
+	vector<int> offsets;
+	getIndicesAndOffsets(pattern, ranges, 0, 1, indices, offsets);
+	tabulateLDOS(indices);
+
 	calculate(calculateLDOSCallback, (void*)ldos.getDataRW(), pattern, ranges, 0, energyResolution);
 
+	clearTables();
+
 	return ldos;
 }
 
 Property::LDOS Diagonalizer::calculateLDOS(
 	std::initializer_list<Index> patterns
 ){
-	//hint[0] is an array of doubles, hint[1] is an array of ints
-	//hint[0][0]: upperBound
-	//hint[0][1]: lowerBound
-	//hint[1][0]: resolution
-	//hint[1][1]: spin_index
-	hint = new void*[2];
-	((double**)hint)[0] = new double[2];
-	((int**)hint)[1] = new int[1];
-	((double**)hint)[0][0] = upperBound;
-	((double**)hint)[0][1] = lowerBound;
-	((int**)hint)[1][0] = energyResolution;
-
 	IndexTree allIndices = generateIndexTree(
 		patterns,
 		*dSolver->getModel().getHoppingAmplitudeSet(),
@@ -415,6 +444,8 @@ Property::LDOS Diagonalizer::calculateLDOS(
 		energyResolution
 	);
 
+	tabulateLDOS(getIndices(allIndices));
+
 	calculate(
 		calculateLDOSCallback,
 		allIndices,
@@ -422,6 +453,8 @@ Property::LDOS Diagonalizer::calculateLDOS(
 		ldos
 	);
 
+	clearTables();
+
 	return ldos;
 }
 
@@ -476,7 +509,7 @@ Property::SpinPolarizedLDOS Diagonalizer::calculateSpinPolarizedLDOS(
 
 	calculate(
 		calculateSP_LDOSCallback,
-		(void*)spinPolarizedLDOS.getDataRW(),
+		spinPolarizedLDOS,
 		pattern,
 		ranges,
 		0,
@@ -545,7 +578,7 @@ double Diagonalizer::calculateEntropy(){
 	Statistics statistics = dSolver->getModel().getStatistics();
 
 	double entropy = 0.;
-	for(int n = 0; n < dSolver->getModel().getBasisSize(); n++){
+	for(int n = 0; n < dSolver->getNumEigenValues(); n++){
 		double p;
 
 		switch(statistics){
@@ -600,25 +633,11 @@ void Diagonalizer::calculateDensityCallback(
 ){
 	Diagonalizer *pe = (Diagonalizer*)cb_this;
 
-	const double *eigen_values = pe->dSolver->getEigenValues();
-	Statistics statistics = pe->dSolver->getModel().getStatistics();
-	for(int n = 0; n < pe->dSolver->getModel().getBasisSize(); n++){
-		double weight;
-		if(statistics == Statistics::FermiDirac){
-			weight = Functions::fermiDiracDistribution(eigen_values[n],
-									pe->dSolver->getModel().getChemicalPotential(),
-									pe->dSolver->getModel().getTemperature());
-		}
-		else{
-			weight = Functions::boseEinsteinDistribution(eigen_values[n],
-									pe->dSolver->getModel().getChemicalPotential(),
-									pe->dSolver->getModel().getTemperature());
-		}
-
-		complex<double> u = pe->dSolver->getAmplitude(n, index);
+	int basisIndex = pe->dSolver->getModel().getBasisIndex(index);
+	if(basisIndex < 0)
+		return;
 
-		((double*)density)[offset] += pow(abs(u), 2)*weight;
-	}
+	((double*)density)[offset] += pe->realTable[pe->basisToRow[basisIndex]];
 }
 
 void Diagonalizer::calculateMAGCallback(
@@ -629,35 +648,19 @@ void Diagonalizer::calculateMAGCallback(
 ){
 	Diagonalizer *pe = (Diagonalizer*)cb_this;
 
-	const double *eigen_values = pe->dSolver->getEigenValues();
-	Statistics statistics = pe->dSolver->getModel().getStatistics();
-
 	int spin_index = ((int*)pe->hint)[0];
 	Index index_u(index);
-	Index index_d(index);
 	index_u.at(spin_index) = 0;
-	index_d.at(spin_index) = 1;
-	for(int n = 0; n < pe->dSolver->getModel().getBasisSize(); n++){
-		double weight;
-		if(statistics == Statistics::FermiDirac){
-			weight = Functions::fermiDiracDistribution(eigen_values[n],
-									pe->dSolver->getModel().getChemicalPotential(),
-									pe->dSolver->getModel().getTemperature());
-		}
-		else{
-			weight = Functions::boseEinsteinDistribution(eigen_values[n],
-									pe->dSolver->getModel().getChemicalPotential(),
-									pe->dSolver->getModel().getTemperature());
-		}
-
-		complex<double> u_u = pe->dSolver->getAmplitude(n, index_u);
-		complex<double> u_d = pe->dSolver->getAmplitude(n, index_d);
-
-		((SpinMatrix*)mag)[offset].at(0, 0) += conj(u_u)*u_u*weight;
-		((SpinMatrix*)mag)[offset].at(0, 1) += conj(u_u)*u_d*weight;
-		((SpinMatrix*)mag)[offset].at(1, 0) += conj(u_d)*u_u*weight;
-		((SpinMatrix*)mag)[offset].at(1, 1) += conj(u_d)*u_d*weight;
-	}
+	int basisIndex = pe->dSolver->getModel().getBasisIndex(index_u);
+	if(basisIndex < 0)
+		return;
+
+	const complex<double> *m
+		= &pe->complexTable[4*pe->basisToRow[basisIndex]];
+	((SpinMatrix*)mag)[offset].at(0, 0) += m[0];
+	((SpinMatrix*)mag)[offset].at(0, 1) += m[1];
+	((SpinMatrix*)mag)[offset].at(1, 0) += m[2];
+	((SpinMatrix*)mag)[offset].at(1, 1) += m[3];
 }
 
 void Diagonalizer::calculateLDOSCallback(
@@ -668,24 +671,15 @@ void Diagonalizer::calculateLDOSCallback(
 ){
 	Diagonalizer *pe = (Diagonalizer*)cb_this;
 
-	const double *eigen_values = pe->dSolver->getEigenValues();
+	int basisIndex = pe->dSolver->getModel().getBasisIndex(index);
+	if(basisIndex < 0)
+		return;
 
-	double u_lim = ((double**)pe->hint)[0][0];
-	double l_lim = ((double**)pe->hint)[0][1];
-	int resolution = ((int**)pe->hint)[1][0];
-
-	double step_size = (u_lim - l_lim)/(double)resolution;
-
-	double dE = (pe->upperBound - pe->lowerBound)/pe->energyResolution;
-	for(int n = 0; n < pe->dSolver->getModel().getBasisSize(); n++){
-		if(eigen_values[n] > l_lim && eigen_values[n] < u_lim){
-			complex<double> u = pe->dSolver->getAmplitude(n, index);
-
-			int e = (int)((eigen_values[n] - l_lim)/step_size);
-			if(e >= resolution)
-				e = resolution-1;
-			((double*)ldos)[offset + e] += real(conj(u)*u)/dE;
-		}
+	unsigned int numRows = pe->realTable.size()/pe->energyResolution;
+	int row = pe->basisToRow[basisIndex];
+	for(int e = 0; e < pe->energyResolution; e++){
+		((double*)ldos)[offset + e]
+			+= pe->realTable[numRows*e + row];
 	}
 }
 
@@ -711,7 +705,7 @@ void Diagonalizer::calculateSP_LDOSCallback(
 	index_u.at(spin_index) = 0;
 	index_d.at(spin_index) = 1;
 	double dE = (pe->upperBound - pe->lowerBound)/pe->energyResolution;
-	for(int n = 0; n < pe->dSolver->getModel().getBasisSize(); n++){
+	for(int n = 0; n < pe->dSolver->getNumEigenValues(); n++){
 		if(eigen_values[n] > l_lim && eigen_values[n] < u_lim){
 			complex<double> u_u = pe->dSolver->getAmplitude(n, index_u);
 			complex<double> u_d = pe->dSolver->getAmplitude(n, index_d);
@@ -727,5 +721,202 @@ void Diagonalizer::calculateSP_LDOSCallback(
 	}
 }
 
+vector<double> Diagonalizer::calculateOccupations(){
+	const double *eigenValues = dSolver->getEigenValues();
+	const Model &model = dSolver->getModel();
+	Statistics statistics = model.getStatistics();
+	double chemicalPotential = model.getChemicalPotential();
+	double temperature = model.getTemperature();
+
+	vector<double> occupations(dSolver->getNumEigenValues());
+	for(unsigned int n = 0; n < occupations.size(); n++){
+		if(statistics == Statistics::FermiDirac){
+			occupations[n] = Functions::fermiDiracDistribution(
+				eigenValues[n],
+				chemicalPotential,
+				temperature
+			);
+		}
+		else{
+			occupations[n] = Functions::boseEinsteinDistribution(
+				eigenValues[n],
+				chemicalPotential,
+				temperature
+			);
+		}
+	}
+
+	return occupations;
+}
+
+vector<Index> Diagonalizer::getIndices(const IndexTree &indexTree){
+	vector<Index> indices;
+	IndexTree::Iterator it = indexTree.begin();
+	while(!it.getHasReachedEnd()){
+		indices.push_back(it.getIndex());
+		it.searchNext();
+	}
+
+	return indices;
+}
+
+vector<int> Diagonalizer::setupRows(const vector<Index> &indices){
+	const Model &model = dSolver->getModel();
+	basisToRow.assign(model.getBasisSize(), -1);
+
+	vector<int> rows;
+	for(unsigned int n = 0; n < indices.size(); n++){
+		int basisIndex = model.getBasisIndex(indices[n]);
+		if(basisIndex < 0 || basisToRow[basisIndex] != -1)
+			continue;
+
+		basisToRow[basisIndex] = rows.size();
+		rows.push_back(basisIndex);
+	}
+
+	return rows;
+}
+
+void Diagonalizer::tabulateDensity(const vector<Index> &indices){
+	vector<int> rows = setupRows(indices);
+	vector<double> occupations = calculateOccupations();
+	const complex<double> *eigenVectors = dSolver->getEigenVectors();
+	unsigned int basisSize = dSolver->getModel().getBasisSize();
+	unsigned int numRows = rows.size();
+
+	realTable.assign(numRows, 0);
+	unsigned int numBlocks = (numRows + ROW_BLOCK_SIZE - 1)/ROW_BLOCK_SIZE;
+	#pragma omp parallel for schedule(dynamic)
+	for(unsigned int block = 0; block < numBlocks; block++){
+		unsigned int begin = block*ROW_BLOCK_SIZE;
+		unsigned int end = min(begin + ROW_BLOCK_SIZE, numRows);
+		for(unsigned int n = 0; n < occupations.size(); n++){
+			if(occupations[n] == 0)
+				continue;
+
+			const complex<double> *state
+				= &eigenVectors[(size_t)basisSize*n];
+			for(unsigned int r = begin; r < end; r++)
+				realTable[r] += occupations[n]*norm(state[rows[r]]);
+		}
+	}
+}
+
+void Diagonalizer::tabulateMagnetization(
+	const vector<Index> &indices,
+	const vector<int> &spinSubindices
+){
+	const Model &model = dSolver->getModel();
+
+	vector<Index> indicesUp;
+	for(unsigned int n = 0; n < indices.size(); n++){
+		if(spinSubindices[n] < 0)
+			continue;
+
+		indicesUp.push_back(indices[n]);
+		indicesUp.back().at(spinSubindices[n]) = 0;
+	}
+	vector<int> rowsUp = setupRows(indicesUp);
+	vector<int> rowsDown(rowsUp.size(), -1);
+	for(unsigned int n = 0; n < indices.size(); n++){
+		if(spinSubindices[n] < 0)
+			continue;
+
+		Index indexUp(indices[n]);
+		Index indexDown(indices[n]);
+		indexUp.at(spinSubindices[n]) = 0;
+		indexDown.at(spinSubindices[n]) = 1;
+		int basisIndexUp = model.getBasisIndex(indexUp);
+		if(basisIndexUp >= 0){
+			rowsDown[basisToRow[basisIndexUp]]
+				= model.getBasisIndex(indexDown);
+		}
+	}
+
+	vector<double> occupations = calculateOccupations();
+	const complex<double> *eigenVectors = dSolver->getEigenVectors();
+	unsigned int basisSize = model.getBasisSize();
+	unsigned int numRows = rowsUp.size();
+
+	complexTable.assign(4*numRows, 0);
+	unsigned int numBlocks = (numRows + ROW_BLOCK_SIZE - 1)/ROW_BLOCK_SIZE;
+	#pragma omp parallel for schedule(dynamic)
+	for(unsigned int block = 0; block < numBlocks; block++){
+		unsigned int begin = block*ROW_BLOCK_SIZE;
+		unsigned int end = min(begin + ROW_BLOCK_SIZE, numRows);
+		for(unsigned int n = 0; n < occupations.size(); n++){
+			if(occupations[n] == 0)
+				continue;
+
+			const complex<double> *state
+				= &eigenVectors[(size_t)basisSize*n];
+			for(unsigned int r = begin; r < end; r++){
+				complex<double> u_u = state[rowsUp[r]];
+				complex<double> u_d = 0;
+				if(rowsDown[r] >= 0)
+					u_d = state[rowsDown[r]];
+
+				complex<double> *m = &complexTable[4*r];
+				m[0] += conj(u_u)*u_u*occupations[n];
+				m[1] += conj(u_u)*u_d*occupations[n];
+				m[2] += conj(u_d)*u_u*occupations[n];
+				m[3] += conj(u_d)*u_d*occupations[n];
+			}
+		}
+	}
+}
+
+void Diagonalizer::tabulateLDOS(const vector<Index> &indices){
+	vector<int> rows = setupRows(indices);
+	const double *eigenValues = dSolver->getEigenValues();
+	const complex<double> *eigenVectors = dSolver->getEigenVectors();
+	unsigned int basisSize = dSolver->getModel().getBasisSize();
+	unsigned int numRows = rows.size();
+
+	//Energy bin of each eigenvalue, -1 for eigenvalues outside of the
+	//energy window.
+	double stepSize = (upperBound - lowerBound)/energyResolution;
+	vector<int> bins(dSolver->getNumEigenValues());
+	for(unsigned int n = 0; n < bins.size(); n++){
+		if(eigenValues[n] > lowerBound && eigenValues[n] < upperBound){
+			bins[n] = (int)((eigenValues[n] - lowerBound)/stepSize);
+			if(bins[n] >= energyResolution)
+				bins[n] = energyResolution-1;
+		}
+		else{
+			bins[n] = -1;
+		}
+	}
+
+	//The row index runs fastest, which makes the updates for a given
+	//eigenstate contiguous in memory.
+	realTable.assign((size_t)numRows*energyResolution, 0);
+	unsigned int numBlocks = (numRows + ROW_BLOCK_SIZE - 1)/ROW_BLOCK_SIZE;
+	#pragma omp parallel for schedule(dynamic)
+	for(unsigned int block = 0; block < numBlocks; block++){
+		unsigned int begin = block*ROW_BLOCK_SIZE;
+		unsigned int end = min(begin + ROW_BLOCK_SIZE, numRows);
+		for(unsigned int n = 0; n < bins.size(); n++){
+			if(bins[n] == -1)
+				continue;
+
+			const complex<double> *state
+				= &eigenVectors[(size_t)basisSize*n];
+			double *histogram = &realTable[(size_t)numRows*bins[n]];
+			for(unsigned int r = begin; r < end; r++)
+				histogram[r] += norm(state[rows[r]])/stepSize;
+		}
+	}
+}
+
+void Diagonalizer::clearTables(){
+	basisToRow.clear();
+	basisToRow.shrink_to_fit();
+	realTable.clear();
+	realTable.shrink_to_fit();
+	complexTable.clear();
+	complexTable.shrink_to_fit();
+}
+
 };	//End of namespace PropertyExtractor
 };	//End of namespace TBTK
@@ -366,7 +366,7 @@ Property::Magnetization ExactDiagonalizer::calculateMagnetization(
 
 	calculate(
 		calculateMagnetizationCallback,
-		(void*)magnetization.getDataRW(),
+		magnetization,
 		pattern,
 		ranges,
 		0,
@@ -397,7 +397,7 @@ Property::LDOS ExactDiagonalizer::calculateLDOS(
 
 	calculate(
 		calculateLDOSCallback,
-		(void*)ldos.getDataRW(),
+		ldos,
 		pattern,
 		ranges,
 		0,
@@ -445,7 +445,7 @@ Property::SpinPolarizedLDOS ExactDiagonalizer::calculateSpinPolarizedLDOS(
 
 	calculate(
 		calculateSpinPolarizedLDOSCallback,
-		(void*)spinPolarizedLDOS.getDataRW(),
+		spinPolarizedLDOS,
 		pattern,
 		ranges,
 		0,
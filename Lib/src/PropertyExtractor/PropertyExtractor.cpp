@@ -21,6 +21,8 @@
 #include "TBTK/PropertyExtractor/PropertyExtractor.h"
 #include "TBTK/TBTKMacros.h"
 
+#include <algorithm>
+
 using namespace std;
 
 namespace TBTK{
@@ -31,6 +33,7 @@ PropertyExtractor::PropertyExtractor(
 	this->energyResolution = ENERGY_RESOLUTION;
 	this->lowerBound = LOWER_BOUND;
 	this->upperBound = UPPER_BOUND;
+	this->parallelExecution = false;
 }
 
 PropertyExtractor::~PropertyExtractor(){
@@ -169,6 +172,34 @@ void PropertyExtractor::calculate(
 	const Index &ranges,
 	int currentOffset,
 	int offsetMultiplier
+){
+	vector<Index> indices;
+	vector<int> offsets;
+	getIndicesAndOffsets(
+		pattern,
+		ranges,
+		currentOffset,
+		offsetMultiplier,
+		indices,
+		offsets
+	);
+
+	if(parallelExecution){
+		calculateInParallel(callback, memory, indices, offsets);
+	}
+	else{
+		for(unsigned int n = 0; n < indices.size(); n++)
+			callback(this, memory, indices[n], offsets[n]);
+	}
+}
+
+void PropertyExtractor::getIndicesAndOffsets(
+	Index pattern,
+	const Index &ranges,
+	int currentOffset,
+	int offsetMultiplier,
+	vector<Index> &indices,
+	vector<int> &offsets
 ){
 	int currentSubindex = pattern.getSize()-1;
 	for(; currentSubindex >= 0; currentSubindex--){
@@ -177,7 +208,8 @@ void PropertyExtractor::calculate(
 	}
 
 	if(currentSubindex == -1){
-		callback(this, memory, pattern, currentOffset);
+		indices.push_back(pattern);
+		offsets.push_back(currentOffset);
 	}
 	else{
 		TBTKAssert(
@@ -195,13 +227,13 @@ void PropertyExtractor::calculate(
 			isSumIndex = true;
 		for(int n = 0; n < ranges.at(currentSubindex); n++){
 			pattern.at(currentSubindex) = n;
-			calculate(
-				callback,
-				memory,
+			getIndicesAndOffsets(
 				pattern,
 				ranges,
 				currentOffset,
-				nextOffsetMultiplier
+				nextOffsetMultiplier,
+				indices,
+				offsets
 			);
 			if(!isSumIndex)
 				currentOffset += offsetMultiplier;
@@ -209,6 +241,66 @@ void PropertyExtractor::calculate(
 	}
 }
 
+void PropertyExtractor::calculateInParallel(
+	void (*callback)(
+		PropertyExtractor *cb_this,
+		void *memory,
+		const Index &index,
+		int offset
+	),
+	void *memory,
+	const vector<Index> &indices,
+	const vector<int> &offsets
+){
+	//Group the indices by offset, keeping the original order within each
+	//group. Every group is handled by a single thread, which guarantees
+	//that no two threads write to the same memory and that the result is
+	//identical to that of serial execution.
+	vector<unsigned int> order(indices.size());
+	for(unsigned int n = 0; n < order.size(); n++)
+		order[n] = n;
+	stable_sort(
+		order.begin(),
+		order.end(),
+		[&offsets](unsigned int lhs, unsigned int rhs){
+			return offsets[lhs] < offsets[rhs];
+		}
+	);
+	vector<unsigned int> groupBegins;
+	for(unsigned int n = 0; n < order.size(); n++)
+		if(n == 0 || offsets[order[n]] != offsets[order[n-1]])
+			groupBegins.push_back(n);
+	groupBegins.push_back(order.size());
+
+	#pragma omp parallel for schedule(dynamic)
+	for(unsigned int group = 0; group < groupBegins.size()-1; group++){
+		for(
+			unsigned int n = groupBegins[group];
+			n < groupBegins[group+1];
+			n++
+		){
+			callback(
+				this,
+				memory,
+				indices[order[n]],
+				offsets[order[n]]
+			);
+		}
+	}
+}
+
+unsigned int PropertyExtractor::getNumDistinctOffsets(
+	const vector<int> &offsets
+){
+	vector<int> sortedOffsets = offsets;
+	sort(sortedOffsets.begin(), sortedOffsets.end());
+
+	return unique(
+		sortedOffsets.begin(),
+		sortedOffsets.end()
+	) - sortedOffsets.begin();
+}
+
 void PropertyExtractor::ensureCompliantRanges(
 	const Index &pattern,
 	Index &ranges
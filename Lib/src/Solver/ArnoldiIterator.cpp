@@ -25,6 +25,7 @@
  * See http://www.caam.rice.edu/software/ARPACK/UG/node138.html for more
  * information about parameters. */
 
+#include "TBTK/EigenPairSorter.h"
 #include "TBTK/Solver/ArnoldiIterator.h"
 #include "TBTK/Streams.h"
 #include "TBTK/TBTKMacros.h"
@@ -168,6 +169,7 @@ void ArnoldiIterator::run(){
 	case Mode::Normal:
 		initNormal();
 		arnoldiLoop();
+		hamiltonian.reset();
 		break;
 	case Mode::ShiftAndInvert:
 		initShiftAndInvert();
@@ -183,6 +185,41 @@ void ArnoldiIterator::run(){
 	sort();
 }
 
+vector<ArnoldiIterator::EigenPairs> ArnoldiIterator::run(
+	const vector<double> &centralValues
+){
+	TBTKAssert(
+		mode == Mode::ShiftAndInvert,
+		"ArnoldiIterator::run()",
+		"Multiple central values are only supported in"
+		<< " Mode::ShiftAndInvert.",
+		"Use ArnoldiIterator::setMode() to set the mode."
+	);
+
+	unsigned int basisSize = getModel().getBasisSize();
+	vector<EigenPairs> result;
+	for(unsigned int n = 0; n < centralValues.size(); n++){
+		shift = centralValues[n];
+		run();
+
+		result.push_back(EigenPairs());
+		EigenPairs &eigenPairs = result.back();
+		eigenPairs.centralValue = shift;
+		eigenPairs.eigenValues.assign(
+			eigenValues,
+			eigenValues + numEigenValues
+		);
+		if(calculateEigenVectors){
+			eigenPairs.eigenVectors.assign(
+				eigenVectors,
+				eigenVectors + (size_t)numEigenValues*basisSize
+			);
+		}
+	}
+
+	return result;
+}
+
 void ArnoldiIterator::arnoldiLoop(){
 	TBTKAssert(
 		numEigenValues > 0,
@@ -242,6 +279,20 @@ void ArnoldiIterator::arnoldiLoop(){
 	//Integer "pointer" used by ARPACK to index into workd
 	int ipntr[14];
 
+	//Free the output from previous runs.
+	if(residuals != NULL){
+		delete [] residuals;
+		residuals = NULL;
+	}
+	if(eigenValues != NULL){
+		delete [] eigenValues;
+		eigenValues = NULL;
+	}
+	if(eigenVectors != NULL){
+		delete [] eigenVectors;
+		eigenVectors = NULL;
+	}
+
 	if(
 		false	//Se comment below
 		&& mode == Mode::ShiftAndInvert
@@ -655,13 +706,25 @@ bool ArnoldiIterator::executeReverseCommunicationMessage(
 			for(int n = 0; n < basisSize; n++)
 				workd[(ipntr[1] - 1) + n] = 0.;
 
-			const Model &model = getModel();
-			int numMatrixElements = model.getHoppingAmplitudeSet()->getNumMatrixElements();
-			const int *cooRowIndices = model.getHoppingAmplitudeSet()->getCOORowIndices();
-			const int *cooColIndices = model.getHoppingAmplitudeSet()->getCOOColIndices();
-			const complex<double> *cooValues = model.getHoppingAmplitudeSet()->getCOOValues();
-			for(int n = 0; n < numMatrixElements; n++)
-				workd[(ipntr[1] - 1) + cooRowIndices[n]] += cooValues[n]*workd[(ipntr[0] - 1) + cooColIndices[n]];
+			const unsigned int *rowPointers
+				= hamiltonian->getCSRRowPointers();
+			const unsigned int *columns
+				= hamiltonian->getCSRColumns();
+			const complex<double> *values
+				= hamiltonian->getCSRValues();
+			for(int row = 0; row < basisSize; row++){
+				for(
+					unsigned int n = rowPointers[row];
+					n < rowPointers[row+1];
+					n++
+				){
+					workd[(ipntr[1] - 1) + row]
+						+= values[n]*workd[
+							(ipntr[0] - 1)
+							+ columns[n]
+						];
+				}
+			}
 
 			break;
 		}
@@ -734,126 +797,37 @@ void ArnoldiIterator::checkZneupdIerr(int ierr) const{
 }
 
 void ArnoldiIterator::initNormal(){
-	//Get matrix representation on COO format
-	const Model &model = getModel();
-	const int *cooRowIndices = model.getHoppingAmplitudeSet()->getCOORowIndices();
-	const int *cooColIndices = model.getHoppingAmplitudeSet()->getCOOColIndices();
-	TBTKAssert(
-		cooRowIndices != NULL && cooColIndices != NULL,
-		"ArnoldiIterator::initNormal()",
-		"COO format not constructed.",
-		"Use Model::constructCOO() to construct COO format."
-	);
+	//Get the matrix representation on CSR format once before the
+	//iteration starts.
+	hamiltonian = getModel().getHoppingAmplitudeSet()->getSparseMatrix();
 }
 
 void ArnoldiIterator::initShiftAndInvert(){
 	const Model &model = getModel();
 
-	SparseMatrix<complex<double>> matrix(
-		SparseMatrix<complex<double>>::StorageFormat::CSC
-	);
-
-	HoppingAmplitudeSet::Iterator it = getModel().getHoppingAmplitudeSet(
-	)->getIterator();
-	const HoppingAmplitude *ha;
-	while((ha = it.getHA())){
-		int from = model.getHoppingAmplitudeSet()->getBasisIndex(
-			ha->getFromIndex()
-		);
-		int to = model.getHoppingAmplitudeSet()->getBasisIndex(
-			ha->getToIndex()
-		);
-		matrix.add(to, from, ha->getAmplitude());
-
-		it.searchNextHA();
-	}
+	SparseMatrix<complex<double>> matrix
+		= *model.getHoppingAmplitudeSet()->getSparseMatrix();
 	for(int n = 0; n < model.getBasisSize(); n++)
 		matrix.add(n, n, -shift);
-	matrix.constructCSX();
+	matrix.setStorageFormat(
+		SparseMatrix<complex<double>>::StorageFormat::CSC
+	);
 
 	luSolver.setMatrix(matrix);
 }
 
 void ArnoldiIterator::sort(){
-	complex<double> *workspace = new complex<double>[numEigenValues];
-	for(int n = 0; n < numEigenValues; n++)
-		workspace[n] = eigenValues[n];
-
-	int *order = new int[numEigenValues];
-	int *orderWorkspace = new int[numEigenValues];
-	for(int n = 0; n < numEigenValues; n++){
-		order[n] = n;
-		orderWorkspace[n] = n;
-	}
-
-	mergeSortSplit(
-		workspace,
+	vector<unsigned int> permutation = EigenPairSorter::getPermutation(
 		eigenValues,
-		orderWorkspace,
-		order,
-		0,
 		numEigenValues
 	);
-
-	const Model &model = getModel();
+	EigenPairSorter::permute(eigenValues, permutation);
 	if(calculateEigenVectors){
-		complex<double> *eigenVectorsWorkspace = new complex<double>[numEigenValues*model.getBasisSize()];
-		for(int n = 0; n < numEigenValues*model.getBasisSize(); n++)
-			eigenVectorsWorkspace[n] = eigenVectors[n];
-
-		for(int n = 0; n < numEigenValues; n++)
-			for(int c = 0; c < model.getBasisSize(); c++)
-				eigenVectors[n*model.getBasisSize() + c] = eigenVectorsWorkspace[order[n]*model.getBasisSize() + c];
-
-		delete [] eigenVectorsWorkspace;
-	}
-
-	delete [] order;
-	delete [] orderWorkspace;
-	delete [] workspace;
-}
-
-void ArnoldiIterator::mergeSortSplit(
-	complex<double> *dataIn,
-	complex<double> *dataOut,
-	int *orderIn,
-	int *orderOut,
-	int first,
-	int end
-){
-	if(end - first < 2)
-		return;
-
-	int middle = (end + first)/2;
-
-	mergeSortSplit(dataOut, dataIn, orderOut, orderIn, first, middle);
-	mergeSortSplit(dataOut, dataIn, orderOut, orderIn, middle, end);
-
-	mergeSortMerge(dataIn, dataOut, orderIn, orderOut, first, middle, end);
-}
-
-void ArnoldiIterator::mergeSortMerge(
-	complex<double> *dataIn,
-	complex<double> *dataOut,
-	int *orderIn,
-	int *orderOut,
-	int first,
-	int middle,
-	int end
-){
-	int i = first;
-	int j = middle;
-	for(int k = first; k < end; k++){
-		if(i < middle && (j >= end || real(dataIn[i]) <= real(dataIn[j]))){
-			dataOut[k] = dataIn[i];
-			orderOut[k] = orderIn[i];
-			i++;
-		}
-		else{
-			dataOut[k] = dataIn[j];
-			orderOut[k] = orderIn[j];
-			j++;
-		}
+		EigenPairSorter::permute(
+			eigenVectors,
+			permutation,
+			getModel().getBasisSize()
+		);
 	}
 }
 
@@ -22,23 +22,33 @@
 #include "TBTK/Streams.h"
 #include "TBTK/TBTKMacros.h"
 
+#include <algorithm>
 #include <iomanip>
 
+#ifdef TBTK_USE_OPEN_MP
+#include <omp.h>
+#endif
+
 using namespace std;
 
 namespace TBTK{
 namespace Solver{
 
+constexpr unsigned int BlockDiagonalizer::DEFAULT_LARGE_BLOCK_THRESHOLD;
+
 BlockDiagonalizer::BlockDiagonalizer() : Communicator(true){
 	hamiltonian = nullptr;
 	eigenValues = nullptr;
 	eigenVectors = nullptr;
 	numBlocks = -1;
 
+	eigenSolutionCache = nullptr;
+
 	maxIterations = 50;
 	selfConsistencyCallback = nullptr;
 
 	parallelExecution = false;
+	largeBlockThreshold = DEFAULT_LARGE_BLOCK_THRESHOLD;
 }
 
 BlockDiagonalizer::~BlockDiagonalizer(){
@@ -243,6 +253,8 @@ void BlockDiagonalizer::init(){
 	eigenValues = new double[getModel().getBasisSize()];
 	eigenVectors = new complex<double>[eigenVectorsSize];
 
+	initSchedule();
+
 	update();
 }
 
@@ -400,94 +412,181 @@ extern "C" void zhbeb_(
 	double *rwork,		//Workspace, dimension = max(1, 3*N-2)
 	int *info);		//0 = successful, <0 = -info value was illegal, >0 = info number of off-diagonal elements failed to converge.
 
+//Lapack function for divide and conquer diagonalization of a full matrix.
+extern "C" void zheevd_(
+	char *jobz,		//'N' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+	char *uplo,		//'U' = Upper triangle stored, 'L' = Lower triangle stored.
+	int *n,			//n*n = Matrix size
+	complex<double> *a,	//Input matrix, overwritten by the eigenvectors if jobz = 'V'
+	int *lda,		//Leading dimension of a
+	double *w,		//Eigenvalues in ascending order
+	complex<double> *work,	//Workspace
+	int *lwork,		//Size of work, -1 = workspace query
+	double *rwork,		//Workspace
+	int *lrwork,		//Size of rwork, -1 = workspace query
+	int *iwork,		//Workspace
+	int *liwork,		//Size of iwork, -1 = workspace query
+	int *info);		//0 = successful, <0 = -info value was illegal, >0 = failed to converge.
+
+void BlockDiagonalizer::initSchedule(){
+	//Sort the blocks into large blocks, which are diagonalized one at a
+	//time with zheevd and a multithreaded BLAS, and small blocks, which
+	//are distributed over the threads. The cost of diagonalizing a block
+	//scales as n^3, so small blocks are sorted in order of decreasing
+	//size to let the dynamic schedule start with the most expensive
+	//blocks.
+	largeBlocks.clear();
+	smallBlocks.clear();
+	int maxLargeBlockSize = 0;
+	for(int b = 0; b < numBlocks; b++){
+		int n = numStatesPerBlock.at(b);
+		if(n >= (int)largeBlockThreshold){
+			largeBlocks.push_back(b);
+			maxLargeBlockSize = max(maxLargeBlockSize, n);
+		}
+		else{
+			smallBlocks.push_back(b);
+		}
+	}
+	stable_sort(
+		smallBlocks.begin(),
+		smallBlocks.end(),
+		[this](unsigned int lhs, unsigned int rhs){
+			return numStatesPerBlock[lhs] > numStatesPerBlock[rhs];
+		}
+	);
+
+	if(getGlobalVerbose() && getVerbose()){
+		Streams::out << "\tNumber of large blocks: "
+			<< largeBlocks.size() << "\n";
+		Streams::out << "\tNumber of small blocks: "
+			<< smallBlocks.size() << "\n";
+	}
+
+	//Workspaces for zhpev. Resized to one per thread in solve(), since
+	//parallel execution and the number of threads can change between
+	//calls.
+	smallBlockWorkspaces.clear();
+	resizeSmallBlockWorkspaces(1);
+
+	//Workspace for zheevd. The required size grows with the size of the
+	//matrix, so the workspace for the largest block is sufficient for
+	//all large blocks.
+	largeBlockWorkspace.work.clear();
+	largeBlockWorkspace.rwork.clear();
+	largeBlockWorkspace.iwork.clear();
+	if(largeBlocks.size() != 0){
+		char jobz = 'V';
+		char uplo = 'U';
+		int n = maxLargeBlockSize;
+		complex<double> workSize;
+		double rworkSize;
+		int iworkSize;
+		int lwork = -1;
+		int lrwork = -1;
+		int liwork = -1;
+		int info;
+		zheevd_(&jobz, &uplo, &n, eigenVectors, &n, eigenValues, &workSize, &lwork, &rworkSize, &lrwork, &iworkSize, &liwork, &info);
+
+		TBTKAssert(
+			info == 0,
+			"BlockDiagonalizer::initSchedule()",
+			"Workspace query for zheevd exited with INFO=" + to_string(info) + ".",
+			"See LAPACK documentation for zheevd for further information."
+		);
+
+		largeBlockWorkspace.work.resize((int)real(workSize));
+		largeBlockWorkspace.rwork.resize((int)rworkSize);
+		largeBlockWorkspace.iwork.resize(iworkSize);
+	}
+}
+
+void BlockDiagonalizer::resizeSmallBlockWorkspaces(
+	unsigned int numWorkspaces
+){
+	if(smallBlockWorkspaces.size() >= numWorkspaces)
+		return;
+
+	//The small blocks are sorted by decreasing size.
+	int maxSmallBlockSize = 0;
+	if(smallBlocks.size() != 0)
+		maxSmallBlockSize = numStatesPerBlock.at(smallBlocks[0]);
+
+	unsigned int oldNumWorkspaces = smallBlockWorkspaces.size();
+	smallBlockWorkspaces.resize(numWorkspaces);
+	for(unsigned int n = oldNumWorkspaces; n < numWorkspaces; n++){
+		Workspace &workspace = smallBlockWorkspaces[n];
+		workspace.work.resize(max(1, 2*maxSmallBlockSize-1));
+		workspace.rwork.resize(max(1, 3*maxSmallBlockSize-2));
+	}
+}
+
 void BlockDiagonalizer::solve(){
-	if(true){//Currently no support for banded matrices.
-		if(parallelExecution){
-			vector<unsigned int> eigenValuesOffsets;
-			eigenValuesOffsets.push_back(0);
-			for(int b = 1; b < numBlocks; b++){
-				eigenValuesOffsets.push_back(
-					eigenValuesOffsets[b-1]
-					+ numStatesPerBlock[b]
-				);
-			}
+	unsigned int basisSize = getModel().getBasisSize();
+	size_t eigenVectorsSize = 0;
+	for(unsigned int n = 0; n < eigenVectorSizes.size(); n++)
+		eigenVectorsSize += eigenVectorSizes[n];
+
+	unsigned long long hash = 0;
+	if(eigenSolutionCache != nullptr){
+		hash = getModel().getHash();
+		if(
+			eigenSolutionCache->load(
+				hash,
+				basisSize,
+				eigenVectorsSize,
+				eigenValues,
+				eigenVectors
+			)
+		){
+			return;
+		}
+	}
 
-			#pragma omp parallel for
-			for(int b = 0; b < numBlocks; b++){
-				//Setup zhpev to calculate...
-				char jobz = 'V';			//...eigenvalues and eigenvectors...
-				char uplo = 'U';			//...for an upper triangular...
-				int n = numStatesPerBlock.at(b);	//...nxn-matrix.
-				//Initialize workspaces
-				complex<double> *work = new complex<double>[(2*n-1)];
-				double *rwork = new double[3*n-2];
-				int info;
-				//Solve brop
-				zhpev_(
-					&jobz,
-					&uplo,
-					&n,
-					hamiltonian + blockOffsets.at(b),
-					eigenValues + eigenValuesOffsets[b],
-					eigenVectors + eigenVectorOffsets.at(b),
-					&n,
-					work,
-					rwork,
-					&info
-				);
+	if(true){//Currently no support for banded matrices.
+		//Large blocks are solved one at a time, with the parallelism
+		//provided by the BLAS.
+		for(unsigned int n = 0; n < largeBlocks.size(); n++)
+			solveLargeBlock(largeBlocks[n]);
 
-				TBTKAssert(
-					info == 0,
-					"Diagonalizer:solve()",
-					"Diagonalization routine zhpev exited with INFO=" + to_string(info) + ".",
-					"See LAPACK documentation for zhpev for further information."
+		if(parallelExecution){
+			int numThreads = 1;
+#ifdef TBTK_USE_OPEN_MP
+			numThreads = omp_get_max_threads();
+#endif
+			resizeSmallBlockWorkspaces(numThreads);
+
+			#pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+			for(unsigned int n = 0; n < smallBlocks.size(); n++){
+				unsigned int thread = 0;
+#ifdef TBTK_USE_OPEN_MP
+				thread = omp_get_thread_num();
+#endif
+				solveSmallBlock(
+					smallBlocks[n],
+					smallBlockWorkspaces[thread]
 				);
-
-				//Delete workspaces
-				delete [] work;
-				delete [] rwork;
 			}
 		}
 		else{
-			unsigned int eigenValuesOffset = 0;
-			for(int b = 0; b < numBlocks; b++){
-				//Setup zhpev to calculate...
-				char jobz = 'V';			//...eigenvalues and eigenvectors...
-				char uplo = 'U';			//...for an upper triangular...
-				int n = numStatesPerBlock.at(b);	//...nxn-matrix.
-				//Initialize workspaces
-				complex<double> *work = new complex<double>[(2*n-1)];
-				double *rwork = new double[3*n-2];
-				int info;
-				//Solve brop
-				zhpev_(
-					&jobz,
-					&uplo,
-					&n,
-					hamiltonian + blockOffsets.at(b),
-					eigenValues + eigenValuesOffset,
-					eigenVectors + eigenVectorOffsets.at(b),
-					&n,
-					work,
-					rwork,
-					&info
+			for(unsigned int n = 0; n < smallBlocks.size(); n++){
+				solveSmallBlock(
+					smallBlocks[n],
+					smallBlockWorkspaces[0]
 				);
-
-				TBTKAssert(
-					info == 0,
-					"Diagonalizer:solve()",
-					"Diagonalization routine zhpev exited with INFO=" + to_string(info) + ".",
-					"See LAPACK documentation for zhpev for further information."
-				);
-
-				//Delete workspaces
-				delete [] work;
-				delete [] rwork;
-
-				eigenValuesOffset += numStatesPerBlock.at(b);
 			}
 		}
 	}
+
+	if(eigenSolutionCache != nullptr){
+		eigenSolutionCache->store(
+			hash,
+			basisSize,
+			eigenVectorsSize,
+			eigenValues,
+			eigenVectors
+		);
+	}
 /*	else{
 		int kd;
 		if(size_z != 1)
@@ -514,5 +613,78 @@ void BlockDiagonalizer::solve(){
 	}*/
 }
 
+void BlockDiagonalizer::solveLargeBlock(unsigned int block){
+	//Setup zheevd to calculate...
+	char jobz = 'V';			//...eigenvalues and eigenvectors...
+	char uplo = 'U';			//...for an upper triangular...
+	int n = numStatesPerBlock.at(block);	//...nxn-matrix.
+
+	//Unpack the block into full storage in the eigenvector array, which
+	//zheevd overwrites with the eigenvectors.
+	const complex<double> *packed = hamiltonian + blockOffsets.at(block);
+	complex<double> *matrix = eigenVectors + eigenVectorOffsets.at(block);
+	for(int col = 0; col < n; col++)
+		for(int row = 0; row <= col; row++)
+			matrix[row + col*n] = packed[row + (col*(col+1))/2];
+
+	int lwork = largeBlockWorkspace.work.size();
+	int lrwork = largeBlockWorkspace.rwork.size();
+	int liwork = largeBlockWorkspace.iwork.size();
+	int info;
+	zheevd_(
+		&jobz,
+		&uplo,
+		&n,
+		matrix,
+		&n,
+		eigenValues + blockToStateMap.at(block),
+		largeBlockWorkspace.work.data(),
+		&lwork,
+		largeBlockWorkspace.rwork.data(),
+		&lrwork,
+		largeBlockWorkspace.iwork.data(),
+		&liwork,
+		&info
+	);
+
+	TBTKAssert(
+		info == 0,
+		"BlockDiagonalizer:solveLargeBlock()",
+		"Diagonalization routine zheevd exited with INFO=" + to_string(info) + ".",
+		"See LAPACK documentation for zheevd for further information."
+	);
+}
+
+void BlockDiagonalizer::solveSmallBlock(
+	unsigned int block,
+	Workspace &workspace
+){
+	//Setup zhpev to calculate...
+	char jobz = 'V';			//...eigenvalues and eigenvectors...
+	char uplo = 'U';			//...for an upper triangular...
+	int n = numStatesPerBlock.at(block);	//...nxn-matrix.
+	int info;
+	//Solve brop
+	zhpev_(
+		&jobz,
+		&uplo,
+		&n,
+		hamiltonian + blockOffsets.at(block),
+		eigenValues + blockToStateMap.at(block),
+		eigenVectors + eigenVectorOffsets.at(block),
+		&n,
+		workspace.work.data(),
+		workspace.rwork.data(),
+		&info
+	);
+
+	TBTKAssert(
+		info == 0,
+		"BlockDiagonalizer:solveSmallBlock()",
+		"Diagonalization routine zhpev exited with INFO=" + to_string(info) + ".",
+		"See LAPACK documentation for zhpev for further information."
+	);
+}
+
 };	//End of namespace Solver
 };	//End of namespace TBTK
@@ -25,7 +25,11 @@
 #include "TBTK/UnitHandler.h"
 
 #include <iostream>
+#include <map>
 #include <math.h>
+#include <mutex>
+#include <random>
+#include <tuple>
 
 using namespace std;
 
@@ -36,10 +40,14 @@ namespace{
 	const complex<double> i(0, 1);
 }
 
+constexpr unsigned int ChebyshevExpander::DEFAULT_BLOCK_SIZE;
+constexpr unsigned int ChebyshevExpander::FFT_OVERSAMPLING;
+
 ChebyshevExpander::ChebyshevExpander() : Communicator(false){
 	scaleFactor = 1.;
+	blockSize = DEFAULT_BLOCK_SIZE;
 	damping = NULL;
-	generatingFunctionLookupTable = NULL;
+	lookupTable = nullptr;
 	generatingFunctionLookupTable_device = NULL;
 	lookupTableNumCoefficients = 0;
 	lookupTableResolution = 0;
@@ -48,12 +56,6 @@ ChebyshevExpander::ChebyshevExpander() : Communicator(false){
 }
 
 ChebyshevExpander::~ChebyshevExpander(){
-	if(generatingFunctionLookupTable != NULL){
-		for(int n = 0; n < lookupTableNumCoefficients; n++)
-			delete [] generatingFunctionLookupTable[n];
-
-		delete [] generatingFunctionLookupTable;
-	}
 }
 
 void ChebyshevExpander::setModel(Model &model){
@@ -116,45 +118,27 @@ void ChebyshevExpander::calculateCoefficients(
 
 	coefficients[0] = jIn1[toBasisIndex];
 
-	//Generate a fixed hopping amplitude and inde list, for speed.
-	HoppingAmplitudeSet::Iterator it = hoppingAmplitudeSet->getIterator();
-	const HoppingAmplitude *ha;
-	int numHoppingAmplitudes = 0;
-	while((ha = it.getHA())){
-		numHoppingAmplitudes++;
-		it.searchNextHA();
-	}
-
-	complex<double> *hoppingAmplitudes = new complex<double>[numHoppingAmplitudes];
-	int *toIndices = new int[numHoppingAmplitudes];
-	int *fromIndices = new int[numHoppingAmplitudes];
-	it.reset();
-	int counter = 0;
-	while((ha = it.getHA())){
-/*		toIndices[counter] = hoppingAmplitudeSet->getBasisIndex(ha->toIndex);
-		fromIndices[counter] = hoppingAmplitudeSet->getBasisIndex(ha->fromIndex);*/
-		toIndices[counter] = hoppingAmplitudeSet->getBasisIndex(ha->getToIndex());
-		fromIndices[counter] = hoppingAmplitudeSet->getBasisIndex(ha->getFromIndex());
-		hoppingAmplitudes[counter] = ha->getAmplitude()/scaleFactor;
-
-		it.searchNextHA();
-		counter++;
-	}
+	//Get the Hamiltonian on CSR format. The HoppingAmplitudeSet returns a
+	//shared cached matrix, or a newly constructed one if any
+	//HoppingAmplitude is given through a callback. Holding the pointer
+	//keeps the matrix alive until the expansion is done.
+	shared_ptr<const SparseMatrix<complex<double>>> sparseMatrix
+		= hoppingAmplitudeSet->getSparseMatrix();
+	const SparseMatrix<complex<double>> &hamiltonian = *sparseMatrix;
 
 	//Calculate |j1>
-	for(int c = 0; c < hoppingAmplitudeSet->getBasisSize(); c++)
-		jResult[c] = 0.;
-	for(int n = 0; n < numHoppingAmplitudes; n++){
-		int from = fromIndices[n];
-		int to = toIndices[n];
-
-		jResult[to] += hoppingAmplitudes[n]*jIn1[from];
-	}
-
-	if(damping != NULL){
-		for(int n = 0; n < hoppingAmplitudeSet->getBasisSize(); n++)
-			jResult[n] *= damping[n];
-	}
+	double multiplier = 1./scaleFactor;
+	calculateChebyshevStep(
+		hamiltonian,
+		jIn1,
+		NULL,
+		jResult,
+		multiplier,
+		NULL,
+		NULL,
+		numCoefficients,
+		1
+	);
 
 	jTemp = jIn2;
 	jIn2 = jIn1;
@@ -163,31 +147,23 @@ void ChebyshevExpander::calculateCoefficients(
 
 	coefficients[1] = jIn1[toBasisIndex];
 
-	//Multiply hopping amplitudes by factor two, to spped up calculation of 2H|j(n-1)> - |j(n-2)>.
-	for(int n = 0; n < numHoppingAmplitudes; n++)
-		hoppingAmplitudes[n] *= 2.;
+	//Multiply the scale factor by two, to speed up calculation of
+	//2H|j(n-1)> - |j(n-2)>.
+	multiplier *= 2.;
 
 	//Iteratively calculate |jn> and corresponding Chebyshev coefficients.
 	for(int n = 2; n < numCoefficients; n++){
-		for(int c = 0; c < hoppingAmplitudeSet->getBasisSize(); c++)
-			jResult[c] = -jIn2[c];
-
-		if(damping != NULL){
-			for(int c = 0; c < hoppingAmplitudeSet->getBasisSize(); c++)
-				jResult[c] *= damping[c];
-		}
-
-		for(int c = 0; c < numHoppingAmplitudes; c++){
-			int from = fromIndices[c];
-			int to = toIndices[c];
-
-			jResult[to] += hoppingAmplitudes[c]*jIn1[from];
-		}
-
-		if(damping != NULL){
-			for(int c = 0; c < hoppingAmplitudeSet->getBasisSize(); c++)
-				jResult[c] *= damping[c];
-		}
+		calculateChebyshevStep(
+			hamiltonian,
+			jIn1,
+			jIn2,
+			jResult,
+			multiplier,
+			NULL,
+			NULL,
+			numCoefficients,
+			n
+		);
 
 		jTemp = jIn2;
 		jIn2 = jIn1;
@@ -209,9 +185,6 @@ void ChebyshevExpander::calculateCoefficients(
 	delete [] jIn1;
 	delete [] jIn2;
 	delete [] jResult;
-	delete [] hoppingAmplitudes;
-	delete [] toIndices;
-	delete [] fromIndices;
 
 	//Lorentzian convolution
 	double lambda = broadening*numCoefficients;
@@ -278,96 +251,215 @@ void ChebyshevExpander::calculateCoefficients(
 		if(coefficientMap[n] != -1)
 			coefficients[coefficientMap[n]*numCoefficients] = jIn1[n];
 
-	//Generate a fixed hopping amplitude and inde list, for speed.
-	HoppingAmplitudeSet::Iterator it = hoppingAmplitudeSet->getIterator();
-	const HoppingAmplitude *ha;
-	int numHoppingAmplitudes = 0;
-	while((ha = it.getHA())){
-		numHoppingAmplitudes++;
-		it.searchNextHA();
-	}
-
-	complex<double> *hoppingAmplitudes = new complex<double>[numHoppingAmplitudes];
-	int *toIndices = new int[numHoppingAmplitudes];
-	int *fromIndices = new int[numHoppingAmplitudes];
-	it.reset();
-	int counter = 0;
-	while((ha = it.getHA())){
-/*		toIndices[counter] = hoppingAmplitudeSet->getBasisIndex(ha->toIndex);
-		fromIndices[counter] = hoppingAmplitudeSet->getBasisIndex(ha->fromIndex);*/
-		toIndices[counter] = hoppingAmplitudeSet->getBasisIndex(ha->getToIndex());
-		fromIndices[counter] = hoppingAmplitudeSet->getBasisIndex(ha->getFromIndex());
-		hoppingAmplitudes[counter] = ha->getAmplitude()/scaleFactor;
-
-		it.searchNextHA();
-		counter++;
-	}
+	shared_ptr<const SparseMatrix<complex<double>>> sparseMatrix
+		= hoppingAmplitudeSet->getSparseMatrix();
+	const SparseMatrix<complex<double>> &hamiltonian = *sparseMatrix;
 
 	//Calculate |j1>
-	for(int c = 0; c < hoppingAmplitudeSet->getBasisSize(); c++)
-		jResult[c] = 0.;
-	for(int n = 0; n < numHoppingAmplitudes; n++){
-		int from = fromIndices[n];
-		int to = toIndices[n];
-
-		jResult[to] += hoppingAmplitudes[n]*jIn1[from];
-	}
-
-	if(damping != NULL){
-		for(int c = 0; c < hoppingAmplitudeSet->getBasisSize(); c++)
-			jResult[c] *= damping[c];
-	}
+	double multiplier = 1./scaleFactor;
+	calculateChebyshevStep(
+		hamiltonian,
+		jIn1,
+		NULL,
+		jResult,
+		multiplier,
+		coefficientMap,
+		coefficients,
+		numCoefficients,
+		1
+	);
 
 	jTemp = jIn2;
 	jIn2 = jIn1;
 	jIn1 = jResult;
 	jResult = jTemp;
 
-	for(int n = 0; n < hoppingAmplitudeSet->getBasisSize(); n++)
-		if(coefficientMap[n] != -1)
-			coefficients[coefficientMap[n]*numCoefficients + 1] = jIn1[n];
-
-	//Multiply hopping amplitudes by factor two, to spped up calculation of 2H|j(n-1)> - |j(n-2)>.
-	for(int n = 0; n < numHoppingAmplitudes; n++)
-		hoppingAmplitudes[n] *= 2.;
+	//Multiply the scale factor by two, to speed up calculation of
+	//2H|j(n-1)> - |j(n-2)>.
+	multiplier *= 2.;
 
 	//Iteratively calculate |jn> and corresponding Chebyshev coefficients.
 	for(int n = 2; n < numCoefficients; n++){
-		for(int c = 0; c < hoppingAmplitudeSet->getBasisSize(); c++)
-			jResult[c] = -jIn2[c];
+		calculateChebyshevStep(
+			hamiltonian,
+			jIn1,
+			jIn2,
+			jResult,
+			multiplier,
+			coefficientMap,
+			coefficients,
+			numCoefficients,
+			n
+		);
+
+		jTemp = jIn2;
+		jIn2 = jIn1;
+		jIn1 = jResult;
+		jResult = jTemp;
 
-		if(damping != NULL){
-			for(int c = 0; c < hoppingAmplitudeSet->getBasisSize(); c++)
-				jResult[c] *= damping[c];
+		if(getGlobalVerbose() && getVerbose()){
+			if(n%100 == 0)
+				Streams::out << "." << flush;
+			if(n%1000 == 0)
+				Streams::out << " " << flush;
 		}
+	}
+	if(getGlobalVerbose() && getVerbose())
+		Streams::out << "\n";
+
+	delete [] jIn1;
+	delete [] jIn2;
+	delete [] jResult;
+	delete [] coefficientMap;
 
-		for(int c = 0; c < numHoppingAmplitudes; c++){
-			int from = fromIndices[c];
-			int to = toIndices[c];
+	//Lorentzian convolution
+	double lambda = broadening*numCoefficients;
+	for(int n = 0; n < numCoefficients; n++)
+		coefficients[n] = coefficients[n]*sinh(lambda*(1 - n/(double)numCoefficients))/sinh(lambda);
+}
 
-			jResult[to] += hoppingAmplitudes[c]*jIn1[from];
+void ChebyshevExpander::calculateCoefficientsBlock(
+	const vector<Index> &to,
+	const vector<Index> &from,
+	complex<double> *coefficients,
+	int numCoefficients,
+	double broadening
+){
+	const Model &model = getModel();
+
+	TBTKAssert(
+		scaleFactor > 0,
+		"ChebyshevExpander::calculateCoefficientsBlock()",
+		"Scale factor must be larger than zero.",
+		"Use ChebyshevExpander::setScaleFactor() to set scale factor."
+	);
+	TBTKAssert(
+		numCoefficients > 0,
+		"ChebyshevExpander::calculateCoefficientsBlock()",
+		"numCoefficients has to be larger than 0.",
+		""
+	);
+	TBTKAssert(
+		to.size() == from.size(),
+		"ChebyshevExpander::calculateCoefficientsBlock()",
+		"Incompatible sizes. 'to' has size '" << to.size() << "'"
+		<< " while 'from' has size '" << from.size() << "'.",
+		""
+	);
+
+	const HoppingAmplitudeSet *hoppingAmplitudeSet = model.getHoppingAmplitudeSet();
+	int basisSize = hoppingAmplitudeSet->getBasisSize();
+
+	if(getGlobalVerbose() && getVerbose()){
+		Streams::out << "ChebyshevExpander::calculateCoefficientsBlock\n";
+		Streams::out << "\tNumber of index pairs: " << to.size() << "\n";
+		Streams::out << "\tBlock size: " << blockSize << "\n";
+		Streams::out << "\tBasis size: " << basisSize << "\n";
+		Streams::out << "\tProgress (1 block per dot): ";
+	}
+
+	shared_ptr<const SparseMatrix<complex<double>>> sparseMatrix
+		= hoppingAmplitudeSet->getSparseMatrix();
+	const SparseMatrix<complex<double>> &hamiltonian = *sparseMatrix;
+
+	unsigned int maxBlockSize = blockSize;
+	if(to.size() < maxBlockSize)
+		maxBlockSize = to.size();
+
+	complex<double> *jIn1 = new complex<double>[basisSize*maxBlockSize];
+	complex<double> *jIn2 = new complex<double>[basisSize*maxBlockSize];
+	complex<double> *jResult = new complex<double>[basisSize*maxBlockSize];
+	complex<double> *jTemp = NULL;
+	int *toBasisIndices = new int[maxBlockSize];
+
+	for(
+		unsigned int blockStart = 0;
+		blockStart < to.size();
+		blockStart += maxBlockSize
+	){
+		unsigned int currentBlockSize = maxBlockSize;
+		if(to.size() - blockStart < currentBlockSize)
+			currentBlockSize = to.size() - blockStart;
+
+		for(int n = 0; n < basisSize*(int)currentBlockSize; n++){
+			jIn1[n] = 0.;
+			jIn2[n] = 0.;
+			jResult[n] = 0.;
 		}
 
-		if(damping != NULL){
-			for(int c = 0; c < hoppingAmplitudeSet->getBasisSize(); c++)
-				jResult[c] *= damping[c];
+		//Set up initial states (|j0>)
+		for(unsigned int k = 0; k < currentBlockSize; k++){
+			int fromBasisIndex = hoppingAmplitudeSet->getBasisIndex(
+				from[blockStart + k]
+			);
+			toBasisIndices[k] = hoppingAmplitudeSet->getBasisIndex(
+				to[blockStart + k]
+			);
+			jIn1[fromBasisIndex*currentBlockSize + k] = 1.;
 		}
 
+		complex<double> *blockCoefficients
+			= &coefficients[blockStart*numCoefficients];
+		for(unsigned int k = 0; k < currentBlockSize; k++){
+			blockCoefficients[k*numCoefficients] = jIn1[
+				toBasisIndices[k]*currentBlockSize + k
+			];
+		}
+
+		//Calculate |j1>
+		double multiplier = 1./scaleFactor;
+		calculateChebyshevBlockStep(
+			hamiltonian,
+			jIn1,
+			NULL,
+			jResult,
+			currentBlockSize,
+			multiplier
+		);
+
 		jTemp = jIn2;
 		jIn2 = jIn1;
 		jIn1 = jResult;
 		jResult = jTemp;
 
-		for(int c = 0; c < hoppingAmplitudeSet->getBasisSize(); c++)
-			if(coefficientMap[c] != -1)
-				coefficients[coefficientMap[c]*numCoefficients + n] = jIn1[c];
+		if(numCoefficients > 1){
+			for(unsigned int k = 0; k < currentBlockSize; k++){
+				blockCoefficients[k*numCoefficients + 1] = jIn1[
+					toBasisIndices[k]*currentBlockSize + k
+				];
+			}
+		}
 
-		if(getGlobalVerbose() && getVerbose()){
-			if(n%100 == 0)
-				Streams::out << "." << flush;
-			if(n%1000 == 0)
-				Streams::out << " " << flush;
+		//Multiply the scale factor by two, to speed up calculation of
+		//2H|j(n-1)> - |j(n-2)>.
+		multiplier *= 2.;
+
+		//Iteratively calculate |jn> and corresponding Chebyshev
+		//coefficients.
+		for(int n = 2; n < numCoefficients; n++){
+			calculateChebyshevBlockStep(
+				hamiltonian,
+				jIn1,
+				jIn2,
+				jResult,
+				currentBlockSize,
+				multiplier
+			);
+
+			jTemp = jIn2;
+			jIn2 = jIn1;
+			jIn1 = jResult;
+			jResult = jTemp;
+
+			for(unsigned int k = 0; k < currentBlockSize; k++){
+				blockCoefficients[k*numCoefficients + n] = jIn1[
+					toBasisIndices[k]*currentBlockSize + k
+				];
+			}
 		}
+
+		if(getGlobalVerbose() && getVerbose())
+			Streams::out << "." << flush;
 	}
 	if(getGlobalVerbose() && getVerbose())
 		Streams::out << "\n";
@@ -375,14 +467,215 @@ void ChebyshevExpander::calculateCoefficients(
 	delete [] jIn1;
 	delete [] jIn2;
 	delete [] jResult;
-	delete [] hoppingAmplitudes;
-	delete [] toIndices;
-	delete [] fromIndices;
+	delete [] toBasisIndices;
 
 	//Lorentzian convolution
 	double lambda = broadening*numCoefficients;
-	for(int n = 0; n < numCoefficients; n++)
-		coefficients[n] = coefficients[n]*sinh(lambda*(1 - n/(double)numCoefficients))/sinh(lambda);
+	for(unsigned int k = 0; k < to.size(); k++){
+		for(int n = 0; n < numCoefficients; n++){
+			coefficients[k*numCoefficients + n]
+				*= sinh(
+					lambda*(1 - n/(double)numCoefficients)
+				)/sinh(lambda);
+		}
+	}
+}
+
+void ChebyshevExpander::calculateStochasticMoments(
+	unsigned int numRandomVectors,
+	int numCoefficients,
+	double *moments,
+	const vector<Index> &localIndices,
+	double *localMoments,
+	unsigned int seed
+){
+	const Model &model = getModel();
+
+	TBTKAssert(
+		scaleFactor > 0,
+		"ChebyshevExpander::calculateStochasticMoments()",
+		"Scale factor must be larger than zero.",
+		"Use ChebyshevExpander::setScaleFactor() to set scale factor."
+	);
+	TBTKAssert(
+		numCoefficients > 0,
+		"ChebyshevExpander::calculateStochasticMoments()",
+		"numCoefficients has to be larger than 0.",
+		""
+	);
+	TBTKAssert(
+		numRandomVectors > 0,
+		"ChebyshevExpander::calculateStochasticMoments()",
+		"numRandomVectors has to be larger than 0.",
+		""
+	);
+	TBTKAssert(
+		localIndices.size() == 0 || localMoments != NULL,
+		"ChebyshevExpander::calculateStochasticMoments()",
+		"localMoments cannot be NULL when localIndices is nonempty.",
+		""
+	);
+
+	const HoppingAmplitudeSet *hoppingAmplitudeSet = model.getHoppingAmplitudeSet();
+	int basisSize = hoppingAmplitudeSet->getBasisSize();
+
+	if(getGlobalVerbose() && getVerbose()){
+		Streams::out << "ChebyshevExpander::calculateStochasticMoments\n";
+		Streams::out << "\tNumber of random vectors: " << numRandomVectors << "\n";
+		Streams::out << "\tBasis size: " << basisSize << "\n";
+		Streams::out << "\tProgress (1 block per dot): ";
+	}
+
+	shared_ptr<const SparseMatrix<complex<double>>> sparseMatrix
+		= hoppingAmplitudeSet->getSparseMatrix();
+	const SparseMatrix<complex<double>> &hamiltonian = *sparseMatrix;
+
+	vector<int> localBasisIndices;
+	for(unsigned int n = 0; n < localIndices.size(); n++){
+		localBasisIndices.push_back(
+			hoppingAmplitudeSet->getBasisIndex(localIndices[n])
+		);
+	}
+	for(unsigned int n = 0; n < localIndices.size()*numCoefficients; n++)
+		localMoments[n] = 0.;
+
+	unsigned int maxBlockSize = blockSize;
+	if(numRandomVectors < maxBlockSize)
+		maxBlockSize = numRandomVectors;
+
+	complex<double> *randomVectors
+		= new complex<double>[basisSize*maxBlockSize];
+	complex<double> *jIn1 = new complex<double>[basisSize*maxBlockSize];
+	complex<double> *jIn2 = new complex<double>[basisSize*maxBlockSize];
+	complex<double> *jResult = new complex<double>[basisSize*maxBlockSize];
+	complex<double> *jTemp = NULL;
+
+	mt19937_64 randomNumberGenerator(seed);
+	uniform_real_distribution<double> phaseDistribution(0, 2*M_PI);
+
+	//Calculates the trace and local moments for the current block.
+	auto extractMoments = [&](
+		const complex<double> *j,
+		unsigned int blockStart,
+		unsigned int currentBlockSize,
+		int n
+	){
+		//The rows are partitioned between the threads, which
+		//accumulate the moments for all vectors in the block in
+		//private buffers that are reduced once at the end.
+		vector<double> blockMoments(currentBlockSize, 0.);
+		#pragma omp parallel
+		{
+			vector<double> threadMoments(currentBlockSize, 0.);
+			#pragma omp for schedule(static)
+			for(int c = 0; c < basisSize; c++){
+				const complex<double> *r
+					= &randomVectors[c*currentBlockSize];
+				const complex<double> *jRow
+					= &j[c*currentBlockSize];
+				for(unsigned int k = 0; k < currentBlockSize; k++)
+					threadMoments[k] += real(conj(r[k])*jRow[k]);
+			}
+			#pragma omp critical (TBTK_CHEBYSHEV_EXPANDER_MOMENTS)
+			for(unsigned int k = 0; k < currentBlockSize; k++)
+				blockMoments[k] += threadMoments[k];
+		}
+		for(unsigned int k = 0; k < currentBlockSize; k++){
+			moments[(blockStart + k)*numCoefficients + n]
+				= blockMoments[k];
+		}
+		for(unsigned int c = 0; c < localBasisIndices.size(); c++){
+			for(unsigned int k = 0; k < currentBlockSize; k++){
+				unsigned int offset
+					= localBasisIndices[c]*currentBlockSize
+					+ k;
+				localMoments[c*numCoefficients + n] += real(
+					conj(randomVectors[offset])*j[offset]
+				)/numRandomVectors;
+			}
+		}
+	};
+
+	for(
+		unsigned int blockStart = 0;
+		blockStart < numRandomVectors;
+		blockStart += maxBlockSize
+	){
+		unsigned int currentBlockSize = maxBlockSize;
+		if(numRandomVectors - blockStart < currentBlockSize)
+			currentBlockSize = numRandomVectors - blockStart;
+
+		//Set up initial states (|j0> = |r>). The random numbers are
+		//generated vector by vector to make the result independent of
+		//the block size.
+		for(unsigned int k = 0; k < currentBlockSize; k++){
+			for(int c = 0; c < basisSize; c++){
+				randomVectors[c*currentBlockSize + k] = exp(
+					i*phaseDistribution(
+						randomNumberGenerator
+					)
+				);
+			}
+		}
+		for(int n = 0; n < basisSize*(int)currentBlockSize; n++){
+			jIn1[n] = randomVectors[n];
+			jIn2[n] = 0.;
+			jResult[n] = 0.;
+		}
+		extractMoments(jIn1, blockStart, currentBlockSize, 0);
+
+		//Calculate |j1>
+		double multiplier = 1./scaleFactor;
+		calculateChebyshevBlockStep(
+			hamiltonian,
+			jIn1,
+			NULL,
+			jResult,
+			currentBlockSize,
+			multiplier
+		);
+
+		jTemp = jIn2;
+		jIn2 = jIn1;
+		jIn1 = jResult;
+		jResult = jTemp;
+
+		if(numCoefficients > 1)
+			extractMoments(jIn1, blockStart, currentBlockSize, 1);
+
+		//Multiply the scale factor by two, to speed up calculation of
+		//2H|j(n-1)> - |j(n-2)>.
+		multiplier *= 2.;
+
+		//Iteratively calculate |jn> and the corresponding moments.
+		for(int n = 2; n < numCoefficients; n++){
+			calculateChebyshevBlockStep(
+				hamiltonian,
+				jIn1,
+				jIn2,
+				jResult,
+				currentBlockSize,
+				multiplier
+			);
+
+			jTemp = jIn2;
+			jIn2 = jIn1;
+			jIn1 = jResult;
+			jResult = jTemp;
+
+			extractMoments(jIn1, blockStart, currentBlockSize, n);
+		}
+
+		if(getGlobalVerbose() && getVerbose())
+			Streams::out << "." << flush;
+	}
+	if(getGlobalVerbose() && getVerbose())
+		Streams::out << "\n";
+
+	delete [] randomVectors;
+	delete [] jIn1;
+	delete [] jIn2;
+	delete [] jResult;
 }
 
 void ChebyshevExpander::calculateCoefficientsWithCutoff(
@@ -561,7 +854,8 @@ void ChebyshevExpander::generateLookupTable(
 	int numCoefficients,
 	int energyResolution,
 	double lowerBound,
-	double upperBound
+	double upperBound,
+	LookupTableStorage storage
 ){
 	TBTKAssert(
 		numCoefficients > 0,
@@ -600,13 +894,18 @@ void ChebyshevExpander::generateLookupTable(
 		Streams::out << "\tEnergy resolution: " << energyResolution << "\n";
 		Streams::out << "\tLower bound: " << lowerBound << "\n";
 		Streams::out << "\tUpper bound: " << upperBound << "\n";
-	}
-
-	if(generatingFunctionLookupTable != NULL){
-		for(int n = 0; n < lookupTableNumCoefficients; n++)
-			delete [] generatingFunctionLookupTable[n];
-
-		delete [] generatingFunctionLookupTable;
+		Streams::out << "\tStorage: ";
+		switch(storage){
+		case LookupTableStorage::Double:
+			Streams::out << "Double\n";
+			break;
+		case LookupTableStorage::Float:
+			Streams::out << "Float\n";
+			break;
+		case LookupTableStorage::Recurrence:
+			Streams::out << "Recurrence\n";
+			break;
+		}
 	}
 
 	lookupTableNumCoefficients = numCoefficients;
@@ -614,37 +913,25 @@ void ChebyshevExpander::generateLookupTable(
 	lookupTableLowerBound = lowerBound;
 	lookupTableUpperBound = upperBound;
 
-	generatingFunctionLookupTable = new complex<double>*[numCoefficients];
-	for(int n = 0; n < numCoefficients; n++)
-		generatingFunctionLookupTable[n] = new complex<double>[energyResolution];
-
-	const double DELTA = 0.0001;
-	#pragma omp parallel for
-	for(int n = 0; n < numCoefficients; n++){
-		double denominator = 1.;
-		if(n == 0)
-			denominator = 2.;
-
-		for(int e = 0; e < energyResolution; e++){
-			double E = (lowerBound + (upperBound - lowerBound)*e/(double)energyResolution)/scaleFactor;
-			generatingFunctionLookupTable[n][e] = (1/scaleFactor)*(-2.*i/sqrt(1+DELTA - E*E))*exp(-i*((double)n)*acos(E))/denominator;
-		}
-	}
+	lookupTable = LookupTable::get(
+		numCoefficients,
+		energyResolution,
+		lowerBound,
+		upperBound,
+		scaleFactor,
+		storage
+	);
 }
 
 void ChebyshevExpander::destroyLookupTable(){
 	TBTKAssert(
-		generatingFunctionLookupTable != NULL,
+		lookupTable != nullptr,
 		"ChebyshevExpander::destroyLookupTable()",
 		"No lookup table generated.",
 		""
 	);
-	for(int n = 0; n < lookupTableNumCoefficients; n++)
-		delete [] generatingFunctionLookupTable[n];
-
-	delete [] generatingFunctionLookupTable;
 
-	generatingFunctionLookupTable = NULL;
+	lookupTable = nullptr;
 }
 
 //Property::GreensFunction* ChebyshevExpander::generateGreensFunction(
@@ -775,7 +1062,7 @@ complex<double>* ChebyshevExpander::generateGreensFunction(
 	Type type
 ){
 	TBTKAssert(
-		generatingFunctionLookupTable != NULL,
+		lookupTable != nullptr,
 		"ChebyshevExpander::generateGreensFunction()",
 		"Lookup table has not been generated.",
 		"Use ChebyshevExpander::generateLookupTable() to generate lookup table."
@@ -785,38 +1072,11 @@ complex<double>* ChebyshevExpander::generateGreensFunction(
 	for(int e = 0; e < lookupTableResolution; e++)
 		greensFunctionData[e] = 0.;
 
-//	if(type == Property::GreensFunction::Type::Retarded){
-	if(type == Type::Retarded){
-		for(int n = 0; n < lookupTableNumCoefficients; n++){
-			for(int e = 0; e < lookupTableResolution; e++){
-				greensFunctionData[e] += generatingFunctionLookupTable[n][e]*coefficients[n];
-			}
-		}
-	}
-//	else if(type == Property::GreensFunction::Type::Advanced){
-	else if(type == Type::Advanced){
-		for(int n = 0; n < lookupTableNumCoefficients; n++){
-			for(int e = 0; e < lookupTableResolution; e++){
-				greensFunctionData[e] += coefficients[n]*conj(generatingFunctionLookupTable[n][e]);
-			}
-		}
-	}
-//	else if(type == Property::GreensFunction::Type::Principal){
-	else if(type == Type::Principal){
-		for(int n = 0; n < lookupTableNumCoefficients; n++){
-			for(int e = 0; e < lookupTableResolution; e++){
-				greensFunctionData[e] += -coefficients[n]*real(generatingFunctionLookupTable[n][e]);
-			}
-		}
-	}
-//	else if(type == Property::GreensFunction::Type::NonPrincipal){
-	else if(type == Type::NonPrincipal){
-		for(int n = 0; n < lookupTableNumCoefficients; n++){
-			for(int e = 0; e < lookupTableResolution; e++){
-				greensFunctionData[e] -= coefficients[n]*i*imag(generatingFunctionLookupTable[n][e]);
-			}
-		}
-	}
+	lookupTable->generateGreensFunction(
+		coefficients,
+		greensFunctionData,
+		type
+	);
 
 /*	Property::GreensFunction *greensFunction = new Property::GreensFunction(
 		type,
@@ -833,6 +1093,185 @@ complex<double>* ChebyshevExpander::generateGreensFunction(
 	return greensFunctionData;
 }
 
+complex<double>* ChebyshevExpander::generateGreensFunctionOnChebyshevNodes(
+	const complex<double> *coefficients,
+	int numCoefficients,
+	int energyResolution,
+	Type type
+){
+	TBTKAssert(
+		numCoefficients > 0,
+		"ChebyshevExpander::generateGreensFunctionOnChebyshevNodes()",
+		"numCoefficients has to be larger than 0.",
+		""
+	);
+	TBTKAssert(
+		energyResolution > 0,
+		"ChebyshevExpander::generateGreensFunctionOnChebyshevNodes()",
+		"energyResolution has to be larger than 0.",
+		""
+	);
+
+	vector<complex<double>> retardedSums;
+	vector<complex<double>> advancedSums;
+	if(type != Type::Advanced){
+		calculateChebyshevSumsFFT(
+			coefficients,
+			numCoefficients,
+			energyResolution,
+			-1,
+			retardedSums
+		);
+	}
+	if(type != Type::Retarded){
+		calculateChebyshevSumsFFT(
+			coefficients,
+			numCoefficients,
+			energyResolution,
+			1,
+			advancedSums
+		);
+	}
+
+	complex<double> *greensFunctionData = new complex<double>[energyResolution];
+	for(int k = 0; k < energyResolution; k++){
+		greensFunctionData[k] = combineChebyshevSums(
+			cos(M_PI*(k + 1/2.)/energyResolution),
+			retardedSums.size() == 0 ? 0. : retardedSums[k],
+			advancedSums.size() == 0 ? 0. : advancedSums[k],
+			type
+		);
+	}
+
+	return greensFunctionData;
+}
+
+vector<double> ChebyshevExpander::getChebyshevNodes(
+	int energyResolution
+) const{
+	TBTKAssert(
+		energyResolution > 0,
+		"ChebyshevExpander::getChebyshevNodes()",
+		"energyResolution has to be larger than 0.",
+		""
+	);
+
+	vector<double> nodes;
+	for(int k = 0; k < energyResolution; k++){
+		nodes.push_back(
+			scaleFactor*cos(M_PI*(k + 1/2.)/energyResolution)
+		);
+	}
+
+	return nodes;
+}
+
+complex<double>* ChebyshevExpander::generateGreensFunctionFFT(
+	const complex<double> *coefficients,
+	int numCoefficients,
+	int energyResolution,
+	double lowerBound,
+	double upperBound,
+	Type type
+){
+	TBTKAssert(
+		numCoefficients > 0,
+		"ChebyshevExpander::generateGreensFunctionFFT()",
+		"numCoefficients has to be larger than 0.",
+		""
+	);
+	TBTKAssert(
+		energyResolution > 0,
+		"ChebyshevExpander::generateGreensFunctionFFT()",
+		"energyResolution has to be larger than 0.",
+		""
+	);
+	TBTKAssert(
+		lowerBound < upperBound,
+		"ChebyshevExpander::generateGreensFunctionFFT()",
+		"lowerBound has to be smaller than upperBound.",
+		""
+	);
+	TBTKAssert(
+		lowerBound > -scaleFactor,
+		"ChebyshevExpander::generateGreensFunctionFFT()",
+		"lowerBound has to be larger than -scaleFactor.",
+		"Use ChebyshevExpander::setScaleFactor to set a larger scale factor."
+	);
+	TBTKAssert(
+		upperBound < scaleFactor,
+		"ChebyshevExpander::generateGreensFunctionFFT()",
+		"upperBound has to be smaller than scaleFactor.",
+		"Use ChebyshevExpander::setScaleFactor to set a larger scale factor."
+	);
+
+	//Number of Chebyshev nodes in [0, pi]. Chosen as a power of two to
+	//make the Fourier transform fast.
+	int numNodes = 1;
+	while(numNodes < (int)FFT_OVERSAMPLING*numCoefficients)
+		numNodes *= 2;
+	int size = 2*numNodes;
+
+	vector<complex<double>> retardedSums;
+	vector<complex<double>> advancedSums;
+	if(type != Type::Advanced){
+		calculateChebyshevSumsFFT(
+			coefficients,
+			numCoefficients,
+			numNodes,
+			-1,
+			retardedSums
+		);
+	}
+	if(type != Type::Retarded){
+		calculateChebyshevSumsFFT(
+			coefficients,
+			numCoefficients,
+			numNodes,
+			1,
+			advancedSums
+		);
+	}
+
+	complex<double> *greensFunctionData = new complex<double>[energyResolution];
+	for(int e = 0; e < energyResolution; e++){
+		double E = (lowerBound + (upperBound - lowerBound)*e/(double)energyResolution)/scaleFactor;
+
+		//Cubic Lagrange interpolation between the four nodes closest
+		//to theta = acos(E). The node j is located at
+		//theta_j = pi(j + 1/2)/numNodes and the sums are periodic in
+		//theta with period 2pi.
+		double x = acos(E)*numNodes/M_PI - 1/2.;
+		int j = (int)floor(x);
+		double t = x - j;
+		double weights[4] = {
+			-t*(t - 1)*(t - 2)/6.,
+			(t + 1)*(t - 1)*(t - 2)/2.,
+			-(t + 1)*t*(t - 2)/2.,
+			(t + 1)*t*(t - 1)/6.
+		};
+
+		complex<double> retardedSum = 0.;
+		complex<double> advancedSum = 0.;
+		for(int c = 0; c < 4; c++){
+			int node = (j - 1 + c + size)%size;
+			if(retardedSums.size() != 0)
+				retardedSum += weights[c]*retardedSums[node];
+			if(advancedSums.size() != 0)
+				advancedSum += weights[c]*advancedSums[node];
+		}
+
+		greensFunctionData[e] = combineChebyshevSums(
+			E,
+			retardedSum,
+			advancedSum,
+			type
+		);
+	}
+
+	return greensFunctionData;
+}
+
 complex<double> ChebyshevExpander::getMonolopoulosABCDamping(
 	double distanceToBoundary,
 	double boundarySize,
@@ -855,5 +1294,391 @@ complex<double> ChebyshevExpander::getMonolopoulosABCDamping(
 	return exp(-gamma);
 }
 
+complex<double> ChebyshevExpander::combineChebyshevSums(
+	double E,
+	complex<double> retardedSum,
+	complex<double> advancedSum,
+	Type type
+) const{
+	//The generating function is prefactor*exp(-i*n*acos(E))/d_n, see
+	//generateGreensFunction().
+	const double DELTA = 0.0001;
+	complex<double> prefactor = (1/scaleFactor)*(-2.*i/sqrt(1+DELTA - E*E));
+
+	switch(type){
+	case Type::Retarded:
+		return prefactor*retardedSum;
+	case Type::Advanced:
+		return conj(prefactor)*advancedSum;
+	case Type::Principal:
+		return -(prefactor*retardedSum + conj(prefactor)*advancedSum)/2.;
+	case Type::NonPrincipal:
+		return -(prefactor*retardedSum - conj(prefactor)*advancedSum)/2.;
+	default:
+		TBTKExit(
+			"ChebyshevExpander::combineChebyshevSums()",
+			"Unknown GreensFunctionType",
+			""
+		);
+	}
+}
+
+void ChebyshevExpander::calculateChebyshevStep(
+	const SparseMatrix<complex<double>> &hamiltonian,
+	const complex<double> *jIn1,
+	const complex<double> *jIn2,
+	complex<double> *jResult,
+	double multiplier,
+	const int *coefficientMap,
+	complex<double> *coefficients,
+	int numCoefficients,
+	int n
+) const{
+	int basisSize = hamiltonian.getNumRows();
+	const unsigned int *rowPointers = hamiltonian.getCSRRowPointers();
+	const unsigned int *columns = hamiltonian.getCSRColumns();
+	const complex<double> *values = hamiltonian.getCSRValues();
+
+	//Each row of the result only depends on jIn1, jIn2, and the
+	//corresponding row of the Hamiltonian. The rows can therefore be
+	//partitioned between threads without any need for synchronization.
+	#pragma omp parallel for schedule(static)
+	for(int row = 0; row < basisSize; row++){
+		//The complex multiplication is written out in terms of real
+		//numbers to avoid the overhead of the IEEE compliant complex
+		//multiplication and to allow for vectorization.
+		double sumReal = 0.;
+		double sumImaginary = 0.;
+		#pragma omp simd reduction(+:sumReal, sumImaginary)
+		for(
+			unsigned int c = rowPointers[row];
+			c < rowPointers[row+1];
+			c++
+		){
+			const complex<double> &value = values[c];
+			const complex<double> &element = jIn1[columns[c]];
+			sumReal += value.real()*element.real()
+				- value.imag()*element.imag();
+			sumImaginary += value.real()*element.imag()
+				+ value.imag()*element.real();
+		}
+
+		complex<double> result(
+			multiplier*sumReal,
+			multiplier*sumImaginary
+		);
+		if(jIn2 != NULL){
+			if(damping != NULL)
+				result -= damping[row]*jIn2[row];
+			else
+				result -= jIn2[row];
+		}
+		if(damping != NULL)
+			result *= damping[row];
+
+		jResult[row] = result;
+
+		if(coefficientMap != NULL && coefficientMap[row] != -1){
+			coefficients[
+				coefficientMap[row]*numCoefficients + n
+			] = result;
+		}
+	}
+}
+
+void ChebyshevExpander::calculateChebyshevBlockStep(
+	const SparseMatrix<complex<double>> &hamiltonian,
+	const complex<double> *jIn1,
+	const complex<double> *jIn2,
+	complex<double> *jResult,
+	unsigned int blockSize,
+	double multiplier
+) const{
+	int basisSize = hamiltonian.getNumRows();
+	const unsigned int *rowPointers = hamiltonian.getCSRRowPointers();
+	const unsigned int *columns = hamiltonian.getCSRColumns();
+	const complex<double> *values = hamiltonian.getCSRValues();
+
+	//Each matrix element is read once per block rather than once per
+	//vector. Since the block index runs fastest, each matrix element
+	//multiplies a contiguous segment of jIn1, which allows for the inner
+	//loop to be vectorized. Rows are independent and partitioned between
+	//threads.
+	#pragma omp parallel for schedule(static)
+	for(int row = 0; row < basisSize; row++){
+		double *result = reinterpret_cast<double*>(
+			&jResult[row*blockSize]
+		);
+		for(unsigned int k = 0; k < 2*blockSize; k++)
+			result[k] = 0.;
+
+		for(
+			unsigned int c = rowPointers[row];
+			c < rowPointers[row+1];
+			c++
+		){
+			double valueReal = values[c].real();
+			double valueImaginary = values[c].imag();
+			const double *element = reinterpret_cast<const double*>(
+				&jIn1[columns[c]*blockSize]
+			);
+			#pragma omp simd
+			for(unsigned int k = 0; k < blockSize; k++){
+				result[2*k] += valueReal*element[2*k]
+					- valueImaginary*element[2*k+1];
+				result[2*k+1] += valueReal*element[2*k+1]
+					+ valueImaginary*element[2*k];
+			}
+		}
+
+		for(unsigned int k = 0; k < blockSize; k++){
+			unsigned int offset = row*blockSize + k;
+			complex<double> r(
+				multiplier*result[2*k],
+				multiplier*result[2*k+1]
+			);
+			if(jIn2 != NULL){
+				if(damping != NULL)
+					r -= damping[row]*jIn2[offset];
+				else
+					r -= jIn2[offset];
+			}
+			if(damping != NULL)
+				r *= damping[row];
+
+			jResult[offset] = r;
+		}
+	}
+}
+
+ChebyshevExpander::LookupTable::LookupTable(
+	int numCoefficients,
+	int energyResolution,
+	double lowerBound,
+	double upperBound,
+	double scaleFactor,
+	LookupTableStorage storage
+){
+	this->numCoefficients = numCoefficients;
+	this->energyResolution = energyResolution;
+	this->storage = storage;
+
+	const double DELTA = 0.0001;
+	switch(storage){
+	case LookupTableStorage::Double:
+	case LookupTableStorage::Float:
+		if(storage == LookupTableStorage::Double)
+			doubleTable.resize(numCoefficients*energyResolution);
+		else
+			floatTable.resize(numCoefficients*energyResolution);
+
+		#pragma omp parallel for
+		for(int n = 0; n < numCoefficients; n++){
+			double denominator = 1.;
+			if(n == 0)
+				denominator = 2.;
+
+			for(int e = 0; e < energyResolution; e++){
+				double E = (lowerBound + (upperBound - lowerBound)*e/(double)energyResolution)/scaleFactor;
+				complex<double> generatingFunction = (1/scaleFactor)*(-2.*i/sqrt(1+DELTA - E*E))*exp(-i*((double)n)*acos(E))/denominator;
+				if(storage == LookupTableStorage::Double)
+					doubleTable[n*energyResolution + e] = generatingFunction;
+				else
+					floatTable[n*energyResolution + e] = complex<float>(generatingFunction);
+			}
+		}
+		break;
+	case LookupTableStorage::Recurrence:
+		prefactors.resize(energyResolution);
+		phases.resize(energyResolution);
+		for(int e = 0; e < energyResolution; e++){
+			double E = (lowerBound + (upperBound - lowerBound)*e/(double)energyResolution)/scaleFactor;
+			prefactors[e] = (1/scaleFactor)*(-2.*i/sqrt(1+DELTA - E*E));
+			phases[e] = exp(-i*acos(E));
+		}
+		break;
+	default:
+		TBTKExit(
+			"ChebyshevExpander::LookupTable::LookupTable()",
+			"Unknown LookupTableStorage.",
+			"This should never happen, contact the developer."
+		);
+	}
+}
+
+shared_ptr<const ChebyshevExpander::LookupTable> ChebyshevExpander::LookupTable::get(
+	int numCoefficients,
+	int energyResolution,
+	double lowerBound,
+	double upperBound,
+	double scaleFactor,
+	LookupTableStorage storage
+){
+	typedef tuple<int, int, double, double, double, int> Key;
+	static map<Key, weak_ptr<const LookupTable>> lookupTables;
+	static mutex lookupTablesMutex;
+
+	Key key(
+		numCoefficients,
+		energyResolution,
+		lowerBound,
+		upperBound,
+		scaleFactor,
+		static_cast<int>(storage)
+	);
+
+	shared_ptr<const LookupTable> lookupTable;
+	{
+		lock_guard<mutex> lock(lookupTablesMutex);
+		auto iterator = lookupTables.find(key);
+		if(iterator != lookupTables.end())
+			lookupTable = iterator->second.lock();
+	}
+	if(lookupTable)
+		return lookupTable;
+
+	//Generate the lookup table without holding the lock, to not block
+	//threads that request other lookup tables.
+	shared_ptr<const LookupTable> newLookupTable
+		= make_shared<const LookupTable>(
+			numCoefficients,
+			energyResolution,
+			lowerBound,
+			upperBound,
+			scaleFactor,
+			storage
+		);
+
+	{
+		lock_guard<mutex> lock(lookupTablesMutex);
+
+		//Remove lookup tables that are no longer in use.
+		for(
+			auto iterator = lookupTables.begin();
+			iterator != lookupTables.end();
+		){
+			if(iterator->second.expired())
+				iterator = lookupTables.erase(iterator);
+			else
+				++iterator;
+		}
+
+		//Another thread may have published an identical lookup table
+		//in the meantime, in which case that one is shared instead.
+		auto iterator = lookupTables.find(key);
+		if(iterator != lookupTables.end())
+			lookupTable = iterator->second.lock();
+		if(!lookupTable){
+			lookupTable = newLookupTable;
+			lookupTables[key] = lookupTable;
+		}
+	}
+
+	return lookupTable;
+}
+
+void ChebyshevExpander::LookupTable::generateGreensFunction(
+	const complex<double> *coefficients,
+	complex<double> *greensFunction,
+	Type type
+) const{
+	vector<complex<double>> row;
+	vector<complex<double>> powers;
+	if(storage != LookupTableStorage::Double)
+		row.resize(energyResolution);
+	if(storage == LookupTableStorage::Recurrence)
+		powers = prefactors;
+
+	for(int n = 0; n < numCoefficients; n++){
+		const complex<double> *generatingFunctions = getRow(
+			n,
+			row,
+			powers
+		);
+
+		switch(type){
+		case Type::Retarded:
+			for(int e = 0; e < energyResolution; e++)
+				greensFunction[e] += generatingFunctions[e]*coefficients[n];
+			break;
+		case Type::Advanced:
+			for(int e = 0; e < energyResolution; e++)
+				greensFunction[e] += coefficients[n]*conj(generatingFunctions[e]);
+			break;
+		case Type::Principal:
+			for(int e = 0; e < energyResolution; e++)
+				greensFunction[e] += -coefficients[n]*real(generatingFunctions[e]);
+			break;
+		case Type::NonPrincipal:
+			for(int e = 0; e < energyResolution; e++)
+				greensFunction[e] -= coefficients[n]*i*imag(generatingFunctions[e]);
+			break;
+		default:
+			TBTKExit(
+				"ChebyshevExpander::LookupTable::generateGreensFunction()",
+				"Unknown GreensFunctionType",
+				""
+			);
+		}
+	}
+}
+
+void ChebyshevExpander::LookupTable::getDenseTable(
+	complex<double> *table
+) const{
+	vector<complex<double>> row;
+	vector<complex<double>> powers;
+	if(storage != LookupTableStorage::Double)
+		row.resize(energyResolution);
+	if(storage == LookupTableStorage::Recurrence)
+		powers = prefactors;
+
+	for(int n = 0; n < numCoefficients; n++){
+		const complex<double> *generatingFunctions = getRow(
+			n,
+			row,
+			powers
+		);
+		for(int e = 0; e < energyResolution; e++)
+			table[n*energyResolution + e] = generatingFunctions[e];
+	}
+}
+
+const complex<double>* ChebyshevExpander::LookupTable::getRow(
+	int n,
+	vector<complex<double>> &row,
+	vector<complex<double>> &powers
+) const{
+	switch(storage){
+	case LookupTableStorage::Double:
+		return &doubleTable[n*energyResolution];
+	case LookupTableStorage::Float:
+		for(int e = 0; e < energyResolution; e++)
+			row[e] = complex<double>(floatTable[n*energyResolution + e]);
+
+		return row.data();
+	case LookupTableStorage::Recurrence:
+	{
+		double denominator = 1.;
+		if(n == 0)
+			denominator = 2.;
+
+		//powers[e] = prefactors[e]*phases[e]^n.
+		for(int e = 0; e < energyResolution; e++){
+			row[e] = powers[e]/denominator;
+			powers[e] *= phases[e];
+		}
+
+		return row.data();
+	}
+	default:
+		TBTKExit(
+			"ChebyshevExpander::LookupTable::getRow()",
+			"Unknown LookupTableStorage.",
+			"This should never happen, contact the developer."
+		);
+	}
+}
+
 };	//End of namespace Solver
 };	//End of namespace TBTK
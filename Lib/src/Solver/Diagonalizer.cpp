@@ -22,18 +22,45 @@
 #include "TBTK/Streams.h"
 #include "TBTK/TBTKMacros.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace std;
 
 namespace TBTK{
 namespace Solver{
 
+constexpr unsigned int Diagonalizer::DEFAULT_MIXING_HISTORY_SIZE;
+constexpr double Diagonalizer::DEFAULT_MIXING_PARAMETER;
+constexpr double Diagonalizer::DEFAULT_CONVERGENCE_LIMIT;
+
 Diagonalizer::Diagonalizer() : Communicator(true){
 	hamiltonian = NULL;
 	eigenValues = NULL;
 	eigenVectors = NULL;
+	numEigenValues = 0;
+
+	algorithm = Algorithm::Packed;
+	range = Range::All;
+
+	work = NULL;
+	rwork = NULL;
+	iwork = NULL;
+	isuppz = NULL;
+	lwork = 0;
+	lrwork = 0;
+	liwork = 0;
+
+	eigenSolutionCache = NULL;
 
 	maxIterations = 50;
 	selfConsistencyCallback = NULL;
+
+	calculateOrderParameter = NULL;
+	setOrderParameter = NULL;
+	mixingHistorySize = DEFAULT_MIXING_HISTORY_SIZE;
+	mixingParameter = DEFAULT_MIXING_PARAMETER;
+	convergenceLimit = DEFAULT_CONVERGENCE_LIMIT;
 }
 
 Diagonalizer::~Diagonalizer(){
@@ -43,6 +70,8 @@ Diagonalizer::~Diagonalizer(){
 		delete [] eigenValues;
 	if(eigenVectors != NULL)
 		delete [] eigenVectors;
+
+	freeWorkspaces();
 }
 
 void Diagonalizer::run(){
@@ -53,6 +82,21 @@ void Diagonalizer::run(){
 		"Use Diagonalizer::setModel() to set model."
 	);*/
 
+	if(calculateOrderParameter != NULL){
+		TBTKAssert(
+			selfConsistencyCallback == NULL,
+			"Diagonalizer::run()",
+			"Both a self-consistency callback and order parameter"
+			<< " callbacks have been set.",
+			"Use either Diagonalizer::setSelfConsistencyCallback() or"
+			<< " Diagonalizer::setOrderParameterCallbacks()."
+		);
+
+		runOrderParameterLoop();
+
+		return;
+	}
+
 	int iterationCounter = 0;
 	init();
 
@@ -70,10 +114,17 @@ void Diagonalizer::run(){
 		solve();
 
 		if(selfConsistencyCallback){
-			if(selfConsistencyCallback(*this))
+			if(selfConsistencyCallback(*this)){
 				break;
-			else
+			}
+			else{
+				//The self-consistency callback is expected to
+				//update amplitudes that are evaluated through
+				//callbacks, which makes the cached Hamiltonian
+				//stale.
+				getModel().invalidateSparseMatrix();
 				update();
+			}
 		}
 		else{
 			break;
@@ -83,6 +134,166 @@ void Diagonalizer::run(){
 		Streams::out << "\n";
 }
 
+void Diagonalizer::runOrderParameterLoop(){
+	TBTKAssert(
+		setOrderParameter != NULL,
+		"Diagonalizer::runOrderParameterLoop()",
+		"The callback setOrderParameter is NULL.",
+		""
+	);
+
+	residualNorms.clear();
+	vector<vector<complex<double>>> inputs;
+	vector<vector<complex<double>>> residuals;
+	vector<complex<double>> input = initialOrderParameter;
+	vector<complex<double>> residual(input.size());
+
+	setOrderParameter(*this, input);
+	getModel().invalidateSparseMatrix();
+	init();
+
+	if(getGlobalVerbose() && getVerbose())
+		Streams::out << "Running Diagonalizer\n";
+	for(int iteration = 0; iteration < maxIterations; iteration++){
+		solve();
+
+		orderParameter.assign(input.size(), 0.);
+		calculateOrderParameter(*this, orderParameter);
+		TBTKAssert(
+			orderParameter.size() == input.size(),
+			"Diagonalizer::runOrderParameterLoop()",
+			"The order parameter calculated by calculateOrderParameter"
+			<< " has size " << orderParameter.size() << ", but the"
+			<< " initial order parameter has size " << input.size()
+			<< ".",
+			""
+		);
+
+		double residualNorm = 0.;
+		double maxError = 0.;
+		for(unsigned int n = 0; n < input.size(); n++){
+			residual[n] = orderParameter[n] - input[n];
+			residualNorm += norm(residual[n]);
+
+			double maxValue = max(abs(orderParameter[n]), abs(input[n]));
+			if(maxValue > 0)
+				maxError = max(maxError, abs(residual[n])/maxValue);
+		}
+		residualNorm = sqrt(residualNorm);
+		residualNorms.push_back(residualNorm);
+
+		if(getGlobalVerbose() && getVerbose()){
+			Streams::out << "\tIteration " << iteration
+				<< ", residual norm: " << residualNorm
+				<< ", max relative error: " << maxError << "\n";
+		}
+
+		if(maxError < convergenceLimit)
+			break;
+		if(iteration + 1 == maxIterations)
+			break;
+
+		inputs.push_back(input);
+		residuals.push_back(residual);
+		if(inputs.size() > mixingHistorySize + 1){
+			inputs.erase(inputs.begin());
+			residuals.erase(residuals.begin());
+		}
+		mix(inputs, residuals, input);
+
+		setOrderParameter(*this, input);
+		getModel().invalidateSparseMatrix();
+		update();
+	}
+}
+
+void Diagonalizer::mix(
+	const vector<vector<complex<double>>> &inputs,
+	const vector<vector<complex<double>>> &residuals,
+	vector<complex<double>> &result
+) const{
+	const vector<complex<double>> &x = inputs.back();
+	const vector<complex<double>> &r = residuals.back();
+	unsigned int size = x.size();
+
+	//Linear mixing.
+	result.resize(size);
+	for(unsigned int n = 0; n < size; n++)
+		result[n] = x[n] + mixingParameter*r[n];
+
+	unsigned int numDifferences = inputs.size() - 1;
+	if(numDifferences == 0)
+		return;
+
+	//Differences between consecutive inputs and residuals.
+	vector<vector<complex<double>>> dX(numDifferences);
+	vector<vector<complex<double>>> dR(numDifferences);
+	for(unsigned int i = 0; i < numDifferences; i++){
+		dX[i].resize(size);
+		dR[i].resize(size);
+		for(unsigned int n = 0; n < size; n++){
+			dX[i][n] = inputs[i+1][n] - inputs[i][n];
+			dR[i][n] = residuals[i+1][n] - residuals[i][n];
+		}
+	}
+
+	//Set up the normal equations A*gamma = b for the least squares
+	//problem min|r - dR*gamma|. The rows of the augmented matrix are
+	//stored as [A_i0, ..., A_i(m-1), b_i].
+	unsigned int m = numDifferences;
+	vector<complex<double>> system(m*(m+1));
+	for(unsigned int i = 0; i < m; i++){
+		for(unsigned int j = 0; j < m; j++){
+			complex<double> sum = 0.;
+			for(unsigned int n = 0; n < size; n++)
+				sum += conj(dR[i][n])*dR[j][n];
+			system[i*(m+1) + j] = sum;
+		}
+		complex<double> sum = 0.;
+		for(unsigned int n = 0; n < size; n++)
+			sum += conj(dR[i][n])*r[n];
+		system[i*(m+1) + m] = sum;
+	}
+
+	//Gaussian elimination with partial pivoting. Falls back to linear
+	//mixing if the history is linearly dependent.
+	double scale = 0.;
+	for(unsigned int i = 0; i < m; i++)
+		scale = max(scale, abs(system[i*(m+1) + i]));
+	for(unsigned int c = 0; c < m; c++){
+		unsigned int pivot = c;
+		for(unsigned int i = c+1; i < m; i++)
+			if(abs(system[i*(m+1) + c]) > abs(system[pivot*(m+1) + c]))
+				pivot = i;
+		if(abs(system[pivot*(m+1) + c]) <= 1e-12*scale)
+			return;
+		for(unsigned int j = 0; j < m+1; j++)
+			swap(system[c*(m+1) + j], system[pivot*(m+1) + j]);
+		for(unsigned int i = c+1; i < m; i++){
+			complex<double> factor
+				= system[i*(m+1) + c]/system[c*(m+1) + c];
+			for(unsigned int j = c; j < m+1; j++)
+				system[i*(m+1) + j] -= factor*system[c*(m+1) + j];
+		}
+	}
+	vector<complex<double>> gamma(m);
+	for(int i = m-1; i >= 0; i--){
+		complex<double> sum = system[i*(m+1) + m];
+		for(unsigned int j = i+1; j < m; j++)
+			sum -= system[i*(m+1) + j]*gamma[j];
+		gamma[i] = sum/system[i*(m+1) + i];
+	}
+
+	//x_new = x + beta*r - sum_i gamma_i*(dX_i + beta*dR_i).
+	for(unsigned int i = 0; i < m; i++){
+		for(unsigned int n = 0; n < size; n++){
+			result[n] -= gamma[i]*(
+				dX[i][n] + mixingParameter*dR[i][n]
+			);
+		}
+	}
+}
+
 void Diagonalizer::init(){
 	if(getGlobalVerbose() && getVerbose())
 		Streams::out << "Initializing Diagonalizer\n";
@@ -93,6 +304,25 @@ void Diagonalizer::init(){
 	if(getGlobalVerbose() && getVerbose())
 		Streams::out << "\tBasis size: " << basisSize << "\n";
 
+	TBTKAssert(
+		range == Range::All || algorithm == Algorithm::MRRR,
+		"Diagonalizer::init()",
+		"Only Algorithm::MRRR supports calculating a subset of the"
+		<< " eigenpairs.",
+		"Use Diagonalizer::setAlgorithm() to select"
+		<< " Algorithm::MRRR or call"
+		<< " Diagonalizer::setCalculateAllEigenStates()."
+	);
+	TBTKAssert(
+		range != Range::EigenStateRange
+		|| eigenStateRange[1] < basisSize,
+		"Diagonalizer::init()",
+		"The eigenstate range [" << eigenStateRange[0] << ", "
+		<< eigenStateRange[1] << "] is out of bounds for a basis"
+		<< " of size " << basisSize << ".",
+		""
+	);
+
 	if(hamiltonian != nullptr)
 		delete [] hamiltonian;
 	if(eigenValues != nullptr)
@@ -100,9 +330,32 @@ void Diagonalizer::init(){
 	if(eigenVectors != nullptr)
 		delete [] eigenVectors;
 
-	hamiltonian = new complex<double>[(basisSize*(basisSize+1))/2];
+	int maxNumEigenValues = basisSize;
+	if(range == Range::EigenStateRange)
+		maxNumEigenValues = eigenStateRange[1] - eigenStateRange[0] + 1;
+
+	switch(algorithm){
+	case Algorithm::Packed:
+		hamiltonian = new complex<double>[(basisSize*(basisSize+1))/2];
+		break;
+	case Algorithm::DivideAndConquer:
+		hamiltonian = NULL;
+		break;
+	case Algorithm::MRRR:
+		hamiltonian = new complex<double>[basisSize*basisSize];
+		break;
+	default:
+		TBTKExit(
+			"Diagonalizer::init()",
+			"Unknown algorithm.",
+			"This should never happen, contact the developer."
+		);
+	}
 	eigenValues = new double[basisSize];
-	eigenVectors = new complex<double>[basisSize*basisSize];
+	eigenVectors = new complex<double>[basisSize*maxNumEigenValues];
+	numEigenValues = 0;
+
+	initWorkspaces();
 
 	update();
 }
@@ -111,20 +364,43 @@ void Diagonalizer::update(){
 	const Model &model = getModel();
 	int basisSize = model.getBasisSize();
 
-	for(int n = 0; n < (basisSize*(basisSize+1))/2; n++)
-		hamiltonian[n] = 0.;
+	shared_ptr<const SparseMatrix<complex<double>>> sparseMatrix
+		= model.getHoppingAmplitudeSet()->getSparseMatrix();
+	const unsigned int *rowPointers = sparseMatrix->getCSRRowPointers();
+	const unsigned int *columns = sparseMatrix->getCSRColumns();
+	const complex<double> *values = sparseMatrix->getCSRValues();
+
+	if(algorithm == Algorithm::Packed){
+		for(int n = 0; n < (basisSize*(basisSize+1))/2; n++)
+			hamiltonian[n] = 0.;
+
+		for(int to = 0; to < basisSize; to++){
+			for(unsigned int n = rowPointers[to]; n < rowPointers[to+1]; n++){
+				int from = columns[n];
+				if(from >= to)
+					hamiltonian[to + (from*(from+1))/2] += values[n];
+			}
+		}
+	}
+	else{
+		//Full column major storage, where only the upper triangle is
+		//referenced by LAPACK.
+		complex<double> *matrix;
+		if(algorithm == Algorithm::DivideAndConquer)
+			matrix = eigenVectors;
+		else
+			matrix = hamiltonian;
 
-	HoppingAmplitudeSet::Iterator it = model.getHoppingAmplitudeSet()->getIterator();
-	const HoppingAmplitude *ha;
-	while((ha = it.getHA())){
-/*		int from = model->getHoppingAmplitudeSet()->getBasisIndex(ha->fromIndex);
-		int to = model->getHoppingAmplitudeSet()->getBasisIndex(ha->toIndex);*/
-		int from = model.getHoppingAmplitudeSet()->getBasisIndex(ha->getFromIndex());
-		int to = model.getHoppingAmplitudeSet()->getBasisIndex(ha->getToIndex());
-		if(from >= to)
-			hamiltonian[to + (from*(from+1))/2] += ha->getAmplitude();
+		for(int n = 0; n < basisSize*basisSize; n++)
+			matrix[n] = 0.;
 
-		it.searchNextHA();
+		for(int to = 0; to < basisSize; to++){
+			for(unsigned int n = rowPointers[to]; n < rowPointers[to+1]; n++){
+				int from = columns[n];
+				if(from >= to)
+					matrix[to + from*basisSize] += values[n];
+			}
+		}
 	}
 }
 
@@ -155,16 +431,177 @@ extern "C" void zhbeb_(
 	double *rwork,		//Workspace, dimension = max(1, 3*N-2)
 	int *info);		//0 = successful, <0 = -info value was illegal, >0 = info number of off-diagonal elements failed to converge.
 
+//Lapack function for divide and conquer diagonalization of a full matrix.
+extern "C" void zheevd_(
+	char *jobz,		//'N' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+	char *uplo,		//'U' = Upper triangle stored, 'L' = Lower triangle stored.
+	int *n,			//n*n = Matrix size
+	complex<double> *a,	//Input matrix, overwritten by the eigenvectors if jobz = 'V'
+	int *lda,		//Leading dimension of a
+	double *w,		//Eigenvalues in ascending order
+	complex<double> *work,	//Workspace
+	int *lwork,		//Size of work, -1 = workspace query
+	double *rwork,		//Workspace
+	int *lrwork,		//Size of rwork, -1 = workspace query
+	int *iwork,		//Workspace
+	int *liwork,		//Size of iwork, -1 = workspace query
+	int *info);		//0 = successful, <0 = -info value was illegal, >0 = failed to converge.
+
+//Lapack function for MRRR diagonalization of a full matrix.
+extern "C" void zheevr_(
+	char *jobz,		//'N' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+	char *range,		//'A' = All, 'V' = Eigenvalues in (vl, vu], 'I' = Eigenvalues il to iu.
+	char *uplo,		//'U' = Upper triangle stored, 'L' = Lower triangle stored.
+	int *n,			//n*n = Matrix size
+	complex<double> *a,	//Input matrix, destroyed on exit
+	int *lda,		//Leading dimension of a
+	double *vl,		//Lower bound of the eigenvalue window
+	double *vu,		//Upper bound of the eigenvalue window
+	int *il,		//Index of the first eigenvalue (starting at 1)
+	int *iu,		//Index of the last eigenvalue (starting at 1)
+	double *abstol,		//Absolute error tolerance, <= 0 = default tolerance
+	int *m,			//Number of eigenvalues found
+	double *w,		//Eigenvalues in ascending order
+	complex<double> *z,	//Eigenvectors
+	int *ldz,		//Leading dimension of z
+	int *isuppz,		//Support of the eigenvectors, dimension = 2*max(1, m)
+	complex<double> *work,	//Workspace
+	int *lwork,		//Size of work, -1 = workspace query
+	double *rwork,		//Workspace
+	int *lrwork,		//Size of rwork, -1 = workspace query
+	int *iwork,		//Workspace
+	int *liwork,		//Size of iwork, -1 = workspace query
+	int *info);		//0 = successful, <0 = -info value was illegal, >0 = internal error.
+
+void Diagonalizer::initWorkspaces(){
+	freeWorkspaces();
+
+	int n = getModel().getBasisSize();
+	char jobz = 'V';
+	char uplo = 'U';
+	int info;
+
+	switch(algorithm){
+	case Algorithm::Packed:
+		lwork = max(1, 2*n-1);
+		lrwork = max(1, 3*n-2);
+		liwork = 0;
+		break;
+	case Algorithm::DivideAndConquer:
+	{
+		//Workspace query.
+		complex<double> workSize;
+		double rworkSize;
+		int iworkSize;
+		lwork = -1;
+		lrwork = -1;
+		liwork = -1;
+		zheevd_(&jobz, &uplo, &n, eigenVectors, &n, eigenValues, &workSize, &lwork, &rworkSize, &lrwork, &iworkSize, &liwork, &info);
+
+		TBTKAssert(
+			info == 0,
+			"Diagonalizer::initWorkspaces()",
+			"Workspace query for zheevd exited with INFO=" + to_string(info) + ".",
+			"See LAPACK documentation for zheevd for further information."
+		);
+
+		lwork = (int)real(workSize);
+		lrwork = (int)rworkSize;
+		liwork = iworkSize;
+		break;
+	}
+	case Algorithm::MRRR:
+	{
+		//Workspace query.
+		char rangeType = 'A';
+		double vl = 0;
+		double vu = 0;
+		int il = 0;
+		int iu = 0;
+		double abstol = 0;
+		int m;
+		complex<double> workSize;
+		double rworkSize;
+		int iworkSize;
+		int isuppzDummy[2];
+		lwork = -1;
+		lrwork = -1;
+		liwork = -1;
+		zheevr_(&jobz, &rangeType, &uplo, &n, hamiltonian, &n, &vl, &vu, &il, &iu, &abstol, &m, eigenValues, eigenVectors, &n, isuppzDummy, &workSize, &lwork, &rworkSize, &lrwork, &iworkSize, &liwork, &info);
+
+		TBTKAssert(
+			info == 0,
+			"Diagonalizer::initWorkspaces()",
+			"Workspace query for zheevr exited with INFO=" + to_string(info) + ".",
+			"See LAPACK documentation for zheevr for further information."
+		);
+
+		lwork = (int)real(workSize);
+		lrwork = (int)rworkSize;
+		liwork = iworkSize;
+		isuppz = new int[2*max(1, n)];
+		break;
+	}
+	default:
+		TBTKExit(
+			"Diagonalizer::initWorkspaces()",
+			"Unknown algorithm.",
+			"This should never happen, contact the developer."
+		);
+	}
+
+	work = new complex<double>[lwork];
+	rwork = new double[lrwork];
+	if(liwork > 0)
+		iwork = new int[liwork];
+}
+
+void Diagonalizer::freeWorkspaces(){
+	if(work != NULL)
+		delete [] work;
+	if(rwork != NULL)
+		delete [] rwork;
+	if(iwork != NULL)
+		delete [] iwork;
+	if(isuppz != NULL)
+		delete [] isuppz;
+
+	work = NULL;
+	rwork = NULL;
+	iwork = NULL;
+	isuppz = NULL;
+	lwork = 0;
+	lrwork = 0;
+	liwork = 0;
+}
+
 void Diagonalizer::solve(){
-	if(true){//Currently no support for banded matrices.
-		//Setup zhpev to calculate...
-		char jobz = 'V';		//...eigenvalues and eigenvectors...
-		char uplo = 'U';		//...for an upper triangular...
-		int n = getModel().getBasisSize();	//...nxn-matrix.
-		//Initialize workspaces
-		complex<double> *work = new complex<double>[(2*n-1)];
-		double *rwork = new double[3*n-2];
-		int info;
+	char jobz = 'V';			//Eigenvalues and eigenvectors...
+	char uplo = 'U';			//...for an upper triangular...
+	int n = getModel().getBasisSize();	//...nxn-matrix.
+	int info;
+
+	bool useCache = (eigenSolutionCache != NULL && range == Range::All);
+	unsigned long long hash = 0;
+	if(useCache){
+		hash = getModel().getHash();
+		if(
+			eigenSolutionCache->load(
+				hash,
+				n,
+				(size_t)n*n,
+				eigenValues,
+				eigenVectors
+			)
+		){
+			numEigenValues = n;
+
+			return;
+		}
+	}
+
+	switch(algorithm){
+	case Algorithm::Packed:
 		//Solve brop
 		zhpev_(&jobz, &uplo, &n, hamiltonian, eigenValues, eigenVectors, &n, work, rwork, &info);
 
@@ -175,9 +612,80 @@ void Diagonalizer::solve(){
 			"See LAPACK documentation for zhpev for further information."
 		);
 
-		//Delete workspaces
-		delete [] work;
-		delete [] rwork;
+		numEigenValues = n;
+		break;
+	case Algorithm::DivideAndConquer:
+		//The Hamiltonian is stored in eigenVectors and is overwritten
+		//by the eigenvectors.
+		zheevd_(&jobz, &uplo, &n, eigenVectors, &n, eigenValues, work, &lwork, rwork, &lrwork, iwork, &liwork, &info);
+
+		TBTKAssert(
+			info == 0,
+			"Diagonalizer:solve()",
+			"Diagonalization routine zheevd exited with INFO=" + to_string(info) + ".",
+			"See LAPACK documentation for zheevd for further information."
+		);
+
+		numEigenValues = n;
+		break;
+	case Algorithm::MRRR:
+	{
+		char rangeType;
+		double vl = 0;
+		double vu = 0;
+		int il = 0;
+		int iu = 0;
+		switch(range){
+		case Range::All:
+			rangeType = 'A';
+			break;
+		case Range::EigenValueWindow:
+			rangeType = 'V';
+			vl = eigenValueWindow[0];
+			vu = eigenValueWindow[1];
+			break;
+		case Range::EigenStateRange:
+			rangeType = 'I';
+			il = eigenStateRange[0] + 1;
+			iu = eigenStateRange[1] + 1;
+			break;
+		default:
+			TBTKExit(
+				"Diagonalizer::solve()",
+				"Unknown range.",
+				"This should never happen, contact the developer."
+			);
+		}
+		double abstol = 0;
+		int m;
+		zheevr_(&jobz, &rangeType, &uplo, &n, hamiltonian, &n, &vl, &vu, &il, &iu, &abstol, &m, eigenValues, eigenVectors, &n, isuppz, work, &lwork, rwork, &lrwork, iwork, &liwork, &info);
+
+		TBTKAssert(
+			info == 0,
+			"Diagonalizer:solve()",
+			"Diagonalization routine zheevr exited with INFO=" + to_string(info) + ".",
+			"See LAPACK documentation for zheevr for further information."
+		);
+
+		numEigenValues = m;
+		break;
+	}
+	default:
+		TBTKExit(
+			"Diagonalizer::solve()",
+			"Unknown algorithm.",
+			"This should never happen, contact the developer."
+		);
+	}
+
+	if(useCache){
+		eigenSolutionCache->store(
+			hash,
+			n,
+			(size_t)n*n,
+			eigenValues,
+			eigenVectors
+		);
 	}
 /*	else{
 		int kd;
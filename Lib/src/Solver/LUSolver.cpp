@@ -23,6 +23,12 @@
 #include "slu_ddefs.h"
 #include "slu_zdefs.h"
 
+#include <algorithm>
+
+#ifdef TBTK_USE_OPEN_MP
+#include <omp.h>
+#endif
+
 using namespace std;
 
 namespace TBTK{
@@ -33,13 +39,22 @@ LUSolver::LUSolver() : Communicator(true){
 	rowPermutations = nullptr;
 	columnPermutations = nullptr;
 	statistics = nullptr;
+	matrixDataType = DataType::None;
+	symbolicAnalysisWasReused = false;
+	symmetricMode = false;
+	blockSize = 256;
+	parallelExecution = false;
 }
 
 LUSolver::~LUSolver(){
-	if(L != nullptr)
+	if(L != nullptr){
 		Destroy_SuperNode_Matrix(L);
-	if(U != nullptr)
+		delete L;
+	}
+	if(U != nullptr){
 		Destroy_CompCol_Matrix(U);
+		delete U;
+	}
 	if(rowPermutations != nullptr)
 		delete [] rowPermutations;
 	if(columnPermutations != nullptr)
@@ -99,9 +114,17 @@ void LUSolver::setMatrix(const SparseMatrix<double> &sparseMatrix){
 		SLU_GE
 	);
 
-	allocatePermutationMatrices(numRows, numColumns);
+	bool reuseSymbolicAnalysis = updateSparsityPattern(
+		numRows,
+		numColumns,
+		numMatrixElements,
+		cscColumnPointers,
+		cscRows
+	);
+	if(!reuseSymbolicAnalysis)
+		allocatePermutationMatrices(numRows, numColumns);
 	initStatistics();
-	performLUFactorization(sluMatrix);
+	performLUFactorization(sluMatrix, reuseSymbolicAnalysis);
 
 	//Clean up
 	Destroy_CompCol_Matrix(&sluMatrix);
@@ -190,14 +213,32 @@ void LUSolver::setMatrix(const SparseMatrix<complex<double>> &sparseMatrix){
 		);
 	}
 
-	allocatePermutationMatrices(numRows, numColumns);
+	bool reuseSymbolicAnalysis = updateSparsityPattern(
+		numRows,
+		numColumns,
+		numMatrixElements,
+		cscColumnPointers,
+		cscRows
+	);
+	if(!reuseSymbolicAnalysis)
+		allocatePermutationMatrices(numRows, numColumns);
 	initStatistics();
-	performLUFactorization(sluMatrix);
+	performLUFactorization(sluMatrix, reuseSymbolicAnalysis);
 
 	//Clean up
 	Destroy_CompCol_Matrix(&sluMatrix);
 }
 
+void LUSolver::setSymmetricMode(bool symmetricMode){
+	//The column permutation depends on the mode, so the symbolic
+	//analysis can not be reused after a change of mode.
+	if(this->symmetricMode != symmetricMode){
+		patternColumnPointers.clear();
+		patternRows.clear();
+	}
+	this->symmetricMode = symmetricMode;
+}
+
 void LUSolver::allocatePermutationMatrices(
 	unsigned int numRows,
 	unsigned int numColumns
@@ -210,6 +251,37 @@ void LUSolver::allocatePermutationMatrices(
 	columnPermutations = new int[numColumns];
 }
 
+bool LUSolver::updateSparsityPattern(
+	unsigned int numRows,
+	unsigned int numColumns,
+	unsigned int numMatrixElements,
+	const unsigned int *cscColumnPointers,
+	const unsigned int *cscRows
+){
+	bool isSamePattern = (
+		L != nullptr
+		&& L->nrow == (int)numRows
+		&& patternColumnPointers.size() == numColumns+1
+		&& patternRows.size() == numMatrixElements
+		&& equal(
+			patternColumnPointers.begin(),
+			patternColumnPointers.end(),
+			cscColumnPointers
+		)
+		&& equal(patternRows.begin(), patternRows.end(), cscRows)
+	);
+
+	if(!isSamePattern){
+		patternColumnPointers.assign(
+			cscColumnPointers,
+			cscColumnPointers + numColumns + 1
+		);
+		patternRows.assign(cscRows, cscRows + numMatrixElements);
+	}
+
+	return isSamePattern;
+}
+
 void LUSolver::initStatistics(){
 	if(statistics != nullptr)
 		StatFree(statistics);
@@ -218,10 +290,14 @@ void LUSolver::initStatistics(){
 }
 
 void LUSolver::allocateLUMatrices(){
-	if(L != nullptr)
+	if(L != nullptr){
 		Destroy_SuperNode_Matrix(L);
-	if(U != nullptr)
-		Destroy_SuperNode_Matrix(U);
+		delete L;
+	}
+	if(U != nullptr){
+		Destroy_CompCol_Matrix(U);
+		delete U;
+	}
 	L = new SuperMatrix();
 	U = new SuperMatrix();
 }
@@ -266,11 +342,21 @@ void LUSolver::checkXgstrfErrors(
 
 void LUSolver::initOptionsAndPermutationMatrices(
 	superlu_options_t &options,
-	SuperMatrix &matrix
+	SuperMatrix &matrix,
+	bool reuseSymbolicAnalysis
 ){
-	//Initialize options.
+	//Initialize options. SamePattern reuses the column permutation and
+	//the column elimination tree, while the row permutation is
+	//recalculated to keep the partial pivoting stable.
 	set_default_options(&options);
 	options.ColPerm = COLAMD;
+	if(symmetricMode){
+		options.SymmetricMode = YES;
+		options.ColPerm = MMD_AT_PLUS_A;
+		options.DiagPivotThresh = 0.001;
+	}
+	if(reuseSymbolicAnalysis)
+		options.Fact = SamePattern;
 
 	//Calculate column permutations.
 	if(options.ColPerm != MY_PERMC && options.Fact == DOFACT)
@@ -279,13 +365,25 @@ void LUSolver::initOptionsAndPermutationMatrices(
 
 //LU factorization performed in accordance with the procedure used in
 //zgssv.c in SuperLU 5.2.1. See this file for further details.
-void LUSolver::performLUFactorization(SuperMatrix &matrix){
+void LUSolver::performLUFactorization(
+	SuperMatrix &matrix,
+	bool reuseSymbolicAnalysis
+){
 	allocateLUMatrices();
 
 	superlu_options_t options;
-	initOptionsAndPermutationMatrices(options, matrix);
+	initOptionsAndPermutationMatrices(
+		options,
+		matrix,
+		reuseSymbolicAnalysis
+	);
 
-	int *etree = new int[matrix.ncol];
+	//The elimination tree is calculated by sp_preorder() unless the
+	//symbolic analysis is reused.
+	if(!reuseSymbolicAnalysis)
+		eliminationTree.assign(matrix.ncol, 0);
+	int *etree = eliminationTree.data();
+	symbolicAnalysisWasReused = reuseSymbolicAnalysis;
 
 	//Create new matrix resulting from post multiplication by the column
 	//permutation matrix, i.e. matrix*columnPermutations.
@@ -353,7 +451,6 @@ void LUSolver::performLUFactorization(SuperMatrix &matrix){
 		);
 	}
 
-	SUPERLU_FREE(etree);
 	Destroy_CompCol_Permuted(&matrixCP);
 }
 
@@ -364,31 +461,128 @@ void LUSolver::solve(Matrix<double> &b){
 
 	TBTKAssert(
 		matrixDataType == DataType::Double,
-//		U->Dtype == SLU_D,
 		"LUSolver::solve()",
 		"The matrix is complex, therefore 'b' must be complex.",
 		""
 	);
 
-	//Setup right hand side on SuperLU format.
-	double *sluBValues = new double[numRows*numColumns];
-	for(unsigned int row = 0; row < numRows; row++)
-		for(unsigned int col = 0; col < numColumns; col++)
-			sluBValues[col*numRows + row] = b.at(row, col);
+	//Solve directly on the column major storage of 'b', one block of
+	//columns at the time.
+	double *data = b.getData();
+	int numBlocks = getNumBlocks(numColumns);
+	#pragma omp parallel if(solveBlocksInParallel(numBlocks))
+	{
+		SuperLUStat_t threadStatistics;
+		StatInit(&threadStatistics);
+
+		#pragma omp for schedule(dynamic)
+		for(int block = 0; block < numBlocks; block++){
+			unsigned int firstColumn = block*blockSize;
+			solveBlock(
+				data + numRows*firstColumn,
+				numRows,
+				min(blockSize, numColumns - firstColumn),
+				threadStatistics
+			);
+		}
+
+		StatFree(&threadStatistics);
+	}
+}
+
+void LUSolver::solve(Matrix<complex<double>> &b){
+	unsigned int numRows = b.getNumRows();
+	unsigned int numColumns = b.getNumCols();
+	checkSolveAssert(numRows);
+
+	TBTKAssert(
+		matrixDataType == DataType::Double
+		|| matrixDataType == DataType::ComplexDouble,
+		"LUSolver::solve()",
+		"Only matrices of type double and complex<double> are"
+		<< " supported yet",
+		"This should never happen, contact the developer."
+	);
+
+	//Workspaces for splitting the right hand side into real and
+	//imaginary parts. One per thread if the blocks are solved in
+	//parallel.
+	int numBlocks = getNumBlocks(numColumns);
+	if(matrixDataType == DataType::Double){
+		unsigned int numWorkspaces = 1;
+#ifdef TBTK_USE_OPEN_MP
+		if(solveBlocksInParallel(numBlocks))
+			numWorkspaces = omp_get_max_threads();
+#endif
+		if(realWorkspaces.size() < numWorkspaces)
+			realWorkspaces.resize(numWorkspaces);
+	}
 
+	//Solve directly on the column major storage of 'b', one block of
+	//columns at the time.
+	complex<double> *data = b.getData();
+	#pragma omp parallel if(solveBlocksInParallel(numBlocks))
+	{
+		unsigned int threadID = 0;
+#ifdef TBTK_USE_OPEN_MP
+		threadID = omp_get_thread_num();
+#endif
+
+		SuperLUStat_t threadStatistics;
+		StatInit(&threadStatistics);
+
+		#pragma omp for schedule(dynamic)
+		for(int block = 0; block < numBlocks; block++){
+			unsigned int firstColumn = block*blockSize;
+			unsigned int numBlockColumns = min(
+				blockSize,
+				numColumns - firstColumn
+			);
+			switch(matrixDataType){
+			case DataType::Double:
+				solveBlock(
+					data + numRows*firstColumn,
+					numRows,
+					numBlockColumns,
+					realWorkspaces[threadID],
+					threadStatistics
+				);
+				break;
+			case DataType::ComplexDouble:
+				solveBlock(
+					data + numRows*firstColumn,
+					numRows,
+					numBlockColumns,
+					threadStatistics
+				);
+				break;
+			default:
+				break;
+			}
+		}
+
+		StatFree(&threadStatistics);
+	}
+}
+
+void LUSolver::solveBlock(
+	double *b,
+	unsigned int numRows,
+	unsigned int numColumns,
+	SuperLUStat_t &statistics
+){
 	SuperMatrix sluB;
 	dCreate_Dense_Matrix(
 		&sluB,
 		numRows,
 		numColumns,
-		sluBValues,
+		b,
 		numRows,	//Leading dimension
 		SLU_DN,
 		SLU_D,
 		SLU_GE
 	);
 
-	//Solve
 	int info;
 	dgstrs(
 		NOTRANS,
@@ -397,177 +591,101 @@ void LUSolver::solve(Matrix<double> &b){
 		columnPermutations,
 		rowPermutations,
 		&sluB,
-		statistics,
+		&statistics,
 		&info
 	);
 	checkXgstrsErrors(info, "dgstrs");
 
-	//Copy results to return value
-	for(unsigned int row = 0; row < numRows; row++)
-		for(unsigned int col = 0; col < numColumns; col++)
-			b.at(row, col) = sluBValues[col*numRows + row];
-
-	Destroy_Dense_Matrix(&sluB);
+	//Only the store is destroyed since the data is owned by 'b'.
+	Destroy_SuperMatrix_Store(&sluB);
 }
 
-void LUSolver::solve(Matrix<complex<double>> &b){
-	unsigned int numRows = b.getNumRows();
-	unsigned int numColumns = b.getNumCols();
-	checkSolveAssert(numRows);
-
-//	switch(U->Dtype){
-//	case SLU_D:
-	switch(matrixDataType){
-	case DataType::Double:
-	{
-		//Setup right hand side on SuperLU format.
-		double *sluBValuesReal = new double[numRows*numColumns];
-		double *sluBValuesImag = new double[numRows*numColumns];
-		bool isReal = true;
-		bool isImag = true;
-		for(unsigned int row = 0; row < numRows; row++){
-			for(unsigned int col = 0; col < numColumns; col++){
-				double r = real(b.at(row, col));
-				double i = imag(b.at(row, col));
-				sluBValuesReal[col*numRows + row] = r;
-				sluBValuesImag[col*numRows + row] = i;
-
-				if(r != 0)
-					isImag = false;
-				if(i != 0)
-					isReal = false;
-			}
-		}
-
-		SuperMatrix sluBReal;
-		dCreate_Dense_Matrix(
-			&sluBReal,
-			numRows,
-			numColumns,
-			sluBValuesReal,
-			numRows,	//Leading dimension
-			SLU_DN,
-			SLU_D,
-			SLU_GE
-		);
-
-		SuperMatrix sluBImag;
-		dCreate_Dense_Matrix(
-			&sluBImag,
-			numRows,
-			numColumns,
-			sluBValuesImag,
-			numRows,	//Leading dimension
-			SLU_DN,
-			SLU_D,
-			SLU_GE
-		);
-
-		//Solve real part
-		if(!isImag){
-			int info;
-			dgstrs(
-				NOTRANS,
-				L,
-				U,
-				columnPermutations,
-				rowPermutations,
-				&sluBReal,
-				statistics,
-				&info
-			);
-			checkXgstrsErrors(info, "dgstrs");
-		}
-
-		//Solve imaginary part
-		if(!isReal){
-			int info;
-			dgstrs(
-				NOTRANS,
-				L,
-				U,
-				columnPermutations,
-				rowPermutations,
-				&sluBImag,
-				statistics,
-				&info
-			);
-			checkXgstrsErrors(info, "dgstrs");
-		}
+void LUSolver::solveBlock(
+	complex<double> *b,
+	unsigned int numRows,
+	unsigned int numColumns,
+	SuperLUStat_t &statistics
+){
+	//complex<double> has the same memory layout as doublecomplex.
+	SuperMatrix sluB;
+	zCreate_Dense_Matrix(
+		&sluB,
+		numRows,
+		numColumns,
+		reinterpret_cast<doublecomplex*>(b),
+		numRows,	//Leading dimension
+		SLU_DN,
+		SLU_Z,
+		SLU_GE
+	);
 
-		//Copy results to return value
-		for(unsigned int row = 0; row < numRows; row++){
-			for(unsigned int col = 0; col < numColumns; col++){
-				b.at(row, col) = complex<double>(
-					sluBValuesReal[col*numRows + row],
-					sluBValuesImag[col*numRows + row]
-				);
-			}
-		}
+	int info;
+	zgstrs(
+		NOTRANS,
+		L,
+		U,
+		columnPermutations,
+		rowPermutations,
+		&sluB,
+		&statistics,
+		&info
+	);
+	checkXgstrsErrors(info, "zgstrs");
 
-		Destroy_Dense_Matrix(&sluBReal);
-		Destroy_Dense_Matrix(&sluBImag);
+	//Only the store is destroyed since the data is owned by 'b'.
+	Destroy_SuperMatrix_Store(&sluB);
+}
 
-		break;
+void LUSolver::solveBlock(
+	complex<double> *b,
+	unsigned int numRows,
+	unsigned int numColumns,
+	vector<double> &workspace,
+	SuperLUStat_t &statistics
+){
+	unsigned int numElements = numRows*numColumns;
+
+	//Parts that are identically zero have zero solutions and are not
+	//solved for.
+	bool hasRealPart = false;
+	bool hasImaginaryPart = false;
+	for(unsigned int n = 0; n < numElements; n++){
+		if(real(b[n]) != 0)
+			hasRealPart = true;
+		if(imag(b[n]) != 0)
+			hasImaginaryPart = true;
+		if(hasRealPart && hasImaginaryPart)
+			break;
+	}
+	unsigned int numParts = hasRealPart + hasImaginaryPart;
+	if(numParts == 0)
+		return;
+
+	//Pack the real parts into the first and the imaginary parts into the
+	//last numColumns columns of the workspace, such that both are solved
+	//for in a single triangular solve.
+	if(workspace.size() < numParts*numElements)
+		workspace.resize(numParts*numElements);
+	double *realParts = workspace.data();
+	double *imaginaryParts = workspace.data() + (numParts - 1)*numElements;
+	for(unsigned int n = 0; n < numElements; n++){
+		if(hasRealPart)
+			realParts[n] = real(b[n]);
+		if(hasImaginaryPart)
+			imaginaryParts[n] = imag(b[n]);
 	}
-//	case SLU_Z:
-	case DataType::ComplexDouble:
-	{
-		//Setup right hand side on SuperLU format.
-		doublecomplex *sluBValues = new doublecomplex[numRows*numColumns];
-		for(unsigned int row = 0; row < numRows; row++){
-			for(unsigned int col = 0; col < numColumns; col++){
-				sluBValues[col*numRows + row].r = real(b.at(row, col));
-				sluBValues[col*numRows + row].i = imag(b.at(row, col));
-			}
-		}
-
-		SuperMatrix sluB;
-		zCreate_Dense_Matrix(
-			&sluB,
-			numRows,
-			numColumns,
-			sluBValues,
-			numRows,	//Leading dimension
-			SLU_DN,
-			SLU_Z,
-			SLU_GE
-		);
-
-		//Solve
-		int info;
-		zgstrs(
-			NOTRANS,
-			L,
-			U,
-			columnPermutations,
-			rowPermutations,
-			&sluB,
-			statistics,
-			&info
-		);
-		checkXgstrsErrors(info, "zgstrs");
-
-		//Copy results to return value
-		for(unsigned int row = 0; row < numRows; row++){
-			for(unsigned int col = 0; col < numColumns; col++){
-				b.at(row, col) = complex<double>(
-					sluBValues[col*numRows + row].r,
-					sluBValues[col*numRows + row].i
-				);
-			}
-		}
 
-		Destroy_Dense_Matrix(&sluB);
+	solveBlock(
+		workspace.data(),
+		numRows,
+		numParts*numColumns,
+		statistics
+	);
 
-		break;
-	}
-	default:
-		TBTKExit(
-			"LUSolver::solve()",
-			"Only matrices of type double and complex<double> are"
-			<< " supported yet",
-			"This should never happen, contact the developer."
+	for(unsigned int n = 0; n < numElements; n++){
+		b[n] = complex<double>(
+			hasRealPart ? realParts[n] : 0.,
+			hasImaginaryPart ? imaginaryParts[n] : 0.
 		);
 	}
 }
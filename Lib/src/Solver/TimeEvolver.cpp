@@ -18,12 +18,15 @@
  *  @author Kristofer Björnson
  */
 
+#include "TBTK/EigenPairSorter.h"
 #include "TBTK/HoppingAmplitudeSet.h"
 #include "TBTK/Streams.h"
 #include "TBTK/TBTKMacros.h"
 #include "TBTK/Solver/TimeEvolver.h"
 
+#include <algorithm>
 #include <complex>
+#include <limits>
 #include <math.h>
 
 using namespace std;
@@ -33,6 +36,9 @@ namespace Solver{
 
 const complex<double> i(0, 1);
 
+constexpr double TimeEvolver::DEFAULT_PROPAGATION_TOLERANCE;
+constexpr unsigned int TimeEvolver::DEFAULT_MAX_KRYLOV_DIMENSION;
+
 vector<TimeEvolver*> TimeEvolver::timeEvolvers;
 vector<Diagonalizer*> TimeEvolver::dSolvers;
 
@@ -50,6 +56,10 @@ TimeEvolver::TimeEvolver(){
 	currentTimeStep = -1;
 	orthogonalityError = 0.;
 	orthogonalityCheckInterval = 0;
+	propagator = Propagator::Euler;
+	propagationTolerance = DEFAULT_PROPAGATION_TOLERANCE;
+	maxKrylovDimension = DEFAULT_MAX_KRYLOV_DIMENSION;
+	propagateOccupiedStatesOnly = false;
 
 	dSolvers.push_back(&dSolver);
 	timeEvolvers.push_back(this);
@@ -78,6 +88,15 @@ TimeEvolver::~TimeEvolver(){
 }
 
 void TimeEvolver::run(){
+	TBTKAssert(
+		!propagateOccupiedStatesOnly || decayMode == DecayMode::None,
+		"TimeEvolver::run()",
+		"Only occupied states can be time evolved when the decay mode"
+		<< " is DecayMode::None.",
+		"Use TimeEvolver::setPropagateOccupiedStatesOnly(false) to time"
+		<< " evolve all states."
+	);
+
 	Model &model = getModel();
 	int basisSize = model.getBasisSize();
 	occupancy = new double[basisSize];
@@ -95,65 +114,107 @@ void TimeEvolver::run(){
 		}
 	}
 
-	complex<double> *dPsi = new complex<double>[basisSize*basisSize];
+	complex<double> *dPsi = NULL;
+	if(propagator == Propagator::Euler)
+		dPsi = new complex<double>[basisSize*basisSize];
 	for(int t = 0; t < numTimeSteps; t++){
 		currentTimeStep = t;
 		callback(this);
 
-		#pragma omp parallel for
-		for(int n = 0; n < basisSize*basisSize; n++)
-			dPsi[n] = 0.;
-
-		HoppingAmplitudeSet::Iterator it = model.getHoppingAmplitudeSet()->getIterator();
-		const HoppingAmplitude *ha;
-		while((ha = it.getHA())){
-/*			int fromIndex = model->getHoppingAmplitudeSet()->getBasisIndex(ha->fromIndex);
-			int toIndex = model->getHoppingAmplitudeSet()->getBasisIndex(ha->toIndex);*/
-			int fromIndex = model.getHoppingAmplitudeSet()->getBasisIndex(ha->getFromIndex());
-			int toIndex = model.getHoppingAmplitudeSet()->getBasisIndex(ha->getToIndex());
-			complex<double> amplitude = ha->getAmplitude();
+		//The callback may have changed time dependent amplitudes,
+		//which makes the cached Hamiltonian stale.
+		model.invalidateSparseMatrix();
+		shared_ptr<const SparseMatrix<complex<double>>> sparseMatrix
+			= model.getHoppingAmplitudeSet()->getSparseMatrix();
+		const SparseMatrix<complex<double>> &hamiltonian
+			= *sparseMatrix;
+		const unsigned int *rowPointers
+			= hamiltonian.getCSRRowPointers();
+		const unsigned int *columns = hamiltonian.getCSRColumns();
+		const complex<double> *values = hamiltonian.getCSRValues();
+
+		if(propagator == Propagator::Euler){
 			#pragma omp parallel for
 			for(int n = 0; n < basisSize; n++){
-				dPsi[basisSize*n + toIndex] += amplitude*eigenVectorsMap[n][fromIndex];
+				if(
+					propagateOccupiedStatesOnly
+					&& occupancy[n] == 0
+				){
+					continue;
+				}
+
+				for(int row = 0; row < basisSize; row++){
+					complex<double> sum = 0.;
+					for(
+						unsigned int c = rowPointers[row];
+						c < rowPointers[row+1];
+						c++
+					){
+						sum += values[c]*eigenVectorsMap[n][columns[c]];
+					}
+					dPsi[basisSize*n + row] = sum;
+				}
 			}
-			it.searchNextHA();
-		}
 
-		#pragma omp parallel for
-		for(int n = 0; n < basisSize; n++){
-			double energy = 0.;
-			for(int c = 0; c < basisSize; c++){
-				energy += real(conj(eigenVectorsMap[n][c])*dPsi[basisSize*n + c]);
+			#pragma omp parallel for
+			for(int n = 0; n < basisSize; n++){
+				if(
+					propagateOccupiedStatesOnly
+					&& occupancy[n] == 0
+				){
+					continue;
+				}
+
+				double energy = 0.;
+				for(int c = 0; c < basisSize; c++){
+					energy += real(conj(eigenVectorsMap[n][c])*dPsi[basisSize*n + c]);
+				}
+				eigenValues[n] = energy;
 			}
-			eigenValues[n] = energy;
-		}
 
-		#pragma omp parallel for
-		for(int n = 0; n < basisSize; n++){
-			for(int c = 0; c < basisSize; c++)
-				eigenVectorsMap[n][c] -= i*dPsi[basisSize*n + c]*UnitHandler::convertTimeNtB(dt)/UnitHandler::getHbarB();
+			#pragma omp parallel for
+			for(int n = 0; n < basisSize; n++){
+				if(
+					propagateOccupiedStatesOnly
+					&& occupancy[n] == 0
+				){
+					continue;
+				}
+
+				for(int c = 0; c < basisSize; c++)
+					eigenVectorsMap[n][c] -= i*dPsi[basisSize*n + c]*UnitHandler::convertTimeNtB(dt)/UnitHandler::getHbarB();
+			}
+		}
+		else{
+			propagate(hamiltonian);
 		}
 
 		sort();
 
 		updateOccupancy();
 
-		#pragma omp parallel for
-		for(int n = 0; n < basisSize; n++){
-			//No need to use eigenVectorsMap here because
-			//noramlization procedure is independent of ordering.
-			double normalizationFactor = 0.;
-			for(int c = 0; c < basisSize; c++){
-				normalizationFactor += pow(abs(eigenVectors[n*basisSize + c]), 2);
+		//The other propagators are norm preserving.
+		if(propagator == Propagator::Euler){
+			#pragma omp parallel for
+			for(int n = 0; n < basisSize; n++){
+				//No need to use eigenVectorsMap here because
+				//noramlization procedure is independent of ordering.
+				double normalizationFactor = 0.;
+				for(int c = 0; c < basisSize; c++){
+					normalizationFactor += pow(abs(eigenVectors[n*basisSize + c]), 2);
+				}
+				normalizationFactor = sqrt(normalizationFactor);
+				for(int c = 0; c < basisSize; c++)
+					eigenVectors[basisSize*n + c] /= normalizationFactor;
 			}
-			normalizationFactor = sqrt(normalizationFactor);
-			for(int c = 0; c < basisSize; c++)
-				eigenVectors[basisSize*n + c] /= normalizationFactor;
 		}
 
 		if(orthogonalityCheckInterval != 0 && t%orthogonalityCheckInterval == 0)
 			calculateOrthogonalityError();
 	}
+
+	if(dPsi != NULL)
+		delete [] dPsi;
 }
 
 bool TimeEvolver::selfConsistencyCallback(Diagonalizer &dSolver){
@@ -208,23 +269,34 @@ void TimeEvolver::onDiagonalizationFinished(){
 void TimeEvolver::sort(){
 	int basisSize = getModel().getBasisSize();
 
-	for(int m = 0; m < basisSize; m++){
-		for(int n = m+1; n < basisSize; n++){
-			if(eigenValues[n] < eigenValues[m]){
-				double tempEigenValue = eigenValues[n];
-				complex<double> *tempEigenVectorsMap = eigenVectorsMap[n];
-				double tempOccupancy = occupancy[n];
-
-				eigenValues[n] = eigenValues[m];
-				eigenVectorsMap[n] = eigenVectorsMap[m];
-				occupancy[n] = occupancy[m];
-
-				eigenValues[m] = tempEigenValue;
-				eigenVectorsMap[m] = tempEigenVectorsMap;
-				occupancy[m] = tempOccupancy;
-			}
+	//Only the states that are time evolved have up to date energies. If
+	//only occupied states are time evolved, these are sorted among the
+	//positions they already occupy, while the other states are left in
+	//place.
+	vector<unsigned int> states;
+	vector<double> energies;
+	for(int n = 0; n < basisSize; n++){
+		if(!propagateOccupiedStatesOnly || occupancy[n] != 0){
+			states.push_back(n);
+			energies.push_back(eigenValues[n]);
 		}
 	}
+	vector<unsigned int> statePermutation
+		= EigenPairSorter::getPermutation(
+			energies.data(),
+			energies.size()
+		);
+	vector<unsigned int> permutation(basisSize);
+	for(int n = 0; n < basisSize; n++)
+		permutation[n] = n;
+	for(unsigned int n = 0; n < states.size(); n++)
+		permutation[states[n]] = states[statePermutation[n]];
+
+	//Only the pointers in eigenVectorsMap are permuted, the eigenvectors
+	//themselves stay in place.
+	EigenPairSorter::permute(eigenValues, permutation);
+	EigenPairSorter::permute(eigenVectorsMap, permutation);
+	EigenPairSorter::permute(occupancy, permutation);
 }
 
 void TimeEvolver::updateOccupancy(){
@@ -323,5 +395,513 @@ void TimeEvolver::calculateOrthogonalityError(){
 		orthogonalityError = maxOverlap;
 }
 
+void TimeEvolver::propagate(
+	const SparseMatrix<complex<double>> &hamiltonian
+){
+	int basisSize = getModel().getBasisSize();
+	double time = UnitHandler::convertTimeNtB(dt)/UnitHandler::getHbarB();
+
+	vector<unsigned int> states;
+	for(int n = 0; n < basisSize; n++)
+		if(!propagateOccupiedStatesOnly || occupancy[n] != 0)
+			states.push_back(n);
+	unsigned int numStates = states.size();
+
+	switch(propagator){
+	case Propagator::CrankNicolson:
+	case Propagator::Chebyshev:
+	{
+		//Collect the states into a block with the state index running
+		//fastest, which allows each matrix element to be applied to
+		//all states at once.
+		vector<complex<double>> block((size_t)basisSize*numStates);
+		#pragma omp parallel for
+		for(int row = 0; row < basisSize; row++){
+			for(unsigned int n = 0; n < numStates; n++){
+				block[(size_t)row*numStates + n]
+					= eigenVectorsMap[states[n]][row];
+			}
+		}
+
+		if(propagator == Propagator::CrankNicolson){
+			propagateCrankNicolson(
+				hamiltonian,
+				block.data(),
+				numStates,
+				time
+			);
+		}
+		else{
+			propagateChebyshev(
+				hamiltonian,
+				block.data(),
+				numStates,
+				time
+			);
+		}
+
+		#pragma omp parallel for
+		for(int row = 0; row < basisSize; row++){
+			for(unsigned int n = 0; n < numStates; n++){
+				eigenVectorsMap[states[n]][row]
+					= block[(size_t)row*numStates + n];
+			}
+		}
+		break;
+	}
+	case Propagator::Lanczos:
+		#pragma omp parallel for schedule(dynamic)
+		for(unsigned int n = 0; n < numStates; n++){
+			propagateLanczos(
+				hamiltonian,
+				eigenVectorsMap[states[n]],
+				time
+			);
+		}
+		break;
+	default:
+		TBTKExit(
+			"TimeEvolver::propagate()",
+			"Unknown Propagator.",
+			"This should never happen, contact the developer."
+		);
+	}
+
+	#pragma omp parallel
+	{
+		vector<complex<double>> hPsi(basisSize);
+		#pragma omp for
+		for(unsigned int n = 0; n < numStates; n++){
+			const complex<double> *psi = eigenVectorsMap[states[n]];
+			multiply(hamiltonian, psi, hPsi.data(), 1);
+
+			double energy = 0.;
+			for(int c = 0; c < basisSize; c++)
+				energy += real(conj(psi[c])*hPsi[c]);
+			eigenValues[states[n]] = energy;
+		}
+	}
+}
+
+void TimeEvolver::propagateCrankNicolson(
+	const SparseMatrix<complex<double>> &hamiltonian,
+	complex<double> *states,
+	unsigned int numStates,
+	double time
+) const{
+	unsigned int basisSize = hamiltonian.getNumRows();
+	unsigned int size = basisSize*numStates;
+
+	//Calculates y = (1 + sign*i*H*time/2)*v.
+	auto apply = [&](const complex<double> *v, complex<double> *y, double sign){
+		multiply(hamiltonian, v, y, numStates);
+		complex<double> factor(0, sign*time/2.);
+		#pragma omp parallel for
+		for(unsigned int n = 0; n < size; n++)
+			y[n] = v[n] + factor*y[n];
+	};
+
+	//Calculates the squared norm of each state in a block.
+	auto calculateNorms = [&](const complex<double> *v, vector<double> &norms){
+		norms.assign(numStates, 0.);
+		for(unsigned int row = 0; row < basisSize; row++)
+			for(unsigned int n = 0; n < numStates; n++)
+				norms[n] += norm(v[row*numStates + n]);
+	};
+
+	//Solve A*x = b, where A = 1 + iHt/2 and b = (1 - iHt/2)*Psi, using
+	//the conjugate gradient method on the normal equations
+	//A^{\dagger}A*x = A^{\dagger}b. The second order accurate
+	//(1 - iHt)*Psi = 2b - Psi is used as initial guess.
+	vector<complex<double>> b(size), x(size), r(size), s(size), p(size);
+	vector<complex<double>> q(size);
+	apply(states, b.data(), -1);
+	for(unsigned int n = 0; n < size; n++)
+		x[n] = 2.*b[n] - states[n];
+	apply(x.data(), q.data(), 1);
+	for(unsigned int n = 0; n < size; n++)
+		r[n] = b[n] - q[n];
+	apply(r.data(), s.data(), -1);
+	p = s;
+
+	vector<double> bNorms, rNorms, gammas, newGammas, qNorms;
+	calculateNorms(b.data(), bNorms);
+	calculateNorms(r.data(), rNorms);
+	calculateNorms(s.data(), gammas);
+	vector<bool> hasConverged(numStates);
+	double tolerance2 = propagationTolerance*propagationTolerance;
+	for(unsigned int iteration = 0; iteration < basisSize + 100; iteration++){
+		bool allHaveConverged = true;
+		for(unsigned int n = 0; n < numStates; n++){
+			hasConverged[n] = rNorms[n] <= tolerance2*bNorms[n];
+			if(!hasConverged[n])
+				allHaveConverged = false;
+		}
+		if(allHaveConverged)
+			break;
+
+		apply(p.data(), q.data(), 1);
+		calculateNorms(q.data(), qNorms);
+		vector<double> a(numStates, 0.);
+		for(unsigned int n = 0; n < numStates; n++)
+			if(!hasConverged[n])
+				a[n] = gammas[n]/qNorms[n];
+
+		for(unsigned int row = 0; row < basisSize; row++){
+			for(unsigned int n = 0; n < numStates; n++){
+				x[row*numStates + n] += a[n]*p[row*numStates + n];
+				r[row*numStates + n] -= a[n]*q[row*numStates + n];
+			}
+		}
+		apply(r.data(), s.data(), -1);
+		calculateNorms(r.data(), rNorms);
+		calculateNorms(s.data(), newGammas);
+
+		for(unsigned int n = 0; n < numStates; n++){
+			if(hasConverged[n])
+				continue;
+
+			double beta = newGammas[n]/gammas[n];
+			for(unsigned int row = 0; row < basisSize; row++){
+				p[row*numStates + n] = s[row*numStates + n]
+					+ beta*p[row*numStates + n];
+			}
+			gammas[n] = newGammas[n];
+		}
+	}
+
+	for(unsigned int n = 0; n < size; n++)
+		states[n] = x[n];
+}
+
+//Calculates the Bessel functions J_k(x) for k = 0, 1, ..., K, where K is the
+//smallest order larger than x for which |J_K(x)| is smaller than the
+//tolerance. Uses Miller's backward recurrence, which is stable for k > x.
+static vector<double> calculateBesselFunctions(double x, double tolerance){
+	if(x == 0)
+		return vector<double>(1, 1.);
+
+	unsigned int startOrder = 2*(unsigned int)((1.5*x + 12*cbrt(x) + 60)/2);
+	vector<double> besselFunctions(startOrder + 2, 0.);
+	besselFunctions[startOrder] = 1e-30;
+	for(unsigned int k = startOrder; k > 0; k--){
+		besselFunctions[k-1] = 2*k/x*besselFunctions[k]
+			- besselFunctions[k+1];
+
+		//Rescale to avoid overflow.
+		if(abs(besselFunctions[k-1]) > 1e250){
+			for(unsigned int l = k-1; l < besselFunctions.size(); l++)
+				besselFunctions[l] *= 1e-250;
+		}
+	}
+
+	//Normalize using 1 = J_0(x) + 2*sum_{k > 0} J_{2k}(x).
+	double normalization = besselFunctions[0];
+	for(unsigned int k = 2; k <= startOrder; k += 2)
+		normalization += 2*besselFunctions[k];
+	for(unsigned int k = 0; k < besselFunctions.size(); k++)
+		besselFunctions[k] /= normalization;
+
+	unsigned int numCoefficients = 2;
+	while(
+		numCoefficients < startOrder
+		&& (
+			numCoefficients <= x
+			|| abs(besselFunctions[numCoefficients-1]) >= tolerance
+		)
+	){
+		numCoefficients++;
+	}
+	besselFunctions.resize(numCoefficients);
+
+	return besselFunctions;
+}
+
+void TimeEvolver::propagateChebyshev(
+	const SparseMatrix<complex<double>> &hamiltonian,
+	complex<double> *states,
+	unsigned int numStates,
+	double time
+) const{
+	unsigned int basisSize = hamiltonian.getNumRows();
+	unsigned int size = basisSize*numStates;
+	const unsigned int *rowPointers = hamiltonian.getCSRRowPointers();
+	const unsigned int *columns = hamiltonian.getCSRColumns();
+	const complex<double> *values = hamiltonian.getCSRValues();
+
+	//Bound the spectrum using Gershgorin's circle theorem.
+	double lowerBound = numeric_limits<double>::max();
+	double upperBound = -numeric_limits<double>::max();
+	for(unsigned int row = 0; row < basisSize; row++){
+		double center = 0.;
+		double radius = 0.;
+		for(unsigned int c = rowPointers[row]; c < rowPointers[row+1]; c++){
+			if(columns[c] == row)
+				center += real(values[c]);
+			else
+				radius += abs(values[c]);
+		}
+		lowerBound = min(lowerBound, center - radius);
+		upperBound = max(upperBound, center + radius);
+	}
+	double center = (upperBound + lowerBound)/2.;
+	double halfWidth = (upperBound - lowerBound)/2.;
+	complex<double> phase = exp(-i*center*time);
+	if(halfWidth == 0){
+		for(unsigned int n = 0; n < size; n++)
+			states[n] *= phase;
+
+		return;
+	}
+
+	//exp(-iHt) = exp(-i*center*t)*sum_k (2 - delta_{k0})(-i)^k
+	//J_k(halfWidth*t)T_k((H - center)/halfWidth).
+	vector<double> besselFunctions = calculateBesselFunctions(
+		abs(halfWidth*time),
+		propagationTolerance
+	);
+	double sign = (time < 0) ? -1 : 1;
+
+	vector<complex<double>> previous(states, states + size);
+	vector<complex<double>> current(size);
+	vector<complex<double>> next(size);
+	vector<complex<double>> result(size);
+	for(unsigned int n = 0; n < size; n++)
+		result[n] = besselFunctions[0]*previous[n];
+
+	complex<double> coefficientPhase = 1.;
+	for(unsigned int k = 1; k < besselFunctions.size(); k++){
+		if(k == 1){
+			multiply(
+				hamiltonian,
+				previous.data(),
+				current.data(),
+				numStates,
+				center,
+				1/halfWidth
+			);
+		}
+		else{
+			multiply(
+				hamiltonian,
+				current.data(),
+				next.data(),
+				numStates,
+				center,
+				2/halfWidth
+			);
+			for(unsigned int n = 0; n < size; n++)
+				next[n] -= previous[n];
+			previous.swap(current);
+			current.swap(next);
+		}
+
+		coefficientPhase *= -i*sign;
+		complex<double> coefficient
+			= 2.*coefficientPhase*besselFunctions[k];
+		for(unsigned int n = 0; n < size; n++)
+			result[n] += coefficient*current[n];
+	}
+
+	for(unsigned int n = 0; n < size; n++)
+		states[n] = phase*result[n];
+}
+
+//Lapack function for diagonalization of a symmetric tridiagonal matrix.
+extern "C" void dstev_(
+	char *jobz,	//'N' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+	int *n,		//Matrix size
+	double *d,	//Diagonal elements. Contains the eigenvalues on exit.
+	double *e,	//Off-diagonal elements. Destroyed on exit.
+	double *z,	//Eigenvectors
+	int *ldz,	//Leading dimension of z
+	double *work,	//Workspace, dimension = max(1, 2*n-2)
+	int *info	//0 = successful, <0 = -info value was illegal, >0 = failed to converge.
+);
+
+//Calculates exp(-iTt)e_0 for the symmetric tridiagonal matrix T with the
+//given diagonal and off-diagonal elements.
+static vector<complex<double>> calculateTridiagonalExponential(
+	const vector<double> &diagonal,
+	const vector<double> &offDiagonal,
+	double time
+){
+	int n = diagonal.size();
+	vector<double> d(diagonal);
+	vector<double> e(offDiagonal.begin(), offDiagonal.begin() + (n-1));
+	e.push_back(0.);
+	vector<double> z(n*n);
+	vector<double> work(max(1, 2*n-2));
+	char jobz = 'V';
+	int info;
+	dstev_(&jobz, &n, d.data(), e.data(), z.data(), &n, work.data(), &info);
+	TBTKAssert(
+		info == 0,
+		"TimeEvolver::propagateLanczos()",
+		"Diagonalization of the Krylov space Hamiltonian failed with"
+		<< " error code " << info << ".",
+		""
+	);
+
+	vector<complex<double>> result(n, 0.);
+	for(int k = 0; k < n; k++){
+		complex<double> factor = exp(-i*d[k]*time)*z[n*k];
+		for(int l = 0; l < n; l++)
+			result[l] += z[n*k + l]*factor;
+	}
+
+	return result;
+}
+
+void TimeEvolver::propagateLanczos(
+	const SparseMatrix<complex<double>> &hamiltonian,
+	complex<double> *state,
+	double time
+) const{
+	unsigned int basisSize = hamiltonian.getNumRows();
+
+	vector<vector<complex<double>>> krylovBasis;
+	vector<double> diagonal;
+	vector<double> offDiagonal;
+	vector<complex<double>> w(basisSize);
+	vector<complex<double>> coefficients;
+
+	//The time step is split into substeps when the Krylov space is too
+	//small to reach the tolerance.
+	double remainingFraction = 1.;
+	double fraction = 1.;
+	while(remainingFraction > 0){
+		fraction = min(fraction, remainingFraction);
+
+		double stateNorm = 0.;
+		for(unsigned int n = 0; n < basisSize; n++)
+			stateNorm += norm(state[n]);
+		stateNorm = sqrt(stateNorm);
+		if(stateNorm == 0)
+			return;
+
+		krylovBasis.assign(1, vector<complex<double>>(basisSize));
+		for(unsigned int n = 0; n < basisSize; n++)
+			krylovBasis[0][n] = state[n]/stateNorm;
+		diagonal.clear();
+		offDiagonal.clear();
+
+		double residual = 0.;
+		bool hasConverged = false;
+		for(unsigned int j = 0; j < maxKrylovDimension; j++){
+			multiply(hamiltonian, krylovBasis[j].data(), w.data(), 1);
+
+			//Full reorthogonalization.
+			for(unsigned int k = 0; k <= j; k++){
+				complex<double> overlap = 0.;
+				for(unsigned int n = 0; n < basisSize; n++)
+					overlap += conj(krylovBasis[k][n])*w[n];
+				for(unsigned int n = 0; n < basisSize; n++)
+					w[n] -= overlap*krylovBasis[k][n];
+				if(k == j)
+					diagonal.push_back(real(overlap));
+			}
+
+			residual = 0.;
+			for(unsigned int n = 0; n < basisSize; n++)
+				residual += norm(w[n]);
+			residual = sqrt(residual);
+
+			coefficients = calculateTridiagonalExponential(
+				diagonal,
+				offDiagonal,
+				fraction*time
+			);
+			if(residual*abs(coefficients[j]) < propagationTolerance){
+				hasConverged = true;
+				break;
+			}
+			if(j + 1 == maxKrylovDimension)
+				break;
+
+			offDiagonal.push_back(residual);
+			krylovBasis.push_back(vector<complex<double>>(basisSize));
+			for(unsigned int n = 0; n < basisSize; n++)
+				krylovBasis[j+1][n] = w[n]/residual;
+		}
+
+		while(!hasConverged){
+			fraction /= 2;
+			coefficients = calculateTridiagonalExponential(
+				diagonal,
+				offDiagonal,
+				fraction*time
+			);
+			if(
+				residual*abs(coefficients.back())
+				< propagationTolerance
+			){
+				hasConverged = true;
+			}
+		}
+
+		for(unsigned int n = 0; n < basisSize; n++)
+			state[n] = 0.;
+		for(unsigned int k = 0; k < coefficients.size(); k++){
+			complex<double> coefficient = stateNorm*coefficients[k];
+			for(unsigned int n = 0; n < basisSize; n++)
+				state[n] += coefficient*krylovBasis[k][n];
+		}
+
+		remainingFraction -= fraction;
+	}
+}
+
+void TimeEvolver::multiply(
+	const SparseMatrix<complex<double>> &hamiltonian,
+	const complex<double> *in,
+	complex<double> *out,
+	unsigned int numStates,
+	double shift,
+	double multiplier
+){
+	int basisSize = hamiltonian.getNumRows();
+	const unsigned int *rowPointers = hamiltonian.getCSRRowPointers();
+	const unsigned int *columns = hamiltonian.getCSRColumns();
+	const complex<double> *values = hamiltonian.getCSRValues();
+
+	//Since the state index runs fastest, each matrix element multiplies
+	//a contiguous segment of the input block. The real and imaginary
+	//parts are treated separately to allow for vectorization.
+	#pragma omp parallel for schedule(static)
+	for(int row = 0; row < basisSize; row++){
+		double *result = reinterpret_cast<double*>(
+			&out[(size_t)row*numStates]
+		);
+		const double *diagonal = reinterpret_cast<const double*>(
+			&in[(size_t)row*numStates]
+		);
+		for(unsigned int n = 0; n < 2*numStates; n++)
+			result[n] = -shift*diagonal[n];
+
+		for(
+			unsigned int c = rowPointers[row];
+			c < rowPointers[row+1];
+			c++
+		){
+			double valueReal = values[c].real();
+			double valueImaginary = values[c].imag();
+			const double *element = reinterpret_cast<const double*>(
+				&in[(size_t)columns[c]*numStates]
+			);
+			#pragma omp simd
+			for(unsigned int n = 0; n < numStates; n++){
+				result[2*n] += valueReal*element[2*n]
+					- valueImaginary*element[2*n+1];
+				result[2*n+1] += valueReal*element[2*n+1]
+					+ valueImaginary*element[2*n];
+			}
+		}
+
+		for(unsigned int n = 0; n < 2*numStates; n++)
+			result[n] *= multiplier;
+	}
+}
+
 };	//End of namespace Solver
 };	//End of namespace TBTK
@@ -20,8 +20,11 @@
 
 #include "TBTK/Functions.h"
 #include "TBTK/RPA/LindhardSusceptibilityCalculator.h"
+#include "TBTK/Streams.h"
+#include "TBTK/Timer.h"
 #include "TBTK/UnitHandler.h"
 
+#include <algorithm>
 #include <complex>
 #include <iomanip>
 
@@ -78,170 +81,185 @@ LindhardSusceptibilityCalculator* LindhardSusceptibilityCalculator::createSlave(
 	);
 }
 
-void LindhardSusceptibilityCalculator::precompute(unsigned int numWorkers){
-	TBTKNotYetImplemented("LindhardSusceptibilityCalculator::precompute()");
-/*	Timer::tick("1");
+void LindhardSusceptibilityCalculator::precompute(){
 	const MomentumSpaceContext &momentumSpaceContext = getMomentumSpaceContext();
 	const vector<vector<double>> &mesh = momentumSpaceContext.getMesh();
 	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+	size_t blockSize = (size_t)numOrbitals*numOrbitals*numOrbitals
+		*numOrbitals*getEnergies().size();
+	bool verbose = getGlobalVerbose() && getVerbose();
+
+	if(verbose){
+		Streams::out << "LindhardSusceptibilityCalculator::precompute\n";
+		Streams::out << "\tNumber of k-points: " << mesh.size() << "\n";
+		Streams::out << "\tNumber of energies: "
+			<< getEnergies().size() << "\n";
+		Timer::tick("Allocation");
+	}
 
-	vector<SusceptibilityCalculator*> susceptibilityCalculators;
-	for(unsigned int n = 0; n < numWorkers; n++){
-		susceptibilityCalculators.push_back(
-			new LindhardSusceptibilityCalculator(
-				momentumSpaceContext
-			)
-//			this->createSlave()
-		);
-		susceptibilityCalculators[n]->setEnergies(
-			getEnergies()
-		);
-		susceptibilityCalculators[n]->setEnergyType(
-			getEnergyType()
-		);
-		susceptibilityCalculators[n]->setEnergiesAreInversionSymmetric(
-			getEnergiesAreInversionSymmetric()
+	//Allocate the store. Every k-point has its own block, which allows
+	//the threads to write their results without synchronization.
+	precomputedEnergies.clear();
+	precomputedRealSusceptibilities.clear();
+	precomputedImaginarySusceptibilities.clear();
+	precomputedRealSusceptibilities.resize(blockSize*mesh.size());
+	precomputedImaginarySusceptibilities.resize(blockSize*mesh.size());
+
+	if(verbose){
+		Timer::tock();
+		Timer::tick("Calculation");
+		Streams::out << "\tProgress (" << max(1, (int)mesh.size()/50)
+			<< " k-points per dot): " << flush;
+	}
+
+	//The time required for different k-points can differ significantly
+	//since the number of poles differ. The k-points are therefore handed
+	//out one at a time to whichever thread is free. The blocks in the
+	//store are ordered in the same way as the blocks in the Model.
+	const Model &model = momentumSpaceContext.getModel();
+	unsigned int numCompleted = 0;
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(unsigned int n = 0; n < mesh.size(); n++){
+		DualIndex kDual(momentumSpaceContext.getKIndex(mesh[n]), mesh[n]);
+		unsigned int meshPoint = model.getHoppingAmplitudeSet(
+		)->getFirstIndexInBlock(kDual)/numOrbitals;
+
+		calculateSusceptibilities(
+			kDual,
+			&precomputedRealSusceptibilities[blockSize*meshPoint],
+			&precomputedImaginarySusceptibilities[
+				blockSize*meshPoint
+			]
 		);
 
-		delete [] susceptibilityCalculators[n]->kPlusQLookupTable;
-		susceptibilityCalculators[n]->kPlusQLookupTable = kPlusQLookupTable;
-		delete [] susceptibilityCalculators[n]->fermiDiracLookupTable;
-		susceptibilityCalculators[n]->fermiDiracLookupTable = fermiDiracLookupTable;
-		susceptibilityCalculators[n]->isMaster = false;
+		if(verbose){
+			unsigned int completed;
+			#pragma omp atomic capture
+			completed = ++numCompleted;
+			if(completed%max(1, (int)mesh.size()/50) == 0){
+				#pragma omp critical (TBTK_LindhardSusceptibilityCalculator_precompute)
+				Streams::out << "." << flush;
+			}
+		}
 	}
 
-	vector<vector<vector<double>>> meshes;
-	unsigned int meshSegmentSize = mesh.size()/(numWorkers-1);
-	for(unsigned int n = 0; n < numWorkers-1; n++){
-		meshes.push_back(vector<vector<double>>());
-		for(
-			unsigned int c = n*meshSegmentSize;
-			c < (n+1)*meshSegmentSize;
-			c++
-		){
-			meshes[n].push_back(mesh.at(c));
-		}
+	precomputedEnergies = getEnergies();
+
+	if(verbose){
+		Streams::out << "\n";
+		Timer::tock();
 	}
-	meshes.push_back(vector<vector<double>>());
-	for(
-		unsigned int n = (numWorkers-1)*meshSegmentSize;
-		n < mesh.size();
-		n++
+}
+
+bool LindhardSusceptibilityCalculator::getPrecomputedSusceptibility(
+	const DualIndex &kDual,
+	const vector<int> &orbitalIndices,
+	vector<complex<double>> &result
+) const{
+	if(
+		precomputedRealSusceptibilities.size() == 0
+		|| precomputedEnergies != getEnergies()
 	){
-		meshes.back().push_back(mesh.at(n));
+		return false;
 	}
-	Timer::tock();
-
-	Timer::tick("2");
-	#pragma omp parallel for
-	for(unsigned int n = 0; n < numWorkers; n++){
-		SusceptibilityCalculator &susceptibilityCalculator = *susceptibilityCalculators.at(n);
-		const vector<vector<double>> &mesh = meshes.at(n);
 
-		for(unsigned int c = 0; c < mesh.size(); c++){
-			for(
-				unsigned int orbital0 = 0;
-				orbital0 < numOrbitals;
-				orbital0++
-			){
-				for(
-					unsigned int orbital1 = 0;
-					orbital1 < numOrbitals;
-					orbital1++
-				){
-					for(
-						unsigned int orbital2 = 0;
-						orbital2 < numOrbitals;
-						orbital2++
-					){
-						for(
-							unsigned int orbital3 = 0;
-							orbital3 < numOrbitals;
-							orbital3++
-						){
-							susceptibilityCalculator.calculateSusceptibility(
-								mesh[c],
-								{
-									(int)orbital0,
-									(int)orbital1,
-									(int)orbital2,
-									(int)orbital3
-								}
-							);
-						}
-					}
-				}
-			}
+	const MomentumSpaceContext &momentumSpaceContext = getMomentumSpaceContext();
+	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+	unsigned int numEnergies = precomputedEnergies.size();
+	size_t blockSize = (size_t)numOrbitals*numOrbitals*numOrbitals
+		*numOrbitals*numEnergies;
+
+	for(unsigned int n = 0; n < orbitalIndices.size(); n++){
+		if(
+			orbitalIndices[n] < 0
+			|| orbitalIndices[n] >= (int)numOrbitals
+		){
+			return false;
 		}
 	}
-	Timer::tock();
 
-	Timer::tick("3");
-//	Streams::out << "Susceptibility tree size:\t" << susceptibilityTree.getSizeInBytes() << "\n";
-	for(unsigned int n = 0; n < numWorkers; n++){
-		SusceptibilityCalculator &susceptibilityCalculator = *susceptibilityCalculators.at(n);
-		const vector<vector<double>> &mesh = meshes.at(n);
+	int linearIndex = momentumSpaceContext.getModel(
+	).getHoppingAmplitudeSet()->getFirstIndexInBlock(kDual);
+	if(linearIndex < 0)
+		return false;
+
+	size_t offset = blockSize*(linearIndex/numOrbitals)
+		+ (size_t)numEnergies*(
+			numOrbitals*(
+				numOrbitals*(
+					numOrbitals*orbitalIndices[3]
+					+ orbitalIndices[0]
+				) + orbitalIndices[1]
+			) + orbitalIndices[2]
+		);
+	result.resize(numEnergies);
+	for(unsigned int e = 0; e < numEnergies; e++){
+		result[e] = complex<double>(
+			precomputedRealSusceptibilities[offset + e],
+			precomputedImaginarySusceptibilities[offset + e]
+		);
+	}
 
-		for(unsigned int c = 0; c < mesh.size(); c++){
-			Index kIndex = momentumSpaceContext.getKIndex(
-				mesh[c]
-			);
+	return true;
+}
 
-			for(
-				unsigned int orbital0 = 0;
-				orbital0 < numOrbitals;
-				orbital0++
-			){
-				for(
-					unsigned int orbital1 = 0;
-					orbital1 < numOrbitals;
-					orbital1++
-				){
-					for(
-						unsigned int orbital2 = 0;
-						orbital2 < numOrbitals;
-						orbital2++
-					){
-						for(
-							unsigned int orbital3 = 0;
-							orbital3 < numOrbitals;
-							orbital3++
-						){
-							SerializableVector<complex<double>> result;
-							Index resultIndex = Index(
-								kIndex,
-								{
-									(int)orbital0,
-									(int)orbital1,
-									(int)orbital2,
-									(int)orbital3
-								}
-							);
-							TBTKAssert(
-								susceptibilityCalculator.susceptibilityTree.get(
-									result,
-									resultIndex
-								),
-								"SusceptibilityCalculator::precompute()",
-								"Unable to find requested susceptibility.",
-								"This should never happen, contact the developer."
-							);
-							susceptibilityTree.add(
-								result,
-								resultIndex
-							);
-						}
-					}
-				}
-			}
+void LindhardSusceptibilityCalculator::addPrecomputedSusceptibilities(
+	IndexedDataTree<SerializableVector<complex<double>>> &tree
+) const{
+	if(
+		precomputedRealSusceptibilities.size() == 0
+		|| precomputedEnergies != getEnergies()
+	){
+		return;
+	}
+
+	const MomentumSpaceContext &momentumSpaceContext = getMomentumSpaceContext();
+	const vector<vector<double>> &mesh = momentumSpaceContext.getMesh();
+	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+	unsigned int numOrbitalPairs = numOrbitals*numOrbitals;
+	for(unsigned int n = 0; n < mesh.size(); n++){
+		DualIndex kDual(momentumSpaceContext.getKIndex(mesh[n]), mesh[n]);
+		for(
+			unsigned int c = 0;
+			c < numOrbitalPairs*numOrbitalPairs;
+			c++
+		){
+			vector<int> orbitalIndices = {
+				(int)(c/(numOrbitalPairs*numOrbitals)),
+				(int)((c/numOrbitalPairs)%numOrbitals),
+				(int)((c/numOrbitals)%numOrbitals),
+				(int)(c%numOrbitals)
+			};
+			vector<complex<double>> result;
+			getPrecomputedSusceptibility(kDual, orbitalIndices, result);
+			tree.add(
+				result,
+				getSusceptibilityResultIndex(kDual, orbitalIndices)
+			);
 		}
 	}
+}
 
-	for(unsigned int n = 0; n < susceptibilityCalculators.size(); n++)
-		delete susceptibilityCalculators[n];
+void LindhardSusceptibilityCalculator::saveSusceptibilities(
+	const string &filename
+) const{
+	IndexedDataTree<SerializableVector<complex<double>>> tree
+		= getSusceptibilityTree();
+	addPrecomputedSusceptibilities(tree);
 
-	Streams::out << "Susceptibility tree size:\t" << susceptibilityTree.getSizeInBytes() << "\n";
-	Timer::tock();*/
+	Resource resource;
+	resource.setData(tree.serialize(Serializable::Mode::JSON));
+	resource.write(filename);
+}
+
+void LindhardSusceptibilityCalculator::loadSusceptibilities(
+	const string &filename
+){
+	SusceptibilityCalculator::loadSusceptibilities(filename);
+
+	precomputedEnergies.clear();
+	precomputedRealSusceptibilities.clear();
+	precomputedImaginarySusceptibilities.clear();
 }
 
 inline complex<double> LindhardSusceptibilityCalculator::getPoleTimesTwoFermi(
@@ -390,48 +408,34 @@ inline int SusceptibilityCalculator::getKPlusQLinearIndex<true>(
 }*/
 
 template<bool useKPlusQLookupTable, bool isSafeFromPoles>
-vector<complex<double>> LindhardSusceptibilityCalculator::calculateSusceptibilityLindhard(
+void LindhardSusceptibilityCalculator::calculateSusceptibilityLindhard(
 	const DualIndex &kDual,
-	const vector<int> &orbitalIndices
-){
-	//Get kIndex and resultIndex
-//	const vector<double> &k = kDual.getContinuousIndex();
+	double *realResult,
+	double *imaginaryResult
+) const{
+	//Get kIndex
 	const vector<double> &k = kDual;
 	const Index &kIndex = kDual;
-	Index resultIndex = getSusceptibilityResultIndex(
-		kIndex,
-		orbitalIndices
-	);
-
-	//Try to return cashed result
-	SerializableVector<complex<double>> result;
-	if(getSusceptibilityTree().get(result, resultIndex))
-		return result;
 
 	const MomentumSpaceContext &momentumSpaceContext = getMomentumSpaceContext();
 	const vector<vector<double>> &mesh = momentumSpaceContext.getMesh();
 	const Model &model = momentumSpaceContext.getModel();
 	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+	unsigned int numOrbitalPairs = numOrbitals*numOrbitals;
 
-	//Initialize result and isolate purely real energies. The real energies
-	//need extra careful treatment because they can result in evaluation of
-	// a term at a pole.
-	vector<complex<double>> realEnergies;
-	vector<complex<double>> complexEnergies;
-	vector<unsigned int> realEnergyIndices;
-	vector<unsigned int> complexEnergyIndices;
+	//Split the energies into real and imaginary parts and isolate purely
+	//real energies. The real energies need extra careful treatment
+	//because they can result in evaluation of a term at a pole.
 	const vector<complex<double>> &energies = getEnergies();
-	for(unsigned int n = 0; n < energies.size(); n++){
-		result.push_back(0);
-		complex<double> energy = energies.at(n);
-		if(abs(imag(energy)) < 1e-10){
-			realEnergies.push_back(energy);
-			realEnergyIndices.push_back(n);
-		}
-		else{
-			complexEnergies.push_back(energy);
-			complexEnergyIndices.push_back(n);
-		}
+	unsigned int numEnergies = energies.size();
+	vector<double> realEnergies(numEnergies);
+	vector<double> imaginaryEnergies(numEnergies);
+	vector<unsigned int> realEnergyIndices;
+	for(unsigned int e = 0; e < numEnergies; e++){
+		realEnergies[e] = real(energies[e]);
+		imaginaryEnergies[e] = imag(energies[e]);
+		if(!isSafeFromPoles && abs(imag(energies[e])) < 1e-10)
+			realEnergyIndices.push_back(e);
 	}
 
 	//Get linear index corresponding to kIndex.
@@ -439,6 +443,22 @@ vector<complex<double>> LindhardSusceptibilityCalculator::calculateSusceptibilit
 		kIndex
 	);
 
+	//Initialize result.
+	unsigned int blockSize = numOrbitalPairs*numEnergies;
+	size_t resultSize = (size_t)numOrbitalPairs*blockSize;
+	fill_n(realResult, resultSize, 0.);
+	fill_n(imaginaryResult, resultSize, 0.);
+
+	//Workspaces for the amplitude products at k and k+q, the pole matrix,
+	//and the pole matrix contracted with the amplitude products at k+q.
+	vector<complex<double>> amplitudeProducts1(numOrbitals*numOrbitalPairs);
+	vector<complex<double>> amplitudeProducts2(numOrbitals*numOrbitalPairs);
+	vector<double> realPoles(numOrbitalPairs*numEnergies);
+	vector<double> imaginaryPoles(numOrbitalPairs*numEnergies);
+	vector<bool> poleIsZero(numOrbitalPairs);
+	vector<double> realContraction(numOrbitals*blockSize);
+	vector<double> imaginaryContraction(numOrbitals*blockSize);
+
 	//Main loop
 	for(unsigned int meshPoint = 0; meshPoint < mesh.size(); meshPoint++){
 		//Get linear index corresponding to k+q
@@ -447,141 +467,322 @@ vector<complex<double>> LindhardSusceptibilityCalculator::calculateSusceptibilit
 			k,
 			kLinearIndex
 		);
-		int kPlusQMeshPoint = kPlusQLinearIndex/momentumSpaceContext.getNumOrbitals();
+		int kPlusQMeshPoint = kPlusQLinearIndex/numOrbitals;
+
+		//Calculate the amplitude products
+		//a(k, state, orbital0)a^{*}(k, state, orbital1) and
+		//a(k+q, state, orbital0)a^{*}(k+q, state, orbital1).
+		for(unsigned int state = 0; state < numOrbitals; state++){
+			for(
+				unsigned int orbital0 = 0;
+				orbital0 < numOrbitals;
+				orbital0++
+			){
+				for(
+					unsigned int orbital1 = 0;
+					orbital1 < numOrbitals;
+					orbital1++
+				){
+					unsigned int n = numOrbitalPairs*state
+						+ numOrbitals*orbital0 + orbital1;
+					amplitudeProducts1[n]
+						= momentumSpaceContext.getAmplitude(
+							meshPoint,
+							state,
+							orbital0
+						)*conj(
+							momentumSpaceContext.getAmplitude(
+								meshPoint,
+								state,
+								orbital1
+							)
+						);
+					amplitudeProducts2[n]
+						= momentumSpaceContext.getAmplitude(
+							kPlusQMeshPoint,
+							state,
+							orbital0
+						)*conj(
+							momentumSpaceContext.getAmplitude(
+								kPlusQMeshPoint,
+								state,
+								orbital1
+							)
+						);
+				}
+			}
+		}
 
+		//Calculate the pole matrix
+		//(f(e2) - f(e1))/(E + e2 - e1) for all pairs of states.
 		for(unsigned int state1 = 0; state1 < numOrbitals; state1++){
-			//Get energy and amplitude for first state.
 			double e1 = momentumSpaceContext.getEnergy(meshPoint, state1);
-			complex<double> a1 = momentumSpaceContext.getAmplitude(
-				meshPoint,
-				state1,
-				orbitalIndices[3]
-			);
-			complex<double> a2 = momentumSpaceContext.getAmplitude(
-				meshPoint,
-				state1,
-				orbitalIndices[0]
-			);
-
-			//Skip to the next state if the current state gives an
-			//obvious zero contribution.
-/*			if(abs(a1*a2) < 1e-10)
-				continue;*/
-			if(real(a1*a2*conj(a1*a2)) < 1e-10)
-				continue;
-
+			double f1 = fermiDiracLookupTable[
+				meshPoint*numOrbitals + state1
+			];
 			for(
 				unsigned int state2 = 0;
 				state2 < numOrbitals;
 				state2++
 			){
-				//Get energy and amplitudes for second state
 				double e2 = momentumSpaceContext.getEnergy(
 					kPlusQLinearIndex + state2
 				);
-				complex<double> a3 = momentumSpaceContext.getAmplitude(
-					kPlusQMeshPoint,
-					state2,
-					orbitalIndices[1]
-				);
-				complex<double> a4 = momentumSpaceContext.getAmplitude(
-					kPlusQMeshPoint,
-					state2,
-					orbitalIndices[2]
+				double fermiDifference = fermiDiracLookupTable[
+					kPlusQLinearIndex + state2
+				] - f1;
+
+				//Skip to the next state if the current pair of
+				//states gives an obvious zero contribution.
+				//Terms evaluated at a pole are finite even if
+				//the Fermi functions cancel.
+				unsigned int pair = numOrbitals*state1 + state2;
+				poleIsZero[pair] = (
+					abs(fermiDifference) < 1e-10
+					&& realEnergyIndices.size() == 0
 				);
-
-				//Skip to the next state if the current state
-				//gives an obvious zero contribution.
-/*				if(abs(a3*a4) < 1e-10)
-					continue;*/
-				if(real(a3*a4*conj(a3*a4)) < 1e-10)
+				if(poleIsZero[pair])
 					continue;
 
-				if(realEnergies.size() > 0){
-					//If the expression is not safe from
-					//poles, the function
-					//poleTimesTwoFermi() is used to
-					//evaluate the Lindhard function to
-					//properly handle potential divisions
-					//by zero.
-					for(
-						unsigned int e = 0;
-						e < realEnergies.size();
-						e++
-					){
-						complex<double> E = realEnergies.at(e);
-						complex<double> pttf = getPoleTimesTwoFermi(
-							E,
-							e2,
-							e1,
-							model.getChemicalPotential(),
-							model.getTemperature(),
-							kPlusQLinearIndex,
-							meshPoint,
-							state2,
-							state1,
-							numOrbitals
-						);
-
-						result[
-							realEnergyIndices[e]
-						] -= a1*conj(a2)*a3*conj(a4)*pttf;
-					}
+				double *realPole = &realPoles[numEnergies*pair];
+				double *imaginaryPole
+					= &imaginaryPoles[numEnergies*pair];
+				for(unsigned int e = 0; e < numEnergies; e++){
+					double x = realEnergies[e] + e2 - e1;
+					double y = imaginaryEnergies[e];
+					double scale = fermiDifference/(x*x + y*y);
+					realPole[e] = x*scale;
+					imaginaryPole[e] = -y*scale;
 				}
-				if(complexEnergies.size() > 0){
-					//If the expression is safe from
-					//division by zero, the performance is
-					//improved by using a lookup table to
-					//evaluate the Fermi function.
-
-					//Calculate numerator of the Lindhard
-					//function
-					complex<double> numerator = a1*conj(a2)*a3*conj(a4)*(
-						fermiDiracLookupTable[
-							kPlusQLinearIndex
-							+ state2
-						]
-						- fermiDiracLookupTable[
-							meshPoint*numOrbitals
-							+ state1
-						]
+
+				//If the expression is not safe from poles, the
+				//function poleTimesTwoFermi() is used to
+				//evaluate the Lindhard function at real
+				//energies to properly handle potential
+				//divisions by zero.
+				for(
+					unsigned int e = 0;
+					e < realEnergyIndices.size();
+					e++
+				){
+					complex<double> pttf = getPoleTimesTwoFermi(
+						energies[realEnergyIndices[e]],
+						e2,
+						e1,
+						model.getChemicalPotential(),
+						model.getTemperature(),
+						kPlusQLinearIndex,
+						meshPoint,
+						state2,
+						state1,
+						numOrbitals
 					);
-					//Skip to the next state if the
-					//numerator gives rise to an obvious
-					//zero contribution.
-					if(abs(numerator) < 1e-10)
+					realPole[realEnergyIndices[e]] = real(pttf);
+					imaginaryPole[realEnergyIndices[e]]
+						= imag(pttf);
+				}
+			}
+		}
+
+		//Contract the pole matrix with the amplitude products at k+q.
+		fill(realContraction.begin(), realContraction.end(), 0.);
+		fill(imaginaryContraction.begin(), imaginaryContraction.end(), 0.);
+		for(unsigned int state1 = 0; state1 < numOrbitals; state1++){
+			for(
+				unsigned int state2 = 0;
+				state2 < numOrbitals;
+				state2++
+			){
+				unsigned int pair = numOrbitals*state1 + state2;
+				if(poleIsZero[pair])
+					continue;
+
+				const double *realPole = &realPoles[numEnergies*pair];
+				const double *imaginaryPole
+					= &imaginaryPoles[numEnergies*pair];
+				for(
+					unsigned int orbitalPair = 0;
+					orbitalPair < numOrbitalPairs;
+					orbitalPair++
+				){
+					complex<double> amplitudeProduct
+						= amplitudeProducts2[
+							numOrbitalPairs*state2
+							+ orbitalPair
+						];
+					if(amplitudeProduct == 0.)
 						continue;
 
+					double a = real(amplitudeProduct);
+					double b = imag(amplitudeProduct);
+					double *realTarget = &realContraction[
+						blockSize*state1
+						+ numEnergies*orbitalPair
+					];
+					double *imaginaryTarget
+						= &imaginaryContraction[
+							blockSize*state1
+							+ numEnergies*orbitalPair
+						];
 					for(
 						unsigned int e = 0;
-						e < complexEnergies.size();
+						e < numEnergies;
 						e++
 					){
-						//
-						complex<double> E = complexEnergies[e];
-						result[
-							complexEnergyIndices[e]
-						] -= numerator/(E + e2 - e1);
+						realTarget[e] += a*realPole[e]
+							- b*imaginaryPole[e];
+						imaginaryTarget[e] += a*imaginaryPole[e]
+							+ b*realPole[e];
 					}
 				}
 			}
 		}
+
+		//Contract the result with the amplitude products at k.
+		for(unsigned int state1 = 0; state1 < numOrbitals; state1++){
+			const double *realSource = &realContraction[blockSize*state1];
+			const double *imaginarySource
+				= &imaginaryContraction[blockSize*state1];
+			for(
+				unsigned int orbitalPair = 0;
+				orbitalPair < numOrbitalPairs;
+				orbitalPair++
+			){
+				complex<double> amplitudeProduct = amplitudeProducts1[
+					numOrbitalPairs*state1 + orbitalPair
+				];
+				if(amplitudeProduct == 0.)
+					continue;
+
+				double a = real(amplitudeProduct);
+				double b = imag(amplitudeProduct);
+				double *realTarget
+					= &realResult[(size_t)blockSize*orbitalPair];
+				double *imaginaryTarget = &imaginaryResult[
+					(size_t)blockSize*orbitalPair
+				];
+				for(unsigned int c = 0; c < blockSize; c++){
+					realTarget[c] -= a*realSource[c]
+						- b*imaginarySource[c];
+					imaginaryTarget[c] -= a*imaginarySource[c]
+						+ b*realSource[c];
+				}
+			}
+		}
 	}
 
 	//Normalize result.
-	for(unsigned int n = 0; n < energies.size(); n++)
-		result[n] /= mesh.size();
+	for(size_t n = 0; n < resultSize; n++){
+		realResult[n] /= mesh.size();
+		imaginaryResult[n] /= mesh.size();
+	}
+}
 
-	//Cashe result
-	cacheSusceptibility(
-		result,
-		k,
-		orbitalIndices,
-		kIndex,
-		resultIndex
-	);
+void LindhardSusceptibilityCalculator::calculateSusceptibilities(
+	const DualIndex &kDual,
+	double *realResult,
+	double *imaginaryResult
+) const{
+	if(getKPlusQLookupTable() != nullptr){
+		if(getSusceptibilityIsSafeFromPoles()){
+			calculateSusceptibilityLindhard<true, true>(
+				kDual,
+				realResult,
+				imaginaryResult
+			);
+		}
+		else{
+			calculateSusceptibilityLindhard<true, false>(
+				kDual,
+				realResult,
+				imaginaryResult
+			);
+		}
+	}
+	else{
+		if(getSusceptibilityIsSafeFromPoles()){
+			calculateSusceptibilityLindhard<false, true>(
+				kDual,
+				realResult,
+				imaginaryResult
+			);
+		}
+		else{
+			calculateSusceptibilityLindhard<false, false>(
+				kDual,
+				realResult,
+				imaginaryResult
+			);
+		}
+	}
+}
 
-	return result;
+void LindhardSusceptibilityCalculator::cacheSusceptibilities(
+	const DualIndex &kDual,
+	const vector<double> &realResult,
+	const vector<double> &imaginaryResult
+){
+	const vector<double> &k = kDual;
+	const Index &kIndex = kDual;
+	unsigned int numOrbitals = getMomentumSpaceContext().getNumOrbitals();
+	unsigned int numEnergies = getEnergies().size();
+
+	vector<complex<double>> result(numEnergies);
+	for(unsigned int orbital0 = 0; orbital0 < numOrbitals; orbital0++){
+		for(
+			unsigned int orbital1 = 0;
+			orbital1 < numOrbitals;
+			orbital1++
+		){
+			for(
+				unsigned int orbital2 = 0;
+				orbital2 < numOrbitals;
+				orbital2++
+			){
+				for(
+					unsigned int orbital3 = 0;
+					orbital3 < numOrbitals;
+					orbital3++
+				){
+					size_t offset = (size_t)numEnergies*(
+						numOrbitals*(
+							numOrbitals*(
+								numOrbitals*orbital3
+								+ orbital0
+							) + orbital1
+						) + orbital2
+					);
+					for(
+						unsigned int e = 0;
+						e < numEnergies;
+						e++
+					){
+						result[e] = complex<double>(
+							realResult[offset + e],
+							imaginaryResult[offset + e]
+						);
+					}
+
+					vector<int> orbitalIndices = {
+						(int)orbital0,
+						(int)orbital1,
+						(int)orbital2,
+						(int)orbital3
+					};
+					cacheSusceptibility(
+						result,
+						k,
+						orbitalIndices,
+						kIndex,
+						getSusceptibilityResultIndex(
+							kIndex,
+							orbitalIndices
+						)
+					);
+				}
+			}
+		}
+	}
 }
 
 complex<double> LindhardSusceptibilityCalculator::calculateSusceptibility(
@@ -616,46 +817,41 @@ vector<complex<double>> LindhardSusceptibilityCalculator::calculateSusceptibilit
 		""
 	);
 
-	if(getKPlusQLookupTable() != nullptr){
-		if(getSusceptibilityIsSafeFromPoles()){
-			return calculateSusceptibilityLindhard<
-				true,
-				true
-			>(
-				kDual,
-				orbitalIndices
-			);
-		}
-		else{
-			return calculateSusceptibilityLindhard<
-				true,
-				false
-			>(
-				kDual,
-				orbitalIndices
-			);
-		}
-	}
-	else{
-		if(getSusceptibilityIsSafeFromPoles()){
-			return calculateSusceptibilityLindhard<
-				false,
-				true
-			>(
-				kDual,
-				orbitalIndices
-			);
-		}
-		else{
-			return calculateSusceptibilityLindhard<
-				false,
-				false
-			>(
-				kDual,
-				orbitalIndices
-			);
-		}
-	}
+	Index resultIndex = getSusceptibilityResultIndex(
+		kDual,
+		orbitalIndices
+	);
+
+	//Try to return precomputed or cashed result
+	SerializableVector<complex<double>> result;
+	if(getPrecomputedSusceptibility(kDual, orbitalIndices, result))
+		return result;
+	if(getSusceptibilityTree().get(result, resultIndex))
+		return result;
+
+	//The susceptibility is calculated for all orbital indices at once
+	//since the remaining components typically are requested next and
+	//most of the work is shared between them.
+	unsigned int numOrbitals = getMomentumSpaceContext().getNumOrbitals();
+	size_t resultSize = (size_t)numOrbitals*numOrbitals*numOrbitals
+		*numOrbitals*getEnergies().size();
+	vector<double> realResult(resultSize);
+	vector<double> imaginaryResult(resultSize);
+	calculateSusceptibilities(
+		kDual,
+		realResult.data(),
+		imaginaryResult.data()
+	);
+	cacheSusceptibilities(kDual, realResult, imaginaryResult);
+
+	TBTKAssert(
+		getSusceptibilityTree().get(result, resultIndex),
+		"LindhardSusceptibilityCalculator::calculateSusceptibility()",
+		"Unable to find requested susceptibility.",
+		"This should never happen, contact the developer."
+	);
+
+	return result;
 }
 
 }	//End of namesapce TBTK
@@ -29,37 +29,83 @@ using namespace std;
 
 namespace TBTK{
 
+//Trigamma function. Valid for arguments that are not close to the negative
+//real axis. The argument is shifted using the recurrence relation until the
+//asymptotic expansion is accurate to machine precision.
+static complex<double> trigamma(complex<double> z){
+	complex<double> result = 0.;
+	while(abs(z) < 10){
+		result += 1./(z*z);
+		z += 1.;
+	}
+
+	complex<double> zInverse = 1./z;
+	complex<double> zInverse2 = zInverse*zInverse;
+	result += zInverse + zInverse2/2. + zInverse2*zInverse*(
+		1./6. + zInverse2*(
+			-1./30. + zInverse2*(
+				1./42. + zInverse2*(-1./30.)
+			)
+		)
+	);
+
+	return result;
+}
+
 MatsubaraSusceptibilityCalculator::MatsubaraSusceptibilityCalculator(
-	const MomentumSpaceContext &momentumSpaceContext
+	const MomentumSpaceContext &momentumSpaceContext,
+	Algorithm algorithm
 ) :
-	SusceptibilityCalculator(Algorithm::Matsubara, momentumSpaceContext)
+	SusceptibilityCalculator(algorithm, momentumSpaceContext)
 {
+	TBTKAssert(
+		algorithm == Algorithm::Matsubara
+		|| algorithm == Algorithm::MatsubaraFFT,
+		"MatsubaraSusceptibilityCalculator::MatsubaraSusceptibilityCalculator()",
+		"Unsupported algorithm.",
+		"Use Algorithm::Matsubara or Algorithm::MatsubaraFFT."
+	);
+
 	greensFunction = nullptr;
+	greensFunctionTransform = nullptr;
+	numPaddedEnergies = 0;
+	useTailCorrection = false;
 }
 
 MatsubaraSusceptibilityCalculator::MatsubaraSusceptibilityCalculator(
 	const MomentumSpaceContext &momentumSpaceContext,
+	Algorithm algorithm,
 	int *kPlusQLookupTable
 ) :
 	SusceptibilityCalculator(
-		Algorithm::Matsubara,
+		algorithm,
 		momentumSpaceContext,
 		kPlusQLookupTable
 	)
 {
 	greensFunction = nullptr;
+	greensFunctionTransform = nullptr;
+	numPaddedEnergies = 0;
+	useTailCorrection = false;
 }
 
 MatsubaraSusceptibilityCalculator::~MatsubaraSusceptibilityCalculator(){
 	if(greensFunction != nullptr)
 		delete [] greensFunction;
+	if(greensFunctionTransform != nullptr)
+		delete [] greensFunctionTransform;
 }
 
 MatsubaraSusceptibilityCalculator* MatsubaraSusceptibilityCalculator::createSlave(){
-	return new MatsubaraSusceptibilityCalculator(
-		getMomentumSpaceContext(),
-		getKPlusQLookupTable()
-	);
+	MatsubaraSusceptibilityCalculator *slave
+		= new MatsubaraSusceptibilityCalculator(
+			getMomentumSpaceContext(),
+			getAlgorithm(),
+			getKPlusQLookupTable()
+		);
+	slave->useTailCorrection = useTailCorrection;
+
+	return slave;
 }
 
 complex<double> MatsubaraSusceptibilityCalculator::calculateSusceptibility(
@@ -94,6 +140,20 @@ vector<complex<double>> MatsubaraSusceptibilityCalculator::calculateSusceptibili
 		""
 	);
 
+	if(getAlgorithm() == Algorithm::MatsubaraFFT){
+		Index resultIndex = getSusceptibilityResultIndex(
+			kDual,
+			orbitalIndices
+		);
+		SerializableVector<complex<double>> result;
+		if(!getSusceptibilityTree().get(result, resultIndex)){
+			calculateSusceptibilityMatsubaraFFT(orbitalIndices);
+			getSusceptibilityTree().get(result, resultIndex);
+		}
+
+		return result;
+	}
+
 	if(getKPlusQLookupTable() != nullptr){
 		return calculateSusceptibilityMatsubara<true>(
 			kDual,
@@ -205,13 +265,19 @@ vector<complex<double>> MatsubaraSusceptibilityCalculator::calculateSusceptibili
 		}
 	}
 
-	//Normalize result.
+	//Add the part of the sum that lies outside of the summation energies
+	//and normalize result.
+	vector<complex<double>> tailCorrections = calculateTailCorrections(
+		orbitalIndices
+	);
 	double temperature = UnitHandler::convertTemperatureNtB(
 		momentumSpaceContext.getModel().getTemperature()
 	);
 	double kT = UnitHandler::getK_BB()*temperature;
-	for(unsigned int n = 0; n < energies.size(); n++)
+	for(unsigned int n = 0; n < energies.size(); n++){
+		result[n] -= (double)mesh.size()*tailCorrections[n];
 		result[n] /= mesh.size()*kT;
+	}
 
 	//Cashe result
 	cacheSusceptibility(
@@ -225,6 +291,69 @@ vector<complex<double>> MatsubaraSusceptibilityCalculator::calculateSusceptibili
 	return result;
 }
 
+vector<complex<double>> MatsubaraSusceptibilityCalculator::calculateTailCorrections(
+	const vector<int> &orbitalIndices
+) const{
+	const vector<complex<double>> &energies = getEnergies();
+	vector<complex<double>> tailCorrections(energies.size(), 0.);
+	if(
+		!useTailCorrection
+		|| orbitalIndices[3] != orbitalIndices[0]
+		|| orbitalIndices[1] != orbitalIndices[2]
+		|| summationEnergies.size() < 2
+	){
+		return tailCorrections;
+	}
+
+	//The summation energies are E_n = E_0 + n*delta. Outside of the
+	//summation energies, G(E_n) is replaced by 1/E_n.
+	int numSummationEnergies = summationEnergies.size();
+	complex<double> delta = summationEnergies[1] - summationEnergies[0];
+	complex<double> offset = summationEnergies[0]/delta;
+
+	//Sum of 1/E_n for n in [from, to), or minus the sum over [to, from) if
+	//to < from.
+	auto sumInverseEnergies = [&](int from, int to){
+		int sign = 1;
+		if(to < from){
+			swap(from, to);
+			sign = -1;
+		}
+		complex<double> sum = 0.;
+		for(int n = from; n < to; n++)
+			sum += 1./(summationEnergies[0] + (double)n*delta);
+
+		return (double)sign*sum;
+	};
+
+	for(unsigned int e = 0; e < energies.size(); e++){
+		int d = (int)e - (int)energies.size()/2;
+		if(d == 0){
+			//\sum 1/E_n^2 over n < 0 and n >= N.
+			tailCorrections[e] = (
+				trigamma(offset + (double)numSummationEnergies)
+				+ trigamma(1. - offset)
+			)/(delta*delta);
+		}
+		else{
+			//1/(E_n E_{n+d}) = (1/E_n - 1/E_{n+d})/(d delta)
+			//telescopes. The sum over all n vanishes, so the
+			//missing terms are minus the terms for which both n and
+			//n+d are inside [0, N).
+			int from = max(0, -d);
+			int to = min(numSummationEnergies, numSummationEnergies - d);
+			if(to < from)
+				to = from;
+			tailCorrections[e] = (
+				sumInverseEnergies(to, to + d)
+				- sumInverseEnergies(from, from + d)
+			)/((double)d*delta);
+		}
+	}
+
+	return tailCorrections;
+}
+
 void MatsubaraSusceptibilityCalculator::calculateGreensFunction(){
 	if(greensFunction != nullptr)
 		return;
@@ -91,6 +91,17 @@ void MomentumSpaceContext::init(){
 		<< " are set using MomentumSpaceContext::setNumOrbitals()."
 	);
 
+	//The RPA calculators assume that the basis index of a given k-point
+	//and orbital is k*numOrbitals + orbital.
+	TBTKAssert(
+		model->getHoppingAmplitudeSet()->getBasisOrdering()
+		== HoppingAmplitudeSet::BasisOrdering::Lexicographic,
+		"MomentumSpaceContext::init()",
+		"The Model must use lexicographic basis ordering.",
+		"Do not call Model::setBasisOrdering() for Models used with"
+		<< " the RPA calculators."
+	);
+
 	Timer::tick("Diagonalize");
 	solver = Solver::BlockDiagonalizer();
 	solver.setModel(*model);
@@ -23,8 +23,12 @@
 #include "TBTK/RPA/RPASusceptibilityCalculator.h"
 #include "TBTK/UnitHandler.h"
 
+#include <algorithm>
 #include <complex>
-#include <iomanip>
+
+#ifdef TBTK_USE_OPEN_MP
+#include <omp.h>
+#endif
 
 using namespace std;
 
@@ -41,10 +45,14 @@ RPASusceptibilityCalculator::RPASusceptibilityCalculator(
 		susceptibilityCalculator = new LindhardSusceptibilityCalculator(
 			momentumSpaceContext
 		);
+		break;
 	case SusceptibilityCalculator::Algorithm::Matsubara:
+	case SusceptibilityCalculator::Algorithm::MatsubaraFFT:
 		susceptibilityCalculator = new MatsubaraSusceptibilityCalculator(
-			momentumSpaceContext
+			momentumSpaceContext,
+			algorithm
 		);
+		break;
 	default:
 		TBTKExit(
 			"RPASusceptibilityCalculator::RPASusceptibilityCalculator()",
@@ -91,6 +99,21 @@ RPASusceptibilityCalculator* RPASusceptibilityCalculator::createSlave(){
 }
 
 extern "C" {
+	void zgemm_(
+		char *transA,
+		char *transB,
+		int *m,
+		int *n,
+		int *k,
+		complex<double> *alpha,
+		const complex<double> *A,
+		int *lda,
+		const complex<double> *B,
+		int *ldb,
+		complex<double> *beta,
+		complex<double> *C,
+		int *ldc
+	);
 	void zgetrf_(
 		int* M,
 		int *N,
@@ -99,104 +122,201 @@ extern "C" {
 		int *ipiv,
 		int *info
 	);
-	void zgetri_(
+	void zgetrs_(
+		char *trans,
 		int *N,
+		int *nrhs,
 		complex<double> *A,
 		int *lda,
 		int *ipiv,
-		complex<double> *work,
-		int *lwork,
+		complex<double> *B,
+		int *ldb,
 		int *info
 	);
 }
 
-inline void RPASusceptibilityCalculator::invertMatrix(
-	complex<double> *matrix,
-	unsigned int dimensions
-){
-	int numRows = dimensions;
-	int numCols = dimensions;
+void RPASusceptibilityCalculator::precompute(){
+	const MomentumSpaceContext &momentumSpaceContext
+		= susceptibilityCalculator->getMomentumSpaceContext();
+	const vector<vector<double>> &mesh = momentumSpaceContext.getMesh();
+	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+	unsigned int matrixDimension = numOrbitals*numOrbitals;
+	unsigned int matrixSize = matrixDimension*matrixDimension;
+	unsigned int numEnergies = energies.size();
 
-	int *ipiv = new int[min(numRows, numCols)];
-	int lwork = numCols*numCols;
-	complex<double> *work = new complex<double>[lwork];
-	int info;
+	if(
+		susceptibilityCalculator->getAlgorithm()
+			== SusceptibilityCalculator::Algorithm::Lindhard
+	){
+		((LindhardSusceptibilityCalculator*)susceptibilityCalculator)->precompute();
+	}
 
-	zgetrf_(&numRows, &numCols, matrix, &numRows, ipiv, &info);
-	zgetri_(&numRows, matrix, &numRows, ipiv, work, &lwork, &info);
+	//Setup the interaction matrices and the trees that the
+	//corresponding results are stored in.
+	generateInteractionAmplitudes();
+	vector<vector<complex<double>>> interactionMatrices(2);
+	generateInteractionMatrix(
+		interactionAmplitudesCharge,
+		interactionMatrices[0]
+	);
+	generateInteractionMatrix(
+		interactionAmplitudesSpin,
+		interactionMatrices[1]
+	);
+	vector<IndexedDataTree<SerializableVector<complex<double>>>*> trees = {
+		&rpaChargeSusceptibilityTree,
+		&rpaSpinSusceptibilityTree
+	};
+	vector<bool> useInversionSymmetry = {
+		getUseInversionSymmetry(),
+		getUseInversionSymmetry()
+	};
+	if(interactionAmplitudes.size() != 0){
+		interactionMatrices.push_back(vector<complex<double>>());
+		generateInteractionMatrix(
+			interactionAmplitudes,
+			interactionMatrices.back()
+		);
+		trees.push_back(&rpaSusceptibilityTree);
+		useInversionSymmetry.push_back(false);
+	}
 
-	delete [] ipiv;
-	delete [] work;
-}
+	//The k-points are processed in chunks to limit the memory required
+	//to store the intermediate results.
+	initWorkspaces();
+	unsigned int chunkSize = workspaces.size();
+	for(
+		unsigned int chunkBegin = 0;
+		chunkBegin < mesh.size();
+		chunkBegin += chunkSize
+	){
+		unsigned int chunkEnd = min(
+			chunkBegin + chunkSize,
+			(unsigned int)mesh.size()
+		);
+		unsigned int numKPoints = chunkEnd - chunkBegin;
 
-void RPASusceptibilityCalculator::multiplyMatrices(
-	complex<double> *matrix1,
-	complex<double> *matrix2,
-	complex<double> *result,
-	unsigned int dimensions
-){
-	for(unsigned int n = 0; n < dimensions*dimensions; n++)
-		result[n] = 0.;
+		//The bare susceptibility cache is not thread safe, so the
+		//bare susceptibilities are collected serially.
+		vector<DualIndex> kDuals;
+		vector<vector<complex<double>>> bareSusceptibilities(
+			numKPoints
+		);
+		for(unsigned int n = 0; n < numKPoints; n++){
+			const vector<double> &k = mesh[chunkBegin + n];
+			kDuals.push_back(
+				DualIndex(momentumSpaceContext.getKIndex(k), k)
+			);
+			getBareSusceptibilityMatrices(
+				kDuals.back(),
+				bareSusceptibilities[n]
+			);
+		}
 
-	for(unsigned int row = 0; row < dimensions; row++)
-		for(unsigned int col = 0; col < dimensions; col++)
-			for(unsigned int n = 0; n < dimensions; n++)
-				result[dimensions*col + row] += matrix1[dimensions*n + row]*matrix2[dimensions*col + n];
-}
+		for(unsigned int t = 0; t < interactionMatrices.size(); t++){
+			vector<vector<complex<double>>> rpaSusceptibilities(
+				numKPoints,
+				vector<complex<double>>(matrixSize*numEnergies)
+			);
 
-void printMatrix(complex<double> *matrix, unsigned int dimension){
-	for(unsigned int r = 0; r < dimension; r++){
-		for(unsigned int c = 0; c < dimension; c++){
-			Streams::out << setw(20) << matrix[dimension*c + r];
+			#pragma omp parallel for schedule(dynamic)
+			for(
+				unsigned int n = 0;
+				n < numKPoints*numEnergies;
+				n++
+			){
+				unsigned int kPoint = n/numEnergies;
+				unsigned int e = n%numEnergies;
+				unsigned int thread = 0;
+#ifdef TBTK_USE_OPEN_MP
+				thread = omp_get_thread_num();
+#endif
+				solveRPAEquation(
+					interactionMatrices[t].data(),
+					&bareSusceptibilities[kPoint][matrixSize*e],
+					&rpaSusceptibilities[kPoint][matrixSize*e],
+					workspaces[thread]
+				);
+			}
+
+			for(unsigned int n = 0; n < numKPoints; n++){
+				cacheRPASusceptibilities(
+					kDuals[n],
+					rpaSusceptibilities[n],
+					*trees[t],
+					useInversionSymmetry[t]
+				);
+			}
 		}
-		Streams::out << "\n";
 	}
-	Streams::out << "\n";
 }
 
-vector<vector<vector<complex<double>>>> RPASusceptibilityCalculator::rpaSusceptibilityMainAlgorithm(
-	const DualIndex &kDual,
-	const vector<int> &orbitalIndices,
-	const vector<InteractionAmplitude> &interactionAmplitudes
-){
-	TBTKAssert(
-		orbitalIndices.size() == 4,
-		"SusceptibilityCalculator::rpaSusceptibilityMainAlgorithm()",
-		"Four orbital indices required but " << orbitalIndices.size()
-		<< " supplied.",
-		""
-	);
-
-	const MomentumSpaceContext &momentumSpaceContext
-		= susceptibilityCalculator->getMomentumSpaceContext();
-	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+void RPASusceptibilityCalculator::initWorkspaces(){
+	unsigned int numWorkspaces = 1;
+#ifdef TBTK_USE_OPEN_MP
+	numWorkspaces = omp_get_max_threads();
+#endif
+	unsigned int numOrbitals = getMomentumSpaceContext().getNumOrbitals();
 	unsigned int matrixDimension = numOrbitals*numOrbitals;
-	//Denominator in the expression chi_RPA = chi_0/(1 - U\chi_0)
-	vector<complex<double>*> denominators;
-
-	//Initialize denominator matrices to unit matrices
-	for(
-		unsigned int e = 0;
-		e < energies.size();
-		e++
+	if(
+		workspaces.size() == numWorkspaces
+		&& workspaces[0].pivots.size() == matrixDimension
 	){
-		//Create denominator matrix
-		denominators.push_back(
-			new complex<double>[matrixDimension*matrixDimension]
+		return;
+	}
+
+	workspaces.resize(numWorkspaces);
+	for(unsigned int n = 0; n < numWorkspaces; n++){
+		workspaces[n].denominator.resize(
+			matrixDimension*matrixDimension
 		);
-		//Initialize denominator matrices to unit matrices
-		for(
-			unsigned int c = 0;
-			c < matrixDimension*matrixDimension;
-			c++
-		){
-			denominators.at(e)[c] = 0.;
+		workspaces[n].pivots.resize(matrixDimension);
+	}
+}
+
+void RPASusceptibilityCalculator::getBareSusceptibilityMatrices(
+	const DualIndex &kDual,
+	vector<complex<double>> &bareSusceptibilities
+){
+	unsigned int numOrbitals = getMomentumSpaceContext().getNumOrbitals();
+	unsigned int matrixDimension = numOrbitals*numOrbitals;
+	unsigned int matrixSize = matrixDimension*matrixDimension;
+	unsigned int numEnergies = energies.size();
+
+	bareSusceptibilities.resize(matrixSize*numEnergies);
+	for(unsigned int a = 0; a < numOrbitals; a++){
+		for(unsigned int b = 0; b < numOrbitals; b++){
+			unsigned int row = numOrbitals*a + b;
+			for(unsigned int c = 0; c < numOrbitals; c++){
+				for(unsigned int d = 0; d < numOrbitals; d++){
+					unsigned int col = numOrbitals*c + d;
+
+					vector<complex<double>> susceptibility
+						= susceptibilityCalculator->calculateSusceptibility(
+							kDual,
+							{(int)a, (int)b, (int)d, (int)c}
+						);
+					for(unsigned int e = 0; e < numEnergies; e++){
+						bareSusceptibilities[
+							matrixSize*e
+							+ matrixDimension*col
+							+ row
+						] = susceptibility[e];
+					}
+				}
+			}
 		}
-		for(unsigned int c = 0; c < matrixDimension; c++)
-			denominators.at(e)[c*matrixDimension + c] = 1.;
 	}
+}
+
+void RPASusceptibilityCalculator::generateInteractionMatrix(
+	const vector<InteractionAmplitude> &interactionAmplitudes,
+	vector<complex<double>> &interactionMatrix
+) const{
+	unsigned int numOrbitals = getMomentumSpaceContext().getNumOrbitals();
+	unsigned int matrixDimension = numOrbitals*numOrbitals;
 
-	//Calculate denominator = (1 + U\chi_0)
+	interactionMatrix.assign(matrixDimension*matrixDimension, 0.);
 	for(unsigned int n = 0; n < interactionAmplitudes.size(); n++){
 		const InteractionAmplitude &interactionAmplitude = interactionAmplitudes.at(n);
 
@@ -210,141 +330,264 @@ vector<vector<vector<complex<double>>>> RPASusceptibilityCalculator::rpaSuscepti
 			continue;
 
 		int row = numOrbitals*c0 + a1;
-		for(unsigned int c = 0; c < numOrbitals; c++){
-			for(unsigned int d = 0; d < numOrbitals; d++){
-				int col = numOrbitals*c + d;
-
-				vector<complex<double>> susceptibility
-					= susceptibilityCalculator->calculateSusceptibility(
-						kDual,
-						{c1, a0, (int)d, (int)c}
-					);
-				for(
-					unsigned int i = 0;
-					i < energies.size();
-					i++
-				){
-					denominators.at(i)[
-						matrixDimension*col + row
-					] += amplitude*susceptibility.at(i);
-				}
-			}
-		}
+		int col = numOrbitals*c1 + a0;
+		interactionMatrix[matrixDimension*col + row] += amplitude;
 	}
+}
 
-	//Calculate (1 + U\chi_0)^{-1}
-	for(unsigned int n = 0; n < energies.size(); n++)
-		invertMatrix(denominators.at(n), matrixDimension);
+void RPASusceptibilityCalculator::solveRPAEquation(
+	const complex<double> *interactionMatrix,
+	const complex<double> *bareSusceptibility,
+	complex<double> *rpaSusceptibility,
+	Workspace &workspace
+) const{
+	unsigned int numOrbitals = getMomentumSpaceContext().getNumOrbitals();
+	int matrixDimension = numOrbitals*numOrbitals;
+	complex<double> *denominator = workspace.denominator.data();
+
+	//Calculate the denominator 1 + U\chi_0
+	for(int n = 0; n < matrixDimension*matrixDimension; n++)
+		denominator[n] = 0.;
+	for(int n = 0; n < matrixDimension; n++)
+		denominator[matrixDimension*n + n] = 1.;
+
+	char noTranspose = 'N';
+	complex<double> one = 1.;
+	zgemm_(
+		&noTranspose,
+		&noTranspose,
+		&matrixDimension,
+		&matrixDimension,
+		&matrixDimension,
+		&one,
+		interactionMatrix,
+		&matrixDimension,
+		bareSusceptibility,
+		&matrixDimension,
+		&one,
+		denominator,
+		&matrixDimension
+	);
 
-	//Initialize \chi_RPA
-	vector<vector<vector<complex<double>>>> rpaSusceptibility;
-	for(unsigned int orbital2 = 0; orbital2 < numOrbitals; orbital2++){
-		rpaSusceptibility.push_back(vector<vector<complex<double>>>());
-		for(unsigned int orbital3 = 0; orbital3 < numOrbitals; orbital3++){
-			rpaSusceptibility[orbital2].push_back(vector<complex<double>>());
-			for(
-				unsigned int e = 0;
-				e < energies.size();
-				e++
-			){
-				rpaSusceptibility[orbital2][orbital3].push_back(0.);
-			}
-		}
-	}
+	int info;
+	zgetrf_(
+		&matrixDimension,
+		&matrixDimension,
+		denominator,
+		&matrixDimension,
+		workspace.pivots.data(),
+		&info
+	);
+	TBTKAssert(
+		info == 0,
+		"RPASusceptibilityCalculator::solveRPAEquation()",
+		"Unable to factorize the denominator 1 + U\\chi_0. zgetrf"
+		<< " exited with INFO=" << info << ".",
+		"The RPA susceptibility diverges at the given energy."
+	);
 
-	//Calculate \chi_RPA = \chi_0/(1 + U\chi_0)
-	for(unsigned int c = 0; c < numOrbitals; c++){
-		for(unsigned int d = 0; d < numOrbitals; d++){
-			vector<complex<double>> susceptibility
-				= susceptibilityCalculator->calculateSusceptibility(
-					kDual,
-					{
-						orbitalIndices.at(0),
-						orbitalIndices.at(1),
-						(int)d,
-						(int)c
-					}
-				);
-			for(unsigned int orbital2 = 0; orbital2 < numOrbitals; orbital2++){
-				for(unsigned int orbital3 = 0; orbital3 < numOrbitals; orbital3++){
-					for(
-						unsigned int i = 0;
-						i < energies.size();
-						i++
-					){
-						rpaSusceptibility[orbital2][orbital3].at(i) += denominators.at(i)[
-							matrixDimension*(
-								numOrbitals*orbital2
-								+ orbital3
-							) + numOrbitals*c + d
-						]*susceptibility.at(i);
-					}
-				}
-			}
+	//Solve (1 + U\chi_0)^T\chi_RPA^T = \chi_0^T, with \chi_0^T as the
+	//initial right hand side.
+	for(int row = 0; row < matrixDimension; row++){
+		for(int col = 0; col < matrixDimension; col++){
+			rpaSusceptibility[matrixDimension*row + col]
+				= bareSusceptibility[matrixDimension*col + row];
 		}
 	}
 
-	//Free memory allocated for denominators
-	for(unsigned int n = 0; n < energies.size(); n++)
-		delete [] denominators.at(n);
+	char transpose = 'T';
+	zgetrs_(
+		&transpose,
+		&matrixDimension,
+		&matrixDimension,
+		denominator,
+		&matrixDimension,
+		workspace.pivots.data(),
+		rpaSusceptibility,
+		&matrixDimension,
+		&info
+	);
+	TBTKAssert(
+		info == 0,
+		"RPASusceptibilityCalculator::solveRPAEquation()",
+		"zgetrs exited with INFO=" << info << ".",
+		"This should never happen, contact the developer."
+	);
+}
 
-	return rpaSusceptibility;
+void RPASusceptibilityCalculator::rpaSusceptibilityMainAlgorithm(
+	const vector<complex<double>> &bareSusceptibilities,
+	const vector<InteractionAmplitude> &interactionAmplitudes,
+	vector<complex<double>> &rpaSusceptibilities
+){
+	unsigned int numOrbitals = getMomentumSpaceContext().getNumOrbitals();
+	unsigned int matrixDimension = numOrbitals*numOrbitals;
+	unsigned int matrixSize = matrixDimension*matrixDimension;
+	unsigned int numEnergies = energies.size();
+
+	vector<complex<double>> interactionMatrix;
+	generateInteractionMatrix(interactionAmplitudes, interactionMatrix);
+
+	initWorkspaces();
+	rpaSusceptibilities.resize(matrixSize*numEnergies);
+
+	#pragma omp parallel for schedule(dynamic)
+	for(unsigned int e = 0; e < numEnergies; e++){
+		unsigned int thread = 0;
+#ifdef TBTK_USE_OPEN_MP
+		thread = omp_get_thread_num();
+#endif
+		solveRPAEquation(
+			interactionMatrix.data(),
+			&bareSusceptibilities[matrixSize*e],
+			&rpaSusceptibilities[matrixSize*e],
+			workspaces[thread]
+		);
+	}
 }
 
 vector<complex<double>> RPASusceptibilityCalculator::calculateRPASusceptibility(
 	const DualIndex &kDual,
-	const vector<int> &orbitalIndices
+	const vector<int> &orbitalIndices,
+	const vector<InteractionAmplitude> &interactionAmplitudes,
+	IndexedDataTree<SerializableVector<complex<double>>> &tree,
+	bool useInversionSymmetry
 ){
 	TBTKAssert(
 		orbitalIndices.size() == 4,
-		"getSusceptibility()",
+		"RPASusceptibilityCalculator::calculateRPASusceptibility()",
 		"Four orbital indices required but " << orbitalIndices.size()
 		<< " supplied.",
 		""
 	);
 
-	//Get kIndex and resultIndex
-	Index resultIndex = getSusceptibilityResultIndex(
-		kDual,
-		orbitalIndices
-	);
-
-	//Try to return cashed result
+	//Try to return cached result
 	SerializableVector<complex<double>> result;
-	if(rpaSusceptibilityTree.get(result, resultIndex))
+	if(
+		tree.get(
+			result,
+			getSusceptibilityResultIndex(kDual, orbitalIndices)
+		)
+	){
 		return result;
+	}
 
-	//Calculate RPA-susceptibility
-	vector<vector<vector<complex<double>>>> rpaSusceptibility = rpaSusceptibilityMainAlgorithm(
-		kDual,
-		orbitalIndices,
-		interactionAmplitudes
+	//Calculate the RPA susceptibility for all orbital indices
+	vector<complex<double>> bareSusceptibilities;
+	getBareSusceptibilityMatrices(kDual, bareSusceptibilities);
+	vector<complex<double>> rpaSusceptibilities;
+	rpaSusceptibilityMainAlgorithm(
+		bareSusceptibilities,
+		interactionAmplitudes,
+		rpaSusceptibilities
 	);
 
 	//Cache result
+	cacheRPASusceptibilities(
+		kDual,
+		rpaSusceptibilities,
+		tree,
+		useInversionSymmetry
+	);
+
+	unsigned int numOrbitals = getMomentumSpaceContext().getNumOrbitals();
+	unsigned int matrixDimension = numOrbitals*numOrbitals;
+	unsigned int matrixSize = matrixDimension*matrixDimension;
+	unsigned int position = matrixDimension*(
+		numOrbitals*orbitalIndices[0] + orbitalIndices[1]
+	) + numOrbitals*orbitalIndices[2] + orbitalIndices[3];
+	result.resize(energies.size());
+	for(unsigned int e = 0; e < energies.size(); e++)
+		result[e] = rpaSusceptibilities[matrixSize*e + position];
+
+	return result;
+}
+
+void RPASusceptibilityCalculator::cacheRPASusceptibilities(
+	const DualIndex &kDual,
+	const vector<complex<double>> &rpaSusceptibilities,
+	IndexedDataTree<SerializableVector<complex<double>>> &tree,
+	bool useInversionSymmetry
+){
 	const MomentumSpaceContext &momentumSpaceContext
 		= susceptibilityCalculator->getMomentumSpaceContext();
 	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
-	for(unsigned int orbital0 = 0; orbital0 < numOrbitals; orbital0++){
-		for(unsigned int orbital1 = 0; orbital1 < numOrbitals; orbital1++){
-			Index resultIndex = getSusceptibilityResultIndex(
-				kDual,
-				{
-					orbitalIndices[0],
-					orbitalIndices[1],
-					(int)orbital0,
-					(int)orbital1
-				}
-			);
-			rpaSusceptibilityTree.add(
-				rpaSusceptibility[orbital0][orbital1],
-				resultIndex
+	unsigned int matrixDimension = numOrbitals*numOrbitals;
+	unsigned int matrixSize = matrixDimension*matrixDimension;
+	unsigned int numEnergies = energies.size();
+
+	//Use symmetries to extend the result to -k. Done before the results
+	//for k are added, to ensure that the calculated results have
+	//precedence when k and -k are the same point.
+	if(useInversionSymmetry){
+		const vector<unsigned int> &numMeshPoints
+			= momentumSpaceContext.getNumMeshPoints();
+		const BrillouinZone &brillouinZone
+			= momentumSpaceContext.getBrillouinZone();
+		const vector<double> &k = kDual;
+
+		vector<double> kMinus;
+		for(unsigned int n = 0; n < k.size(); n++)
+			kMinus.push_back(-k.at(n));
+		Index kMinusIndex = brillouinZone.getMinorCellIndex(
+			kMinus,
+			numMeshPoints
+		);
+
+		for(unsigned int n = 0; n < matrixSize; n++){
+			int orbital0 = n/(matrixDimension*numOrbitals);
+			int orbital1 = (n/matrixDimension)%numOrbitals;
+			int orbital2 = (n/numOrbitals)%numOrbitals;
+			int orbital3 = n%numOrbitals;
+
+			SerializableVector<complex<double>> conjugatedResult;
+			for(unsigned int e = 0; e < numEnergies; e++){
+				conjugatedResult.push_back(
+					conj(rpaSusceptibilities[matrixSize*e + n])
+				);
+			}
+
+			tree.add(
+				conjugatedResult,
+				Index(
+					kMinusIndex,
+					{orbital1, orbital0, orbital3, orbital2}
+				)
 			);
 		}
 	}
-	result = rpaSusceptibility[orbitalIndices[2]][orbitalIndices[3]];
 
-	return result;
+	for(unsigned int n = 0; n < matrixSize; n++){
+		int orbital0 = n/(matrixDimension*numOrbitals);
+		int orbital1 = (n/matrixDimension)%numOrbitals;
+		int orbital2 = (n/numOrbitals)%numOrbitals;
+		int orbital3 = n%numOrbitals;
+
+		SerializableVector<complex<double>> result;
+		for(unsigned int e = 0; e < numEnergies; e++)
+			result.push_back(rpaSusceptibilities[matrixSize*e + n]);
+
+		tree.add(
+			result,
+			getSusceptibilityResultIndex(
+				kDual,
+				{orbital0, orbital1, orbital2, orbital3}
+			)
+		);
+	}
+}
+
+vector<complex<double>> RPASusceptibilityCalculator::calculateRPASusceptibility(
+	const DualIndex &kDual,
+	const vector<int> &orbitalIndices
+){
+	return calculateRPASusceptibility(
+		kDual,
+		orbitalIndices,
+		interactionAmplitudes,
+		rpaSusceptibilityTree,
+		false
+	);
 }
 
 void RPASusceptibilityCalculator::generateInteractionAmplitudes(){
@@ -438,214 +681,35 @@ void RPASusceptibilityCalculator::generateInteractionAmplitudes(){
 	interactionAmplitudesAreGenerated = true;
 }
 
+
 vector<complex<double>> RPASusceptibilityCalculator::calculateChargeRPASusceptibility(
 	const DualIndex &kDual,
 	const vector<int> &orbitalIndices
 ){
-	TBTKAssert(
-		orbitalIndices.size() == 4,
-		"getSusceptibility()",
-		"Four orbital indices required but " << orbitalIndices.size()
-		<< " supplied.",
-		""
-	);
-
-	//Get kIndex and resultIndex
-	Index resultIndex = getSusceptibilityResultIndex(
-		kDual,
-		orbitalIndices
-	);
-
-	//Try to return cashed result
-	SerializableVector<complex<double>> result;
-	if(rpaChargeSusceptibilityTree.get(result, resultIndex))
-		return result;
-
-	const MomentumSpaceContext &momentumSpaceContext
-		= susceptibilityCalculator->getMomentumSpaceContext();
-	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
-
-	//Setup InteractionAmplitude
 	generateInteractionAmplitudes();
 
-	//Calculate the RPA charge-susceptibility
-	vector<vector<vector<complex<double>>>> rpaSusceptibility = rpaSusceptibilityMainAlgorithm(
+	return calculateRPASusceptibility(
 		kDual,
 		orbitalIndices,
-		interactionAmplitudesCharge
+		interactionAmplitudesCharge,
+		rpaChargeSusceptibilityTree,
+		getUseInversionSymmetry()
 	);
-
-	//Cache result
-	for(unsigned int orbital0 = 0; orbital0 < numOrbitals; orbital0++){
-		for(unsigned int orbital1 = 0; orbital1 < numOrbitals; orbital1++){
-			Index resultIndex = getSusceptibilityResultIndex(
-				kDual,
-				{
-					orbitalIndices[0],
-					orbitalIndices[1],
-					(int)orbital0,
-					(int)orbital1
-				}
-			);
-			rpaChargeSusceptibilityTree.add(
-				rpaSusceptibility[orbital0][orbital1],
-				resultIndex
-			);
-
-			//<!!!Needs proper checking!!!>
-			const MomentumSpaceContext &momentumSpaceContext
-				= susceptibilityCalculator->getMomentumSpaceContext();
-			const vector<unsigned int> &numMeshPoints = momentumSpaceContext.getNumMeshPoints();
-			const BrillouinZone &brillouinZone = momentumSpaceContext.getBrillouinZone();
-//			const vector<double> &k = kDual.getContinuousIndex();
-			const vector<double> &k = kDual;
-
-			const vector<complex<double>> &result = rpaSusceptibility[orbital0][orbital1];
-
-			//Use symmetries to extend result to other entries.
-			if(
-				getEnergyType() == EnergyType::Imaginary
-				&& getEnergiesAreInversionSymmetric()
-			){
-				vector<complex<double>> conjugatedResult;
-				for(unsigned int n = 0; n < result.size(); n++){
-					conjugatedResult.push_back(
-						conj(result.at(n))
-					);
-				}
-
-				vector<double> kMinus;
-				for(unsigned int n = 0; n < k.size(); n++)
-					kMinus.push_back(-k.at(n));
-				Index kMinusIndex = brillouinZone.getMinorCellIndex(
-					kMinus,
-					numMeshPoints
-				);
-
-				rpaChargeSusceptibilityTree.add(
-					conjugatedResult,
-					Index(
-						kMinusIndex,
-						{
-							orbitalIndices.at(1),
-							orbitalIndices.at(0),
-							(int)orbital1,
-							(int)orbital0
-						}
-					)
-				);
-			}
-			//</!!!Needs proper checking!!!>
-		}
-	}
-	result = rpaSusceptibility[orbitalIndices[2]][orbitalIndices[3]];
-
-	return result;
 }
 
 vector<complex<double>> RPASusceptibilityCalculator::calculateSpinRPASusceptibility(
 	const DualIndex &kDual,
 	const vector<int> &orbitalIndices
 ){
-	TBTKAssert(
-		orbitalIndices.size() == 4,
-		"getSusceptibility()",
-		"Four orbital indices required but " << orbitalIndices.size()
-		<< " supplied.",
-		""
-	);
-
-	//Get kIndex and resultIndex
-	Index resultIndex = getSusceptibilityResultIndex(
-		kDual,
-		orbitalIndices
-	);
-
-	//Try to return cached result
-	SerializableVector<complex<double>> result;
-	if(rpaSpinSusceptibilityTree.get(result, resultIndex))
-		return result;
-
-	const MomentumSpaceContext &momentumSpaceContext
-		= susceptibilityCalculator->getMomentumSpaceContext();
-	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
-
-	//Setup InteractionAmplitude
 	generateInteractionAmplitudes();
 
-	//Calculate RPA spin-susceptibility
-	vector<vector<vector<complex<double>>>> rpaSusceptibility = rpaSusceptibilityMainAlgorithm(
+	return calculateRPASusceptibility(
 		kDual,
 		orbitalIndices,
-		interactionAmplitudesSpin
+		interactionAmplitudesSpin,
+		rpaSpinSusceptibilityTree,
+		getUseInversionSymmetry()
 	);
-
-	//Cache result
-	for(unsigned int orbital0 = 0; orbital0 < numOrbitals; orbital0++){
-		for(unsigned int orbital1 = 0; orbital1 < numOrbitals; orbital1++){
-			Index resultIndex = getSusceptibilityResultIndex(
-				kDual,
-				{
-					orbitalIndices[0],
-					orbitalIndices[1],
-					(int)orbital0,
-					(int)orbital1
-				}
-			);
-			rpaSpinSusceptibilityTree.add(
-				rpaSusceptibility[orbital0][orbital1],
-				resultIndex
-			);
-
-			//<!!!Needs proper checking!!!>
-			const MomentumSpaceContext &momentumSpaceContext
-				= susceptibilityCalculator->getMomentumSpaceContext();
-			const vector<unsigned int> &numMeshPoints = momentumSpaceContext.getNumMeshPoints();
-			const BrillouinZone &brillouinZone = momentumSpaceContext.getBrillouinZone();
-//			const vector<double> &k = kDual.getContinuousIndex();
-			const vector<double> &k = kDual;
-
-			const vector<complex<double>> &result = rpaSusceptibility[orbital0][orbital1];
-
-			//Use symmetries to extend result to other entries.
-			if(
-				getEnergyType() == EnergyType::Imaginary
-				&& getEnergiesAreInversionSymmetric()
-			){
-				vector<complex<double>> conjugatedResult;
-				for(unsigned int n = 0; n < result.size(); n++){
-					conjugatedResult.push_back(
-						conj(result.at(n))
-					);
-				}
-
-				vector<double> kMinus;
-				for(unsigned int n = 0; n < k.size(); n++)
-					kMinus.push_back(-k.at(n));
-				Index kMinusIndex = brillouinZone.getMinorCellIndex(
-					kMinus,
-					numMeshPoints
-				);
-
-				rpaSpinSusceptibilityTree.add(
-					conjugatedResult,
-					Index(
-						kMinusIndex,
-						{
-							orbitalIndices.at(1),
-							orbitalIndices.at(0),
-							(int)orbital1,
-							(int)orbital0
-						}
-					)
-				);
-			}
-			//</!!!Needs proper checking!!!>
-		}
-	}
-	result = rpaSusceptibility[orbitalIndices[2]][orbitalIndices[3]];
-
-	return result;
 }
 
 }	//End of namesapce TBTK
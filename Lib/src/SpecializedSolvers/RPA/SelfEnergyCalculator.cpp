@@ -34,7 +34,8 @@ namespace TBTK{
 
 SelfEnergyCalculator::SelfEnergyCalculator(
 	const MomentumSpaceContext &momentumSpaceContext,
-	unsigned int numWorkers
+	unsigned int numWorkers,
+	SusceptibilityCalculator::Algorithm algorithm
 ){
 	TBTKAssert(
 		numWorkers > 0,
@@ -44,6 +45,7 @@ SelfEnergyCalculator::SelfEnergyCalculator(
 	);
 
 	isInitialized = false;
+	this->algorithm = algorithm;
 
 	kMinusQLookupTable = nullptr;
 
@@ -108,6 +110,8 @@ void SelfEnergyCalculator::init(){
 		);
 	}
 
+	clearGreensFunctionTransforms();
+
 	isInitialized = true;
 }
 
@@ -211,8 +215,11 @@ inline int SelfEnergyCalculator::getKMinusQLinearIndex<false>(
 ) const{
 	const MomentumSpaceContext &momentumSpaceContext = electronFluctuationVertexCalculators[0]->getMomentumSpaceContext();
 	const vector<vector<double>> &mesh = momentumSpaceContext.getMesh();
+	vector<double> kMinusQ;
+	for(unsigned int n = 0; n < k.size(); n++)
+		kMinusQ.push_back(k[n] - mesh[meshIndex][n]);
 	Index kMinusQIndex = momentumSpaceContext.getBrillouinZone().getMinorCellIndex(
-		{mesh[meshIndex][0] + k[0], mesh[meshIndex][1] + k[1]},
+		kMinusQ,
 		momentumSpaceContext.getNumMeshPoints()
 	);
 	return momentumSpaceContext.getModel().getHoppingAmplitudeSet()->getFirstIndexInBlock(
@@ -230,7 +237,7 @@ inline int SelfEnergyCalculator::getKMinusQLinearIndex<true>(
 	const vector<vector<double>> &mesh = momentumSpaceContext.getMesh();
 	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
 	return kMinusQLookupTable[
-		meshIndex*mesh.size() + kLinearIndex/numOrbitals
+		(kLinearIndex/numOrbitals)*mesh.size() + meshIndex
 	];
 }
 
@@ -283,6 +290,13 @@ vector<complex<double>> SelfEnergyCalculator::calculateSelfEnergy(
 	if(selfEnergyTree.get(result, resultIndex))
 		return result;
 
+	if(algorithm == SusceptibilityCalculator::Algorithm::MatsubaraFFT){
+		selfEnergyMainLoopFFT(orbitalIndices);
+		selfEnergyTree.get(result, resultIndex);
+
+		return result;
+	}
+
 	//Initialize results
 	for(unsigned int n = 0; n < selfEnergyEnergies.size(); n++)
 		result.push_back(0);
@@ -501,4 +515,34 @@ void SelfEnergyCalculator::selfEnergyMainLoop(
 		result.at(n) *= kT/mesh.size();
 }
 
+void SelfEnergyCalculator::initGreensFunctionTransforms(){
+	const MomentumSpaceContext &momentumSpaceContext = electronFluctuationVertexCalculators[0]->getMomentumSpaceContext();
+	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+
+	//Sums of summation energies and self-energy energies often coincide,
+	//for example for Matsubara energies. The Green's function only needs
+	//to be transformed once for each distinct energy.
+	greensFunctionEnergies.clear();
+	greensFunctionEnergyIndices.clear();
+	for(unsigned int e0 = 0; e0 < numSummationEnergies; e0++){
+		for(unsigned int e1 = 0; e1 < selfEnergyEnergies.size(); e1++){
+			complex<double> E = selfEnergyEnergies[e1]
+				+ summationEnergies[e0];
+			unsigned int index = 0;
+			for(; index < greensFunctionEnergies.size(); index++){
+				complex<double> difference
+					= greensFunctionEnergies[index] - E;
+				if(abs(difference) <= 1e-12*(1 + abs(E)))
+					break;
+			}
+			if(index == greensFunctionEnergies.size())
+				greensFunctionEnergies.push_back(E);
+			greensFunctionEnergyIndices.push_back(index);
+		}
+	}
+
+	greensFunctionTransforms.clear();
+	greensFunctionTransforms.resize(numOrbitals*numOrbitals);
+}
+
 }	//End of namesapce TBTK
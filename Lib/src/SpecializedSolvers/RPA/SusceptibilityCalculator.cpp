@@ -34,7 +34,9 @@ namespace TBTK{
 SusceptibilityCalculator::SusceptibilityCalculator(
 	Algorithm algorithm,
 	const MomentumSpaceContext &momentumSpaceContext
-){
+) :
+	Communicator(false)
+{
 	this->algorithm = algorithm;
 	this->momentumSpaceContext = &momentumSpaceContext;
 
@@ -51,7 +53,9 @@ SusceptibilityCalculator::SusceptibilityCalculator(
 	Algorithm algorithm,
 	const MomentumSpaceContext &momentumSpaceContext,
 	int *kPlusQLookupTable
-){
+) :
+	Communicator(false)
+{
 	this->algorithm = algorithm;
 	this->momentumSpaceContext = &momentumSpaceContext;
 
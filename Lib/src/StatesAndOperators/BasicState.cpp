@@ -61,7 +61,7 @@ void BasicState::addOverlap(
 	const Index &braIndex,
 	const Index &braRelativeUnitCell
 ){
-	storage->overlapsIsSorted = false;
+	storage->overlapsIsSorted.store(false, memory_order_relaxed);
 	storage->overlaps.push_back(make_tuple(overlap, braIndex, braRelativeUnitCell));
 }
 
@@ -70,7 +70,7 @@ void BasicState::addMatrixElement(
 	const Index &braIndex,
 	const Index &braRelativeUnitCell
 ){
-	storage->matrixElementsIsSorted = false;
+	storage->matrixElementsIsSorted.store(false, memory_order_relaxed);
 	storage->matrixElements.push_back(make_tuple(matrixElement, braIndex, braRelativeUnitCell));
 }
 
@@ -82,8 +82,16 @@ complex<double> BasicState::getOverlap(const AbstractState &bra) const{
 		"The bra state has to be a BasicState."
 	);
 
-	if(!storage->overlapsIsSorted){
-		storage->sortOverlaps();
+	if(!storage->overlapsIsSorted.load(memory_order_acquire)){
+		//Cloned states share Storage, which therefore can be sorted
+		//from several threads simultaneously. The acquire load pairs
+		//with the release store in sortOverlaps(), which guarantees
+		//that the sorted overlaps are visible once the flag is set.
+#ifdef TBTK_USE_OPEN_MP
+		#pragma omp critical (TBTK_BASIC_STATE_SORT)
+#endif
+		if(!storage->overlapsIsSorted.load(memory_order_acquire))
+			storage->sortOverlaps();
 	}
 
 	int min = 0;
@@ -184,8 +192,13 @@ complex<double> BasicState::getMatrixElement(
 		"The bra state has to be a BasicState."
 	);
 
-	if(!storage->matrixElementsIsSorted){
-		storage->sortMatrixElements();
+	if(!storage->matrixElementsIsSorted.load(memory_order_acquire)){
+		//See getOverlap().
+#ifdef TBTK_USE_OPEN_MP
+		#pragma omp critical (TBTK_BASIC_STATE_SORT)
+#endif
+		if(!storage->matrixElementsIsSorted.load(memory_order_acquire))
+			storage->sortMatrixElements();
 	}
 
 	int min = 0;
@@ -311,12 +324,12 @@ public:
 
 void BasicState::Storage::sortOverlaps(){
 	sort(overlaps.begin(), overlaps.end(), SortHelperClass());
-	overlapsIsSorted = true;
+	overlapsIsSorted.store(true, memory_order_release);
 }
 
 void BasicState::Storage::sortMatrixElements(){
 	sort(matrixElements.begin(), matrixElements.end(), SortHelperClass());
-	matrixElementsIsSorted = true;
+	matrixElementsIsSorted.store(true, memory_order_release);
 }
 
 };	//End of namespace TBTK
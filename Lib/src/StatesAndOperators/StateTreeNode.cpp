@@ -122,10 +122,17 @@ StateTreeNode::StateTreeNode(
 	//coordinates, but are contained in a plane. Without shifting the box,
 	//the first partition boundary would cut every state and thereby every
 	//state would be added to the root node.
+	//The box is also enlarged in both directions by a margin that is
+	//proportional to its size, since states are only added to partitions
+	//that contain them with a margin of (1 - ROUNDOFF_MARGIN_MULTIPLIER)
+	//times the partitions half size.
 	for(unsigned int n = 0; n < max.size(); n++)
 		max.at(n) += centerShiftMultiplier*maxFiniteExtent;
-	for(unsigned int n = 0; n < min.size(); n++)
-		min.at(n) -= 2.*(max.at(n) - min.at(n))*(1 - ROUNDOFF_MARGIN_MULTIPLIER);
+	for(unsigned int n = 0; n < min.size(); n++){
+		double margin = 2.*(max.at(n) - min.at(n))*(1 - ROUNDOFF_MARGIN_MULTIPLIER);
+		min.at(n) -= margin;
+		max.at(n) += margin;
+	}
 
 	//Calculate center nad halfSize of the bounding box.
 	halfSize = 0.;
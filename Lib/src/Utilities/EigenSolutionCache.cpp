@@ -0,0 +1,294 @@
+/* Copyright 2018 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file EigenSolutionCache.cpp
+ *
+ *  @author Kristofer Björnson
+ */
+
+#include "TBTK/EigenSolutionCache.h"
+#include "TBTK/TBTKMacros.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace TBTK{
+
+//Identifies files written by EigenSolutionCache.
+static const char MAGIC[8] = {'T', 'B', 'T', 'K', 'E', 'I', 'G', '1'};
+
+//Combines the hash of the Model with the size of the solution. Solutions for
+//the same Model but with different memory layouts, such as those of the
+//Diagonalizer and the BlockDiagonalizer, are thereby stored separately.
+static unsigned long long getKey(
+	unsigned long long hash,
+	unsigned int numEigenValues,
+	size_t numEigenVectorElements
+){
+	unsigned long long key = hash;
+	key ^= numEigenValues + 0x9E3779B97F4A7C15ull + (key << 6) + (key >> 2);
+	key ^= numEigenVectorElements + 0x9E3779B97F4A7C15ull + (key << 6)
+		+ (key >> 2);
+
+	return key;
+}
+
+EigenSolutionCache::EigenSolutionCache(const string &path, size_t maxSize){
+	this->path = path;
+	if(this->path.size() != 0 && this->path.back() != '/')
+		this->path += '/';
+	this->maxSize = maxSize;
+}
+
+void EigenSolutionCache::setMaxSize(size_t maxSize){
+	this->maxSize = maxSize;
+
+	vector<Entry> entries;
+	unsigned long long useCounter;
+	readIndex(entries, useCounter);
+	evict(entries, maxSize);
+	writeIndex(entries, useCounter);
+}
+
+size_t EigenSolutionCache::getSize(){
+	vector<Entry> entries;
+	unsigned long long useCounter;
+	readIndex(entries, useCounter);
+
+	size_t size = 0;
+	for(unsigned int n = 0; n < entries.size(); n++)
+		size += entries[n].size;
+
+	return size;
+}
+
+bool EigenSolutionCache::load(
+	unsigned long long hash,
+	unsigned int numEigenValues,
+	size_t numEigenVectorElements,
+	double *eigenValues,
+	complex<double> *eigenVectors
+){
+	unsigned long long key = getKey(
+		hash,
+		numEigenValues,
+		numEigenVectorElements
+	);
+
+	vector<Entry> entries;
+	unsigned long long useCounter;
+	readIndex(entries, useCounter);
+
+	unsigned int entry = 0;
+	while(entry < entries.size() && entries[entry].key != key)
+		entry++;
+	if(entry == entries.size())
+		return false;
+
+	ifstream fin(getFilename(key), ios::binary);
+	if(!fin)
+		return false;
+
+	char magic[8];
+	unsigned long long storedHash;
+	unsigned int storedNumEigenValues;
+	unsigned long long storedNumEigenVectorElements;
+	fin.read(magic, sizeof(magic));
+	fin.read((char*)&storedHash, sizeof(storedHash));
+	fin.read((char*)&storedNumEigenValues, sizeof(storedNumEigenValues));
+	fin.read(
+		(char*)&storedNumEigenVectorElements,
+		sizeof(storedNumEigenVectorElements)
+	);
+	if(
+		!fin
+		|| memcmp(magic, MAGIC, sizeof(MAGIC)) != 0
+		|| storedHash != hash
+		|| storedNumEigenValues != numEigenValues
+		|| storedNumEigenVectorElements != numEigenVectorElements
+	){
+		return false;
+	}
+
+	fin.read((char*)eigenValues, numEigenValues*sizeof(double));
+	fin.read(
+		(char*)eigenVectors,
+		numEigenVectorElements*sizeof(complex<double>)
+	);
+	if(!fin)
+		return false;
+
+	entries[entry].lastUsed = useCounter++;
+	writeIndex(entries, useCounter);
+
+	return true;
+}
+
+void EigenSolutionCache::store(
+	unsigned long long hash,
+	unsigned int numEigenValues,
+	size_t numEigenVectorElements,
+	const double *eigenValues,
+	const complex<double> *eigenVectors
+){
+	size_t size = sizeof(MAGIC) + sizeof(unsigned long long)
+		+ sizeof(unsigned int) + sizeof(unsigned long long)
+		+ numEigenValues*sizeof(double)
+		+ numEigenVectorElements*sizeof(complex<double>);
+	if(size > maxSize)
+		return;
+
+	unsigned long long key = getKey(
+		hash,
+		numEigenValues,
+		numEigenVectorElements
+	);
+
+	vector<Entry> entries;
+	unsigned long long useCounter;
+	readIndex(entries, useCounter);
+
+	//Remove any previous entry with the same key and make room for the
+	//new entry.
+	for(unsigned int n = 0; n < entries.size(); n++){
+		if(entries[n].key == key){
+			entries.erase(entries.begin() + n);
+			break;
+		}
+	}
+	evict(entries, maxSize - size);
+
+	ofstream fout(getFilename(key), ios::binary);
+	TBTKAssert(
+		fout,
+		"EigenSolutionCache::store()",
+		"Unable to open '" << getFilename(key) << "' for writing.",
+		"Make sure that the directory '" << path << "' exists."
+	);
+	unsigned long long storedNumEigenVectorElements
+		= numEigenVectorElements;
+	fout.write(MAGIC, sizeof(MAGIC));
+	fout.write((const char*)&hash, sizeof(hash));
+	fout.write((const char*)&numEigenValues, sizeof(numEigenValues));
+	fout.write(
+		(const char*)&storedNumEigenVectorElements,
+		sizeof(storedNumEigenVectorElements)
+	);
+	fout.write(
+		(const char*)eigenValues,
+		numEigenValues*sizeof(double)
+	);
+	fout.write(
+		(const char*)eigenVectors,
+		numEigenVectorElements*sizeof(complex<double>)
+	);
+	fout.close();
+	TBTKAssert(
+		fout,
+		"EigenSolutionCache::store()",
+		"Failed to write '" << getFilename(key) << "'.",
+		""
+	);
+
+	Entry entry;
+	entry.key = key;
+	entry.size = size;
+	entry.lastUsed = useCounter++;
+	entries.push_back(entry);
+	writeIndex(entries, useCounter);
+}
+
+void EigenSolutionCache::clear(){
+	vector<Entry> entries;
+	unsigned long long useCounter;
+	readIndex(entries, useCounter);
+	evict(entries, 0);
+	writeIndex(entries, useCounter);
+}
+
+string EigenSolutionCache::getFilename(unsigned long long key) const{
+	stringstream ss;
+	ss << path << hex << key << ".eigen";
+
+	return ss.str();
+}
+
+string EigenSolutionCache::getIndexFilename() const{
+	return path + "EigenSolutionCacheIndex";
+}
+
+void EigenSolutionCache::readIndex(
+	vector<Entry> &entries,
+	unsigned long long &useCounter
+) const{
+	entries.clear();
+	useCounter = 0;
+
+	ifstream fin(getIndexFilename());
+	if(!fin)
+		return;
+
+	fin >> useCounter;
+	Entry entry;
+	while(fin >> hex >> entry.key >> dec >> entry.size >> entry.lastUsed)
+		entries.push_back(entry);
+}
+
+void EigenSolutionCache::writeIndex(
+	const vector<Entry> &entries,
+	unsigned long long useCounter
+) const{
+	ofstream fout(getIndexFilename());
+	TBTKAssert(
+		fout,
+		"EigenSolutionCache::writeIndex()",
+		"Unable to open '" << getIndexFilename() << "' for writing.",
+		"Make sure that the directory '" << path << "' exists."
+	);
+
+	fout << useCounter << "\n";
+	for(unsigned int n = 0; n < entries.size(); n++){
+		fout << hex << entries[n].key << dec << " "
+			<< entries[n].size << " "
+			<< entries[n].lastUsed << "\n";
+	}
+}
+
+void EigenSolutionCache::evict(vector<Entry> &entries, size_t size){
+	sort(
+		entries.begin(),
+		entries.end(),
+		[](const Entry &lhs, const Entry &rhs){
+			return lhs.lastUsed > rhs.lastUsed;
+		}
+	);
+
+	size_t totalSize = 0;
+	for(unsigned int n = 0; n < entries.size(); n++)
+		totalSize += entries[n].size;
+
+	while(totalSize > size){
+		totalSize -= entries.back().size;
+		remove(getFilename(entries.back().key).c_str());
+		entries.pop_back();
+	}
+}
+
+};	//End of namespace TBTK
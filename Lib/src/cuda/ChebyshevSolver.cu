@@ -555,7 +555,7 @@ void ChebyshevExpander::loadLookupTableGPU(){
 		Streams::out << "CheyshevExpander::loadLookupTableGPU\n";
 
 	TBTKAssert(
-		generatingFunctionLookupTable != NULL,
+		lookupTable != nullptr,
 		"ChebyshevExpander::loadLookupTableGPU()",
 		"Lookup table has not been generated.",
 		"Call ChebyshevExpander::generateLokupTable() to generate lookup table."
@@ -564,9 +564,7 @@ void ChebyshevExpander::loadLookupTableGPU(){
 		destroyLookupTableGPU();
 
 	complex<double> *generatingFunctionLookupTable_host = new complex<double>[lookupTableNumCoefficients*lookupTableResolution];
-	for(int n = 0; n < lookupTableNumCoefficients; n++)
-		for(int e = 0; e < lookupTableResolution; e++)
-			generatingFunctionLookupTable_host[n*lookupTableResolution + e] = generatingFunctionLookupTable[n][e];
+	lookupTable->getDenseTable(generatingFunctionLookupTable_host);
 
 	int memoryRequirement = lookupTableNumCoefficients*lookupTableResolution*sizeof(complex<double>);
 	if(getGlobalVerbose() && getVerbose()){
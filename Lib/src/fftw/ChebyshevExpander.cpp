@@ -0,0 +1,71 @@
+/* Copyright 2016 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file ChebyshevExpander.cpp
+ *  @brief Functions of the ChebyshevExpander that use FourierTransform
+ *
+ *  @author Kristofer Björnson
+ */
+
+#include "TBTK/FourierTransform.h"
+#include "TBTK/Solver/ChebyshevExpander.h"
+
+#include <cmath>
+
+using namespace std;
+
+namespace TBTK{
+namespace Solver{
+
+namespace{
+	const complex<double> i(0, 1);
+}
+
+void ChebyshevExpander::calculateChebyshevSumsFFT(
+	const complex<double> *coefficients,
+	int numCoefficients,
+	int numNodes,
+	int sign,
+	vector<complex<double>> &sums
+) const{
+	//With N = 2K, exp(sign*i*n*theta_j) = exp(sign*i*pi*n/N)
+	//*exp(sign*2pi*i*n*j/N). The sum is therefore a discrete Fourier
+	//transform of the twisted coefficients c_n*exp(sign*i*pi*n/N)/d_n,
+	//where coefficients that are equal modulo N are added together.
+	int size = 2*numNodes;
+	vector<complex<double>> twistedCoefficients(size, 0.);
+	for(int n = 0; n < numCoefficients; n++){
+		double denominator = 1.;
+		if(n == 0)
+			denominator = 2.;
+
+		twistedCoefficients[n%size] += coefficients[n]*exp(
+			(double)sign*i*M_PI*(double)n/(double)size
+		)/denominator;
+	}
+
+	sums.resize(size);
+	FourierTransform::Plan<complex<double>> plan(
+		twistedCoefficients.data(),
+		sums.data(),
+		size,
+		sign
+	);
+	plan.setNormalizationFactor(1.);
+	FourierTransform::transform(plan);
+}
+
+};	//End of namespace Solver
+};	//End of namespace TBTK
@@ -0,0 +1,269 @@
+/* Copyright 2018 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file MatsubaraSusceptibilityCalculator.cpp
+ *  @brief Functions of the MatsubaraSusceptibilityCalculator that use
+ *  FourierTransform
+ *
+ *  @author Kristofer Björnson
+ */
+
+#include "TBTK/FourierTransform.h"
+#include "TBTK/RPA/MatsubaraSusceptibilityCalculator.h"
+#include "TBTK/RPA/MomentumSpaceFourierTransform.h"
+
+#include <complex>
+
+using namespace std;
+
+namespace TBTK{
+
+void MatsubaraSusceptibilityCalculator::calculateSusceptibilityMatsubaraFFT(
+	const vector<int> &orbitalIndices
+){
+	calculateGreensFunctionTransform();
+
+	const MomentumSpaceContext &momentumSpaceContext = getMomentumSpaceContext();
+	const vector<vector<double>> &mesh = momentumSpaceContext.getMesh();
+	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+	const vector<complex<double>> &energies = getEnergies();
+	unsigned int numMeshPoints = mesh.size();
+
+	MomentumSpaceFourierTransform momentumSpaceFourierTransform(
+		momentumSpaceContext
+	);
+
+	//The sum over k and n of G_{o3o0}(k, n)G_{o1o2}(k+q, n+e-E/2) is a
+	//correlation, which is the inverse transform of
+	//G_{o3o0}(-f, -g)G_{o1o2}(f, g) in terms of the transforms.
+	const complex<double> *transform0 = &greensFunctionTransform[
+		(size_t)numPaddedEnergies*numMeshPoints*(
+			numOrbitals*orbitalIndices[3] + orbitalIndices[0]
+		)
+	];
+	const complex<double> *transform1 = &greensFunctionTransform[
+		(size_t)numPaddedEnergies*numMeshPoints*(
+			numOrbitals*orbitalIndices[1] + orbitalIndices[2]
+		)
+	];
+	vector<complex<double>> product(
+		(size_t)numPaddedEnergies*numMeshPoints
+	);
+	for(unsigned int g = 0; g < numPaddedEnergies; g++){
+		unsigned int invertedG = (numPaddedEnergies - g)%numPaddedEnergies;
+		for(unsigned int f = 0; f < numMeshPoints; f++){
+			product[(size_t)numMeshPoints*g + f]
+				= transform0[
+					(size_t)numMeshPoints*invertedG
+					+ momentumSpaceFourierTransform.getInvertedGridPoint(f)
+				]*transform1[(size_t)numMeshPoints*g + f];
+		}
+	}
+
+	//Inverse transform with respect to the energy.
+	vector<complex<double>> energyBuffer(numPaddedEnergies);
+	FourierTransform::InversePlan<complex<double>> energyPlan(
+		energyBuffer.data(),
+		energyBuffer.data(),
+		numPaddedEnergies
+	);
+	energyPlan.setNormalizationFactor(1.);
+	for(unsigned int f = 0; f < numMeshPoints; f++){
+		for(unsigned int g = 0; g < numPaddedEnergies; g++){
+			energyBuffer[g]
+				= product[(size_t)numMeshPoints*g + f];
+		}
+		FourierTransform::transform(energyPlan);
+		for(unsigned int g = 0; g < numPaddedEnergies; g++){
+			product[(size_t)numMeshPoints*g + f]
+				= energyBuffer[g];
+		}
+	}
+
+	//Inverse transform with respect to k for the energy differences that
+	//are needed.
+	vector<vector<complex<double>>> results(
+		numMeshPoints,
+		vector<complex<double>>(energies.size())
+	);
+	vector<complex<double>> kBuffer(numMeshPoints);
+	for(unsigned int e = 0; e < energies.size(); e++){
+		int energyDifference = (int)e - (int)energies.size()/2;
+		unsigned int g = (
+			energyDifference + (int)numPaddedEnergies
+		)%numPaddedEnergies;
+		momentumSpaceFourierTransform.inverse(
+			&product[(size_t)numMeshPoints*g],
+			kBuffer.data()
+		);
+		for(unsigned int meshPoint = 0; meshPoint < numMeshPoints; meshPoint++)
+			results[meshPoint][e] = kBuffer[meshPoint];
+	}
+
+	//Normalize the transforms, add the part of the sum that lies outside
+	//of the summation energies, and normalize result.
+	vector<complex<double>> tailCorrections = calculateTailCorrections(
+		orbitalIndices
+	);
+	double temperature = UnitHandler::convertTemperatureNtB(
+		momentumSpaceContext.getModel().getTemperature()
+	);
+	double kT = UnitHandler::getK_BB()*temperature;
+	for(unsigned int meshPoint = 0; meshPoint < numMeshPoints; meshPoint++){
+		for(unsigned int e = 0; e < energies.size(); e++){
+			results[meshPoint][e] = -(
+				results[meshPoint][e]/(
+					(double)numPaddedEnergies*numMeshPoints
+				) + (double)numMeshPoints*tailCorrections[e]
+			)/(numMeshPoints*kT);
+		}
+	}
+
+	//Cache result
+	for(unsigned int meshPoint = 0; meshPoint < numMeshPoints; meshPoint++){
+		Index kIndex = momentumSpaceContext.getKIndex(mesh[meshPoint]);
+		Index resultIndex = getSusceptibilityResultIndex(
+			kIndex,
+			orbitalIndices
+		);
+		cacheSusceptibility(
+			results[meshPoint],
+			mesh[meshPoint],
+			orbitalIndices,
+			kIndex,
+			resultIndex
+		);
+	}
+}
+
+void MatsubaraSusceptibilityCalculator::calculateGreensFunctionTransform(){
+	if(greensFunctionTransform != nullptr)
+		return;
+
+	TBTKAssert(
+		summationEnergies.size() != 0,
+		"MatsubaraSusceptibilityCalculator::calculateGreensFunctionTransform()",
+		"Number of summation energies cannot be zero.",
+		"Use MatsubaraSusceptibilityCalculator::setNumSummationEnergies()"
+		<< " to set the number of summation energies."
+	);
+
+	const MomentumSpaceContext &momentumSpaceContext = getMomentumSpaceContext();
+	const vector<vector<double>> &mesh = momentumSpaceContext.getMesh();
+	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+	unsigned int numMeshPoints = mesh.size();
+
+	//Zero pad the summation energies to avoid wrap around in the
+	//correlation. Padding to a power of two also keeps the transforms
+	//fast.
+	unsigned int maxEnergyDifference = max(
+		getEnergies().size()/2,
+		getEnergies().size() - 1 - getEnergies().size()/2
+	);
+	numPaddedEnergies = 1;
+	while(numPaddedEnergies < summationEnergies.size() + maxEnergyDifference)
+		numPaddedEnergies *= 2;
+
+	MomentumSpaceFourierTransform momentumSpaceFourierTransform(
+		momentumSpaceContext
+	);
+
+	greensFunctionTransform = new complex<double>[
+		(size_t)numOrbitals*numOrbitals*numPaddedEnergies*numMeshPoints
+	];
+
+	vector<complex<double>> energyBuffer(numPaddedEnergies);
+	FourierTransform::ForwardPlan<complex<double>> energyPlan(
+		energyBuffer.data(),
+		energyBuffer.data(),
+		numPaddedEnergies
+	);
+	energyPlan.setNormalizationFactor(1.);
+
+	vector<complex<double>> kBuffer(numMeshPoints);
+	for(unsigned int orbital0 = 0; orbital0 < numOrbitals; orbital0++){
+		for(
+			unsigned int orbital1 = 0;
+			orbital1 < numOrbitals;
+			orbital1++
+		){
+			complex<double> *transform = &greensFunctionTransform[
+				(size_t)numPaddedEnergies*numMeshPoints*(
+					numOrbitals*orbital0 + orbital1
+				)
+			];
+
+			//Transform with respect to k.
+			for(unsigned int g = 0; g < summationEnergies.size(); g++){
+				for(
+					unsigned int meshPoint = 0;
+					meshPoint < numMeshPoints;
+					meshPoint++
+				){
+					kBuffer[meshPoint] = 0.;
+					for(
+						unsigned int state = 0;
+						state < numOrbitals;
+						state++
+					){
+						double energy = momentumSpaceContext.getEnergy(
+							meshPoint,
+							state
+						);
+						complex<double> a0 = momentumSpaceContext.getAmplitude(
+							meshPoint,
+							state,
+							orbital0
+						);
+						complex<double> a1 = momentumSpaceContext.getAmplitude(
+							meshPoint,
+							state,
+							orbital1
+						);
+						kBuffer[meshPoint] += a0*conj(a1)/(
+							summationEnergies[g] - energy
+						);
+					}
+				}
+				momentumSpaceFourierTransform.forward(
+					kBuffer.data(),
+					&transform[(size_t)numMeshPoints*g]
+				);
+			}
+			for(
+				size_t n = (size_t)numMeshPoints*summationEnergies.size();
+				n < (size_t)numMeshPoints*numPaddedEnergies;
+				n++
+			){
+				transform[n] = 0.;
+			}
+
+			//Transform with respect to the energy.
+			for(unsigned int f = 0; f < numMeshPoints; f++){
+				for(unsigned int g = 0; g < numPaddedEnergies; g++){
+					energyBuffer[g]
+						= transform[(size_t)numMeshPoints*g + f];
+				}
+				FourierTransform::transform(energyPlan);
+				for(unsigned int g = 0; g < numPaddedEnergies; g++){
+					transform[(size_t)numMeshPoints*g + f]
+						= energyBuffer[g];
+				}
+			}
+		}
+	}
+}
+
+};	//End of namespace TBTK
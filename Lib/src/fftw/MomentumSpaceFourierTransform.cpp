@@ -0,0 +1,162 @@
+/* Copyright 2018 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file MomentumSpaceFourierTransform.cpp
+ *
+ *  @author Kristofer Björnson
+ */
+
+#include "TBTK/RPA/MomentumSpaceFourierTransform.h"
+
+using namespace std;
+
+namespace TBTK{
+
+MomentumSpaceFourierTransform::MomentumSpaceFourierTransform(
+	const MomentumSpaceContext &momentumSpaceContext
+){
+	const vector<unsigned int> &numMeshPoints
+		= momentumSpaceContext.getNumMeshPoints();
+	const vector<vector<double>> &mesh = momentumSpaceContext.getMesh();
+
+	TBTKAssert(
+		numMeshPoints.size() > 0 && numMeshPoints.size() <= 3,
+		"MomentumSpaceFourierTransform::MomentumSpaceFourierTransform()",
+		"Only one-, two-, and three-dimensional meshes are supported,"
+		<< " but the mesh is " << numMeshPoints.size()
+		<< "-dimensional.",
+		""
+	);
+
+	//The grid is stored in row-major order, which is the order expected
+	//by FourierTransform.
+	unsigned int size = 1;
+	for(unsigned int n = 0; n < numMeshPoints.size(); n++)
+		size *= numMeshPoints[n];
+	TBTKAssert(
+		size == mesh.size(),
+		"MomentumSpaceFourierTransform::MomentumSpaceFourierTransform()",
+		"The number of mesh points does not match the mesh size.",
+		"This should never happen, contact the developer."
+	);
+
+	gridPoints.reserve(size);
+	for(unsigned int n = 0; n < size; n++){
+		Index kIndex = momentumSpaceContext.getKIndex(mesh[n]);
+		unsigned int gridPoint = 0;
+		for(unsigned int c = 0; c < numMeshPoints.size(); c++){
+			int N = numMeshPoints[c];
+			gridPoint = gridPoint*N + ((kIndex[c]%N) + N)%N;
+		}
+		gridPoints.push_back(gridPoint);
+	}
+
+	invertedGridPoints.reserve(size);
+	for(unsigned int n = 0; n < size; n++){
+		unsigned int invertedGridPoint = 0;
+		unsigned int stride = 1;
+		unsigned int remainder = n;
+		for(int c = numMeshPoints.size() - 1; c >= 0; c--){
+			unsigned int N = numMeshPoints[c];
+			unsigned int x = remainder%N;
+			remainder /= N;
+			invertedGridPoint += stride*((N - x)%N);
+			stride *= N;
+		}
+		invertedGridPoints.push_back(invertedGridPoint);
+	}
+
+	input.resize(size);
+	output.resize(size);
+	switch(numMeshPoints.size()){
+	case 1:
+		forwardPlan = new FourierTransform::ForwardPlan<complex<double>>(
+			input.data(),
+			output.data(),
+			numMeshPoints[0]
+		);
+		inversePlan = new FourierTransform::InversePlan<complex<double>>(
+			input.data(),
+			output.data(),
+			numMeshPoints[0]
+		);
+		break;
+	case 2:
+		forwardPlan = new FourierTransform::ForwardPlan<complex<double>>(
+			input.data(),
+			output.data(),
+			numMeshPoints[0],
+			numMeshPoints[1]
+		);
+		inversePlan = new FourierTransform::InversePlan<complex<double>>(
+			input.data(),
+			output.data(),
+			numMeshPoints[0],
+			numMeshPoints[1]
+		);
+		break;
+	case 3:
+		forwardPlan = new FourierTransform::ForwardPlan<complex<double>>(
+			input.data(),
+			output.data(),
+			numMeshPoints[0],
+			numMeshPoints[1],
+			numMeshPoints[2]
+		);
+		inversePlan = new FourierTransform::InversePlan<complex<double>>(
+			input.data(),
+			output.data(),
+			numMeshPoints[0],
+			numMeshPoints[1],
+			numMeshPoints[2]
+		);
+		break;
+	}
+	forwardPlan->setNormalizationFactor(1.);
+	inversePlan->setNormalizationFactor(1.);
+}
+
+MomentumSpaceFourierTransform::~MomentumSpaceFourierTransform(){
+	delete forwardPlan;
+	delete inversePlan;
+}
+
+void MomentumSpaceFourierTransform::forward(
+	const complex<double> *in,
+	complex<double> *out
+){
+	for(unsigned int n = 0; n < gridPoints.size(); n++)
+		input[gridPoints[n]] = in[n];
+
+	FourierTransform::transform(*forwardPlan);
+
+	for(unsigned int n = 0; n < output.size(); n++)
+		out[n] = output[n];
+}
+
+void MomentumSpaceFourierTransform::inverse(
+	const complex<double> *in,
+	complex<double> *out
+){
+	for(unsigned int n = 0; n < input.size(); n++)
+		input[n] = in[n];
+
+	FourierTransform::transform(*inversePlan);
+
+	for(unsigned int n = 0; n < gridPoints.size(); n++)
+		out[n] = output[gridPoints[n]];
+}
+
+};	//End of namespace TBTK
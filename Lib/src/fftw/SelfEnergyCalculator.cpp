@@ -0,0 +1,251 @@
+/* Copyright 2017 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file SelfEnergyCalculator.cpp
+ *  @brief Functions of the SelfEnergyCalculator that use FourierTransform
+ *
+ *  @author Kristofer Björnson
+ */
+
+#include "TBTK/RPA/MomentumSpaceFourierTransform.h"
+#include "TBTK/RPA/SelfEnergyCalculator.h"
+#include "TBTK/UnitHandler.h"
+
+#include <complex>
+
+using namespace std;
+
+namespace TBTK{
+
+void SelfEnergyCalculator::selfEnergyMainLoopFFT(
+	const vector<int> &orbitalIndices
+){
+	const MomentumSpaceContext &momentumSpaceContext = electronFluctuationVertexCalculators[0]->getMomentumSpaceContext();
+	const Model &model = momentumSpaceContext.getModel();
+	const vector<vector<double>> &mesh = momentumSpaceContext.getMesh();
+	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+	unsigned int numMeshPoints = mesh.size();
+	unsigned int numWorkers = electronFluctuationVertexCalculators.size();
+
+	MomentumSpaceFourierTransform momentumSpaceFourierTransform(
+		momentumSpaceContext
+	);
+	if(greensFunctionTransforms.size() == 0)
+		initGreensFunctionTransforms();
+
+	//The sum over q of V(q)G(k-q) is a convolution, which is accumulated
+	//as V(f)G(f) in terms of the transforms.
+	vector<complex<double>> accumulator(
+		(size_t)selfEnergyEnergies.size()*numMeshPoints,
+		0.
+	);
+	vector<complex<double>> selfEnergyVertices(
+		(size_t)numMeshPoints*numSummationEnergies
+	);
+	vector<complex<double>> vertexTransforms(
+		(size_t)numSummationEnergies*numMeshPoints
+	);
+	vector<complex<double>> buffer(numMeshPoints);
+	for(
+		unsigned int propagatorStart = 0;
+		propagatorStart < numOrbitals;
+		propagatorStart++
+	){
+		for(
+			unsigned int propagatorEnd = 0;
+			propagatorEnd < numOrbitals;
+			propagatorEnd++
+		){
+			//Calculate the vertex for every q.
+			#pragma omp parallel for default(none) shared(mesh, numMeshPoints, numWorkers, orbitalIndices, propagatorStart, propagatorEnd, selfEnergyVertices)
+			for(unsigned int worker = 0; worker < numWorkers; worker++){
+				unsigned int blockSize = numMeshPoints/numWorkers;
+				unsigned int begin = worker*blockSize;
+				unsigned int end = (worker+1)*blockSize;
+				if(worker == numWorkers-1)
+					end = numMeshPoints;
+
+				for(unsigned int n = begin; n < end; n++){
+					vector<complex<double>> selfEnergyVertex
+						= electronFluctuationVertexCalculators[worker]->calculateSelfEnergyVertex(
+							mesh.at(n),
+							{
+								(int)propagatorEnd,
+								orbitalIndices[0],
+								(int)propagatorStart,
+								orbitalIndices[1]
+							}
+						);
+					for(
+						unsigned int e0 = 0;
+						e0 < numSummationEnergies;
+						e0++
+					){
+						selfEnergyVertices[
+							(size_t)numSummationEnergies*n
+							+ e0
+						] = selfEnergyVertex[e0];
+					}
+				}
+			}
+
+			bool vertexIsZero = true;
+			for(unsigned int n = 0; n < selfEnergyVertices.size(); n++){
+				if(selfEnergyVertices[n] != 0.){
+					vertexIsZero = false;
+					break;
+				}
+			}
+			if(vertexIsZero)
+				continue;
+
+			for(unsigned int e0 = 0; e0 < numSummationEnergies; e0++){
+				for(unsigned int n = 0; n < numMeshPoints; n++){
+					buffer[n] = selfEnergyVertices[
+						(size_t)numSummationEnergies*n + e0
+					];
+				}
+				momentumSpaceFourierTransform.forward(
+					buffer.data(),
+					&vertexTransforms[(size_t)numMeshPoints*e0]
+				);
+			}
+
+			//Accumulate the product of the transforms.
+			if(
+				greensFunctionTransforms[
+					numOrbitals*propagatorStart + propagatorEnd
+				].size() == 0
+			){
+				calculateGreensFunctionTransforms(
+					propagatorStart,
+					propagatorEnd,
+					momentumSpaceFourierTransform
+				);
+			}
+			const vector<complex<double>> &greensFunctionTransform
+				= greensFunctionTransforms[
+					numOrbitals*propagatorStart + propagatorEnd
+				];
+			for(unsigned int e0 = 0; e0 < numSummationEnergies; e0++){
+				for(
+					unsigned int e1 = 0;
+					e1 < selfEnergyEnergies.size();
+					e1++
+				){
+					complex<double> *a = &accumulator[
+						(size_t)numMeshPoints*e1
+					];
+					const complex<double> *v = &vertexTransforms[
+						(size_t)numMeshPoints*e0
+					];
+					const complex<double> *g
+						= &greensFunctionTransform[
+							(size_t)numMeshPoints
+							*greensFunctionEnergyIndices[
+								selfEnergyEnergies.size()*e0
+								+ e1
+							]
+						];
+					for(unsigned int f = 0; f < numMeshPoints; f++)
+						a[f] += v[f]*g[f];
+				}
+			}
+		}
+	}
+
+	//Calculate kT
+	double temperature = UnitHandler::convertTemperatureNtB(
+		model.getTemperature()
+	);
+	double kT = UnitHandler::getK_BB()*temperature;
+
+	//Transform back and cache the result. The inverse transform is not
+	//normalized, which gives an additional factor numMeshPoints.
+	vector<SerializableVector<complex<double>>> results(
+		numMeshPoints,
+		SerializableVector<complex<double>>()
+	);
+	for(unsigned int e1 = 0; e1 < selfEnergyEnergies.size(); e1++){
+		momentumSpaceFourierTransform.inverse(
+			&accumulator[(size_t)numMeshPoints*e1],
+			buffer.data()
+		);
+		for(unsigned int n = 0; n < numMeshPoints; n++){
+			results[n].push_back(
+				buffer[n]*kT/((double)numMeshPoints*numMeshPoints)
+			);
+		}
+	}
+	for(unsigned int n = 0; n < numMeshPoints; n++){
+		selfEnergyTree.add(
+			results[n],
+			Index(
+				momentumSpaceContext.getKIndex(mesh[n]),
+				{orbitalIndices.at(0), orbitalIndices.at(1)}
+			)
+		);
+	}
+}
+
+void SelfEnergyCalculator::calculateGreensFunctionTransforms(
+	unsigned int propagatorStart,
+	unsigned int propagatorEnd,
+	MomentumSpaceFourierTransform &momentumSpaceFourierTransform
+){
+	const MomentumSpaceContext &momentumSpaceContext = electronFluctuationVertexCalculators[0]->getMomentumSpaceContext();
+	const Model &model = momentumSpaceContext.getModel();
+	unsigned int numOrbitals = momentumSpaceContext.getNumOrbitals();
+	unsigned int numMeshPoints = momentumSpaceContext.getMesh().size();
+
+	vector<complex<double>> &greensFunctionTransform
+		= greensFunctionTransforms[
+			numOrbitals*propagatorStart + propagatorEnd
+		];
+	greensFunctionTransform.resize(
+		(size_t)numMeshPoints*greensFunctionEnergies.size()
+	);
+	for(unsigned int e = 0; e < greensFunctionEnergies.size(); e++){
+		complex<double> E = greensFunctionEnergies[e]
+			+ model.getChemicalPotential();
+		complex<double> *g
+			= &greensFunctionTransform[(size_t)numMeshPoints*e];
+		for(unsigned int n = 0; n < numMeshPoints; n++){
+			g[n] = 0.;
+			for(
+				unsigned int state = 0;
+				state < numOrbitals;
+				state++
+			){
+				complex<double> a0 = momentumSpaceContext.getAmplitude(
+					n,
+					state,
+					propagatorEnd
+				);
+				complex<double> a1 = momentumSpaceContext.getAmplitude(
+					n,
+					state,
+					propagatorStart
+				);
+				g[n] += a0*conj(a1)/(
+					E - momentumSpaceContext.getEnergy(n, state)
+				);
+			}
+		}
+		momentumSpaceFourierTransform.forward(g, g);
+	}
+}
+
+};	//End of namespace TBTK
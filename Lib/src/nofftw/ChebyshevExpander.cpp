@@ -0,0 +1,46 @@
+/* Copyright 2016 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file ChebyshevExpander.cpp
+ *  @brief Dummy functions to allow for compilation without FFTW3
+ *
+ *  @author Kristofer Björnson
+ */
+
+#include "TBTK/Solver/ChebyshevExpander.h"
+#include "TBTK/TBTKMacros.h"
+
+using namespace std;
+
+namespace TBTK{
+namespace Solver{
+
+void ChebyshevExpander::calculateChebyshevSumsFFT(
+	const complex<double> *coefficients,
+	int numCoefficients,
+	int numNodes,
+	int sign,
+	vector<complex<double>> &sums
+) const{
+	TBTKExit(
+		"ChebyshevExpander::calculateChebyshevSumsFFT()",
+		"FFTW3 not supported.",
+		"Install with FFTW3 support or use"
+		<< " ChebyshevExpander::generateGreensFunction()."
+	);
+}
+
+};	//End of namespace Solver
+};	//End of namespace TBTK
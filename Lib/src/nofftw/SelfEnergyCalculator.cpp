@@ -0,0 +1,39 @@
+/* Copyright 2017 Kristofer Björnson
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file SelfEnergyCalculator.cpp
+ *  @brief Dummy functions to allow for compilation without FFTW3
+ *
+ *  @author Kristofer Björnson
+ */
+
+#include "TBTK/RPA/SelfEnergyCalculator.h"
+#include "TBTK/TBTKMacros.h"
+
+using namespace std;
+
+namespace TBTK{
+
+void SelfEnergyCalculator::selfEnergyMainLoopFFT(
+	const vector<int> &orbitalIndices
+){
+	TBTKExit(
+		"SelfEnergyCalculator::selfEnergyMainLoopFFT()",
+		"FFTW3 not supported.",
+		"Install with FFTW3 support or use another algorithm."
+	);
+}
+
+};	//End of namespace TBTK
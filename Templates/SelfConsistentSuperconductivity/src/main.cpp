@@ -30,6 +30,7 @@
 
 #include <complex>
 #include <iostream>
+#include <vector>
 
 using namespace std;
 using namespace TBTK;
@@ -40,12 +41,8 @@ const complex<double> i(0, 1);
 const int SIZE_X = 20;
 const int SIZE_Y = 20;
 
-//Order parameter. The two buffers are alternatively swaped by setting dCounter
-// = 0 or 1. One buffer contains the order parameter used in the previous
-//calculation, while the other is used to store the newly obtained order
-//parameter that will be used in the next calculation.
-complex<double> D[2][SIZE_X][SIZE_Y];
-int dCounter = 0;
+//Order parameter, stored as D[x*SIZE_Y + y].
+vector<complex<double>> D(SIZE_X*SIZE_Y);
 
 //Superconducting pair potential, convergence limit, max iterations, and initial guess
 const double V_sc = 2.;
@@ -53,16 +50,12 @@ const double CONVERGENCE_LIMIT = 0.0001;
 const int MAX_ITERATIONS = 50;
 const complex<double> D_INITIAL_GUESS = 0.3;
 
-//Self-consistent callback that is to be called each time a diagonalization has
-//finished. Calculates the order parameter from the current solution.
-bool scCallback(Solver::Diagonalizer &dSolver){
-	//Clear the order parameter
-	for(int x = 0; x < SIZE_X; x++){
-		for(int y = 0; y < SIZE_Y; y++){
-			D[(dCounter+1)%2][x][y] = 0.;
-		}
-	}
-
+//Callback that is called each time a diagonalization has finished. Calculates
+//the order parameter from the current solution.
+void calculateD(
+	Solver::Diagonalizer &dSolver,
+	vector<complex<double>> &orderParameter
+){
 	//Calculate D(x, y) = <c_{x, y, \downarrow}c_{x, y, \uparrow}> = \sum_{E_n<E_F} conj(v_d^{(n)})*u_u^{(n)}
 	for(int x = 0; x < SIZE_X; x++){
 		for(int y = 0; y < SIZE_Y; y++){
@@ -71,34 +64,20 @@ bool scCallback(Solver::Diagonalizer &dSolver){
 				complex<double> u_u = dSolver.getAmplitude(n, {x, y, 0});
 				complex<double> v_d = dSolver.getAmplitude(n, {x, y, 3});
 
-				D[(dCounter+1)%2][x][y] -= V_sc*conj(v_d)*u_u;
+				orderParameter[x*SIZE_Y + y] -= V_sc*conj(v_d)*u_u;
 			}
 		}
 	}
+}
 
-	//Swap order parameter buffers
-	dCounter = (dCounter+1)%2;
-
-	//Calculate convergence parameter
-	double maxError = 0.;
-	for(int x = 0; x < SIZE_X; x++){
-		for(int y = 0; y < SIZE_Y; y++){
-			double error = 0.;
-			if(abs(D[dCounter][x][y]) == 0 && abs(D[(dCounter+1)%2][x][y]) == 0)
-				error = 0.;
-			else
-				error = abs(D[dCounter][x][y] - D[(dCounter+1)%2][x][y])/max(abs(D[dCounter][x][y]), abs(D[(dCounter+1)%2][x][y]));
-
-			if(error > maxError)
-				maxError = error;
-		}
-	}
-
-	//Return true or false depending on whether the result has converged or not
-	if(maxError < CONVERGENCE_LIMIT)
-		return true;
-	else
-		return false;
+//Callback that is called by the Diagonalizer to set the order parameter that
+//is used in the next diagonalization. The Diagonalizer uses Anderson mixing to
+//obtain the new order parameter from the previous iterations.
+void setD(
+	Solver::Diagonalizer &dSolver,
+	const vector<complex<double>> &orderParameter
+){
+	D = orderParameter;
 }
 
 //Callback function responsible for determining the value of the order
@@ -113,27 +92,18 @@ complex<double> fD(const Index &to, const Index &from){
 	//Return appropriate amplitude
 	switch(s){
 		case 0:
-			return conj(D[dCounter][x][y]);
+			return conj(D[x*SIZE_Y + y]);
 		case 1:
-			return -conj(D[dCounter][x][y]);
+			return -conj(D[x*SIZE_Y + y]);
 		case 2:
-			return -D[dCounter][x][y];
+			return -D[x*SIZE_Y + y];
 		case 3:
-			return D[dCounter][x][y];
+			return D[x*SIZE_Y + y];
 		default://Never happens
 			return 0;
 	}
 }
 
-//Function responsible for initializing the order parameter
-void initD(){
-	for(int x = 0; x < SIZE_X; x++){
-		for(int y = 0; y < SIZE_Y; y++){
-			D[0][x][y] = D_INITIAL_GUESS;
-		}
-	}
-}
-
 int main(int argc, char **argv){
 	//Parameters
 	complex<double> mu = -1.0;
@@ -165,27 +135,31 @@ int main(int argc, char **argv){
 	//Construct model
 	model.construct();
 
-	//Initialize D
-	initD();
-
 	//Setup and run Solver::Diagonalizer
 	Solver::Diagonalizer dSolver;
 	dSolver.setModel(model);
 	dSolver.setMaxIterations(MAX_ITERATIONS);
-	dSolver.setSelfConsistencyCallback(scCallback);
+	dSolver.setConvergenceLimit(CONVERGENCE_LIMIT);
+	dSolver.setOrderParameterCallbacks(
+		vector<complex<double>>(SIZE_X*SIZE_Y, D_INITIAL_GUESS),
+		calculateD,
+		setD
+	);
 	dSolver.run();
 
 	//Set filename and remove any file already in the folder
 	FileWriter::setFileName("TBTKResults.h5");
 	FileWriter::clear();
 
-	//Calculate abs(D) and arg(D)
+	//Calculate abs(D) and arg(D) for the order parameter calculated from
+	//the final solution. (The global D holds the last mixed input.)
+	const vector<complex<double>> &DFinal = dSolver.getOrderParameter();
 	double D_abs[SIZE_X*SIZE_Y];
 	double D_arg[SIZE_X*SIZE_Y];
 	for(int x = 0; x < SIZE_X; x++){
 		for(int y = 0; y < SIZE_Y; y++){
-			D_abs[x*SIZE_Y + y] = abs(D[dCounter][x][y]);
-			D_arg[x*SIZE_Y + y] = arg(D[dCounter][x][y]);
+			D_abs[x*SIZE_Y + y] = abs(DFinal[x*SIZE_Y + y]);
+			D_arg[x*SIZE_Y + y] = arg(DFinal[x*SIZE_Y + y]);
 		}
 	}
 
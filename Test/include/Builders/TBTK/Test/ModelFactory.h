@@ -0,0 +1,139 @@
+#include "TBTK/BasicState.h"
+#include "TBTK/ModelFactory.h"
+#include "TBTK/StateSet.h"
+
+#include "gtest/gtest.h"
+
+#include <map>
+#include <string>
+
+#ifdef TBTK_USE_OPEN_MP
+#include <omp.h>
+#endif
+
+namespace TBTK{
+
+//Chain of BasicStates with two orbitals per site and matrix elements
+//between nearest neighbors.
+void createModelFactoryTestStateSet(StateSet &stateSet, int size){
+	for(int x = 0; x < size; x++){
+		for(int orbital = 0; orbital < 2; orbital++){
+			BasicState *state = new BasicState({x, orbital});
+			state->setCoordinates({(double)x});
+			state->setSpecifiers({orbital});
+			state->setExtent(1.5);
+
+			//Added in reversed order to require sorting.
+			if(x + 1 < size){
+				state->addMatrixElement(
+					std::complex<double>(-1, 0.1*x),
+					{x + 1, 1 - orbital}
+				);
+				state->addMatrixElement(-1, {x + 1, orbital});
+			}
+			if(x > 0){
+				state->addMatrixElement(
+					std::complex<double>(-1, -0.1*(x - 1)),
+					{x - 1, 1 - orbital}
+				);
+				state->addMatrixElement(-1, {x - 1, orbital});
+			}
+			state->addMatrixElement(0.5, {x, 1 - orbital});
+			state->addMatrixElement(1 + 0.1*x + orbital, {x, orbital});
+
+			stateSet.addState(state);
+		}
+	}
+}
+
+//Collects the HoppingAmplitudes of a Model, keyed on their indices.
+std::map<std::string, std::complex<double>> getModelFactoryTestAmplitudes(
+	const Model &model
+){
+	std::map<std::string, std::complex<double>> amplitudes;
+	HoppingAmplitudeSet::Iterator iterator
+		= model.getHoppingAmplitudeSet()->getIterator();
+	const HoppingAmplitude *hoppingAmplitude;
+	while((hoppingAmplitude = iterator.getHA())){
+		amplitudes[
+			hoppingAmplitude->getToIndex().toString()
+			+ hoppingAmplitude->getFromIndex().toString()
+		] += hoppingAmplitude->getAmplitude();
+		iterator.searchNextHA();
+	}
+
+	return amplitudes;
+}
+
+TEST(ModelFactory, createModel){
+	const int SIZE = 50;
+
+	//Reference obtained by evaluating the matrix element between every
+	//pair of states.
+	StateSet referenceStateSet;
+	createModelFactoryTestStateSet(referenceStateSet, SIZE);
+	std::map<std::string, std::complex<double>> referenceAmplitudes;
+	const std::vector<AbstractState*> &states
+		= referenceStateSet.getStates();
+	for(unsigned int from = 0; from < states.size(); from++){
+		for(unsigned int to = 0; to < states.size(); to++){
+			std::complex<double> amplitude
+				= states[from]->getMatrixElement(*states[to]);
+			if(amplitude != 0.){
+				referenceAmplitudes[
+					Index(
+						states[to]->getContainer(),
+						states[to]->getIndex()
+					).toString()
+					+ Index(
+						states[from]->getContainer(),
+						states[from]->getIndex()
+					).toString()
+				] = amplitude;
+			}
+		}
+	}
+	EXPECT_EQ(
+		referenceAmplitudes.size(),
+		(unsigned int)(4*SIZE + 8*(SIZE - 1))
+	);
+
+	//The matrix elements are only evaluated between overlapping states,
+	//which gives the same result as evaluating all pairs. The result is
+	//also independent of the number of threads. A new StateSet is used
+	//for each run to also test the lazy sorting of the matrix elements.
+	std::vector<int> numThreads = {1};
+#ifdef TBTK_USE_OPEN_MP
+	int maxThreads = omp_get_max_threads();
+	numThreads.push_back(maxThreads > 1 ? maxThreads : 4);
+#endif
+	for(unsigned int n = 0; n < numThreads.size(); n++){
+#ifdef TBTK_USE_OPEN_MP
+		omp_set_num_threads(numThreads[n]);
+#endif
+		StateSet stateSet;
+		createModelFactoryTestStateSet(stateSet, SIZE);
+		Model *model = ModelFactory::createModel(stateSet);
+		std::map<std::string, std::complex<double>> amplitudes
+			= getModelFactoryTestAmplitudes(*model);
+		EXPECT_EQ(amplitudes.size(), referenceAmplitudes.size());
+		for(auto &amplitude : referenceAmplitudes){
+			auto iterator = amplitudes.find(amplitude.first);
+			ASSERT_TRUE(iterator != amplitudes.end());
+			EXPECT_DOUBLE_EQ(
+				real(iterator->second),
+				real(amplitude.second)
+			);
+			EXPECT_DOUBLE_EQ(
+				imag(iterator->second),
+				imag(amplitude.second)
+			);
+		}
+		delete model;
+#ifdef TBTK_USE_OPEN_MP
+		omp_set_num_threads(maxThreads);
+#endif
+	}
+}
+
+};
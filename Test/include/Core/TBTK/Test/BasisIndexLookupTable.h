@@ -0,0 +1,112 @@
+#include "TBTK/BasisIndexLookupTable.h"
+
+#include "gtest/gtest.h"
+
+namespace TBTK{
+
+TEST(BasisIndexLookupTable, Constructor){
+	BasisIndexLookupTable basisIndexLookupTable;
+	EXPECT_FALSE(basisIndexLookupTable.getIsGenerated());
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({0, 0, 0}), -1);
+}
+
+TEST(BasisIndexLookupTable, generate){
+	HoppingAmplitudeTree hoppingAmplitudeTree;
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {0, 0, 0}, {0, 0, 0}));
+	BasisIndexLookupTable basisIndexLookupTable;
+
+	EXPECT_EXIT(
+		{
+			Streams::setStdMuteErr();
+			basisIndexLookupTable.generate(hoppingAmplitudeTree);
+		},
+		::testing::ExitedWithCode(1),
+		""
+	);
+
+	hoppingAmplitudeTree.generateBasisIndices();
+	basisIndexLookupTable.generate(hoppingAmplitudeTree);
+	EXPECT_TRUE(basisIndexLookupTable.getIsGenerated());
+
+	basisIndexLookupTable.clear();
+	EXPECT_FALSE(basisIndexLookupTable.getIsGenerated());
+}
+
+TEST(BasisIndexLookupTable, getBasisIndex){
+	HoppingAmplitudeTree hoppingAmplitudeTree;
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {0, 0, 0}, {0, 0, 0}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {0, 0, 1}, {0, 0, 1}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {0, 0, 1}, {0, 0, 2}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {0, 0, 2}, {0, 0, 1}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {1, 1, 0}, {1, 1, 0}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {1, 1, 0}, {1, 1, 1}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {1, 1, 1}, {1, 1, 0}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {2, 0}, {2, 0}));
+	hoppingAmplitudeTree.generateBasisIndices();
+
+	BasisIndexLookupTable basisIndexLookupTable;
+	basisIndexLookupTable.generate(hoppingAmplitudeTree);
+
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({0, 0, 0}), 0);
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({0, 0, 1}), 1);
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({0, 0, 2}), 2);
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({1, 1, 0}), 3);
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({1, 1, 1}), 4);
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({2, 0}), 5);
+
+	//Indices that are not part of the basis.
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({0, 0}), -1);
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({0, 0, 3}), -1);
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({2, 0, 0}), -1);
+	EXPECT_EQ(basisIndexLookupTable.getBasisIndex({}), -1);
+}
+
+TEST(BasisIndexLookupTable, getPhysicalIndex){
+	HoppingAmplitudeTree hoppingAmplitudeTree;
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {0, 0, 0}, {0, 0, 0}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {0, 0, 1}, {0, 0, 1}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {0, 0, 1}, {0, 0, 2}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {0, 0, 2}, {0, 0, 1}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {1, 1, 0}, {1, 1, 0}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {1, 1, 0}, {1, 1, 1}));
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {1, 1, 1}, {1, 1, 0}));
+	hoppingAmplitudeTree.generateBasisIndices();
+
+	BasisIndexLookupTable basisIndexLookupTable;
+	basisIndexLookupTable.generate(hoppingAmplitudeTree);
+
+	EXPECT_TRUE(basisIndexLookupTable.getPhysicalIndex(0).equals({0, 0, 0}));
+	EXPECT_TRUE(basisIndexLookupTable.getPhysicalIndex(1).equals({0, 0, 1}));
+	EXPECT_TRUE(basisIndexLookupTable.getPhysicalIndex(2).equals({0, 0, 2}));
+	EXPECT_TRUE(basisIndexLookupTable.getPhysicalIndex(3).equals({1, 1, 0}));
+	EXPECT_TRUE(basisIndexLookupTable.getPhysicalIndex(4).equals({1, 1, 1}));
+	EXPECT_EXIT(
+		{
+			Streams::setStdMuteErr();
+			basisIndexLookupTable.getPhysicalIndex(-1);
+		},
+		::testing::ExitedWithCode(1),
+		""
+	);
+	EXPECT_EXIT(
+		{
+			Streams::setStdMuteErr();
+			basisIndexLookupTable.getPhysicalIndex(5);
+		},
+		::testing::ExitedWithCode(1),
+		""
+	);
+}
+
+TEST(BasisIndexLookupTable, getSizeInBytes){
+	HoppingAmplitudeTree hoppingAmplitudeTree;
+	hoppingAmplitudeTree.add(HoppingAmplitude(1, {0, 0, 0}, {0, 0, 0}));
+	hoppingAmplitudeTree.generateBasisIndices();
+
+	BasisIndexLookupTable basisIndexLookupTable;
+	unsigned int emptySize = basisIndexLookupTable.getSizeInBytes();
+	basisIndexLookupTable.generate(hoppingAmplitudeTree);
+	EXPECT_TRUE(basisIndexLookupTable.getSizeInBytes() > emptySize);
+}
+
+};
@@ -2,6 +2,8 @@
 
 #include "gtest/gtest.h"
 
+#include <type_traits>
+
 namespace TBTK{
 
 TEST(HoppingAmplitude, ConstructorAmplitude){
@@ -48,6 +50,21 @@ TEST(HoppingAmplitude, CopyConstructor){
 	EXPECT_TRUE(hoppingAmplitude3.getFromIndex().equals({3, 4, 5})) << errorMessage;
 }
 
+TEST(HoppingAmplitude, MoveConstructor){
+	std::string errorMessage = "Move constructor failed.";
+
+	//std::vector only moves elements on reallocation if the move
+	//constructor is noexcept.
+	EXPECT_TRUE(std::is_nothrow_move_constructible<HoppingAmplitude>::value) << errorMessage;
+	EXPECT_TRUE(std::is_nothrow_move_assignable<HoppingAmplitude>::value) << errorMessage;
+
+	HoppingAmplitude hoppingAmplitude0(std::complex<double>(1, 2), {1, 2, 3}, {4, 5});
+	HoppingAmplitude hoppingAmplitude1 = std::move(hoppingAmplitude0);
+	EXPECT_EQ(hoppingAmplitude1.getAmplitude(), std::complex<double>(1, 2)) << errorMessage;
+	EXPECT_TRUE(hoppingAmplitude1.getToIndex().equals({1, 2, 3})) << errorMessage;
+	EXPECT_TRUE(hoppingAmplitude1.getFromIndex().equals({4, 5})) << errorMessage;
+}
+
 TEST(HoppingAmplitude, SerializeToJSON){
 	std::string errorMessage = "JSON serialization failed.";
 
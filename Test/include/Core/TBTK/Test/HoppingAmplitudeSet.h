@@ -0,0 +1,304 @@
+#include "TBTK/HoppingAmplitudeSet.h"
+
+#include "gtest/gtest.h"
+
+namespace TBTK{
+
+TEST(HoppingAmplitudeSet, getSparseMatrix){
+	HoppingAmplitudeSet hoppingAmplitudeSet;
+	hoppingAmplitudeSet.addHoppingAmplitude(
+		HoppingAmplitude(1, {0}, {0})
+	);
+	hoppingAmplitudeSet.addHoppingAmplitude(
+		HoppingAmplitude(2, {0}, {1})
+	);
+	hoppingAmplitudeSet.addHoppingAmplitude(
+		HoppingAmplitude(3, {0}, {1})
+	);
+	hoppingAmplitudeSet.addHoppingAmplitude(
+		HoppingAmplitude(4, {2}, {1})
+	);
+	hoppingAmplitudeSet.addHoppingAmplitude(
+		HoppingAmplitude(5, {1}, {2})
+	);
+
+	EXPECT_EXIT(
+		{
+			Streams::setStdMuteErr();
+			hoppingAmplitudeSet.getSparseMatrix();
+		},
+		::testing::ExitedWithCode(1),
+		""
+	);
+
+	hoppingAmplitudeSet.construct();
+	std::shared_ptr<const SparseMatrix<std::complex<double>>> sparseMatrix
+		= hoppingAmplitudeSet.getSparseMatrix();
+
+	//Rows correspond to 'to'-indices and columns to 'from'-indices.
+	//Amplitudes with the same indices are added.
+	EXPECT_EQ(sparseMatrix->getNumRows(), 3u);
+	EXPECT_EQ(sparseMatrix->getNumColumns(), 3u);
+	EXPECT_EQ(sparseMatrix->getCSRNumMatrixElements(), 4u);
+	const unsigned int *rowPointers = sparseMatrix->getCSRRowPointers();
+	const unsigned int *columns = sparseMatrix->getCSRColumns();
+	const std::complex<double> *values = sparseMatrix->getCSRValues();
+	EXPECT_EQ(rowPointers[0], 0u);
+	EXPECT_EQ(rowPointers[1], 2u);
+	EXPECT_EQ(rowPointers[2], 3u);
+	EXPECT_EQ(rowPointers[3], 4u);
+	EXPECT_EQ(columns[0], 0u);
+	EXPECT_EQ(columns[1], 1u);
+	EXPECT_EQ(columns[2], 2u);
+	EXPECT_EQ(columns[3], 1u);
+	EXPECT_DOUBLE_EQ(real(values[0]), 1);
+	EXPECT_DOUBLE_EQ(real(values[1]), 5);
+	EXPECT_DOUBLE_EQ(real(values[2]), 5);
+	EXPECT_DOUBLE_EQ(real(values[3]), 4);
+
+	//The matrix is cached.
+	EXPECT_EQ(
+		hoppingAmplitudeSet.getSparseMatrix().get(),
+		sparseMatrix.get()
+	);
+}
+
+std::complex<double> sparseMatrixCallbackValue = 1;
+std::complex<double> sparseMatrixCallback(const Index &to, const Index &from){
+	return sparseMatrixCallbackValue;
+}
+
+TEST(HoppingAmplitudeSet, invalidateSparseMatrix){
+	HoppingAmplitudeSet hoppingAmplitudeSet;
+	hoppingAmplitudeSet.addHoppingAmplitude(HoppingAmplitude(1, {0}, {0}));
+	hoppingAmplitudeSet.construct();
+
+	//Invalidation forces the matrix to be reconstructed, while
+	//previously returned matrices remain valid.
+	std::shared_ptr<const SparseMatrix<std::complex<double>>> sparseMatrix
+		= hoppingAmplitudeSet.getSparseMatrix();
+	hoppingAmplitudeSet.invalidateSparseMatrix();
+	EXPECT_NE(
+		hoppingAmplitudeSet.getSparseMatrix().get(),
+		sparseMatrix.get()
+	);
+	EXPECT_DOUBLE_EQ(real(sparseMatrix->getCSRValues()[0]), 1);
+}
+
+TEST(HoppingAmplitudeSet, getSparseMatrixCallback){
+	HoppingAmplitudeSet hoppingAmplitudeSet;
+	hoppingAmplitudeSet.addHoppingAmplitude(
+		HoppingAmplitude(sparseMatrixCallback, {0}, {0})
+	);
+	hoppingAmplitudeSet.construct();
+
+	//Amplitudes given by callbacks are reevaluated on every call.
+	sparseMatrixCallbackValue = 1;
+	EXPECT_DOUBLE_EQ(
+		real(hoppingAmplitudeSet.getSparseMatrix()->getCSRValues()[0]),
+		1
+	);
+	sparseMatrixCallbackValue = 2;
+	EXPECT_DOUBLE_EQ(
+		real(hoppingAmplitudeSet.getSparseMatrix()->getCSRValues()[0]),
+		2
+	);
+}
+
+TEST(HoppingAmplitudeSet, getHash){
+	HoppingAmplitudeSet hoppingAmplitudeSet0;
+	hoppingAmplitudeSet0.addHoppingAmplitudeAndHermitianConjugate(
+		HoppingAmplitude(1, {0}, {1})
+	);
+	hoppingAmplitudeSet0.construct();
+
+	HoppingAmplitudeSet hoppingAmplitudeSet1;
+	hoppingAmplitudeSet1.addHoppingAmplitudeAndHermitianConjugate(
+		HoppingAmplitude(1, {0}, {1})
+	);
+	hoppingAmplitudeSet1.construct();
+
+	//Different amplitude.
+	HoppingAmplitudeSet hoppingAmplitudeSet2;
+	hoppingAmplitudeSet2.addHoppingAmplitudeAndHermitianConjugate(
+		HoppingAmplitude(2, {0}, {1})
+	);
+	hoppingAmplitudeSet2.construct();
+
+	//Same matrix, but different basis.
+	HoppingAmplitudeSet hoppingAmplitudeSet3;
+	hoppingAmplitudeSet3.addHoppingAmplitudeAndHermitianConjugate(
+		HoppingAmplitude(1, {0}, {2})
+	);
+	hoppingAmplitudeSet3.construct();
+
+	EXPECT_EQ(hoppingAmplitudeSet0.getHash(), hoppingAmplitudeSet1.getHash());
+	EXPECT_NE(hoppingAmplitudeSet0.getHash(), hoppingAmplitudeSet2.getHash());
+	EXPECT_NE(hoppingAmplitudeSet0.getHash(), hoppingAmplitudeSet3.getHash());
+}
+
+//Two decoupled strips for which the lexicographic order results in a large
+//bandwidth.
+HoppingAmplitudeSet createBasisOrderingTestSet(
+	HoppingAmplitudeSet::BasisOrdering basisOrdering,
+	int sizeX,
+	int sizeY
+){
+	HoppingAmplitudeSet hoppingAmplitudeSet;
+	for(int s = 0; s < 2; s++){
+		for(int x = 0; x < sizeX; x++){
+			for(int y = 0; y < sizeY; y++){
+				if(x+1 < sizeX){
+					hoppingAmplitudeSet.addHoppingAmplitudeAndHermitianConjugate(
+						HoppingAmplitude(1, {s, y, x+1}, {s, y, x})
+					);
+				}
+				if(y+1 < sizeY){
+					hoppingAmplitudeSet.addHoppingAmplitudeAndHermitianConjugate(
+						HoppingAmplitude(1, {s, y+1, x}, {s, y, x})
+					);
+				}
+			}
+		}
+	}
+	hoppingAmplitudeSet.setBasisOrdering(basisOrdering);
+	hoppingAmplitudeSet.construct();
+
+	return hoppingAmplitudeSet;
+}
+
+TEST(HoppingAmplitudeSet, setBasisOrdering){
+	const int SIZE_X = 20;
+	const int SIZE_Y = 2;
+	for(
+		HoppingAmplitudeSet::BasisOrdering basisOrdering
+		: {
+			HoppingAmplitudeSet::BasisOrdering::ReverseCuthillMcKee,
+			HoppingAmplitudeSet::BasisOrdering::Morton
+		}
+	){
+		HoppingAmplitudeSet hoppingAmplitudeSet
+			= createBasisOrderingTestSet(
+				basisOrdering,
+				SIZE_X,
+				SIZE_Y
+			);
+		EXPECT_TRUE(
+			hoppingAmplitudeSet.getBasisOrdering() == basisOrdering
+		);
+
+		//The basis indices and physical indices are consistent.
+		for(int n = 0; n < hoppingAmplitudeSet.getBasisSize(); n++){
+			EXPECT_EQ(
+				hoppingAmplitudeSet.getBasisIndex(
+					hoppingAmplitudeSet.getPhysicalIndex(n)
+				),
+				n
+			);
+		}
+
+		//The blocks remain contiguous.
+		for(int s = 0; s < 2; s++){
+			for(int x = 0; x < SIZE_X; x++){
+				for(int y = 0; y < SIZE_Y; y++){
+					int basisIndex
+						= hoppingAmplitudeSet.getBasisIndex(
+							{s, y, x}
+						);
+					EXPECT_GE(
+						basisIndex,
+						hoppingAmplitudeSet.getFirstIndexInBlock({s})
+					);
+					EXPECT_LE(
+						basisIndex,
+						hoppingAmplitudeSet.getLastIndexInBlock({s})
+					);
+				}
+			}
+		}
+
+		//The bandwidth is reduced.
+		std::shared_ptr<const SparseMatrix<std::complex<double>>>
+			sparseMatrix = hoppingAmplitudeSet.getSparseMatrix();
+		const unsigned int *rowPointers
+			= sparseMatrix->getCSRRowPointers();
+		const unsigned int *columns = sparseMatrix->getCSRColumns();
+		int bandwidth = 0;
+		for(int row = 0; row < hoppingAmplitudeSet.getBasisSize(); row++){
+			for(
+				unsigned int n = rowPointers[row];
+				n < rowPointers[row+1];
+				n++
+			){
+				bandwidth = std::max(
+					bandwidth,
+					std::abs(row - (int)columns[n])
+				);
+			}
+		}
+		EXPECT_LT(bandwidth, SIZE_X);
+
+		//The ordering is preserved by serialization.
+		HoppingAmplitudeSet deserializedHoppingAmplitudeSet(
+			hoppingAmplitudeSet.serialize(Serializable::Mode::JSON),
+			Serializable::Mode::JSON
+		);
+		EXPECT_TRUE(
+			deserializedHoppingAmplitudeSet.getBasisOrdering()
+			== basisOrdering
+		);
+		ASSERT_EQ(
+			deserializedHoppingAmplitudeSet.getBasisSize(),
+			hoppingAmplitudeSet.getBasisSize()
+		);
+		for(int n = 0; n < hoppingAmplitudeSet.getBasisSize(); n++){
+			Index index = hoppingAmplitudeSet.getPhysicalIndex(n);
+			EXPECT_TRUE(
+				deserializedHoppingAmplitudeSet.getPhysicalIndex(
+					n
+				).equals(index)
+			);
+			EXPECT_EQ(
+				deserializedHoppingAmplitudeSet.getBasisIndex(index),
+				n
+			);
+		}
+
+		//Fails when the HoppingAmplitudeSet already is constructed.
+		EXPECT_EXIT(
+			{
+				Streams::setStdMuteErr();
+				hoppingAmplitudeSet.setBasisOrdering(
+					HoppingAmplitudeSet::BasisOrdering::Lexicographic
+				);
+			},
+			::testing::ExitedWithCode(1),
+			""
+		);
+	}
+
+	//The Morton order interleaves the bits of the subindices within
+	//each block, which keeps neighboring sites close.
+	HoppingAmplitudeSet hoppingAmplitudeSet = createBasisOrderingTestSet(
+		HoppingAmplitudeSet::BasisOrdering::Morton,
+		4,
+		4
+	);
+	for(int s = 0; s < 2; s++){
+		int firstIndex = hoppingAmplitudeSet.getFirstIndexInBlock({s});
+		for(int x = 0; x < 4; x++){
+			for(int y = 0; y < 4; y++){
+				int morton = 0;
+				for(int bit = 0; bit < 2; bit++){
+					morton |= ((x >> bit) & 1) << (2*bit);
+					morton |= ((y >> bit) & 1) << (2*bit + 1);
+				}
+				EXPECT_EQ(
+					hoppingAmplitudeSet.getBasisIndex({s, y, x}),
+					firstIndex + morton
+				);
+			}
+		}
+	}
+}
+};
@@ -35,6 +35,56 @@ TEST(Index, CopyConstructor){
 	EXPECT_EQ(indexCopy[2], 3) << "Copy constructor failed.";
 }
 
+TEST(Index, CopyConstructorLongIndex){
+	Index index({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+	Index indexCopy = index;
+	EXPECT_EQ(indexCopy.getSize(), 12) << "Copy constructor failed.";
+	for(int n = 0; n < 12; n++)
+		EXPECT_EQ(indexCopy[n], n+1) << "Copy constructor failed.";
+}
+
+TEST(Index, MoveConstructor){
+	Index index({1, 2, 3});
+	Index indexMoved = std::move(index);
+	EXPECT_EQ(indexMoved.getSize(), 3) << "Move constructor failed.";
+	EXPECT_EQ(indexMoved[0], 1) << "Move constructor failed.";
+	EXPECT_EQ(indexMoved[1], 2) << "Move constructor failed.";
+	EXPECT_EQ(indexMoved[2], 3) << "Move constructor failed.";
+}
+
+TEST(Index, MoveConstructorLongIndex){
+	Index index({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+	Index indexMoved = std::move(index);
+	EXPECT_EQ(indexMoved.getSize(), 12) << "Move constructor failed.";
+	for(int n = 0; n < 12; n++)
+		EXPECT_EQ(indexMoved[n], n+1) << "Move constructor failed.";
+}
+
+TEST(Index, operatorAssignment){
+	std::string errorMessage = "Assignment failed.";
+
+	Index index0({1, 2, 3});
+	Index index1({1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+	Index index2;
+
+	index2 = index1;
+	EXPECT_TRUE(index2.equals(index1)) << errorMessage;
+	index2 = index0;
+	EXPECT_TRUE(index2.equals(index0)) << errorMessage;
+}
+
+TEST(Index, operatorMoveAssignment){
+	std::string errorMessage = "Move assignment failed.";
+
+	Index index0;
+	index0 = Index({1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+	EXPECT_TRUE(
+		index0.equals({1, 2, 3, 4, 5, 6, 7, 8, 9, 10})
+	) << errorMessage;
+	index0 = Index({1, 2, 3});
+	EXPECT_TRUE(index0.equals({1, 2, 3})) << errorMessage;
+}
+
 TEST(Index, ConstructorConcatenationInitializerList){
 	std::string errorMessage = "Index concatenation filed.";
 
@@ -156,6 +206,15 @@ TEST(Index, push_back){
 	EXPECT_TRUE(index.equals({1, 2, 3})) << "push_back failed.";
 }
 
+TEST(Index, push_backBeyondInlineCapacity){
+	Index index;
+	for(int n = 0; n < 20; n++)
+		index.push_back(n);
+	EXPECT_EQ(index.getSize(), 20) << "push_back failed.";
+	for(int n = 0; n < 20; n++)
+		EXPECT_EQ(index[n], n) << "push_back failed.";
+}
+
 TEST(Index, popFront){
 	std::string errorMessage = "popFront() failed.";
 
@@ -254,6 +313,10 @@ TEST(Index, operatorGreaterThan){
 
 TEST(Index, getSizeInBytes){
 	EXPECT_TRUE(Index().getSizeInBytes() > 0) << "getSizeInBytes() failed.";
+	EXPECT_TRUE(
+		Index({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}).getSizeInBytes()
+		> Index({1, 2, 3}).getSizeInBytes()
+	) << "getSizeInBytes() failed.";
 }
 
 };
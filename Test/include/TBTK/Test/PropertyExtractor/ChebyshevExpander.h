@@ -0,0 +1,153 @@
+#include "TBTK/Model.h"
+#include "TBTK/PropertyExtractor/ChebyshevExpander.h"
+#include "TBTK/Solver/ChebyshevExpander.h"
+#include "TBTK/Solver/Diagonalizer.h"
+
+#include "gtest/gtest.h"
+
+namespace TBTK{
+namespace PropertyExtractor{
+
+TEST(ChebyshevExpander, calculateLDOSBatched){
+	//Chain with a site dependent on-site energy.
+	const int SIZE = 10;
+	Model model;
+	for(int x = 0; x < SIZE; x++){
+		model << HoppingAmplitude(0.1*x, {x}, {x});
+		if(x + 1 < SIZE)
+			model << HoppingAmplitude(-1, {x+1}, {x}) + HC;
+	}
+	model.construct();
+
+	Solver::ChebyshevExpander solver;
+	solver.setModel(model);
+	solver.setVerbose(false);
+	solver.setScaleFactor(5);
+	//The block size does not divide the number of sites, which leaves a
+	//partial batch to be flushed at the end.
+	solver.setBlockSize(4);
+
+	const int NUM_COEFFICIENTS = 200;
+	const int ENERGY_RESOLUTION = 100;
+	const double LOWER_BOUND = -4;
+	const double UPPER_BOUND = 4;
+	ChebyshevExpander propertyExtractor(
+		solver,
+		NUM_COEFFICIENTS,
+		false,
+		false,
+		false
+	);
+	propertyExtractor.setEnergyWindow(
+		LOWER_BOUND,
+		UPPER_BOUND,
+		ENERGY_RESOLUTION
+	);
+
+	//Parallel execution is ignored by the batched calculation.
+	propertyExtractor.setParallelExecution(true);
+	Property::LDOS ldos = propertyExtractor.calculateLDOS({{IDX_ALL}});
+	EXPECT_TRUE(propertyExtractor.getParallelExecution());
+
+	const double dE = (UPPER_BOUND - LOWER_BOUND)/ENERGY_RESOLUTION;
+	for(int x = 0; x < SIZE; x++){
+		Property::GreensFunction greensFunction
+			= propertyExtractor.calculateGreensFunction(
+				{x},
+				{x},
+				Property::GreensFunction::Type::NonPrincipal
+			);
+		const std::complex<double> *greensFunctionData
+			= greensFunction.getData();
+		for(int e = 0; e < ENERGY_RESOLUTION; e++){
+			EXPECT_NEAR(
+				ldos({x}, e),
+				imag(greensFunctionData[e])/M_PI*dE,
+				1e-10
+			);
+		}
+	}
+}
+
+//Number of states below each of the energies in the middle between two
+//consecutive eigenvalues, obtained by integrating the DOS.
+std::vector<double> getChebyshevExpanderTestStateCount(
+	const Property::DOS &dos,
+	const double *eigenValues,
+	int numEigenValues
+){
+	const double dE = (dos.getUpperBound() - dos.getLowerBound())/dos.getResolution();
+	std::vector<double> stateCount;
+	for(int n = 0; n + 1 < numEigenValues; n++){
+		double E = (eigenValues[n] + eigenValues[n+1])/2.;
+		double count = 0.;
+		for(int e = 0; e < dos.getResolution(); e++){
+			if(dos.getLowerBound() + e*dE < E)
+				count += dos(e)*dE;
+		}
+		stateCount.push_back(count);
+	}
+
+	return stateCount;
+}
+
+TEST(ChebyshevExpander, calculateDOS){
+	//Chain with a site dependent on-site energy.
+	const int SIZE = 10;
+	Model model;
+	for(int x = 0; x < SIZE; x++){
+		model << HoppingAmplitude(0.1*x, {x}, {x});
+		if(x + 1 < SIZE)
+			model << HoppingAmplitude(-1, {x+1}, {x}) + HC;
+	}
+	model.construct();
+
+	Solver::Diagonalizer diagonalizer;
+	diagonalizer.setModel(model);
+	diagonalizer.setVerbose(false);
+	diagonalizer.run();
+	const double *eigenValues = diagonalizer.getEigenValues();
+
+	Solver::ChebyshevExpander solver;
+	solver.setModel(model);
+	solver.setVerbose(false);
+	solver.setScaleFactor(5);
+
+	ChebyshevExpander propertyExtractor(solver, 400, false, false, false);
+	propertyExtractor.setEnergyWindow(-4, 4, 800);
+
+	//The exact trace gives the integer number of states below each
+	//energy between two eigenvalues.
+	Property::DOS dos = propertyExtractor.calculateDOS();
+	std::vector<double> stateCount = getChebyshevExpanderTestStateCount(
+		dos,
+		eigenValues,
+		SIZE
+	);
+	for(unsigned int n = 0; n < stateCount.size(); n++)
+		EXPECT_NEAR(stateCount[n], n + 1, 0.05);
+
+	//The stochastic trace agrees with the exact trace within the
+	//statistical error.
+	propertyExtractor.setUseStochasticDOS(true);
+	propertyExtractor.setNumRandomVectors(100);
+	Property::DOS standardError(-4, 4, 800);
+	Property::DOS stochasticDOS
+		= propertyExtractor.calculateDOS(standardError);
+	std::vector<double> stochasticStateCount
+		= getChebyshevExpanderTestStateCount(
+			stochasticDOS,
+			eigenValues,
+			SIZE
+		);
+	for(unsigned int n = 0; n < stochasticStateCount.size(); n++)
+		EXPECT_NEAR(stochasticStateCount[n], n + 1, 0.5);
+
+	double totalError = 0.;
+	for(int e = 0; e < standardError.getResolution(); e++)
+		totalError += standardError(e);
+	EXPECT_TRUE(totalError > 0);
+}
+
+};
+};
@@ -0,0 +1,75 @@
+#include "TBTK/Model.h"
+#include "TBTK/PropertyExtractor/Diagonalizer.h"
+#include "TBTK/Solver/Diagonalizer.h"
+
+#include "gtest/gtest.h"
+
+namespace TBTK{
+namespace PropertyExtractor{
+
+TEST(Diagonalizer, calculateMagnetizationParallel){
+	//Chain with a site dependent Zeeman term.
+	const int SIZE = 20;
+	Model model;
+	model.setChemicalPotential(0.5);
+	for(int x = 0; x < SIZE; x++){
+		for(int s = 0; s < 2; s++){
+			model << HoppingAmplitude(
+				(1 - 2*s)*0.1*x,
+				{x, s},
+				{x, s}
+			);
+			if(x + 1 < SIZE)
+				model << HoppingAmplitude(-1, {x+1, s}, {x, s}) + HC;
+		}
+		model << HoppingAmplitude(0.2, {x, 1}, {x, 0}) + HC;
+	}
+	model.construct();
+
+	Solver::Diagonalizer solver;
+	solver.setModel(model);
+	solver.setVerbose(false);
+	solver.run();
+
+	Diagonalizer propertyExtractor(solver);
+
+	//All indices are summed over and therefore share a single offset.
+	propertyExtractor.setParallelExecution(false);
+	Property::Magnetization serialMagnetization
+		= propertyExtractor.calculateMagnetization(
+			{IDX_SUM_ALL, IDX_SPIN},
+			{SIZE, 2}
+		);
+	propertyExtractor.setParallelExecution(true);
+	Property::Magnetization parallelMagnetization
+		= propertyExtractor.calculateMagnetization(
+			{IDX_SUM_ALL, IDX_SPIN},
+			{SIZE, 2}
+		);
+
+	ASSERT_EQ(
+		serialMagnetization.getSize(),
+		parallelMagnetization.getSize()
+	);
+	const SpinMatrix *serialData = serialMagnetization.getData();
+	const SpinMatrix *parallelData = parallelMagnetization.getData();
+	for(unsigned int n = 0; n < serialMagnetization.getSize(); n++){
+		for(unsigned int row = 0; row < 2; row++){
+			for(unsigned int col = 0; col < 2; col++){
+				EXPECT_NEAR(
+					real(parallelData[n].at(row, col)),
+					real(serialData[n].at(row, col)),
+					1e-10
+				);
+				EXPECT_NEAR(
+					imag(parallelData[n].at(row, col)),
+					imag(serialData[n].at(row, col)),
+					1e-10
+				);
+			}
+		}
+	}
+}
+
+};
+};
@@ -0,0 +1,182 @@
+#include "TBTK/BrillouinZone.h"
+#include "TBTK/Model.h"
+#include "TBTK/RPA/MatsubaraSusceptibilityCalculator.h"
+#include "TBTK/RPA/MomentumSpaceContext.h"
+#include "TBTK/RPA/SelfEnergyCalculator.h"
+#include "TBTK/Test/RPA/SusceptibilityCalculatorTestContext.h"
+#include "TBTK/UnitHandler.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace TBTK{
+
+TEST(MatsubaraSusceptibilityCalculator, MatsubaraFFT){
+	Model model;
+	BrillouinZone brillouinZone(
+		{{2*M_PI, 0}, {0, 2*M_PI}},
+		SpacePartition::MeshType::Nodal
+	);
+	MomentumSpaceContext momentumSpaceContext;
+	createSusceptibilityCalculatorTestContext(
+		model,
+		brillouinZone,
+		momentumSpaceContext
+	);
+
+	std::vector<std::complex<double>> energies
+		= getSusceptibilityCalculatorTestMatsubaraEnergies(model);
+
+	const unsigned int NUM_ORBITALS
+		= SUSCEPTIBILITY_CALCULATOR_TEST_NUM_ORBITALS;
+	const std::vector<std::vector<double>> &mesh
+		= momentumSpaceContext.getMesh();
+	for(unsigned int t = 0; t < 2; t++){
+		MatsubaraSusceptibilityCalculator directCalculator(
+			momentumSpaceContext,
+			SusceptibilityCalculator::Algorithm::Matsubara
+		);
+		MatsubaraSusceptibilityCalculator fftCalculator(
+			momentumSpaceContext,
+			SusceptibilityCalculator::Algorithm::MatsubaraFFT
+		);
+		MatsubaraSusceptibilityCalculator *calculators[2] = {
+			&directCalculator,
+			&fftCalculator
+		};
+		for(unsigned int n = 0; n < 2; n++){
+			calculators[n]->setVerbose(false);
+			calculators[n]->setEnergyType(
+				SusceptibilityCalculator::EnergyType::Imaginary
+			);
+			calculators[n]->setEnergies(energies);
+			calculators[n]->setNumSummationEnergies(31);
+			calculators[n]->setUseTailCorrection(t == 1);
+		}
+
+		for(unsigned int n = 0; n < mesh.size(); n++){
+			DualIndex kDual(
+				momentumSpaceContext.getKIndex(mesh[n]),
+				mesh[n]
+			);
+			for(
+				unsigned int c = 0;
+				c < NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS;
+				c++
+			){
+				std::vector<int> orbitalIndices = {
+					(int)(c/(NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS)),
+					(int)((c/(NUM_ORBITALS*NUM_ORBITALS))%NUM_ORBITALS),
+					(int)((c/NUM_ORBITALS)%NUM_ORBITALS),
+					(int)(c%NUM_ORBITALS)
+				};
+				std::vector<std::complex<double>> direct
+					= directCalculator.calculateSusceptibility(
+						kDual,
+						orbitalIndices
+					);
+				std::vector<std::complex<double>> fft
+					= fftCalculator.calculateSusceptibility(
+						kDual,
+						orbitalIndices
+					);
+				ASSERT_EQ(direct.size(), energies.size());
+				ASSERT_EQ(fft.size(), energies.size());
+				for(unsigned int e = 0; e < energies.size(); e++){
+					double tolerance
+						= 1e-10*(1 + abs(direct[e]));
+					EXPECT_NEAR(
+						real(fft[e]),
+						real(direct[e]),
+						tolerance
+					);
+					EXPECT_NEAR(
+						imag(fft[e]),
+						imag(direct[e]),
+						tolerance
+					);
+				}
+			}
+		}
+	}
+}
+
+TEST(SelfEnergyCalculator, MatsubaraFFT){
+	Model model;
+	BrillouinZone brillouinZone(
+		{{2*M_PI, 0}, {0, 2*M_PI}},
+		SpacePartition::MeshType::Nodal
+	);
+	MomentumSpaceContext momentumSpaceContext;
+	createSusceptibilityCalculatorTestContext(
+		model,
+		brillouinZone,
+		momentumSpaceContext
+	);
+
+	//Fermionic Matsubara energies.
+	double kT = UnitHandler::getK_BB()*UnitHandler::convertTemperatureNtB(
+		model.getTemperature()
+	);
+	std::vector<std::complex<double>> selfEnergyEnergies;
+	for(int e = -1; e <= 1; e++){
+		selfEnergyEnergies.push_back(
+			std::complex<double>(0, M_PI*(2*e + 1)*kT)
+		);
+	}
+
+	SelfEnergyCalculator directCalculator(momentumSpaceContext, 2);
+	SelfEnergyCalculator fftCalculator(
+		momentumSpaceContext,
+		2,
+		SusceptibilityCalculator::Algorithm::MatsubaraFFT
+	);
+	SelfEnergyCalculator *calculators[2] = {
+		&directCalculator,
+		&fftCalculator
+	};
+	for(unsigned int n = 0; n < 2; n++){
+		calculators[n]->setNumSummationEnergies(11);
+		calculators[n]->setSelfEnergyEnergies(selfEnergyEnergies);
+		calculators[n]->setU(0.4);
+		calculators[n]->setUp(0.2);
+		calculators[n]->setJ(0.1);
+		calculators[n]->setJp(0.1);
+		calculators[n]->init();
+	}
+
+	const unsigned int NUM_ORBITALS
+		= SUSCEPTIBILITY_CALCULATOR_TEST_NUM_ORBITALS;
+	const std::vector<std::vector<double>> &mesh
+		= momentumSpaceContext.getMesh();
+	for(unsigned int n = 0; n < mesh.size(); n++){
+		for(unsigned int c = 0; c < NUM_ORBITALS*NUM_ORBITALS; c++){
+			std::vector<int> orbitalIndices = {
+				(int)(c/NUM_ORBITALS),
+				(int)(c%NUM_ORBITALS)
+			};
+			std::vector<std::complex<double>> direct
+				= directCalculator.calculateSelfEnergy(
+					mesh[n],
+					orbitalIndices
+				);
+			std::vector<std::complex<double>> fft
+				= fftCalculator.calculateSelfEnergy(
+					mesh[n],
+					orbitalIndices
+				);
+			ASSERT_EQ(direct.size(), selfEnergyEnergies.size());
+			ASSERT_EQ(fft.size(), selfEnergyEnergies.size());
+			for(unsigned int e = 0; e < selfEnergyEnergies.size(); e++){
+				double tolerance = 1e-10*(1 + abs(direct[e]));
+				EXPECT_NEAR(real(fft[e]), real(direct[e]), tolerance);
+				EXPECT_NEAR(imag(fft[e]), imag(direct[e]), tolerance);
+			}
+		}
+	}
+}
+
+};
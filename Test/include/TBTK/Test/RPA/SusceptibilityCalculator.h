@@ -0,0 +1,287 @@
+#include "TBTK/BrillouinZone.h"
+#include "TBTK/Model.h"
+#include "TBTK/RPA/LindhardSusceptibilityCalculator.h"
+#include "TBTK/RPA/MatsubaraSusceptibilityCalculator.h"
+#include "TBTK/RPA/MomentumSpaceContext.h"
+#include "TBTK/RPA/RPASusceptibilityCalculator.h"
+#include "TBTK/Test/RPA/SusceptibilityCalculatorTestContext.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace TBTK{
+
+TEST(LindhardSusceptibilityCalculator, precompute){
+	Model model;
+	BrillouinZone brillouinZone(
+		{{2*M_PI, 0}, {0, 2*M_PI}},
+		SpacePartition::MeshType::Nodal
+	);
+	MomentumSpaceContext momentumSpaceContext;
+	createSusceptibilityCalculatorTestContext(
+		model,
+		brillouinZone,
+		momentumSpaceContext
+	);
+
+	std::vector<std::complex<double>> energies
+		= getSusceptibilityCalculatorTestEnergies();
+
+	LindhardSusceptibilityCalculator precomputedCalculator(
+		momentumSpaceContext
+	);
+	precomputedCalculator.setVerbose(false);
+	precomputedCalculator.setEnergyType(
+		SusceptibilityCalculator::EnergyType::Imaginary
+	);
+	precomputedCalculator.setEnergies(energies);
+	precomputedCalculator.precompute();
+
+	LindhardSusceptibilityCalculator onDemandCalculator(
+		momentumSpaceContext
+	);
+	onDemandCalculator.setVerbose(false);
+	onDemandCalculator.setEnergyType(
+		SusceptibilityCalculator::EnergyType::Imaginary
+	);
+	onDemandCalculator.setEnergies(energies);
+
+	const unsigned int NUM_ORBITALS
+		= SUSCEPTIBILITY_CALCULATOR_TEST_NUM_ORBITALS;
+	const std::vector<std::vector<double>> &mesh
+		= momentumSpaceContext.getMesh();
+	for(unsigned int n = 0; n < mesh.size(); n++){
+		DualIndex kDual(momentumSpaceContext.getKIndex(mesh[n]), mesh[n]);
+		for(
+			unsigned int c = 0;
+			c < NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS;
+			c++
+		){
+			std::vector<int> orbitalIndices = {
+				(int)(c/(NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS)),
+				(int)((c/(NUM_ORBITALS*NUM_ORBITALS))%NUM_ORBITALS),
+				(int)((c/NUM_ORBITALS)%NUM_ORBITALS),
+				(int)(c%NUM_ORBITALS)
+			};
+			std::vector<std::complex<double>> precomputed
+				= precomputedCalculator.calculateSusceptibility(
+					kDual,
+					orbitalIndices
+				);
+			std::vector<std::complex<double>> onDemand
+				= onDemandCalculator.calculateSusceptibility(
+					kDual,
+					orbitalIndices
+				);
+			ASSERT_EQ(precomputed.size(), energies.size());
+			ASSERT_EQ(onDemand.size(), energies.size());
+			for(unsigned int e = 0; e < energies.size(); e++){
+				//Single energy evaluation of the Lindhard
+				//formula.
+				std::complex<double> reference
+					= onDemandCalculator.calculateSusceptibility(
+						mesh[n],
+						orbitalIndices,
+						energies[e]
+					);
+				EXPECT_NEAR(
+					real(precomputed[e]),
+					real(reference),
+					1e-10
+				);
+				EXPECT_NEAR(
+					imag(precomputed[e]),
+					imag(reference),
+					1e-10
+				);
+				EXPECT_NEAR(
+					real(onDemand[e]),
+					real(reference),
+					1e-10
+				);
+				EXPECT_NEAR(
+					imag(onDemand[e]),
+					imag(reference),
+					1e-10
+				);
+			}
+		}
+	}
+}
+
+TEST(RPASusceptibilityCalculator, precompute){
+	Model model;
+	BrillouinZone brillouinZone(
+		{{2*M_PI, 0}, {0, 2*M_PI}},
+		SpacePartition::MeshType::Nodal
+	);
+	MomentumSpaceContext momentumSpaceContext;
+	createSusceptibilityCalculatorTestContext(
+		model,
+		brillouinZone,
+		momentumSpaceContext
+	);
+
+	std::vector<std::complex<double>> energies
+		= getSusceptibilityCalculatorTestEnergies();
+
+	RPASusceptibilityCalculator precomputedCalculator(
+		momentumSpaceContext
+	);
+	RPASusceptibilityCalculator onDemandCalculator(momentumSpaceContext);
+	RPASusceptibilityCalculator *calculators[2] = {
+		&precomputedCalculator,
+		&onDemandCalculator
+	};
+	for(unsigned int n = 0; n < 2; n++){
+		calculators[n]->setEnergyType(
+			RPASusceptibilityCalculator::EnergyType::Imaginary
+		);
+		calculators[n]->setEnergies(energies);
+		calculators[n]->setU(0.4);
+		calculators[n]->setUp(0.2);
+		calculators[n]->setJ(0.1);
+		calculators[n]->setJp(0.1);
+	}
+	precomputedCalculator.precompute();
+
+	const unsigned int NUM_ORBITALS
+		= SUSCEPTIBILITY_CALCULATOR_TEST_NUM_ORBITALS;
+	const std::vector<std::vector<double>> &mesh
+		= momentumSpaceContext.getMesh();
+	for(unsigned int n = 0; n < mesh.size(); n++){
+		DualIndex kDual(momentumSpaceContext.getKIndex(mesh[n]), mesh[n]);
+		for(
+			unsigned int c = 0;
+			c < NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS;
+			c++
+		){
+			std::vector<int> orbitalIndices = {
+				(int)(c/(NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS)),
+				(int)((c/(NUM_ORBITALS*NUM_ORBITALS))%NUM_ORBITALS),
+				(int)((c/NUM_ORBITALS)%NUM_ORBITALS),
+				(int)(c%NUM_ORBITALS)
+			};
+			std::vector<std::complex<double>> results[2][2];
+			for(unsigned int m = 0; m < 2; m++){
+				results[m][0] = calculators[m]
+					->calculateChargeRPASusceptibility(
+						kDual,
+						orbitalIndices
+					);
+				results[m][1] = calculators[m]
+					->calculateSpinRPASusceptibility(
+						kDual,
+						orbitalIndices
+					);
+			}
+			for(unsigned int s = 0; s < 2; s++){
+				ASSERT_EQ(results[0][s].size(), energies.size());
+				ASSERT_EQ(results[1][s].size(), energies.size());
+				for(unsigned int e = 0; e < energies.size(); e++){
+					EXPECT_NEAR(
+						real(results[0][s][e]),
+						real(results[1][s][e]),
+						1e-10
+					);
+					EXPECT_NEAR(
+						imag(results[0][s][e]),
+						imag(results[1][s][e]),
+						1e-10
+					);
+				}
+			}
+		}
+	}
+}
+
+TEST(MatsubaraSusceptibilityCalculator, setUseTailCorrection){
+	Model model;
+	BrillouinZone brillouinZone(
+		{{2*M_PI, 0}, {0, 2*M_PI}},
+		SpacePartition::MeshType::Nodal
+	);
+	MomentumSpaceContext momentumSpaceContext;
+	createSusceptibilityCalculatorTestContext(
+		model,
+		brillouinZone,
+		momentumSpaceContext
+	);
+
+	std::vector<std::complex<double>> energies
+		= getSusceptibilityCalculatorTestMatsubaraEnergies(model);
+
+	//Truncated sums with and without the tail correction, and a
+	//reference sum over many more summation energies.
+	const unsigned int NUM_SUMMATION_ENERGIES[3] = {31, 31, 4001};
+	const bool USE_TAIL_CORRECTION[3] = {false, true, false};
+	MatsubaraSusceptibilityCalculator *calculators[3];
+	for(unsigned int n = 0; n < 3; n++){
+		calculators[n] = new MatsubaraSusceptibilityCalculator(
+			momentumSpaceContext
+		);
+		calculators[n]->setVerbose(false);
+		calculators[n]->setEnergyType(
+			SusceptibilityCalculator::EnergyType::Imaginary
+		);
+		calculators[n]->setEnergies(energies);
+		calculators[n]->setNumSummationEnergies(
+			NUM_SUMMATION_ENERGIES[n]
+		);
+		calculators[n]->setUseTailCorrection(USE_TAIL_CORRECTION[n]);
+	}
+	EXPECT_FALSE(calculators[0]->getUseTailCorrection());
+	EXPECT_TRUE(calculators[1]->getUseTailCorrection());
+
+	const unsigned int NUM_ORBITALS
+		= SUSCEPTIBILITY_CALCULATOR_TEST_NUM_ORBITALS;
+	const std::vector<std::vector<double>> &mesh
+		= momentumSpaceContext.getMesh();
+	for(unsigned int n = 0; n < mesh.size(); n++){
+		DualIndex kDual(momentumSpaceContext.getKIndex(mesh[n]), mesh[n]);
+		for(
+			unsigned int c = 0;
+			c < NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS;
+			c++
+		){
+			std::vector<int> orbitalIndices = {
+				(int)(c/(NUM_ORBITALS*NUM_ORBITALS*NUM_ORBITALS)),
+				(int)((c/(NUM_ORBITALS*NUM_ORBITALS))%NUM_ORBITALS),
+				(int)((c/NUM_ORBITALS)%NUM_ORBITALS),
+				(int)(c%NUM_ORBITALS)
+			};
+			std::vector<std::complex<double>> results[3];
+			for(unsigned int m = 0; m < 3; m++){
+				results[m] = calculators[m]->calculateSusceptibility(
+					kDual,
+					orbitalIndices
+				);
+				ASSERT_EQ(results[m].size(), energies.size());
+			}
+			bool isDiagonal = (
+				orbitalIndices[3] == orbitalIndices[0]
+				&& orbitalIndices[1] == orbitalIndices[2]
+			);
+			for(unsigned int e = 0; e < energies.size(); e++){
+				double error = abs(results[0][e] - results[2][e]);
+				double correctedError
+					= abs(results[1][e] - results[2][e]);
+				//The correction only applies to the orbital
+				//combinations that are diagonal in the
+				//asymptotic form of the Green's function.
+				if(isDiagonal)
+					EXPECT_LT(correctedError, error/10);
+				else
+					EXPECT_EQ(results[1][e], results[0][e]);
+			}
+		}
+	}
+
+	for(unsigned int n = 0; n < 3; n++)
+		delete calculators[n];
+}
+
+};
@@ -0,0 +1,79 @@
+#include "TBTK/BrillouinZone.h"
+#include "TBTK/Model.h"
+#include "TBTK/RPA/MomentumSpaceContext.h"
+#include "TBTK/UnitHandler.h"
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace TBTK{
+
+const unsigned int SUSCEPTIBILITY_CALCULATOR_TEST_NUM_ORBITALS = 2;
+
+//Two coupled orbitals on a square lattice, defined on a 4x4 mesh.
+inline void createSusceptibilityCalculatorTestContext(
+	Model &model,
+	BrillouinZone &brillouinZone,
+	MomentumSpaceContext &momentumSpaceContext
+){
+	std::vector<unsigned int> numMeshPoints = {4, 4};
+	std::vector<std::vector<double>> mesh
+		= brillouinZone.getMinorMesh(numMeshPoints);
+	for(unsigned int n = 0; n < mesh.size(); n++){
+		const std::vector<double> &k = mesh[n];
+		Index kIndex = brillouinZone.getMinorCellIndex(k, numMeshPoints);
+		double dispersion = -2*(cos(k[0]) + cos(k[1]));
+		model << HoppingAmplitude(
+			dispersion - 0.5,
+			{kIndex[0], kIndex[1], 0},
+			{kIndex[0], kIndex[1], 0}
+		);
+		model << HoppingAmplitude(
+			dispersion/2. + 0.5,
+			{kIndex[0], kIndex[1], 1},
+			{kIndex[0], kIndex[1], 1}
+		);
+		model << HoppingAmplitude(
+			0.3*sin(k[0]),
+			{kIndex[0], kIndex[1], 1},
+			{kIndex[0], kIndex[1], 0}
+		) + HC;
+	}
+	model.setVerbose(false);
+	model.setTemperature(1000);
+	model.setChemicalPotential(0.1);
+	model.construct();
+
+	momentumSpaceContext.setModel(model);
+	momentumSpaceContext.setBrillouinZone(brillouinZone);
+	momentumSpaceContext.setNumMeshPoints(numMeshPoints);
+	momentumSpaceContext.setNumOrbitals(
+		SUSCEPTIBILITY_CALCULATOR_TEST_NUM_ORBITALS
+	);
+	momentumSpaceContext.init();
+}
+
+inline std::vector<std::complex<double>> getSusceptibilityCalculatorTestEnergies(){
+	return {
+		std::complex<double>(0, 0.1),
+		std::complex<double>(0, 0.3),
+		std::complex<double>(0, 0.7)
+	};
+}
+
+//Bosonic Matsubara energies centered around zero, as required by the
+//Matsubara algorithms.
+inline std::vector<std::complex<double>>
+getSusceptibilityCalculatorTestMatsubaraEnergies(const Model &model){
+	double kT = UnitHandler::getK_BB()*UnitHandler::convertTemperatureNtB(
+		model.getTemperature()
+	);
+	std::vector<std::complex<double>> energies;
+	for(int e = -1; e <= 1; e++)
+		energies.push_back(std::complex<double>(0, 2*M_PI*e*kT));
+
+	return energies;
+}
+
+};
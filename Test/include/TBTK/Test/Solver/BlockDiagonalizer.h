@@ -0,0 +1,94 @@
+#include "TBTK/Model.h"
+#include "TBTK/Solver/BlockDiagonalizer.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+namespace TBTK{
+namespace Solver{
+
+//Blocks of different sizes, with a Hamiltonian that differs between the
+//blocks.
+void createBlockDiagonalizerTestModel(Model &model){
+	const int NUM_BLOCKS = 20;
+	for(int k = 0; k < NUM_BLOCKS; k++){
+		int numOrbitals = 1 + k%7;
+		for(int o = 0; o < numOrbitals; o++){
+			model << HoppingAmplitude(0.1*k*o, {k, o}, {k, o});
+			if(o + 1 < numOrbitals){
+				model << HoppingAmplitude(
+					-1. + 0.05*k,
+					{k, o+1},
+					{k, o}
+				) + HC;
+			}
+		}
+	}
+	model.construct();
+}
+
+//Enables parallel execution after the first diagonalization, which leaves
+//the workspaces allocated for serial execution in the second solve.
+bool enableParallelExecutionCallback(BlockDiagonalizer &solver){
+	static bool isFirstCall = true;
+	if(isFirstCall){
+		isFirstCall = false;
+		solver.setParallelExecution(true);
+
+		return false;
+	}
+
+	return true;
+}
+
+TEST(BlockDiagonalizer, parallelExecution){
+	Model model;
+	createBlockDiagonalizerTestModel(model);
+	int basisSize = model.getBasisSize();
+
+	//Blocks with at least five states are diagonalized as large blocks.
+	BlockDiagonalizer serialSolver;
+	serialSolver.setModel(model);
+	serialSolver.setVerbose(false);
+	serialSolver.setLargeBlockThreshold(5);
+	serialSolver.setParallelExecution(false);
+	serialSolver.run();
+	std::vector<double> serialEigenValues;
+	for(int n = 0; n < basisSize; n++)
+		serialEigenValues.push_back(serialSolver.getEigenValue(n));
+
+	BlockDiagonalizer parallelSolver;
+	parallelSolver.setModel(model);
+	parallelSolver.setVerbose(false);
+	parallelSolver.setLargeBlockThreshold(5);
+	parallelSolver.setParallelExecution(true);
+	parallelSolver.run();
+	for(int n = 0; n < basisSize; n++){
+		EXPECT_NEAR(
+			parallelSolver.getEigenValue(n),
+			serialEigenValues[n],
+			1e-12
+		);
+	}
+
+	BlockDiagonalizer switchingSolver;
+	switchingSolver.setModel(model);
+	switchingSolver.setVerbose(false);
+	switchingSolver.setLargeBlockThreshold(5);
+	switchingSolver.setParallelExecution(false);
+	switchingSolver.setSelfConsistencyCallback(
+		enableParallelExecutionCallback
+	);
+	switchingSolver.run();
+	for(int n = 0; n < basisSize; n++){
+		EXPECT_NEAR(
+			switchingSolver.getEigenValue(n),
+			serialEigenValues[n],
+			1e-12
+		);
+	}
+}
+
+};
+};
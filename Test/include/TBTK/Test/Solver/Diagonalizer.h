@@ -0,0 +1,306 @@
+#include "TBTK/Model.h"
+#include "TBTK/Solver/Diagonalizer.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace TBTK{
+namespace Solver{
+
+const int DIAGONALIZER_TEST_SIZE = 20;
+
+//Chain with complex hopping amplitudes and site dependent on-site energies,
+//which has a non-degenerate spectrum.
+void createDiagonalizerTestModel(Model &model){
+	for(int x = 0; x < DIAGONALIZER_TEST_SIZE; x++){
+		model << HoppingAmplitude(0.3*sin(1.7*x), {x}, {x});
+		if(x + 1 < DIAGONALIZER_TEST_SIZE){
+			model << HoppingAmplitude(
+				std::complex<double>(-1, 0.2*x),
+				{x+1},
+				{x}
+			) + HC;
+		}
+	}
+	model.construct();
+}
+
+//Absolute value of the overlap between two eigenvectors, which is one for
+//eigenvectors that agree up to a phase.
+double getDiagonalizerTestOverlap(
+	Diagonalizer &lhs,
+	int lhsState,
+	Diagonalizer &rhs,
+	int rhsState
+){
+	std::complex<double> overlap = 0;
+	for(int x = 0; x < DIAGONALIZER_TEST_SIZE; x++){
+		overlap += conj(lhs.getAmplitude(lhsState, {x}))
+			*rhs.getAmplitude(rhsState, {x});
+	}
+
+	return abs(overlap);
+}
+
+TEST(Diagonalizer, algorithms){
+	Model model;
+	createDiagonalizerTestModel(model);
+
+	Diagonalizer packed;
+	packed.setModel(model);
+	packed.setVerbose(false);
+	packed.setAlgorithm(Diagonalizer::Algorithm::Packed);
+	packed.run();
+	EXPECT_EQ(packed.getNumEigenValues(), DIAGONALIZER_TEST_SIZE);
+
+	Diagonalizer::Algorithm algorithms[2] = {
+		Diagonalizer::Algorithm::DivideAndConquer,
+		Diagonalizer::Algorithm::MRRR
+	};
+	for(unsigned int n = 0; n < 2; n++){
+		Diagonalizer solver;
+		solver.setModel(model);
+		solver.setVerbose(false);
+		solver.setAlgorithm(algorithms[n]);
+		solver.run();
+
+		ASSERT_EQ(solver.getNumEigenValues(), DIAGONALIZER_TEST_SIZE);
+		for(int state = 0; state < DIAGONALIZER_TEST_SIZE; state++){
+			EXPECT_NEAR(
+				solver.getEigenValue(state),
+				packed.getEigenValue(state),
+				1e-10
+			);
+			EXPECT_NEAR(
+				getDiagonalizerTestOverlap(
+					solver,
+					state,
+					packed,
+					state
+				),
+				1,
+				1e-8
+			);
+		}
+	}
+}
+
+TEST(Diagonalizer, setEigenValueWindow){
+	Model model;
+	createDiagonalizerTestModel(model);
+
+	Diagonalizer packed;
+	packed.setModel(model);
+	packed.setVerbose(false);
+	packed.run();
+
+	//Place the window boundaries between eigenvalues.
+	const int FIRST = 5;
+	const int LAST = 12;
+	double lowerBound
+		= (packed.getEigenValue(FIRST-1) + packed.getEigenValue(FIRST))/2.;
+	double upperBound
+		= (packed.getEigenValue(LAST) + packed.getEigenValue(LAST+1))/2.;
+
+	Diagonalizer solver;
+	solver.setModel(model);
+	solver.setVerbose(false);
+	solver.setAlgorithm(Diagonalizer::Algorithm::MRRR);
+	solver.setEigenValueWindow(lowerBound, upperBound);
+	solver.run();
+
+	ASSERT_EQ(solver.getNumEigenValues(), LAST - FIRST + 1);
+	for(int state = 0; state < solver.getNumEigenValues(); state++){
+		EXPECT_NEAR(
+			solver.getEigenValue(state),
+			packed.getEigenValue(FIRST + state),
+			1e-10
+		);
+		EXPECT_NEAR(
+			getDiagonalizerTestOverlap(
+				solver,
+				state,
+				packed,
+				FIRST + state
+			),
+			1,
+			1e-8
+		);
+	}
+
+	//Calculating all eigenstates again after a window has been used.
+	solver.setCalculateAllEigenStates();
+	solver.run();
+	EXPECT_EQ(solver.getNumEigenValues(), DIAGONALIZER_TEST_SIZE);
+}
+
+TEST(Diagonalizer, setEigenStateRange){
+	Model model;
+	createDiagonalizerTestModel(model);
+
+	Diagonalizer packed;
+	packed.setModel(model);
+	packed.setVerbose(false);
+	packed.run();
+
+	const int FIRST = 0;
+	const int LAST = 3;
+	Diagonalizer solver;
+	solver.setModel(model);
+	solver.setVerbose(false);
+	solver.setAlgorithm(Diagonalizer::Algorithm::MRRR);
+	solver.setEigenStateRange(FIRST, LAST);
+	solver.run();
+
+	ASSERT_EQ(solver.getNumEigenValues(), LAST - FIRST + 1);
+	for(int state = 0; state < solver.getNumEigenValues(); state++){
+		EXPECT_NEAR(
+			solver.getEigenValue(state),
+			packed.getEigenValue(FIRST + state),
+			1e-10
+		);
+		EXPECT_NEAR(
+			getDiagonalizerTestOverlap(
+				solver,
+				state,
+				packed,
+				FIRST + state
+			),
+			1,
+			1e-8
+		);
+	}
+
+	//Only Algorithm::MRRR supports a subset of the eigenstates.
+	EXPECT_EXIT(
+		{
+			Streams::setStdMuteErr();
+			Diagonalizer invalidSolver;
+			invalidSolver.setModel(model);
+			invalidSolver.setVerbose(false);
+			invalidSolver.setEigenStateRange(FIRST, LAST);
+			invalidSolver.run();
+		},
+		::testing::ExitedWithCode(1),
+		""
+	);
+
+	//The range has to be within the basis.
+	EXPECT_EXIT(
+		{
+			Streams::setStdMuteErr();
+			Diagonalizer invalidSolver;
+			invalidSolver.setModel(model);
+			invalidSolver.setVerbose(false);
+			invalidSolver.setAlgorithm(Diagonalizer::Algorithm::MRRR);
+			invalidSolver.setEigenStateRange(0, DIAGONALIZER_TEST_SIZE);
+			invalidSolver.run();
+		},
+		::testing::ExitedWithCode(1),
+		""
+	);
+}
+
+
+//Hartree approximation of a Hubbard chain with the spin resolved densities
+//n[2*x + s] as order parameter.
+const double DIAGONALIZER_TEST_U = 1;
+std::vector<std::complex<double>> diagonalizerTestDensity;
+
+std::complex<double> diagonalizerTestHartreePotential(
+	const Index &to,
+	const Index &from
+){
+	int x = from.at(0);
+	int s = from.at(1);
+
+	return DIAGONALIZER_TEST_U*diagonalizerTestDensity[2*x + (1 - s)];
+}
+
+void calculateDiagonalizerTestDensity(
+	Diagonalizer &solver,
+	std::vector<std::complex<double>> &density
+){
+	for(int n = 0; n < solver.getModel().getBasisSize(); n++){
+		if(solver.getEigenValue(n) > 0)
+			break;
+
+		for(int x = 0; x < DIAGONALIZER_TEST_SIZE; x++){
+			for(int s = 0; s < 2; s++){
+				density[2*x + s] += pow(
+					abs(solver.getAmplitude(n, {x, s})),
+					2
+				);
+			}
+		}
+	}
+}
+
+void setDiagonalizerTestDensity(
+	Diagonalizer &solver,
+	const std::vector<std::complex<double>> &density
+){
+	diagonalizerTestDensity = density;
+}
+
+TEST(Diagonalizer, setOrderParameterCallbacks){
+	Model model;
+	for(int x = 0; x < DIAGONALIZER_TEST_SIZE; x++){
+		for(int s = 0; s < 2; s++){
+			model << HoppingAmplitude(
+				0.3*sin(1.7*x) - DIAGONALIZER_TEST_U/2.,
+				{x, s},
+				{x, s}
+			);
+			model << HoppingAmplitude(
+				diagonalizerTestHartreePotential,
+				{x, s},
+				{x, s}
+			);
+			if(x + 1 < DIAGONALIZER_TEST_SIZE)
+				model << HoppingAmplitude(-1, {x+1, s}, {x, s}) + HC;
+		}
+	}
+	model.construct();
+
+	//Linear mixing and Anderson mixing should converge to the same fixed
+	//point.
+	unsigned int mixingHistorySizes[2] = {0, 5};
+	std::vector<std::complex<double>> densities[2];
+	for(unsigned int n = 0; n < 2; n++){
+		Diagonalizer solver;
+		solver.setModel(model);
+		solver.setVerbose(false);
+		solver.setMaxIterations(200);
+		solver.setConvergenceLimit(1e-10);
+		solver.setMixingHistorySize(mixingHistorySizes[n]);
+		solver.setOrderParameterCallbacks(
+			std::vector<std::complex<double>>(
+				2*DIAGONALIZER_TEST_SIZE,
+				0.3
+			),
+			calculateDiagonalizerTestDensity,
+			setDiagonalizerTestDensity
+		);
+		solver.run();
+
+		const std::vector<double> &residualNorms
+			= solver.getResidualNorms();
+		ASSERT_LT(residualNorms.size(), 200);
+		EXPECT_LT(residualNorms.back(), 1e-8);
+
+		densities[n] = solver.getOrderParameter();
+		ASSERT_EQ(densities[n].size(), 2*DIAGONALIZER_TEST_SIZE);
+	}
+
+	for(unsigned int n = 0; n < densities[0].size(); n++){
+		EXPECT_NEAR(real(densities[1][n]), real(densities[0][n]), 1e-8);
+		EXPECT_NEAR(imag(densities[1][n]), 0, 1e-12);
+	}
+}
+
+};
+};
@@ -0,0 +1,220 @@
+#include "TBTK/Matrix.h"
+#include "TBTK/Solver/LUSolver.h"
+#include "TBTK/SparseMatrix.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace TBTK{
+namespace Solver{
+
+//Dense copy of the test matrix. Element (row, col) is stored at
+//row + size*col.
+template<typename DataType>
+std::vector<DataType> createLUSolverTestMatrix(
+	unsigned int size,
+	DataType shift
+){
+	std::vector<DataType> matrix(size*size, 0.);
+	for(unsigned int n = 0; n < size; n++){
+		matrix[n + size*n] = DataType(4 + 0.1*n) + shift;
+		if(n + 1 < size){
+			matrix[(n + 1) + size*n] = -1.;
+			matrix[n + size*(n + 1)] = -0.5;
+		}
+		if(n + 5 < size)
+			matrix[(n + 5) + size*n] = 0.25;
+	}
+
+	return matrix;
+}
+
+template<typename DataType>
+SparseMatrix<DataType> createLUSolverTestSparseMatrix(
+	const std::vector<DataType> &matrix,
+	unsigned int size
+){
+	SparseMatrix<DataType> sparseMatrix(
+		SparseMatrix<DataType>::StorageFormat::CSC,
+		size,
+		size
+	);
+	for(unsigned int col = 0; col < size; col++)
+		for(unsigned int row = 0; row < size; row++)
+			if(matrix[row + size*col] != DataType(0.))
+				sparseMatrix.add(row, col, matrix[row + size*col]);
+	sparseMatrix.constructCSX();
+
+	return sparseMatrix;
+}
+
+template<typename DataType>
+Matrix<DataType> createLUSolverTestRightHandSide(
+	unsigned int size,
+	unsigned int numColumns
+){
+	Matrix<DataType> b(size, numColumns);
+	for(unsigned int col = 0; col < numColumns; col++)
+		for(unsigned int row = 0; row < size; row++)
+			b.at(row, col) = std::sin(1. + row + 0.37*col);
+
+	return b;
+}
+
+//Maximum of |Ax - b| over all elements.
+template<typename DataType>
+double getLUSolverTestResidual(
+	const std::vector<DataType> &matrix,
+	const Matrix<DataType> &x,
+	const Matrix<DataType> &b
+){
+	unsigned int size = b.getNumRows();
+	double residual = 0;
+	for(unsigned int col = 0; col < b.getNumCols(); col++){
+		for(unsigned int row = 0; row < size; row++){
+			DataType sum = -b.at(row, col);
+			for(unsigned int n = 0; n < size; n++)
+				sum += matrix[row + size*n]*x.at(n, col);
+			residual = std::max(residual, std::abs(sum));
+		}
+	}
+
+	return residual;
+}
+
+TEST(LUSolver, solveMultipleBlocks){
+	//The right hand side spans three blocks of the default block size
+	//256, with the last block only partially filled.
+	const unsigned int SIZE = 30;
+	const unsigned int NUM_COLUMNS = 600;
+	std::vector<double> matrix = createLUSolverTestMatrix<double>(SIZE, 0);
+	Matrix<double> b = createLUSolverTestRightHandSide<double>(
+		SIZE,
+		NUM_COLUMNS
+	);
+
+	for(unsigned int n = 0; n < 2; n++){
+		LUSolver solver;
+		solver.setVerbose(false);
+		solver.setParallelExecution(n == 1);
+		EXPECT_EQ(solver.getBlockSize(), 256u);
+		solver.setMatrix(
+			createLUSolverTestSparseMatrix(matrix, SIZE)
+		);
+		EXPECT_FALSE(solver.getSymbolicAnalysisWasReused());
+		EXPECT_TRUE(
+			solver.getMatrixDataType() == LUSolver::DataType::Double
+		);
+
+		Matrix<double> x = b;
+		solver.solve(x);
+		EXPECT_LT(getLUSolverTestResidual(matrix, x, b), 1e-10);
+	}
+}
+
+TEST(LUSolver, solveMultipleBlocksComplex){
+	const unsigned int SIZE = 30;
+	const unsigned int NUM_COLUMNS = 300;
+	std::vector<std::complex<double>> matrix
+		= createLUSolverTestMatrix<std::complex<double>>(
+			SIZE,
+			std::complex<double>(0, 0.5)
+		);
+	Matrix<std::complex<double>> b
+		= createLUSolverTestRightHandSide<std::complex<double>>(
+			SIZE,
+			NUM_COLUMNS
+		);
+
+	for(unsigned int n = 0; n < 2; n++){
+		LUSolver solver;
+		solver.setVerbose(false);
+		solver.setParallelExecution(n == 1);
+		solver.setBlockSize(64);
+		solver.setMatrix(
+			createLUSolverTestSparseMatrix(matrix, SIZE)
+		);
+		EXPECT_TRUE(
+			solver.getMatrixDataType()
+				== LUSolver::DataType::ComplexDouble
+		);
+
+		Matrix<std::complex<double>> x = b;
+		solver.solve(x);
+		EXPECT_LT(getLUSolverTestResidual(matrix, x, b), 1e-10);
+	}
+}
+
+TEST(LUSolver, refactorizeAfterShift){
+	//Shifting the diagonal keeps the sparsity pattern, so the symbolic
+	//analysis of the first factorization should be reused.
+	const unsigned int SIZE = 30;
+	const unsigned int NUM_COLUMNS = 300;
+	Matrix<double> b = createLUSolverTestRightHandSide<double>(
+		SIZE,
+		NUM_COLUMNS
+	);
+
+	for(unsigned int mode = 0; mode < 2; mode++){
+		LUSolver solver;
+		solver.setVerbose(false);
+		solver.setSymmetricMode(mode == 1);
+		std::vector<double> matrix
+			= createLUSolverTestMatrix<double>(SIZE, 0);
+		solver.setMatrix(
+			createLUSolverTestSparseMatrix(matrix, SIZE)
+		);
+		EXPECT_FALSE(solver.getSymbolicAnalysisWasReused());
+		Matrix<double> x = b;
+		solver.solve(x);
+		EXPECT_LT(getLUSolverTestResidual(matrix, x, b), 1e-10);
+
+		std::vector<double> shiftedMatrix
+			= createLUSolverTestMatrix<double>(SIZE, 2.5);
+		solver.setMatrix(
+			createLUSolverTestSparseMatrix(shiftedMatrix, SIZE)
+		);
+		EXPECT_TRUE(solver.getSymbolicAnalysisWasReused());
+		Matrix<double> shiftedX = b;
+		solver.solve(shiftedX);
+		EXPECT_LT(
+			getLUSolverTestResidual(shiftedMatrix, shiftedX, b),
+			1e-10
+		);
+
+		//A fresh factorization of the shifted matrix should give the
+		//same solution.
+		LUSolver referenceSolver;
+		referenceSolver.setVerbose(false);
+		referenceSolver.setSymmetricMode(mode == 1);
+		referenceSolver.setMatrix(
+			createLUSolverTestSparseMatrix(shiftedMatrix, SIZE)
+		);
+		Matrix<double> referenceX = b;
+		referenceSolver.solve(referenceX);
+		for(unsigned int col = 0; col < NUM_COLUMNS; col++){
+			for(unsigned int row = 0; row < SIZE; row++){
+				EXPECT_NEAR(
+					shiftedX.at(row, col),
+					referenceX.at(row, col),
+					1e-10
+				);
+			}
+		}
+
+		//Changing the sparsity pattern requires a new symbolic
+		//analysis.
+		std::vector<double> smallerMatrix
+			= createLUSolverTestMatrix<double>(SIZE - 1, 0);
+		solver.setMatrix(
+			createLUSolverTestSparseMatrix(smallerMatrix, SIZE - 1)
+		);
+		EXPECT_FALSE(solver.getSymbolicAnalysisWasReused());
+	}
+}
+
+};
+};
@@ -0,0 +1,272 @@
+#include "TBTK/Model.h"
+#include "TBTK/Solver/Diagonalizer.h"
+#include "TBTK/Solver/TimeEvolver.h"
+#include "TBTK/UnitHandler.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace TBTK{
+namespace Solver{
+
+const int TIME_EVOLVER_TEST_SIZE = 10;
+
+//The potential is switched on once the time evolution starts.
+bool timeEvolverTestPotentialIsOn = false;
+
+double getTimeEvolverTestPotential(int x){
+	return 1.5 + 0.3*x;
+}
+
+std::complex<double> timeEvolverTestPotentialCallback(
+	const Index &to,
+	const Index &from
+){
+	if(timeEvolverTestPotentialIsOn)
+		return getTimeEvolverTestPotential(to[0]);
+	else
+		return 0;
+}
+
+bool timeEvolverTestCallback(TimeEvolver *timeEvolver){
+	timeEvolverTestPotentialIsOn = (timeEvolver->getCurrentTimeStep() >= 0);
+
+	return true;
+}
+
+//Chain with a potential that is switched on at t = 0, or that is on from
+//the start if potentialIsStatic is true.
+void createTimeEvolverTestModel(Model &model, bool potentialIsStatic){
+	for(int x = 0; x < TIME_EVOLVER_TEST_SIZE; x++){
+		if(potentialIsStatic){
+			model << HoppingAmplitude(
+				getTimeEvolverTestPotential(x),
+				{x},
+				{x}
+			);
+		}
+		else{
+			model << HoppingAmplitude(
+				timeEvolverTestPotentialCallback,
+				{x},
+				{x}
+			);
+		}
+		if(x + 1 < TIME_EVOLVER_TEST_SIZE)
+			model << HoppingAmplitude(-1, {x+1}, {x}) + HC;
+	}
+	model.construct();
+}
+
+//Time evolves the ground state eigenvectors of the chain without
+//potential using the propagator and compares them to the exact
+//evolution obtained from the eigenstates of the chain with potential.
+void testTimeEvolverPropagator(
+	TimeEvolver::Propagator propagator,
+	int numTimeSteps,
+	double time,
+	bool propagateOccupiedStatesOnly,
+	double tolerance
+){
+	const int NUM_PARTICLES = 4;
+
+	Model model;
+	createTimeEvolverTestModel(model, false);
+	model.setVerbose(false);
+
+	timeEvolverTestPotentialIsOn = false;
+	Diagonalizer initialSolver;
+	initialSolver.setModel(model);
+	initialSolver.setVerbose(false);
+	initialSolver.run();
+
+	Model finalModel;
+	createTimeEvolverTestModel(finalModel, true);
+	Diagonalizer finalSolver;
+	finalSolver.setModel(finalModel);
+	finalSolver.setVerbose(false);
+	finalSolver.run();
+
+	//Exact evolution of each initial state.
+	std::vector<std::vector<std::complex<double>>> exactStates;
+	for(int n = 0; n < TIME_EVOLVER_TEST_SIZE; n++){
+		std::vector<std::complex<double>> state(
+			TIME_EVOLVER_TEST_SIZE,
+			0
+		);
+		for(int m = 0; m < TIME_EVOLVER_TEST_SIZE; m++){
+			std::complex<double> overlap = 0;
+			for(int x = 0; x < TIME_EVOLVER_TEST_SIZE; x++){
+				overlap += conj(finalSolver.getAmplitude(m, {x}))
+					*initialSolver.getAmplitude(n, {x});
+			}
+			std::complex<double> phase = exp(
+				std::complex<double>(
+					0,
+					-finalSolver.getEigenValue(m)*time
+				)
+			);
+			for(int x = 0; x < TIME_EVOLVER_TEST_SIZE; x++){
+				state[x] += finalSolver.getAmplitude(m, {x})
+					*phase*overlap;
+			}
+		}
+		exactStates.push_back(state);
+	}
+
+	//The time step is given in natural units, while the propagators
+	//evolve by the time step in base units divided by hbar.
+	double dt = time/numTimeSteps
+		*UnitHandler::getHbarB()/UnitHandler::convertTimeNtB(1.);
+
+	TimeEvolver timeEvolver;
+	timeEvolver.setModel(model);
+	timeEvolver.getDiagonalizer()->setVerbose(false);
+	timeEvolver.setCallback(timeEvolverTestCallback);
+	timeEvolver.setNumberOfParticles(NUM_PARTICLES);
+	timeEvolver.setPropagator(propagator);
+	timeEvolver.setPropagateOccupiedStatesOnly(
+		propagateOccupiedStatesOnly
+	);
+	timeEvolver.setTimeStep(dt);
+	timeEvolver.setNumTimeSteps(numTimeSteps);
+	timeEvolver.run();
+
+	std::vector<bool> isFound(TIME_EVOLVER_TEST_SIZE, false);
+	for(int n = 0; n < TIME_EVOLVER_TEST_SIZE; n++){
+		//The occupied states are the time evolved lowest states.
+		double occupancy = timeEvolver.getOccupancy(n);
+		if(n < NUM_PARTICLES){
+			EXPECT_EQ(occupancy, 1);
+		}
+		else{
+			EXPECT_EQ(occupancy, 0);
+		}
+
+		double norm = 0;
+		for(int x = 0; x < TIME_EVOLVER_TEST_SIZE; x++)
+			norm += pow(abs(timeEvolver.getAmplitude(n, {x})), 2);
+		EXPECT_NEAR(norm, 1, tolerance);
+
+		//States that are not time evolved keep their position and
+		//energy.
+		if(propagateOccupiedStatesOnly && n >= NUM_PARTICLES){
+			EXPECT_EQ(
+				timeEvolver.getEigenValue(n),
+				initialSolver.getEigenValue(n)
+			);
+			for(int x = 0; x < TIME_EVOLVER_TEST_SIZE; x++){
+				EXPECT_EQ(
+					timeEvolver.getAmplitude(n, {x}),
+					initialSolver.getAmplitude(n, {x})
+				);
+			}
+
+			continue;
+		}
+
+		//The states are sorted by energy during the time evolution.
+		//Find the exact state it corresponds to.
+		int closestState = -1;
+		double minDistance = 0;
+		for(unsigned int m = 0; m < exactStates.size(); m++){
+			double distance = 0;
+			for(int x = 0; x < TIME_EVOLVER_TEST_SIZE; x++){
+				distance += pow(
+					abs(
+						timeEvolver.getAmplitude(n, {x})
+						- exactStates[m][x]
+					),
+					2
+				);
+			}
+			distance = sqrt(distance);
+			if(closestState == -1 || distance < minDistance){
+				closestState = m;
+				minDistance = distance;
+			}
+		}
+		EXPECT_NEAR(minDistance, 0, tolerance);
+		EXPECT_FALSE(isFound[closestState]);
+		isFound[closestState] = true;
+
+		//Occupied states are the ones that were occupied initially.
+		if(n < NUM_PARTICLES){
+			EXPECT_TRUE(closestState < NUM_PARTICLES);
+		}
+
+		//The energy is the expectation value of the Hamiltonian.
+		double energy = 0;
+		for(int m = 0; m < TIME_EVOLVER_TEST_SIZE; m++){
+			std::complex<double> overlap = 0;
+			for(int x = 0; x < TIME_EVOLVER_TEST_SIZE; x++){
+				overlap += conj(finalSolver.getAmplitude(m, {x}))
+					*timeEvolver.getAmplitude(n, {x});
+			}
+			energy += finalSolver.getEigenValue(m)*pow(abs(overlap), 2);
+		}
+		EXPECT_NEAR(timeEvolver.getEigenValue(n), energy, tolerance);
+		if(n > 0 && (!propagateOccupiedStatesOnly || n < NUM_PARTICLES)){
+			EXPECT_TRUE(
+				timeEvolver.getEigenValue(n - 1)
+				<= timeEvolver.getEigenValue(n)
+			);
+		}
+	}
+}
+
+TEST(TimeEvolver, propagateCrankNicolson){
+	//Crank-Nicolson is second order in the time step.
+	testTimeEvolverPropagator(
+		TimeEvolver::Propagator::CrankNicolson,
+		200,
+		1,
+		false,
+		1e-3
+	);
+}
+
+TEST(TimeEvolver, propagateChebyshev){
+	testTimeEvolverPropagator(
+		TimeEvolver::Propagator::Chebyshev,
+		10,
+		1,
+		false,
+		1e-8
+	);
+}
+
+TEST(TimeEvolver, propagateLanczos){
+	testTimeEvolverPropagator(
+		TimeEvolver::Propagator::Lanczos,
+		10,
+		1,
+		false,
+		1e-8
+	);
+}
+
+TEST(TimeEvolver, setPropagateOccupiedStatesOnly){
+	TimeEvolver::Propagator propagators[3] = {
+		TimeEvolver::Propagator::CrankNicolson,
+		TimeEvolver::Propagator::Chebyshev,
+		TimeEvolver::Propagator::Lanczos
+	};
+	double tolerances[3] = {1e-3, 1e-8, 1e-8};
+	int numTimeSteps[3] = {200, 10, 10};
+	for(unsigned int n = 0; n < 3; n++){
+		testTimeEvolverPropagator(
+			propagators[n],
+			numTimeSteps[n],
+			1,
+			true,
+			tolerances[n]
+		);
+	}
+}
+
+};
+};
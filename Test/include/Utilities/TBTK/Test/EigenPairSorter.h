@@ -0,0 +1,46 @@
+#include "TBTK/EigenPairSorter.h"
+
+#include "gtest/gtest.h"
+
+#include <complex>
+#include <vector>
+
+namespace TBTK{
+
+TEST(EigenPairSorter, getPermutation){
+	//Equal values keep their original order.
+	double values[5] = {0.5, -1, 0.5, 2, -3};
+	std::vector<unsigned int> permutation
+		= EigenPairSorter::getPermutation(values, 5);
+	std::vector<unsigned int> expected = {4, 1, 0, 2, 3};
+	EXPECT_EQ(permutation, expected);
+
+	//Complex values are ordered by their real part.
+	std::complex<double> complexValues[3] = {
+		std::complex<double>(1, -1),
+		std::complex<double>(-1, 2),
+		std::complex<double>(0, 0)
+	};
+	permutation = EigenPairSorter::getPermutation(complexValues, 3);
+	expected = {1, 2, 0};
+	EXPECT_EQ(permutation, expected);
+}
+
+TEST(EigenPairSorter, permute){
+	std::vector<unsigned int> permutation = {2, 0, 3, 1};
+
+	double values[4] = {0, 1, 2, 3};
+	EigenPairSorter::permute(values, permutation);
+	for(unsigned int n = 0; n < 4; n++)
+		EXPECT_EQ(values[n], permutation[n]);
+
+	//Blocks of two elements.
+	int blocks[8] = {0, 0, 1, 1, 2, 2, 3, 3};
+	EigenPairSorter::permute(blocks, permutation, 2);
+	for(unsigned int n = 0; n < 4; n++){
+		EXPECT_EQ(blocks[2*n], permutation[n]);
+		EXPECT_EQ(blocks[2*n + 1], permutation[n]);
+	}
+}
+
+};
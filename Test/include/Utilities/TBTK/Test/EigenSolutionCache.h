@@ -0,0 +1,194 @@
+#include "TBTK/EigenSolutionCache.h"
+#include "TBTK/Model.h"
+#include "TBTK/Solver/BlockDiagonalizer.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace TBTK{
+
+//Creates an empty temporary directory for the cache.
+std::string createEigenSolutionCacheDirectory(){
+	char path[] = "/tmp/TBTKEigenSolutionCacheXXXXXX";
+	EXPECT_TRUE(mkdtemp(path) != nullptr);
+
+	return path;
+}
+
+//Removes the temporary directory together with the cache.
+void removeEigenSolutionCacheDirectory(
+	EigenSolutionCache &eigenSolutionCache,
+	const std::string &path
+){
+	eigenSolutionCache.clear();
+	std::remove((path + "/EigenSolutionCacheIndex").c_str());
+	rmdir(path.c_str());
+}
+
+TEST(EigenSolutionCache, load){
+	std::string path = createEigenSolutionCacheDirectory();
+	EigenSolutionCache eigenSolutionCache(path, 1024);
+
+	double eigenValues[2] = {1, 2};
+	std::complex<double> eigenVectors[4] = {1, 0, 0, 1};
+	eigenSolutionCache.store(1, 2, 4, eigenValues, eigenVectors);
+
+	//Hit.
+	double loadedEigenValues[2];
+	std::complex<double> loadedEigenVectors[4];
+	EXPECT_TRUE(
+		eigenSolutionCache.load(
+			1,
+			2,
+			4,
+			loadedEigenValues,
+			loadedEigenVectors
+		)
+	);
+	for(unsigned int n = 0; n < 2; n++)
+		EXPECT_DOUBLE_EQ(loadedEigenValues[n], eigenValues[n]);
+	for(unsigned int n = 0; n < 4; n++){
+		EXPECT_DOUBLE_EQ(
+			real(loadedEigenVectors[n]),
+			real(eigenVectors[n])
+		);
+	}
+
+	//Miss for a different hash.
+	EXPECT_FALSE(
+		eigenSolutionCache.load(
+			2,
+			2,
+			4,
+			loadedEigenValues,
+			loadedEigenVectors
+		)
+	);
+
+	//Miss for a different size.
+	EXPECT_FALSE(
+		eigenSolutionCache.load(
+			1,
+			1,
+			4,
+			loadedEigenValues,
+			loadedEigenVectors
+		)
+	);
+
+	removeEigenSolutionCacheDirectory(eigenSolutionCache, path);
+}
+
+TEST(EigenSolutionCache, store){
+	std::string path = createEigenSolutionCacheDirectory();
+
+	//Each entry requires 108 bytes, which allows for two entries.
+	EigenSolutionCache eigenSolutionCache(path, 250);
+
+	double eigenValues[2] = {1, 2};
+	std::complex<double> eigenVectors[4] = {1, 0, 0, 1};
+	eigenSolutionCache.store(1, 2, 4, eigenValues, eigenVectors);
+	eigenSolutionCache.store(2, 2, 4, eigenValues, eigenVectors);
+	EXPECT_EQ(eigenSolutionCache.getSize(), 216u);
+
+	//Mark the first entry as the most recently used.
+	double loadedEigenValues[2];
+	std::complex<double> loadedEigenVectors[4];
+	EXPECT_TRUE(
+		eigenSolutionCache.load(
+			1,
+			2,
+			4,
+			loadedEigenValues,
+			loadedEigenVectors
+		)
+	);
+
+	//The least recently used entry is evicted.
+	eigenSolutionCache.store(3, 2, 4, eigenValues, eigenVectors);
+	EXPECT_EQ(eigenSolutionCache.getSize(), 216u);
+	EXPECT_TRUE(
+		eigenSolutionCache.load(
+			1,
+			2,
+			4,
+			loadedEigenValues,
+			loadedEigenVectors
+		)
+	);
+	EXPECT_FALSE(
+		eigenSolutionCache.load(
+			2,
+			2,
+			4,
+			loadedEigenValues,
+			loadedEigenVectors
+		)
+	);
+	EXPECT_TRUE(
+		eigenSolutionCache.load(
+			3,
+			2,
+			4,
+			loadedEigenValues,
+			loadedEigenVectors
+		)
+	);
+
+	//Solutions larger than the budget are not stored.
+	std::complex<double> largeEigenVectors[16];
+	eigenSolutionCache.store(4, 2, 16, eigenValues, largeEigenVectors);
+	EXPECT_EQ(eigenSolutionCache.getSize(), 216u);
+
+	//Shrinking the budget evicts entries.
+	eigenSolutionCache.setMaxSize(108);
+	EXPECT_EQ(eigenSolutionCache.getSize(), 108u);
+
+	removeEigenSolutionCacheDirectory(eigenSolutionCache, path);
+}
+
+double eigenSolutionCacheCallbackValue = 1;
+std::complex<double> eigenSolutionCacheCallback(
+	const Index &to,
+	const Index &from
+){
+	return eigenSolutionCacheCallbackValue;
+}
+
+TEST(EigenSolutionCache, BlockDiagonalizer){
+	std::string path = createEigenSolutionCacheDirectory();
+	EigenSolutionCache eigenSolutionCache(path, 1024);
+
+	Model model;
+	model << HoppingAmplitude(eigenSolutionCacheCallback, {0}, {0});
+	model << HoppingAmplitude(1, {1}, {1});
+	model.construct();
+
+	Solver::BlockDiagonalizer solver;
+	solver.setModel(model);
+	solver.setVerbose(false);
+	solver.setEigenSolutionCache(&eigenSolutionCache);
+
+	eigenSolutionCacheCallbackValue = 1;
+	solver.run();
+	EXPECT_DOUBLE_EQ(solver.getEigenValue({0}, 0), 1);
+	EXPECT_GT(eigenSolutionCache.getSize(), 0u);
+
+	//A changed callback amplitude results in a cache miss rather than in
+	//the stale solution being returned.
+	eigenSolutionCacheCallbackValue = -5;
+	solver.run();
+	EXPECT_DOUBLE_EQ(solver.getEigenValue({0}, 0), -5);
+
+	//The original solution is still cached.
+	eigenSolutionCacheCallbackValue = 1;
+	solver.run();
+	EXPECT_DOUBLE_EQ(solver.getEigenValue({0}, 0), 1);
+
+	removeEigenSolutionCacheDirectory(eigenSolutionCache, path);
+}
+
+};
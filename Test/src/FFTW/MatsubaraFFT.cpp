@@ -0,0 +1 @@
+#include "TBTK/Test/RPA/MatsubaraFFT.h"
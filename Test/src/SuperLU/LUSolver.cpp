@@ -0,0 +1 @@
+#include "TBTK/Test/Solver/LUSolver.h"
@@ -1,8 +1,19 @@
 #include "gtest/gtest.h"
 
+#include "TBTK/Test/BasisIndexLookupTable.h"
+#include "TBTK/Test/EigenPairSorter.h"
+#include "TBTK/Test/EigenSolutionCache.h"
 #include "TBTK/Test/Index.h"
 #include "TBTK/Test/HoppingAmplitude.h"
+#include "TBTK/Test/HoppingAmplitudeSet.h"
 #include "TBTK/Test/HoppingAmplitudeTree.h"
+#include "TBTK/Test/ModelFactory.h"
+#include "TBTK/Test/PropertyExtractor/ChebyshevExpander.h"
+#include "TBTK/Test/PropertyExtractor/Diagonalizer.h"
+#include "TBTK/Test/RPA/SusceptibilityCalculator.h"
+#include "TBTK/Test/Solver/BlockDiagonalizer.h"
+#include "TBTK/Test/Solver/Diagonalizer.h"
+#include "TBTK/Test/Solver/TimeEvolver.h"
 
 int main(int argc, char **argv){
 	::testing::InitGoogleTest(&argc, argv);